@@ -9,6 +9,7 @@
 #ifndef CIRCT_STREAM_CONVERSION_PASSES_H
 #define CIRCT_STREAM_CONVERSION_PASSES_H
 
+#include "circt-stream/Conversion/StreamToAsync.h"
 #include "circt-stream/Conversion/StreamToHandshake.h"
 #include "mlir/Pass/PassRegistry.h"
 
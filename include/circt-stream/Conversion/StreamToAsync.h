@@ -0,0 +1,26 @@
+//===- StreamToAsync.h ------------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the pass which lowers the Stream dialect to tasks that
+// run on the threads of the stream runtime.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_STREAM_CONVERSION_STREAMTOASYNC_H_
+#define CIRCT_STREAM_CONVERSION_STREAMTOASYNC_H_
+
+#include <memory>
+
+namespace mlir {
+class Pass;
+}
+
+namespace circt_stream {
+std::unique_ptr<mlir::Pass> createStreamToAsyncPass();
+}
+#endif // CIRCT_STREAM_CONVERSION_STREAMTOASYNC_H_
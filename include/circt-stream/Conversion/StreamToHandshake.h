@@ -21,6 +21,7 @@ class Pass;
 }
 
 namespace circt_stream {
+std::unique_ptr<mlir::Pass> createStreamLowerRegionsPass();
 std::unique_ptr<mlir::Pass> createStreamToHandshakePass();
 }
 #endif // CIRCT_STREAM_CONVERSION_STREAMTOHANDSHAKE_H_
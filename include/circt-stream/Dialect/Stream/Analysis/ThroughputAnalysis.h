@@ -0,0 +1,72 @@
+//===- ThroughputAnalysis.h - Stream throughput estimation ------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares an analysis that statically estimates the throughput and
+// the latency of the stream operations within a function.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_STREAM_DIALECT_STREAM_ANALYSIS_THROUGHPUTANALYSIS_H
+#define CIRCT_STREAM_DIALECT_STREAM_ANALYSIS_THROUGHPUTANALYSIS_H
+
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/Value.h"
+#include "llvm/ADT/DenseMap.h"
+
+namespace circt_stream {
+namespace stream {
+
+/// The estimated timing of a single stream operation, in cycles.
+struct OpTiming {
+  /// Cycles between two consecutive elements the operation can accept.
+  int64_t initiationInterval = 1;
+  /// Cycles between consuming an element and emitting the corresponding
+  /// result.
+  int64_t latency = 1;
+  /// Cycles between consuming EOS and emitting EOS.
+  int64_t eosLatency = 1;
+};
+
+/// Estimates the timing of all stream operations in a function. The
+/// estimates assume that the lowered circuit is buffered on each edge, such
+/// that each operation on a path adds a cycle. Constants and tuple
+/// manipulations are free.
+class ThroughputAnalysis {
+public:
+  explicit ThroughputAnalysis(mlir::Operation *funcOp);
+
+  /// Returns the estimates of a stream operation, or nullptr if the operation
+  /// neither consumes nor produces streams.
+  const OpTiming *getTiming(mlir::Operation *op) const;
+
+  /// Returns the time at which the elements of a stream arrive, relative to
+  /// the arguments of the function.
+  int64_t getArrival(mlir::Value stream) const;
+
+  /// Returns the operation with the largest initiation interval, or nullptr
+  /// if the function contains no stream operations.
+  mlir::Operation *getCriticalOp() const { return criticalOp; }
+
+  /// Returns the initiation interval of the whole function, which is
+  /// determined by its critical operation.
+  int64_t getInitiationInterval() const;
+
+  /// Returns the latest arrival of a stream the function returns.
+  int64_t getLatency() const { return latency; }
+
+private:
+  llvm::DenseMap<mlir::Operation *, OpTiming> timings;
+  llvm::DenseMap<mlir::Value, int64_t> arrivals;
+  mlir::Operation *criticalOp = nullptr;
+  int64_t latency = 0;
+};
+
+} // namespace stream
+} // namespace circt_stream
+
+#endif // CIRCT_STREAM_DIALECT_STREAM_ANALYSIS_THROUGHPUTANALYSIS_H
@@ -0,0 +1,96 @@
+//===- Interpreter.h - Stream dialect interpreter ---------------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares an interpreter that executes functions built from stream
+// operations in software, e.g., to obtain reference results for simulations
+// of the lowered circuits.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_STREAM_DIALECT_STREAM_INTERPRETER_INTERPRETER_H
+#define CIRCT_STREAM_DIALECT_STREAM_INTERPRETER_INTERPRETER_H
+
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Support/LogicalResult.h"
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/raw_ostream.h"
+#include <vector>
+
+namespace circt_stream {
+namespace stream {
+
+/// A single stream element, i.e., either an integer or a tuple of elements.
+class Element {
+public:
+  Element() = default;
+  Element(llvm::APInt value) : value(std::move(value)) {}
+  Element(std::vector<Element> fields)
+      : fields(std::move(fields)), tuple(true) {}
+
+  bool isTuple() const { return tuple; }
+
+  const llvm::APInt &getValue() const {
+    assert(!tuple && "expected an integer element");
+    return value;
+  }
+
+  llvm::ArrayRef<Element> getFields() const {
+    assert(tuple && "expected a tuple element");
+    return fields;
+  }
+
+  bool operator==(const Element &other) const;
+  bool operator!=(const Element &other) const { return !(*this == other); }
+
+  /// Prints integers as signed decimals and tuples as `(a, b, ...)`.
+  void print(llvm::raw_ostream &os) const;
+
+private:
+  llvm::APInt value;
+  std::vector<Element> fields;
+  bool tuple = false;
+};
+
+inline llvm::raw_ostream &operator<<(llvm::raw_ostream &os,
+                                     const Element &element) {
+  element.print(os);
+  return os;
+}
+
+/// The elements of a finite stream. Lanes are not modelled, i.e., the
+/// elements of a multi-lane stream are stored one after another.
+using StreamContents = std::vector<Element>;
+
+struct InterpreterOptions {
+  /// Executes each operation in its own thread instead of one after another.
+  /// The threads exchange the elements through bounded single-producer
+  /// single-consumer queues.
+  bool parallel = false;
+  /// Maximal number of elements that are transferred at once between
+  /// threads.
+  size_t batchSize = 1024;
+  /// Number of batches each queue can hold.
+  size_t queueDepth = 8;
+};
+
+/// Executes the provided function on the given input streams and stores the
+/// contents of the returned streams in `results`. By default, each operation
+/// processes its whole input before the next one is executed. Emits an error
+/// and fails on operations that cannot be interpreted.
+mlir::LogicalResult
+interpretFunction(mlir::func::FuncOp funcOp,
+                  llvm::ArrayRef<StreamContents> inputs,
+                  llvm::SmallVectorImpl<StreamContents> &results,
+                  const InterpreterOptions &options = {});
+
+} // namespace stream
+} // namespace circt_stream
+
+#endif // CIRCT_STREAM_DIALECT_STREAM_INTERPRETER_INTERPRETER_H
@@ -0,0 +1,69 @@
+//===- SPSCQueue.h - Bounded lock-free queue --------------------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a bounded, lock-free queue for exactly one producer and
+// one consumer thread.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_STREAM_DIALECT_STREAM_INTERPRETER_SPSCQUEUE_H
+#define CIRCT_STREAM_DIALECT_STREAM_INTERPRETER_SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace circt_stream {
+namespace stream {
+
+/// A ring buffer that holds up to `capacity` values. The producer only writes
+/// the tail and the consumer only writes the head, so no locks are required.
+template <typename T>
+class SPSCQueue {
+public:
+  explicit SPSCQueue(size_t capacity) : slots(capacity + 1) {}
+
+  /// Moves the value into the queue. Returns false if the queue is full.
+  bool tryPush(T &value) {
+    size_t tail = tailIdx.load(std::memory_order_relaxed);
+    size_t next = increment(tail);
+    if (next == headIdx.load(std::memory_order_acquire))
+      return false;
+    slots[tail] = std::move(value);
+    tailIdx.store(next, std::memory_order_release);
+    return true;
+  }
+
+  /// Moves the oldest value out of the queue. Returns false if the queue is
+  /// empty.
+  bool tryPop(T &value) {
+    size_t head = headIdx.load(std::memory_order_relaxed);
+    if (head == tailIdx.load(std::memory_order_acquire))
+      return false;
+    value = std::move(slots[head]);
+    headIdx.store(increment(head), std::memory_order_release);
+    return true;
+  }
+
+private:
+  size_t increment(size_t idx) const {
+    return idx + 1 == slots.size() ? 0 : idx + 1;
+  }
+
+  std::vector<T> slots;
+  // The indices are placed on separate cache lines, such that the producer
+  // and the consumer do not invalidate each other's cache.
+  alignas(64) std::atomic<size_t> headIdx{0};
+  alignas(64) std::atomic<size_t> tailIdx{0};
+};
+
+} // namespace stream
+} // namespace circt_stream
+
+#endif // CIRCT_STREAM_DIALECT_STREAM_INTERPRETER_SPSCQUEUE_H
@@ -18,6 +18,8 @@
 #include "mlir/Interfaces/InferTypeOpInterface.h"
 #include "mlir/Interfaces/SideEffectInterfaces.h"
 
+#include "circt-stream/Dialect/Stream/StreamOpsEnums.h.inc"
+
 #define GET_OP_CLASSES
 #include "circt-stream/Dialect/Stream/StreamOps.h.inc"
 
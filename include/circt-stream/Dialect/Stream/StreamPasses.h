@@ -0,0 +1,35 @@
+//===- StreamPasses.h - Stream pass entry points ----------------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This header file defines prototypes that expose pass constructors.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_STREAM_DIALECT_STREAM_STREAMPASSES_H
+#define CIRCT_STREAM_DIALECT_STREAM_STREAMPASSES_H
+
+#include "mlir/Pass/Pass.h"
+#include <memory>
+
+namespace circt_stream {
+namespace stream {
+
+std::unique_ptr<mlir::Pass> createStreamAnalyzeThroughputPass();
+std::unique_ptr<mlir::Pass> createStreamBufferSizingPass();
+std::unique_ptr<mlir::Pass> createStreamNarrowWidthsPass();
+std::unique_ptr<mlir::Pass> createStreamFoldConstantsPass();
+std::unique_ptr<mlir::Pass> createStreamEliminateDeadFieldsPass();
+
+/// Generate the code for registering passes.
+#define GEN_PASS_REGISTRATION
+#include "circt-stream/Dialect/Stream/StreamPasses.h.inc"
+
+} // namespace stream
+} // namespace circt_stream
+
+#endif // CIRCT_STREAM_DIALECT_STREAM_STREAMPASSES_H
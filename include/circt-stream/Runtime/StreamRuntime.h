@@ -0,0 +1,64 @@
+//===- StreamRuntime.h - Runtime of the CPU lowering ------------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the C interface of the runtime that is called by the code
+// produced by `--convert-stream-to-async`. Each stream operation runs as a task
+// on its own thread, and the tasks are connected by channels. A channel
+// transfers the elements of a stream in batches through a bounded lock-free
+// single-producer single-consumer queue.
+//
+// An element consists of a fixed number of 64-bit words, one for each integer
+// of its tuples. Only the low bits of a word that correspond to the width of
+// its integer are defined.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CIRCT_STREAM_RUNTIME_STREAMRUNTIME_H
+#define CIRCT_STREAM_RUNTIME_STREAMRUNTIME_H
+
+#include <cstdint>
+
+extern "C" {
+
+/// Creates a channel for elements of `words` words. The queue holds up to
+/// `depth` batches of `batchSize` elements each.
+void *stream_rt_channel_create(int64_t words, int64_t depth,
+                               int64_t batchSize);
+
+/// Appends a word to the element that is currently produced. Full batches are
+/// sent to the consumer, and the producer blocks while the queue is full. Must
+/// only be called by the producer of the channel.
+void stream_rt_push(void *channel, int64_t word);
+
+/// Sends the remaining elements and ends the stream. Must be called exactly
+/// once by the producer, which must not use the channel afterwards.
+void stream_rt_close(void *channel);
+
+/// Advances to the next element and blocks until it is available. Returns
+/// false once the stream ended, in which case the channel is destroyed. Must
+/// only be called by the consumer of the channel.
+bool stream_rt_next(void *channel);
+
+/// Returns the word `idx` of the current element of the consumer.
+int64_t stream_rt_value(void *channel, int64_t idx);
+
+/// Creates a task that executes `fn` with the task as argument once it is
+/// started.
+void *stream_rt_task_create(void (*fn)(void *));
+
+/// Appends a channel to the ones the task can access.
+void stream_rt_task_add_channel(void *task, void *channel);
+
+/// Returns the channel that was added at position `idx`.
+void *stream_rt_task_channel(void *task, int64_t idx);
+
+/// Executes the task on a new thread. The task is destroyed once it finished.
+void stream_rt_task_start(void *task);
+}
+
+#endif // CIRCT_STREAM_RUNTIME_STREAMRUNTIME_H
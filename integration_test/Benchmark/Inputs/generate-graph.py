@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+"""Generates a synthetic stream program with the requested number of stream
+operations. The program is a chain of maps, interrupted by a split/combine
+pair every few operations, and is used to measure compile times."""
+
+import argparse
+import sys
+
+
+def emit_map(out, idx, val):
+  out.write(f"    %m{idx} = stream.map(%{val}) : (!stream.stream<i32>) -> "
+            "!stream.stream<i32> {\n"
+            "    ^0(%val : i32):\n"
+            f"      %c = arith.constant {idx} : i32\n"
+            "      %r = arith.addi %val, %c : i32\n"
+            "      stream.yield %r : i32\n"
+            "    }\n")
+  return f"m{idx}"
+
+
+def emit_split_combine(out, idx, val):
+  out.write(f"    %s{idx}:2 = stream.split(%{val}) : (!stream.stream<i32>) -> "
+            "(!stream.stream<i32>, !stream.stream<i32>) {\n"
+            "    ^0(%val : i32):\n"
+            "      stream.yield %val, %val : i32, i32\n"
+            "    }\n"
+            f"    %c{idx} = stream.combine(%s{idx}#0, %s{idx}#1) : "
+            "(!stream.stream<i32>, !stream.stream<i32>) -> "
+            "!stream.stream<i32> {\n"
+            "    ^0(%a : i32, %b : i32):\n"
+            "      %r = arith.addi %a, %b : i32\n"
+            "      stream.yield %r : i32\n"
+            "    }\n")
+  return f"c{idx}"
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__)
+  parser.add_argument("ops", type=int, help="number of stream operations")
+  parser.add_argument("--split-every",
+                      type=int,
+                      default=16,
+                      help="number of operations between split/combine pairs")
+  args = parser.parse_args()
+
+  out = sys.stdout
+  out.write("module {\n"
+            "  func.func @top(%in: !stream.stream<i32>) -> "
+            "!stream.stream<i32> {\n")
+  val = "in"
+  idx = 0
+  while idx < args.ops:
+    if args.ops - idx >= 2 and idx % args.split_every == args.split_every - 2:
+      val = emit_split_combine(out, idx, val)
+      idx += 2
+    else:
+      val = emit_map(out, idx, val)
+      idx += 1
+  out.write(f"    return %{val} : !stream.stream<i32>\n" "  }\n" "}\n")
+
+
+if __name__ == "__main__":
+  main()
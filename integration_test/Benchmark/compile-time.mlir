@@ -0,0 +1,20 @@
+// REQUIRES: benchmark
+// Measures the time it takes to lower synthetic graphs of 1K, 10K, and 100K
+// stream operations. The pass timings are written next to the test outputs.
+// RUN: %PYTHON% %S/Inputs/generate-graph.py 1000 > %t.1k.mlir
+// RUN: stream-opt %t.1k.mlir --convert-stream-to-handshake --mlir-timing 2> %t.1k.timing | \
+// RUN: FileCheck %s --check-prefix=OPS1K
+// RUN: FileCheck %s --check-prefix=TIMING < %t.1k.timing
+// RUN: %PYTHON% %S/Inputs/generate-graph.py 10000 > %t.10k.mlir
+// RUN: stream-opt %t.10k.mlir --convert-stream-to-handshake --mlir-timing 2> %t.10k.timing | \
+// RUN: FileCheck %s --check-prefix=OPS10K
+// RUN: FileCheck %s --check-prefix=TIMING < %t.10k.timing
+// RUN: %PYTHON% %S/Inputs/generate-graph.py 100000 > %t.100k.mlir
+// RUN: stream-opt %t.100k.mlir --convert-stream-to-handshake --mlir-timing 2> %t.100k.timing | \
+// RUN: FileCheck %s --check-prefix=OPS100K
+// RUN: FileCheck %s --check-prefix=TIMING < %t.100k.timing
+
+// OPS1K: instance @stream_map_875(
+// OPS10K: instance @stream_map_8749(
+// OPS100K: instance @stream_map_87499(
+// TIMING: Total Execution Time
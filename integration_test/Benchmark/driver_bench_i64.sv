@@ -0,0 +1,67 @@
+module driver(
+  input clock,
+  input reset
+);
+  logic out0_valid, out0_ready;
+  logic [63:0] out0_data_field0;
+  logic out0_data_field1;
+  logic inCtrl_valid, inCtrl_ready;
+  logic outCtrl_valid, outCtrl_ready;
+
+  top dut (.*);
+
+  logic [1:0] state = 0;
+
+  // Cycles since reset was released.
+  longint cycle = 0;
+  longint firstCycle = -1;
+  longint elements = 0;
+
+  string reportFile;
+  integer fd;
+
+  always @(posedge clock) begin
+    if(reset == 1) begin
+      inCtrl_valid = 1;
+      out0_ready = 1;
+      outCtrl_ready = 1;
+
+      state = 1;
+    end
+    else begin
+      cycle = cycle + 1;
+
+      if(state == 1) begin
+        // holds valid high for 1 cycle.
+        state = 2;
+      end
+      else if(state == 2) begin
+        // sets valid to 0 to make sure the ctrl signal was only fired once.
+        inCtrl_valid = 0;
+        state = 3;
+      end
+
+      // Outputs are monitored from the first cycle on, such that no
+      // transaction is missed.
+      if(out0_valid == 1) begin
+        if(firstCycle < 0)
+          firstCycle = cycle;
+
+        if(out0_data_field1 == 0) begin
+          elements = elements + 1;
+        end
+        else begin
+          $display("BENCH {\"firstCycle\": %0d, \"eosCycle\": %0d, \"elements\": %0d, \"elementsPerCycle\": %f}",
+                   firstCycle, cycle, elements, real'(elements) / real'(cycle));
+          if($value$plusargs("report=%s", reportFile)) begin
+            fd = $fopen(reportFile, "w");
+            $fdisplay(fd, "{\"firstCycle\": %0d, \"eosCycle\": %0d, \"elements\": %0d, \"elementsPerCycle\": %f}",
+                      firstCycle, cycle, elements, real'(elements) / real'(cycle));
+            $fclose(fd);
+          end
+          $finish();
+        end
+      end
+    end
+  end
+endmodule // driver
@@ -0,0 +1,20 @@
+config.excludes.add('driver_bench_i64.sv')
+
+# The benchmarks simulate large streams and are only run by the
+# check-stream-benchmark target, which sets the `benchmark` parameter.
+if lit_config.params.get('benchmark'):
+  config.available_features.add('benchmark')
+
+# Shared pipeline of the benchmarks. `%bench-lower` lowers a stream program
+# read from stdin to Verilog, and `%bench-sim` simulates the Verilog files
+# that are appended with the benchmark driver. The substitutions are applied
+# first, such that the tools, `%S`, and `%t` are substituted within them.
+config.substitutions.insert(
+    0, ('%bench-lower', "stream-opt --convert-stream-to-handshake "
+        "--canonicalize='top-down=true region-simplify=true' "
+        "--handshake-materialize-forks-sinks --canonicalize "
+        "--handshake-insert-buffers=strategy=all "
+        "--lower-handshake-to-firrtl | firtool --format=mlir --verilog"))
+config.substitutions.insert(
+    0, ('%bench-sim', "circt-rtl-sim.py --no-default-driver --top driver "
+        "%S/driver_bench_i64.sv %S/../Dialect/Stream/driver.cpp"))
@@ -0,0 +1,35 @@
+// REQUIRES: verilator, benchmark
+// RUN: sed -e 's/@SIZE@/16/' %s | %bench-lower > %t.16.sv
+// RUN: %bench-sim %t.16.sv --simargs="+report=%t.16.json"
+// RUN: FileCheck %s --check-prefix=SIZE16 < %t.16.json
+// RUN: sed -e 's/@SIZE@/256/' %s | %bench-lower > %t.256.sv
+// RUN: %bench-sim %t.256.sv --simargs="+report=%t.256.json"
+// RUN: FileCheck %s --check-prefix=SIZE256 < %t.256.json
+// RUN: sed -e 's/@SIZE@/4096/' %s | %bench-lower > %t.4096.sv
+// RUN: %bench-sim %t.4096.sv --simargs="+report=%t.4096.json"
+// RUN: FileCheck %s --check-prefix=SIZE4096 < %t.4096.json
+
+// SIZE16: "elements": 16,
+// SIZE256: "elements": 256,
+// SIZE4096: "elements": 4096,
+
+module {
+  func.func @top() -> !stream.stream<i64> {
+    %in = stream.iota start 0 step 1 count @SIZE@ : !stream.stream<i64>
+    %left, %right = stream.split(%in) : (!stream.stream<i64>) -> (!stream.stream<i64>, !stream.stream<i64>) {
+    ^0(%val: i64):
+      stream.yield %val, %val : i64, i64
+    }
+    %sq = stream.map(%left) : (!stream.stream<i64>) -> !stream.stream<i64> {
+    ^0(%val : i64):
+      %r = arith.muli %val, %val : i64
+      stream.yield %r : i64
+    }
+    %out = stream.combine(%sq, %right) : (!stream.stream<i64>, !stream.stream<i64>) -> (!stream.stream<i64>) {
+    ^0(%val0: i64, %val1: i64):
+      %0 = arith.addi %val0, %val1 : i64
+      stream.yield %0 : i64
+    }
+    return %out : !stream.stream<i64>
+  }
+}
@@ -0,0 +1,33 @@
+// REQUIRES: verilator, benchmark
+// Streams a million elements from a memory-mapped trace through a map and
+// back into a trace, without printing the elements in the simulation.
+// RUN: stream-opt %s --convert-stream-to-handshake > %t.handshake.mlir
+// RUN: %PYTHON% %S/../Inputs/generate-driver.py %t.handshake.mlir -o %t.driver.sv
+// RUN: stream-opt %t.handshake.mlir \
+// RUN:   --canonicalize='top-down=true region-simplify=true' \
+// RUN:   --handshake-materialize-forks-sinks --canonicalize \
+// RUN:   --handshake-insert-buffers=strategy=all --lower-handshake-to-firrtl | \
+// RUN: firtool --format=mlir --verilog > %t.sv
+// RUN: %PYTHON% %S/../Inputs/trace.py iota %t.in0.bin --count 1000000
+// RUN: circt-rtl-sim.py %t.sv %t.driver.sv %S/../Dialect/Stream/driver.cpp --no-default-driver --top driver \
+// RUN:   --simargs="+in0=%t.in0.bin +out0=%t.out0.bin" | FileCheck %s --check-prefix=SIM
+// RUN: %PYTHON% %S/../Inputs/trace.py decode %t.out0.bin | tail -n 3 | FileCheck %s --check-prefix=OUT
+
+// SIM: out0: Count=1000000
+// SIM: Cycles=
+
+// OUT:      Element=2999997
+// OUT-NEXT: EOS
+// OUT-NEXT: Count=1000000
+
+module {
+  func.func @top(%in: !stream.stream<i64>) -> !stream.stream<i64> {
+    %out = stream.map(%in) : (!stream.stream<i64>) -> !stream.stream<i64> {
+    ^0(%val : i64):
+      %0 = arith.constant 3 : i64
+      %r = arith.muli %0, %val : i64
+      stream.yield %r : i64
+    }
+    return %out : !stream.stream<i64>
+  }
+}
@@ -0,0 +1,34 @@
+// REQUIRES: verilator
+// RUN: stream-opt %s --convert-stream-to-handshake > %t.handshake.mlir
+// RUN: %PYTHON% %S/../../Inputs/generate-driver.py %t.handshake.mlir -o %t.driver.sv
+// RUN: stream-opt %t.handshake.mlir \
+// RUN:   --canonicalize='top-down=true region-simplify=true' \
+// RUN:   --handshake-materialize-forks-sinks --canonicalize \
+// RUN:   --handshake-insert-buffers=strategy=all --lower-handshake-to-firrtl | \
+// RUN: firtool --format=mlir --verilog > %t.sv
+// RUN: printf '1 5\n0 7\n2 9\n0 1\n0 3\n' | %PYTHON% %S/../../Inputs/trace.py encode %t.in0.bin --fields 2
+// RUN: circt-rtl-sim.py %t.sv %t.driver.sv %S/driver.cpp --no-default-driver --top driver \
+// RUN:   --simargs="+in0=%t.in0.bin +out0=%t.out0.bin" | FileCheck %s --check-prefix=SIM
+// RUN: %PYTHON% %S/../../Inputs/trace.py decode %t.out0.bin --fields 2 | FileCheck %s
+
+// SIM: out0: Count=3
+
+// The EOS transaction carries the key 0, which must not be counted by the
+// slot of key 0 while the other slot is flushed.
+// CHECK:      Element=(1, 1)
+// CHECK-NEXT: Element=(2, 1)
+// CHECK-NEXT: Element=(0, 3)
+// CHECK-NEXT: EOS
+// CHECK-NEXT: Count=3
+
+module {
+  func.func @top(%in: !stream.stream<tuple<i8, i32>>) -> !stream.stream<tuple<i8, i32>> {
+    %res = stream.reduce_by_key(%in) {initValue = 0 : i32, capacity = 2 : i64}: (!stream.stream<tuple<i8, i32>>) -> !stream.stream<tuple<i8, i32>> {
+    ^0(%acc: i32, %val: i32):
+      %c1 = arith.constant 1 : i32
+      %r = arith.addi %acc, %c1 : i32
+      stream.yield %r : i32
+    }
+    return %res : !stream.stream<tuple<i8, i32>>
+  }
+}
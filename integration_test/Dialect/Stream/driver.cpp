@@ -9,6 +9,9 @@
 // A fairly standard, boilerplate Verilator C++ simulation driver. Assumes the
 // top level exposes just two signals: 'clock' and 'reset'.
 //
+// The driver also provides the DPI functions that the testbenches generated by
+// generate-driver.py use to read and write memory-mapped trace files.
+//
 // Based on the CIRCT's driver.cpp.
 //
 //===----------------------------------------------------------------------===//
@@ -18,7 +21,14 @@
 #include "verilated_vcd_c.h"
 
 #include "signal.h"
+#include <algorithm>
+#include <cstdint>
+#include <fcntl.h>
 #include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
 
 vluint64_t timeStamp;
 
@@ -29,6 +39,98 @@ void handle_sigint(int) { stopSimulation = true; }
 // Called by $time in Verilog.
 double sc_time_stamp() { return timeStamp; }
 
+namespace {
+// A trace file of 64-bit words that is mapped into memory. Traces that are
+// written grow their mapping on demand and are truncated to the written words
+// when they are closed.
+struct Trace {
+  int fd = -1;
+  int64_t *words = nullptr;
+  size_t size = 0;
+  size_t capacity = 0;
+  bool writable = false;
+};
+std::vector<Trace> traces;
+
+bool mapTrace(Trace &trace) {
+  if (trace.capacity == 0)
+    return true;
+  int prot = trace.writable ? PROT_READ | PROT_WRITE : PROT_READ;
+  void *addr = mmap(nullptr, trace.capacity * sizeof(int64_t), prot,
+                    MAP_SHARED, trace.fd, 0);
+  if (addr == MAP_FAILED)
+    return false;
+  trace.words = static_cast<int64_t *>(addr);
+  return true;
+}
+
+void unmapTrace(Trace &trace) {
+  if (trace.words)
+    munmap(trace.words, trace.capacity * sizeof(int64_t));
+  trace.words = nullptr;
+}
+
+int addTrace(const char *path, Trace trace) {
+  if (trace.fd < 0 || !mapTrace(trace)) {
+    std::cerr << "[driver] Cannot map the trace " << path << std::endl;
+    exit(1);
+  }
+  traces.push_back(trace);
+  return traces.size() - 1;
+}
+} // namespace
+
+extern "C" int trace_open_read(const char *path) {
+  Trace trace;
+  trace.fd = open(path, O_RDONLY);
+  struct stat st;
+  if (trace.fd >= 0 && fstat(trace.fd, &st) == 0)
+    trace.size = trace.capacity = st.st_size / sizeof(int64_t);
+  return addTrace(path, trace);
+}
+
+extern "C" int trace_open_write(const char *path) {
+  Trace trace;
+  trace.fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  trace.writable = true;
+  return addTrace(path, trace);
+}
+
+extern "C" long long trace_size(int handle) { return traces[handle].size; }
+
+extern "C" long long trace_read(int handle, long long idx) {
+  return traces[handle].words[idx];
+}
+
+// Writes to an invalid handle are dropped, such that outputs without a trace
+// are only counted.
+extern "C" void trace_write(int handle, long long word) {
+  if (handle < 0)
+    return;
+  Trace &trace = traces[handle];
+  if (trace.size == trace.capacity) {
+    unmapTrace(trace);
+    trace.capacity = std::max<size_t>(2 * trace.capacity, 1 << 16);
+    if (ftruncate(trace.fd, trace.capacity * sizeof(int64_t)) != 0 ||
+        !mapTrace(trace)) {
+      std::cerr << "[driver] Cannot grow a trace" << std::endl;
+      exit(1);
+    }
+  }
+  trace.words[trace.size++] = word;
+}
+
+extern "C" void trace_close(int handle) {
+  if (handle < 0 || traces[handle].fd < 0)
+    return;
+  Trace &trace = traces[handle];
+  unmapTrace(trace);
+  if (trace.writable && ftruncate(trace.fd, trace.size * sizeof(int64_t)) != 0)
+    std::cerr << "[driver] Cannot truncate a trace" << std::endl;
+  close(trace.fd);
+  trace.fd = -1;
+}
+
 int main(int argc, char **argv) {
   // Register graceful exit handler.
   signal(SIGINT, handle_sigint);
@@ -81,6 +183,7 @@ int main(int argc, char **argv) {
 
   // Take simulation out of reset.
   dut.reset = 0;
+  vluint64_t resetEndTime = timeStamp;
 
   // Run for the specified number of cycles out of reset.
   vluint64_t endTime = timeStamp + (numCyclesToRun * 2);
@@ -99,6 +202,8 @@ int main(int argc, char **argv) {
   if (tfp)
     tfp->close();
 
-  std::cout << "[driver] Ending simulation at tick #" << timeStamp << std::endl;
+  std::cout << "[driver] Ending simulation at tick #" << timeStamp << " after "
+            << (timeStamp - resetEndTime) / 2 << " cycles out of reset"
+            << std::endl;
   return 0;
 }
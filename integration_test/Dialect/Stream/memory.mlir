@@ -0,0 +1,57 @@
+// REQUIRES: verilator
+// RUN: stream-opt %s --convert-stream-to-handshake > %t.handshake.mlir
+// RUN: %PYTHON% %S/../../Inputs/generate-driver.py %t.handshake.mlir -o %t.driver.sv
+// RUN: stream-opt %t.handshake.mlir \
+// RUN:   --canonicalize='top-down=true region-simplify=true' \
+// RUN:   --handshake-materialize-forks-sinks --canonicalize \
+// RUN:   --handshake-insert-buffers=strategy=all --lower-handshake-to-firrtl | \
+// RUN: firtool --format=mlir --verilog > %t.sv
+// RUN: printf '5\n6\n7\n' | %PYTHON% %S/../../Inputs/trace.py encode %t.in0.bin
+// RUN: %PYTHON% %S/../../Inputs/trace.py iota %t.src.bin --count 8 --start 10 --step 10
+// RUN: circt-rtl-sim.py %t.sv %t.driver.sv %S/driver.cpp --no-default-driver --top driver \
+// RUN:   --simargs="+in0=%t.in0.bin +in2=%t.src.bin +in3_final=%t.dst.bin +out0=%t.out0.bin" | FileCheck %s --check-prefix=SIM
+// RUN: %PYTHON% %S/../../Inputs/trace.py decode %t.out0.bin | FileCheck %s --check-prefix=LOAD
+// RUN: %PYTHON% %S/../../Inputs/trace.py decode %t.dst.bin | FileCheck %s --check-prefix=STORE
+
+// With a single request in flight, each request waits for the response of
+// the previous one, and the EOS transaction waits behind the last response.
+// RUN: stream-opt %s --convert-stream-to-handshake=load-requests=1 > %t.one.handshake.mlir
+// RUN: %PYTHON% %S/../../Inputs/generate-driver.py %t.one.handshake.mlir -o %t.one.driver.sv
+// RUN: stream-opt %t.one.handshake.mlir \
+// RUN:   --canonicalize='top-down=true region-simplify=true' \
+// RUN:   --handshake-materialize-forks-sinks --canonicalize \
+// RUN:   --handshake-insert-buffers=strategy=all --lower-handshake-to-firrtl | \
+// RUN: firtool --format=mlir --verilog > %t.one.sv
+// RUN: circt-rtl-sim.py %t.one.sv %t.one.driver.sv %S/driver.cpp --no-default-driver --top driver \
+// RUN:   --simargs="+in0=%t.in0.bin +in2=%t.src.bin +in3_final=%t.one.dst.bin +out0=%t.one.out0.bin" | FileCheck %s --check-prefix=SIM
+// RUN: %PYTHON% %S/../../Inputs/trace.py decode %t.one.out0.bin | FileCheck %s --check-prefix=LOAD
+// RUN: %PYTHON% %S/../../Inputs/trace.py decode %t.one.dst.bin | FileCheck %s --check-prefix=STORE
+
+// SIM: out0: Count=3
+
+// The load reads every second element of the source, starting at the second.
+// LOAD:      Element=20
+// LOAD-NEXT: Element=40
+// LOAD-NEXT: Element=60
+// LOAD-NEXT: EOS
+// LOAD-NEXT: Count=3
+
+// The input stream is stored from the third element of the destination on.
+// STORE:      Element=0
+// STORE-NEXT: Element=0
+// STORE-NEXT: Element=5
+// STORE-NEXT: Element=6
+// STORE-NEXT: Element=7
+// STORE-NEXT: Element=0
+// STORE-NEXT: Element=0
+// STORE-NEXT: Element=0
+// STORE-NEXT: EOS
+// STORE-NEXT: Count=8
+
+module {
+  func.func @top(%in: !stream.stream<i64>, %src: memref<8xi64>, %dst: memref<8xi64>) -> !stream.stream<i64> {
+    %out = stream.load %src[start 1 stride 2 count 3] : memref<8xi64> -> !stream.stream<i64>
+    stream.store %in, %dst[start 2 stride 1] : !stream.stream<i64>, memref<8xi64>
+    return %out : !stream.stream<i64>
+  }
+}
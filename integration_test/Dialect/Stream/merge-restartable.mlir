@@ -0,0 +1,35 @@
+// REQUIRES: verilator
+// RUN: stream-opt %s --convert-stream-to-handshake=restartable > %t.handshake.mlir
+// RUN: %PYTHON% %S/../../Inputs/generate-driver.py %t.handshake.mlir --repeat in0=2 -o %t.driver.sv
+// RUN: stream-opt %t.handshake.mlir \
+// RUN:   --canonicalize='top-down=true region-simplify=true' \
+// RUN:   --handshake-materialize-forks-sinks --canonicalize \
+// RUN:   --handshake-insert-buffers=strategy=all --lower-handshake-to-firrtl | \
+// RUN: firtool --format=mlir --verilog > %t.sv
+// RUN: printf '1\n2\n' | %PYTHON% %S/../../Inputs/trace.py encode %t.in0.bin
+// RUN: %PYTHON% %S/../../Inputs/trace.py iota %t.in2.bin --count 16 --start 10 --step 10
+// RUN: circt-rtl-sim.py %t.sv %t.driver.sv %S/driver.cpp --no-default-driver --top driver \
+// RUN:   --simargs="+in0=%t.in0.bin +in2=%t.in2.bin +out0=%t.out0.bin" | FileCheck %s --check-prefix=SIM
+// RUN: %PYTHON% %S/../../Inputs/trace.py decode %t.out0.bin | FileCheck %s
+
+// The first input ends twice before the second one ends, as the merge prefers
+// it. Its second EOS must not end the merged stream, so the sum covers both
+// streams of the first input and the whole second one.
+
+// SIM: out0: Count=1
+
+// CHECK:      Element=1366
+// CHECK-NEXT: EOS
+// CHECK-NEXT: Count=1
+
+module {
+  func.func @top(%in0: !stream.stream<i64>, %in1: !stream.stream<i64>) -> !stream.stream<i64> {
+    %merged = stream.merge %in0, %in1 : !stream.stream<i64>
+    %res = stream.reduce(%merged) {initValue = 0 : i64}: (!stream.stream<i64>) -> !stream.stream<i64> {
+    ^0(%acc: i64, %val: i64):
+      %r = arith.addi %acc, %val : i64
+      stream.yield %r : i64
+    }
+    return %res : !stream.stream<i64>
+  }
+}
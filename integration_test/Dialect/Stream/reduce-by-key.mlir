@@ -0,0 +1,34 @@
+// REQUIRES: verilator
+// RUN: stream-opt %s --convert-stream-to-handshake > %t.handshake.mlir
+// RUN: %PYTHON% %S/../../Inputs/generate-driver.py %t.handshake.mlir -o %t.driver.sv
+// RUN: stream-opt %t.handshake.mlir \
+// RUN:   --canonicalize='top-down=true region-simplify=true' \
+// RUN:   --handshake-materialize-forks-sinks --canonicalize \
+// RUN:   --handshake-insert-buffers=strategy=all --lower-handshake-to-firrtl | \
+// RUN: firtool --format=mlir --verilog > %t.sv
+// RUN: printf '1 10\n2 20\n1 30\n3 40\n2 50\n1 60\n' | %PYTHON% %S/../../Inputs/trace.py encode %t.in0.bin --fields 2
+// RUN: circt-rtl-sim.py %t.sv %t.driver.sv %S/driver.cpp --no-default-driver --top driver \
+// RUN:   --simargs="+in0=%t.in0.bin +out0=%t.out0.bin" | FileCheck %s --check-prefix=SIM
+// RUN: %PYTHON% %S/../../Inputs/trace.py decode %t.out0.bin --fields 2 | FileCheck %s
+
+// SIM: out0: Count=4
+
+// The third key evicts the first one, and the first key then evicts the
+// second one, before the remaining slots are flushed on EOS.
+// CHECK:      Element=(1, 40)
+// CHECK-NEXT: Element=(2, 70)
+// CHECK-NEXT: Element=(3, 40)
+// CHECK-NEXT: Element=(1, 60)
+// CHECK-NEXT: EOS
+// CHECK-NEXT: Count=4
+
+module {
+  func.func @top(%in: !stream.stream<tuple<i8, i32>>) -> !stream.stream<tuple<i8, i32>> {
+    %res = stream.reduce_by_key(%in) {initValue = 0 : i32, capacity = 2 : i64}: (!stream.stream<tuple<i8, i32>>) -> !stream.stream<tuple<i8, i32>> {
+    ^0(%acc: i32, %val: i32):
+      %r = arith.addi %acc, %val : i32
+      stream.yield %r : i32
+    }
+    return %res : !stream.stream<tuple<i8, i32>>
+  }
+}
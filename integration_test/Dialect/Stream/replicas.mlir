@@ -0,0 +1,29 @@
+// REQUIRES: verilator
+// RUN: stream-opt %s --convert-stream-to-handshake \
+// RUN:   --canonicalize='top-down=true region-simplify=true' \
+// RUN:   --handshake-materialize-forks-sinks --canonicalize \
+// RUN:   --handshake-insert-buffers=strategy=all --lower-handshake-to-firrtl | \
+// RUN: firtool --format=mlir --verilog > %t.sv && \
+// RUN: circt-rtl-sim.py %t.sv %S/driver_out_i64.sv %S/driver.cpp --no-default-driver --top driver | FileCheck %s
+// The elements leave the replicas in their original order.
+// CHECK:      Element={{.*}}11
+// CHECK-NEXT: Element={{.*}}12
+// CHECK-NEXT: Element={{.*}}13
+// CHECK-NEXT: Element={{.*}}14
+// CHECK-NEXT: Element={{.*}}15
+// CHECK-NEXT: Element={{.*}}16
+// CHECK-NEXT: Element={{.*}}17
+// CHECK-NEXT: EOS
+
+module {
+  func.func @top() -> !stream.stream<i64> {
+    %in = stream.create !stream.stream<i64> [1,2,3,4,5,6,7]
+    %out = stream.map(%in) {replicas = 3 : i64} : (!stream.stream<i64>) -> !stream.stream<i64> {
+    ^0(%val : i64):
+      %0 = arith.constant 10 : i64
+      %r = arith.addi %0, %val : i64
+      stream.yield %r : i64
+    }
+    return %out : !stream.stream<i64>
+  }
+}
@@ -0,0 +1,58 @@
+// REQUIRES: verilator
+// RUN: stream-opt %s --convert-stream-to-handshake > %t.handshake.mlir
+// RUN: %PYTHON% %S/../../Inputs/generate-driver.py %t.handshake.mlir -o %t.driver.sv
+// RUN: stream-opt %t.handshake.mlir \
+// RUN:   --canonicalize='top-down=true region-simplify=true' \
+// RUN:   --handshake-materialize-forks-sinks --canonicalize \
+// RUN:   --handshake-insert-buffers=strategy=all --lower-handshake-to-firrtl | \
+// RUN: firtool --format=mlir --verilog > %t.sv
+// RUN: printf '1\n2\n3\n-4\n' | %PYTHON% %S/../../Inputs/trace.py encode %t.in0.bin
+// RUN: circt-rtl-sim.py %t.sv %t.driver.sv %S/driver.cpp --no-default-driver --top driver \
+// RUN:   --simargs="+in0=%t.in0.bin +out0=%t.out0.bin +out2=%t.out2.bin" | FileCheck %s --check-prefix=SIM
+// RUN: %PYTHON% %S/../../Inputs/trace.py decode %t.out0.bin | FileCheck %s --check-prefix=OUT0
+// RUN: %PYTHON% %S/../../Inputs/trace.py decode %t.out2.bin --fields 2 | FileCheck %s --check-prefix=OUT2
+
+// With EOS on the last element, the driver flags the last element of the trace.
+// RUN: stream-opt %s --convert-stream-to-handshake=eos-on-last > %t.last.handshake.mlir
+// RUN: %PYTHON% %S/../../Inputs/generate-driver.py %t.last.handshake.mlir --eos-on-last -o %t.last.driver.sv
+// RUN: stream-opt %t.last.handshake.mlir \
+// RUN:   --canonicalize='top-down=true region-simplify=true' \
+// RUN:   --handshake-materialize-forks-sinks --canonicalize \
+// RUN:   --handshake-insert-buffers=strategy=all --lower-handshake-to-firrtl | \
+// RUN: firtool --format=mlir --verilog > %t.last.sv
+// RUN: circt-rtl-sim.py %t.last.sv %t.last.driver.sv %S/driver.cpp --no-default-driver --top driver \
+// RUN:   --simargs="+in0=%t.in0.bin +out0=%t.last.out0.bin" | FileCheck %s --check-prefix=SIM
+// RUN: %PYTHON% %S/../../Inputs/trace.py decode %t.last.out0.bin | FileCheck %s --check-prefix=OUT0
+
+// SIM-DAG: out0: Count=4
+// SIM-DAG: out2: Count=4
+
+// OUT0:      Element=11
+// OUT0-NEXT: Element=12
+// OUT0-NEXT: Element=13
+// OUT0-NEXT: Element=6
+// OUT0-NEXT: EOS
+// OUT0-NEXT: Count=4
+
+// OUT2:      Element=(1, -1)
+// OUT2-NEXT: Element=(2, -2)
+// OUT2-NEXT: Element=(3, -3)
+// OUT2-NEXT: Element=(-4, 4)
+// OUT2-NEXT: EOS
+// OUT2-NEXT: Count=4
+
+module {
+  func.func @top(%in: !stream.stream<i64>) -> (!stream.stream<i64>, !stream.stream<tuple<i32, i32>>) {
+    %0, %1 = stream.split(%in) : (!stream.stream<i64>) -> (!stream.stream<i64>, !stream.stream<tuple<i32, i32>>) {
+    ^0(%val : i64):
+      %c10 = arith.constant 10 : i64
+      %sum = arith.addi %val, %c10 : i64
+      %t = arith.trunci %val : i64 to i32
+      %c0 = arith.constant 0 : i32
+      %neg = arith.subi %c0, %t : i32
+      %pair = stream.pack %t, %neg : tuple<i32, i32>
+      stream.yield %sum, %pair : i64, tuple<i32, i32>
+    }
+    return %0, %1 : !stream.stream<i64>, !stream.stream<tuple<i32, i32>>
+  }
+}
@@ -0,0 +1,540 @@
+#!/usr/bin/env python3
+"""Generates a SystemVerilog testbench for the top handshake.func of a lowered
+stream program. Each input stream is driven from a binary trace file and each
+output stream is written to one, both memory-mapped by the DPI functions of
+driver.cpp. The trace files are passed as plusargs named after the data port
+of the stream, e.g., `+in0=input.bin +out0=output.bin`. See trace.py for the
+file format. With `--repeat in0=N`, the trace of an input is sent as N
+consecutive streams, e.g., to drive restartable programs.
+
+Memref arguments are modeled as memories that answer each request in the next
+cycle. A memory is initialized from the optional trace `+in0=init.bin` and its
+final contents are written to the optional trace `+in0_final=final.bin`. As
+stores do not signal the end of a program, the simulation ends once the input
+streams were sent, the output streams ended, and no memory was written for
+`DRAIN_CYCLES` cycles."""
+
+import argparse
+import re
+import sys
+
+
+class Int:
+
+  def __init__(self, width):
+    self.width = width
+
+
+class Tuple:
+
+  def __init__(self, fields):
+    self.fields = fields
+
+
+class NoneType:
+  pass
+
+
+class MemRef:
+
+  def __init__(self, size, elementType):
+    self.size = size
+    self.elementType = elementType
+
+
+def split_top_level(text):
+  """Splits a comma separated list, ignoring commas nested in brackets."""
+  items = []
+  depth = 0
+  start = 0
+  for i, c in enumerate(text):
+    if c in "<([{":
+      depth += 1
+    elif c in ">)]}":
+      depth -= 1
+    elif c == "," and depth == 0:
+      items.append(text[start:i].strip())
+      start = i + 1
+  if text[start:].strip():
+    items.append(text[start:].strip())
+  return items
+
+
+def parse_type(text):
+  text = text.strip()
+  if text == "none":
+    return NoneType()
+  if re.fullmatch(r"i\d+", text):
+    return Int(int(text[1:]))
+  if text.startswith("tuple<") and text.endswith(">"):
+    return Tuple([parse_type(field) for field in split_top_level(text[6:-1])])
+  match = re.fullmatch(r"memref<(\d+)x(i\d+)>", text)
+  if match:
+    return MemRef(int(match.group(1)), parse_type(match.group(2)))
+  raise ValueError(f"unsupported port type '{text}'")
+
+
+def parse_names(attrs, key, count, default):
+  match = re.search(key + r"\s*=\s*\[([^\]]*)\]", attrs or "")
+  if not match:
+    return default
+  names = [name.strip().strip('"') for name in split_top_level(match.group(1))]
+  if len(names) != count:
+    raise ValueError(f"expected {count} entries in '{key}'")
+  return names
+
+
+def parse_signature(text, top):
+  """Returns the names and types of the arguments and results of the top
+  function, and the SSA values of its arguments."""
+  match = re.search(
+      r"handshake\.func @" + re.escape(top) +
+      r"\((.*?)\)\s*->\s*(\([^)]*\)|[^\s{]+)(?:\s*attributes\s*(\{.*\}))?",
+      text)
+  if not match:
+    raise ValueError(f"could not find the handshake.func @{top}")
+
+  args = [
+      arg.split(":", 1)
+      for arg in split_top_level(match.group(1))
+      if arg != "..."
+  ]
+  argValues = [value.strip() for value, _ in args]
+  args = [type for _, type in args]
+  results = match.group(2)
+  if results.startswith("("):
+    results = results[1:-1]
+  results = split_top_level(results)
+
+  argTypes = [parse_type(arg) for arg in args]
+  resTypes = [parse_type(res) for res in results]
+  argNames = parse_names(match.group(3), "argNames", len(argTypes),
+                         [f"in{i}" for i in range(len(argTypes) - 1)] +
+                         ["inCtrl"])
+  resNames = parse_names(match.group(3), "resNames", len(resTypes),
+                         [f"out{i}" for i in range(len(resTypes) - 1)] +
+                         ["outCtrl"])
+  return (list(zip(argNames, argTypes)), list(zip(resNames, resTypes)),
+          argValues)
+
+
+def function_body(text, name):
+  """Returns the text of a handshake.func up to the next one."""
+  start = re.search(r"handshake\.func (?:private )?@" + re.escape(name) + r"\(",
+                    text)
+  if not start:
+    raise ValueError(f"could not find the handshake.func @{name}")
+  end = text.find("handshake.func", start.end())
+  return text[start.start():end if end >= 0 else len(text)]
+
+
+def memory_ports(text, top, value):
+  """Returns the number of load and store ports of the memref argument `value`
+  of the top function. The lowering passes each memref to the single instance
+  that accesses it, whose function holds the extmemory."""
+  for match in re.finditer(r"instance @([\w.$-]+)\(([^)]*)\)",
+                           function_body(text, top)):
+    operands = [operand.strip() for operand in match.group(2).split(",")]
+    if value not in operands:
+      continue
+    callee = function_body(text, match.group(1))
+    signature = re.search(r"\((.*?)\)\s*->", callee).group(1)
+    calleeArgs = [arg.split(":", 1)[0].strip()
+                  for arg in split_top_level(signature)
+                  if arg != "..."]
+    arg = calleeArgs[operands.index(value)]
+    extmem = re.search(
+        r"extmemory\[ld = (\d+), st = (\d+)\] \(" + re.escape(arg) + r"\b",
+        callee)
+    if not extmem:
+      raise ValueError(f"could not find the extmemory of '{value}'")
+    return int(extmem.group(1)), int(extmem.group(2))
+  return 0, 0
+
+
+def is_stream(ports, i):
+  """A stream is lowered to a tuple of the element and the EOS flag, followed
+  by a none-typed ctrl channel."""
+  if i + 1 >= len(ports):
+    return False
+  tupleType, ctrlType = ports[i][1], ports[i + 1][1]
+  return (isinstance(tupleType, Tuple) and len(tupleType.fields) == 2 and
+          isinstance(tupleType.fields[1], Int) and
+          tupleType.fields[1].width == 1 and isinstance(ctrlType, NoneType))
+
+
+def leaves(name, type):
+  """Returns the signals and widths of the flattened data of a channel."""
+  if isinstance(type, Int):
+    if type.width > 64:
+      raise ValueError(f"'{name}' is wider than the 64 bits of a trace word")
+    return [(name, type.width)]
+  if isinstance(type, Tuple):
+    result = []
+    for i, field in enumerate(type.fields):
+      result += leaves(f"{name}_field{i}", field)
+    return result
+  return []
+
+
+class Stream:
+
+  def __init__(self, data, ctrl, elementType):
+    self.data = data
+    self.ctrl = ctrl
+    self.fields = leaves(f"{data}_data_field0", elementType)
+    self.eos = f"{data}_data_field1"
+
+
+# Idle cycles after which the stores to the memories are considered done.
+DRAIN_CYCLES = 32
+
+
+class Memory:
+
+  def __init__(self, name, type, loads, stores):
+    self.name = name
+    self.size = type.size
+    self.width = type.elementType.width
+    # The ports follow the bundle of a memref that lower-handshake-to-firrtl
+    # derives from its extmemory.
+    self.loads = [f"{name}_ld{i}" for i in range(loads)]
+    self.stores = [f"{name}_st{i}" for i in range(stores)]
+
+
+def declare(out, ports):
+  for name, type in ports:
+    if isinstance(type, MemRef):
+      continue
+    out.write(f"  logic {name}_valid, {name}_ready;\n")
+    for signal, width in leaves(f"{name}_data", type):
+      out.write(f"  logic [{width - 1}:0] {signal};\n")
+
+
+def emit_input(out, stream, eosOnLast, repeat):
+  n = len(stream.fields)
+  d, c = stream.data, stream.ctrl
+  # Index of the transaction that carries EOS. With EOS on the last element,
+  # the flag is set on the last element of the trace instead of an additional
+  # transaction without data.
+  last = f"{d}_length - 1" if eosOnLast else f"{d}_length"
+  eos = ("flags its last element as EOS"
+         if eosOnLast else "appends the EOS transaction")
+  if repeat > 1:
+    eos += f".\n  // The stream is sent {repeat} times, each with its own EOS"
+  out.write(f"""
+  // Drives {d} and {c} from the trace and {eos}.
+  int {d}_trace;
+  longint {d}_length, {d}_total, {d}_idx, {d}_pos, {c}_idx;
+  assign {d}_total = {repeat} * ({last} + 1);
+  assign {d}_pos = {d}_idx % ({last} + 1);
+  initial begin
+    string path;
+    if (!$value$plusargs("{d}=%s", path))
+      $fatal(1, "missing trace for input stream {d}");
+    {d}_trace = trace_open_read(path);
+    {d}_length = trace_size({d}_trace) / {n};
+""")
+  if eosOnLast:
+    out.write(f"""    if ({d}_length == 0)
+      $fatal(1, "the trace of input stream {d} has no element to flag as EOS");
+""")
+  total = f"{d}_total"
+  out.write(f"""  end
+
+  always @(posedge clock) begin
+    if (reset == 1) begin
+      {d}_valid <= 0;
+      {d}_idx <= 0;
+    end
+    else if (!{d}_valid || {d}_ready) begin
+      {d}_valid <= ({d}_idx < {total});
+      if ({d}_idx < {total}) begin
+""")
+  for k, (signal, width) in enumerate(stream.fields):
+    read = f"trace_read({d}_trace, {d}_pos * {n} + {k})"
+    if not eosOnLast:
+      read = f"{d}_pos < {d}_length ? {read} : 0"
+    out.write(f"        {signal} <= {read};\n")
+  out.write(f"""        {stream.eos} <= {d}_pos == {last};
+        {d}_idx <= {d}_idx + 1;
+      end
+    end
+  end
+
+  always @(posedge clock) begin
+    if (reset == 1) begin
+      {c}_valid <= 0;
+      {c}_idx <= 0;
+    end
+    else if (!{c}_valid || {c}_ready) begin
+      {c}_valid <= ({c}_idx < {total});
+      if ({c}_idx < {total})
+        {c}_idx <= {c}_idx + 1;
+    end
+  end
+""")
+
+
+def emit_output(out, stream, eosOnLast):
+  d, c = stream.data, stream.ctrl
+  out.write(f"""
+  // Appends the elements of {d} to the trace, if one is provided.
+  int {d}_trace = -1;
+  longint {d}_count = 0;
+  logic {d}_done = 0;
+  assign {d}_ready = 1;
+  assign {c}_ready = 1;
+  initial begin
+    string path;
+    if ($value$plusargs("{d}=%s", path))
+      {d}_trace = trace_open_write(path);
+  end
+
+  always @(posedge clock) begin
+    if (reset == 0 && {d}_valid == 1 && !{d}_done) begin
+""")
+  cond = "1" if eosOnLast else f"{stream.eos} == 0"
+  out.write(f"      if ({cond}) begin\n")
+  for signal, width in stream.fields:
+    out.write(f"        trace_write({d}_trace, "
+              f"longint'($signed({signal})));\n")
+  out.write(f"""        {d}_count <= {d}_count + 1;
+      end
+      if ({stream.eos} == 1)
+        {d}_done <= 1;
+    end
+  end
+""")
+
+
+def emit_memory(out, mem):
+  w = mem.width
+  mw = f"{mem.name}_mem"
+  out.write(f"""
+  // Models the memory {mem.name} of {mem.size} elements.
+  // Each request is answered in the next cycle.
+  longint {mw} [{mem.size}];
+  int {mem.name}_final = -1;
+  longint {mem.name}_idle = 0;
+  initial begin
+    string path;
+    int trace;
+    for (int i = 0; i < {mem.size}; i++)
+      {mw}[i] = 0;
+    if ($value$plusargs("{mem.name}=%s", path)) begin
+      trace = trace_open_read(path);
+      if (trace_size(trace) > {mem.size})
+        $fatal(1, "the trace of memory {mem.name} exceeds its size");
+      for (longint i = 0; i < trace_size(trace); i++)
+        {mw}[i] = trace_read(trace, i);
+      trace_close(trace);
+    end
+    if ($value$plusargs("{mem.name}_final=%s", path))
+      {mem.name}_final = trace_open_write(path);
+  end
+""")
+  for p in mem.loads:
+    out.write(f"""
+  logic {p}_addr_valid, {p}_addr_ready, {p}_data_valid, {p}_data_ready;
+  logic [63:0] {p}_addr_data;
+  logic [{w - 1}:0] {p}_data_data;
+  assign {p}_addr_ready = !{p}_data_valid || {p}_data_ready;
+  always @(posedge clock) begin
+    if (reset == 1)
+      {p}_data_valid <= 0;
+    else if ({p}_addr_ready) begin
+      {p}_data_valid <= {p}_addr_valid;
+      if ({p}_addr_valid)
+        {p}_data_data <= {w}'({mw}[{p}_addr_data]);
+    end
+  end
+""")
+  for p in mem.stores:
+    out.write(f"""
+  logic {p}_addr_valid, {p}_addr_ready, {p}_data_valid, {p}_data_ready;
+  logic {p}_done_valid, {p}_done_ready, {p}_fire;
+  logic [63:0] {p}_addr_data;
+  logic [{w - 1}:0] {p}_data_data;
+  // The address and the data are accepted together
+  assign {p}_fire = {p}_addr_valid && {p}_data_valid &&
+      (!{p}_done_valid || {p}_done_ready);
+  assign {p}_addr_ready = {p}_fire;
+  assign {p}_data_ready = {p}_fire;
+  always @(posedge clock) begin
+    if (reset == 1)
+      {p}_done_valid <= 0;
+    else begin
+      if ({p}_fire)
+        {mw}[{p}_addr_data] <= longint'($signed({p}_data_data));
+      if (!{p}_done_valid || {p}_done_ready)
+        {p}_done_valid <= {p}_fire;
+    end
+  end
+""")
+  if mem.stores:
+    fire = " || ".join(f"{p}_fire" for p in mem.stores)
+    out.write(f"""
+  always @(posedge clock)
+    if (reset == 1 || {fire})
+      {mem.name}_idle <= 0;
+    else
+      {mem.name}_idle <= {mem.name}_idle + 1;
+""")
+
+
+def collect_channels(inputs, outputs):
+  """Groups the ports into streams and memories. The last argument and result
+  are the ctrl signals of the function."""
+  inStreams, outStreams, outValues, memories = [], [], [], []
+  i = 0
+  while i < len(inputs) - 1:
+    if isinstance(inputs[i][1], MemRef):
+      memories.append(i)
+      i += 1
+      continue
+    if not is_stream(inputs, i):
+      raise ValueError(f"cannot drive the input port '{inputs[i][0]}'")
+    inStreams.append(
+        Stream(inputs[i][0], inputs[i + 1][0], inputs[i][1].fields[0]))
+    i += 2
+  i = 0
+  while i < len(outputs) - 1:
+    if is_stream(outputs, i):
+      outStreams.append(
+          Stream(outputs[i][0], outputs[i + 1][0], outputs[i][1].fields[0]))
+      i += 2
+    elif isinstance(outputs[i][1], Int):
+      # Plain integers, like performance counters, are printed once.
+      outValues.append(outputs[i][0])
+      i += 1
+    else:
+      raise ValueError(f"cannot observe the output port '{outputs[i][0]}'")
+  return inStreams, outStreams, outValues, memories
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__)
+  parser.add_argument("input", help="MLIR file with the lowered handshake IR")
+  parser.add_argument("--top",
+                      default="top",
+                      help="name of the handshake.func to drive")
+  parser.add_argument("--eos-on-last",
+                      action="store_true",
+                      help="the last element of each stream carries EOS")
+  parser.add_argument("--repeat",
+                      action="append",
+                      default=[],
+                      metavar="PORT=N",
+                      help="send the stream of an input port N times, e.g., "
+                      "to drive restartable programs")
+  parser.add_argument("-o", "--output", help="output file, defaults to stdout")
+  args = parser.parse_args()
+
+  with open(args.input) as f:
+    text = f.read()
+  try:
+    inputs, outputs, argValues = parse_signature(text, args.top)
+    inStreams, outStreams, outValues, memIdxs = collect_channels(
+        inputs, outputs)
+    memories = [
+        Memory(inputs[i][0], inputs[i][1],
+               *memory_ports(text, args.top, argValues[i])) for i in memIdxs
+    ]
+    if not outStreams and not any(mem.stores for mem in memories):
+      raise ValueError("expected an output stream or a memory that is "
+                       "written")
+    repeats = {}
+    for entry in args.repeat:
+      name, sep, count = entry.partition("=")
+      if not sep or not count.isdigit() or int(count) < 1:
+        raise ValueError(f"expected PORT=N with N > 0, got '{entry}'")
+      if name not in [s.data for s in inStreams]:
+        raise ValueError(f"'{name}' is not an input stream")
+      repeats[name] = int(count)
+  except ValueError as e:
+    sys.exit(f"error: {e}")
+
+  out = open(args.output, "w") if args.output else sys.stdout
+  out.write(
+      "// Generated by generate-driver.py, do not edit.\n"
+      "import \"DPI-C\" function int trace_open_read(input string path);\n"
+      "import \"DPI-C\" function int trace_open_write(input string path);\n"
+      "import \"DPI-C\" function longint trace_size(input int trace);\n"
+      "import \"DPI-C\" function longint trace_read(input int trace, "
+      "input longint idx);\n"
+      "import \"DPI-C\" function void trace_write(input int trace, "
+      "input longint word);\n"
+      "import \"DPI-C\" function void trace_close(input int trace);\n"
+      "\n"
+      "module driver(\n"
+      "  input clock,\n"
+      "  input reset\n"
+      ");\n")
+  declare(out, inputs)
+  declare(out, outputs)
+  inCtrl, outCtrl = inputs[-1][0], outputs[-1][0]
+  out.write(f"""
+  {args.top} dut (.*);
+
+  // Cycles since reset was released.
+  longint cycle = 0;
+
+  // The function is started exactly once.
+  always @(posedge clock) begin
+    if (reset == 1)
+      {inCtrl}_valid <= 1;
+    else if ({inCtrl}_ready)
+      {inCtrl}_valid <= 0;
+  end
+  assign {outCtrl}_ready = 1;
+""")
+  for name in outValues:
+    out.write(f"""
+  assign {name}_ready = 1;
+  always @(posedge clock)
+    if (reset == 0 && {name}_valid == 1)
+      $display("{name}=%0d", {name}_data);
+""")
+  for stream in inStreams:
+    emit_input(out, stream, args.eos_on_last, repeats.get(stream.data, 1))
+  for stream in outStreams:
+    emit_output(out, stream, args.eos_on_last)
+  for mem in memories:
+    emit_memory(out, mem)
+
+  # Stores do not signal that they are done, so the memories have to be idle
+  # for a while after the inputs were sent
+  done = [f"{s.data}_done" for s in outStreams]
+  if any(mem.stores for mem in memories):
+    done += [
+        f"{s.data}_idx == {s.data}_total" for s in inStreams
+    ] + [
+        f"{mem.name}_idle >= {DRAIN_CYCLES}" for mem in memories if mem.stores
+    ]
+  done = " && ".join(done)
+  out.write(f"""
+  always @(posedge clock) begin
+    if (reset == 0) begin
+      cycle <= cycle + 1;
+      if ({done}) begin
+""")
+  for stream in outStreams:
+    out.write(f"        $display(\"{stream.data}: Count=%0d\", "
+              f"{stream.data}_count);\n")
+  out.write("        $display(\"Cycles=%0d\", cycle);\n")
+  for mem in memories:
+    out.write(f"        for (int i = 0; i < {mem.size}; i++)\n"
+              f"          trace_write({mem.name}_final, {mem.name}_mem[i]);\n"
+              f"        trace_close({mem.name}_final);\n")
+  for stream in inStreams + outStreams:
+    out.write(f"        trace_close({stream.data}_trace);\n")
+  out.write("        $finish();\n"
+            "      end\n"
+            "    end\n"
+            "  end\n"
+            "endmodule // driver\n")
+
+
+if __name__ == "__main__":
+  main()
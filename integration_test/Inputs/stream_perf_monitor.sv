@@ -0,0 +1,81 @@
+// Performance monitor of a stream, instantiated by the `perf-counters` option
+// of `--convert-stream-to-handshake`. The ctrl channel of the stream is passed
+// through, such that the monitor observes the valid signal of the producer and
+// the ready signal of the consumers. `in0` carries the EOS flag of each
+// transaction.
+//
+// Once the EOS transaction is transferred, the monitor emits
+//  - `active`: the cycles from the first valid transaction up to and including
+//    the EOS transaction, and
+//  - `stalled`: the cycles in which a transaction was valid but not ready.
+// Afterwards, the counters are reset for the next stream.
+module stream_perf_monitor(
+  input         in0_valid,
+  output        in0_ready,
+  input         in0_data,
+  input         inCtrl_valid,
+  output        inCtrl_ready,
+  output        active_valid,
+  input         active_ready,
+  output [63:0] active_data,
+  output        stalled_valid,
+  input         stalled_ready,
+  output [63:0] stalled_data,
+  output        outCtrl_valid,
+  input         outCtrl_ready,
+  input         clock,
+  input         reset
+);
+  logic running;
+  logic [63:0] activeCnt, stalledCnt;
+  logic activeValid, stalledValid;
+  logic [63:0] activeData, stalledData;
+
+  // The EOS transaction waits until the counts of the previous stream have
+  // been consumed.
+  wire blocked = in0_data && (activeValid || stalledValid);
+  wire valid = in0_valid && inCtrl_valid;
+  wire fire = valid && !blocked && outCtrl_ready;
+
+  assign in0_ready = fire;
+  assign inCtrl_ready = fire;
+  assign outCtrl_valid = valid && !blocked;
+  assign active_valid = activeValid;
+  assign active_data = activeData;
+  assign stalled_valid = stalledValid;
+  assign stalled_data = stalledData;
+
+  always @(posedge clock) begin
+    if (reset) begin
+      running <= 0;
+      activeCnt <= 0;
+      stalledCnt <= 0;
+      activeValid <= 0;
+      stalledValid <= 0;
+    end
+    else begin
+      if (activeValid && active_ready)
+        activeValid <= 0;
+      if (stalledValid && stalled_ready)
+        stalledValid <= 0;
+
+      if (fire && in0_data) begin
+        activeData <= activeCnt + 1;
+        stalledData <= stalledCnt;
+        activeValid <= 1;
+        stalledValid <= 1;
+        running <= 0;
+        activeCnt <= 0;
+        stalledCnt <= 0;
+      end
+      else begin
+        if (valid)
+          running <= 1;
+        if (valid || running)
+          activeCnt <= activeCnt + 1;
+        if (valid && !fire)
+          stalledCnt <= stalledCnt + 1;
+      end
+    end
+  end
+endmodule
@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+"""Creates and prints the binary trace files of the generated testbenches.
+
+A trace holds the elements of a stream one after another. Each integer of an
+element, i.e., each field of a flattened tuple, is stored as a signed 64-bit
+little-endian word. The end of the file marks the end of the stream.
+
+  trace.py encode out.bin [--fields N] < values.txt
+  trace.py iota out.bin --count N [--start S] [--step S]
+  trace.py decode in.bin [--fields N] [--count-only]
+
+`encode` reads one element per line, with the fields separated by spaces.
+`decode` prints the elements in the format of stream-run."""
+
+import argparse
+import struct
+import sys
+
+
+def to_word(value):
+  # Unsigned values are reinterpreted, such that all 64-bit patterns can be
+  # written.
+  return struct.pack("<q", value - (1 << 64) if value >= (1 << 63) else value)
+
+
+def encode(args):
+  with open(args.output, "wb") as out:
+    for line in sys.stdin:
+      values = [int(value, 0) for value in line.split()]
+      if not values:
+        continue
+      if len(values) != args.fields:
+        sys.exit(f"error: expected {args.fields} fields, got '{line.strip()}'")
+      out.write(b"".join(to_word(value) for value in values))
+
+
+def iota(args):
+  # The elements are written in chunks to keep large traces fast.
+  chunk = 1 << 16
+  with open(args.output, "wb") as out:
+    for first in range(0, args.count, chunk):
+      last = min(first + chunk, args.count)
+      out.write(
+          struct.pack(f"<{last - first}q",
+                      *(args.start + i * args.step for i in range(first, last))))
+
+
+def decode(args):
+  with open(args.input, "rb") as f:
+    data = f.read()
+  size = 8 * args.fields
+  if len(data) % size != 0:
+    sys.exit("error: the trace does not hold a whole number of elements")
+  count = len(data) // size
+  if not args.count_only:
+    out = sys.stdout
+    for idx in range(count):
+      values = struct.unpack_from(f"<{args.fields}q", data, idx * size)
+      if args.fields == 1:
+        out.write(f"Element={values[0]}\n")
+      else:
+        out.write(f"Element=({', '.join(str(v) for v in values)})\n")
+    out.write("EOS\n")
+  print(f"Count={count}")
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+  commands = parser.add_subparsers(dest="command", required=True)
+
+  encodeParser = commands.add_parser("encode", help="write values from stdin")
+  encodeParser.add_argument("output")
+  encodeParser.add_argument("--fields", type=int, default=1)
+  encodeParser.set_defaults(run=encode)
+
+  iotaParser = commands.add_parser("iota", help="write a sequence")
+  iotaParser.add_argument("output")
+  iotaParser.add_argument("--count", type=int, required=True)
+  iotaParser.add_argument("--start", type=int, default=0)
+  iotaParser.add_argument("--step", type=int, default=1)
+  iotaParser.set_defaults(run=iota)
+
+  decodeParser = commands.add_parser("decode", help="print a trace")
+  decodeParser.add_argument("input")
+  decodeParser.add_argument("--fields", type=int, default=1)
+  decodeParser.add_argument("--count-only", action="store_true")
+  decodeParser.set_defaults(run=decode)
+
+  args = parser.parse_args()
+  args.run(args)
+
+
+if __name__ == "__main__":
+  main()
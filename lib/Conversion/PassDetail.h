@@ -36,6 +36,10 @@ class FuncOp;
 namespace memref {
 class MemRefDialect;
 }
+
+namespace LLVM {
+class LLVMDialect;
+}
 }  // namespace mlir
 
 namespace circt {
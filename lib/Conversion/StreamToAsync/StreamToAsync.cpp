@@ -0,0 +1,768 @@
+//===- StreamToAsync.cpp - Lower streams to CPU tasks -----------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Lowers each stream operation of a function to a task that runs on its own
+// thread. The tasks are connected by the channels of the stream runtime, see
+// `circt-stream/Runtime/StreamRuntime.h`, which transfer the elements in
+// batches through bounded lock-free single-producer single-consumer queues.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt-stream/Conversion/StreamToAsync.h"
+#include "../PassDetail.h"
+#include "circt-stream/Dialect/Stream/StreamDialect.h"
+#include "circt-stream/Dialect/Stream/StreamOps.h"
+#include "circt-stream/Dialect/Stream/StreamTypes.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/ControlFlow/IR/ControlFlowOps.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/Dialect/SCF/SCF.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/RegionGraphTraits.h"
+#include "mlir/IR/SymbolTable.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/TypeSwitch.h"
+
+using namespace mlir;
+using namespace circt_stream;
+using namespace circt_stream::stream;
+
+/// Appends the integers an element of the provided type consists of, in the
+/// order of a depth-first traversal of its tuples. Each of them is
+/// transferred as one word by the runtime.
+static void appendLeafTypes(Type type, SmallVectorImpl<Type> &leaves) {
+  if (auto tupleType = type.dyn_cast<TupleType>()) {
+    for (Type fieldType : tupleType.getTypes())
+      appendLeafTypes(fieldType, leaves);
+    return;
+  }
+  leaves.push_back(type);
+}
+
+static SmallVector<Type> getLeafTypes(Type type) {
+  SmallVector<Type> leaves;
+  appendLeafTypes(type, leaves);
+  return leaves;
+}
+
+static Type getElementType(Value stream) {
+  return stream.getType().cast<StreamType>().getElementType();
+}
+
+static LogicalResult verifyElementType(Operation *op, Type elementType) {
+  SmallVector<Type> leaves = getLeafTypes(elementType);
+  if (leaves.empty())
+    return op->emitError("cannot lower streams of empty tuples to tasks");
+  for (Type leaf : leaves) {
+    auto intType = leaf.dyn_cast<IntegerType>();
+    if (!intType || intType.getWidth() > 64)
+      return op->emitError("expect stream elements to consist of integers of "
+                           "at most 64 bits, got ")
+             << elementType;
+  }
+  return success();
+}
+
+/// Operations of regions whose tuples are replaced by the integers they
+/// consist of.
+static bool handlesTuples(Operation *op) {
+  return isa<PackOp, UnpackOp, YieldOp, cf::BranchOp, cf::CondBranchOp,
+             arith::SelectOp>(op);
+}
+
+static LogicalResult verifySupported(Operation &op) {
+  if (!isa<CreateOp, IotaOp, MapOp, FilterOp, ReduceOp, SplitOp, CombineOp,
+           stream::BufferOp, TakeOp, TakeWhileOp, SinkOp>(op))
+    return op.emitError("cannot lower operation ")
+           << op.getName() << " to tasks";
+
+  for (Value operand : op.getOperands())
+    if (failed(verifyElementType(&op, getElementType(operand))))
+      return failure();
+  for (Value result : op.getResults())
+    if (failed(verifyElementType(&op, getElementType(result))))
+      return failure();
+
+  auto isTuple = [](Type type) { return type.isa<TupleType>(); };
+  WalkResult walkResult = op.walk([&](Operation *inner) {
+    if (inner == &op || handlesTuples(inner))
+      return WalkResult::advance();
+    if (llvm::any_of(inner->getOperandTypes(), isTuple) ||
+        llvm::any_of(inner->getResultTypes(), isTuple)) {
+      inner->emitError("cannot lower tuples of operation ")
+          << inner->getName() << " to tasks";
+      return WalkResult::interrupt();
+    }
+    return WalkResult::advance();
+  });
+  return failure(walkResult.wasInterrupted());
+}
+
+namespace {
+/// Clones the region of a stream operation into an `scf.execute_region`,
+/// with each tuple replaced by the integers it consists of, as the tasks
+/// only exchange integers.
+class RegionFlattener {
+public:
+  RegionFlattener(MLIRContext *ctx, Location loc) : builder(ctx), loc(loc) {}
+
+  /// Executes the region on the integers of its arguments, at the insertion
+  /// point of `b`. Returns the integers of the yielded values.
+  SmallVector<Value> build(Region &region, ValueRange args, OpBuilder &b);
+
+private:
+  SmallVector<Value> lookup(ValueRange values);
+  /// Maps `value` to the first integers of `leaves` and drops them.
+  void map(Value value, ArrayRef<Value> &leaves);
+  void flatten(Operation &op);
+
+  OpBuilder builder;
+  Location loc;
+  BlockAndValueMapping mapping;
+  DenseMap<Value, SmallVector<Value>> tupleLeaves;
+  DenseMap<Block *, Block *> blocks;
+};
+} // namespace
+
+SmallVector<Value> RegionFlattener::lookup(ValueRange values) {
+  SmallVector<Value> leaves;
+  for (Value value : values) {
+    if (value.getType().isa<TupleType>())
+      llvm::append_range(leaves, tupleLeaves.find(value)->second);
+    else
+      leaves.push_back(mapping.lookup(value));
+  }
+  return leaves;
+}
+
+void RegionFlattener::map(Value value, ArrayRef<Value> &leaves) {
+  size_t numLeaves = getLeafTypes(value.getType()).size();
+  if (value.getType().isa<TupleType>())
+    tupleLeaves[value] = llvm::to_vector(leaves.take_front(numLeaves));
+  else
+    mapping.map(value, leaves.front());
+  leaves = leaves.drop_front(numLeaves);
+}
+
+SmallVector<Value> RegionFlattener::build(Region &region, ValueRange args,
+                                          OpBuilder &b) {
+  // All yields have the same types, as the operation verifies them.
+  SmallVector<Type> resultTypes;
+  for (Block &block : region)
+    if (auto yieldOp = dyn_cast<YieldOp>(block.getTerminator())) {
+      for (Type type : yieldOp.results().getTypes())
+        appendLeafTypes(type, resultTypes);
+      break;
+    }
+
+  auto executeOp = b.create<scf::ExecuteRegionOp>(loc, resultTypes);
+  Region &body = executeOp.getRegion();
+  Block *entry = new Block();
+  body.push_back(entry);
+
+  // The blocks are visited in reverse post-order, such that each value is
+  // cloned before its uses.
+  llvm::ReversePostOrderTraversal<Block *> rpo(&region.front());
+  SmallVector<Block *> order(rpo.begin(), rpo.end());
+  for (Block *block : order) {
+    Block *newBlock = new Block();
+    body.push_back(newBlock);
+    blocks[block] = newBlock;
+    for (BlockArgument arg : block->getArguments())
+      for (Type type : getLeafTypes(arg.getType()))
+        newBlock->addArgument(type, arg.getLoc());
+    SmallVector<Value> newArgs(newBlock->getArguments().begin(),
+                               newBlock->getArguments().end());
+    ArrayRef<Value> leaves = newArgs;
+    for (BlockArgument arg : block->getArguments())
+      map(arg, leaves);
+  }
+
+  builder.setInsertionPointToEnd(entry);
+  builder.create<cf::BranchOp>(loc, blocks[&region.front()], args);
+  for (Block *block : order) {
+    builder.setInsertionPointToEnd(blocks[block]);
+    for (Operation &op : *block)
+      flatten(op);
+  }
+  return llvm::to_vector(executeOp.getResults());
+}
+
+void RegionFlattener::flatten(Operation &op) {
+  TypeSwitch<Operation *>(&op)
+      .Case<PackOp>([&](PackOp packOp) {
+        tupleLeaves[packOp.result()] = lookup(packOp.inputs());
+      })
+      .Case<UnpackOp>([&](UnpackOp unpackOp) {
+        SmallVector<Value> inputLeaves = lookup(unpackOp.input());
+        ArrayRef<Value> leaves = inputLeaves;
+        for (Value result : unpackOp.results())
+          map(result, leaves);
+      })
+      .Case<YieldOp>([&](YieldOp yieldOp) {
+        builder.create<scf::YieldOp>(loc, lookup(yieldOp.results()));
+      })
+      .Case<cf::BranchOp>([&](cf::BranchOp brOp) {
+        builder.create<cf::BranchOp>(loc, blocks[brOp.getDest()],
+                                     lookup(brOp.getDestOperands()));
+      })
+      .Case<cf::CondBranchOp>([&](cf::CondBranchOp condBrOp) {
+        builder.create<cf::CondBranchOp>(
+            loc, mapping.lookup(condBrOp.getCondition()),
+            blocks[condBrOp.getTrueDest()],
+            lookup(condBrOp.getTrueOperands()),
+            blocks[condBrOp.getFalseDest()],
+            lookup(condBrOp.getFalseOperands()));
+      })
+      .Case<arith::SelectOp>([&](arith::SelectOp selectOp) {
+        if (!selectOp.getType().isa<TupleType>()) {
+          builder.clone(op, mapping);
+          return;
+        }
+        // A tuple is selected integer by integer.
+        Value cond = mapping.lookup(selectOp->getOperand(0));
+        SmallVector<Value> trueLeaves = lookup(selectOp->getOperand(1));
+        SmallVector<Value> falseLeaves = lookup(selectOp->getOperand(2));
+        SmallVector<Value> &leaves = tupleLeaves[selectOp.getResult()];
+        for (auto it : llvm::zip(trueLeaves, falseLeaves))
+          leaves.push_back(builder.create<arith::SelectOp>(
+              loc, cond, std::get<0>(it), std::get<1>(it)));
+      })
+      .Default([&](Operation *other) { builder.clone(*other, mapping); });
+}
+
+namespace {
+/// Lowers the stream operations of functions to tasks that call the stream
+/// runtime.
+class TaskLowering {
+public:
+  TaskLowering(ModuleOp module, int64_t batchSize, int64_t queueDepth)
+      : module(module), symbolTable(module), batchSize(batchSize),
+        queueDepth(queueDepth),
+        ptrType(LLVM::LLVMPointerType::get(
+            IntegerType::get(module.getContext(), 8))) {}
+
+  LogicalResult lowerFunction(func::FuncOp funcOp);
+
+private:
+  /// Calls the runtime function with the provided name. Its declaration is
+  /// inserted on the first call. Returns the result, if any.
+  Value call(OpBuilder &b, Location loc, StringRef name, TypeRange results,
+             ValueRange operands);
+  Value buildI64(OpBuilder &b, Location loc, int64_t value);
+
+  Value createChannel(OpBuilder &b, Location loc, Type elementType);
+  void push(OpBuilder &b, Location loc, ArrayRef<Value> channels,
+            ValueRange leaves);
+  SmallVector<Value> read(OpBuilder &b, Location loc, Value channel,
+                          Type elementType);
+  void close(OpBuilder &b, Location loc, ArrayRef<Value> channels);
+  void buildDrain(OpBuilder &b, Location loc, Value channel);
+  SmallVector<Value> buildElementLoop(
+      OpBuilder &b, Location loc, ArrayRef<Value> inputs,
+      ArrayRef<Type> elementTypes, ValueRange inits,
+      function_ref<SmallVector<Value>(ValueRange, ValueRange)> bodyFn);
+
+  /// Creates a task function, whose body receives the channels of the task,
+  /// and a spawn of it in front of the insertion point of `b`.
+  void buildTask(OpBuilder &b, func::FuncOp parent, Location loc,
+                 ArrayRef<Value> inputs, ArrayRef<SmallVector<Value>> outputs,
+                 function_ref<void(OpBuilder &, ArrayRef<Value>,
+                                   ArrayRef<SmallVector<Value>>)>
+                     bodyFn);
+  void buildOpTask(Operation &op, OpBuilder &b, ArrayRef<Value> inputs,
+                   ArrayRef<SmallVector<Value>> outputs);
+
+  ModuleOp module;
+  SymbolTable symbolTable;
+  int64_t batchSize;
+  int64_t queueDepth;
+  Type ptrType;
+  unsigned numTasks = 0;
+};
+} // namespace
+
+Value TaskLowering::call(OpBuilder &b, Location loc, StringRef name,
+                         TypeRange results, ValueRange operands) {
+  auto callee = symbolTable.lookup<func::FuncOp>(name);
+  if (!callee) {
+    callee = func::FuncOp::create(
+        loc, name, b.getFunctionType(operands.getTypes(), results));
+    callee.setPrivate();
+    symbolTable.insert(callee, module.getBody()->begin());
+  }
+  auto callOp = b.create<func::CallOp>(loc, callee, operands);
+  return results.empty() ? Value() : callOp.getResult(0);
+}
+
+Value TaskLowering::buildI64(OpBuilder &b, Location loc, int64_t value) {
+  return b.create<arith::ConstantOp>(loc, b.getI64IntegerAttr(value));
+}
+
+Value TaskLowering::createChannel(OpBuilder &b, Location loc,
+                                  Type elementType) {
+  int64_t words = getLeafTypes(elementType).size();
+  return call(b, loc, "stream_rt_channel_create", ptrType,
+              {buildI64(b, loc, words), buildI64(b, loc, queueDepth),
+               buildI64(b, loc, batchSize)});
+}
+
+void TaskLowering::push(OpBuilder &b, Location loc, ArrayRef<Value> channels,
+                        ValueRange leaves) {
+  Type i64Type = b.getI64Type();
+  SmallVector<Value> words;
+  for (Value leaf : leaves)
+    words.push_back(leaf.getType() == i64Type
+                        ? leaf
+                        : b.create<arith::ExtUIOp>(loc, i64Type, leaf));
+  for (Value channel : channels)
+    for (Value word : words)
+      call(b, loc, "stream_rt_push", {}, {channel, word});
+}
+
+SmallVector<Value> TaskLowering::read(OpBuilder &b, Location loc,
+                                      Value channel, Type elementType) {
+  Type i64Type = b.getI64Type();
+  SmallVector<Value> leaves;
+  for (auto it : llvm::enumerate(getLeafTypes(elementType))) {
+    Value word = call(b, loc, "stream_rt_value", i64Type,
+                      {channel, buildI64(b, loc, it.index())});
+    if (it.value() != i64Type)
+      word = b.create<arith::TruncIOp>(loc, it.value(), word);
+    leaves.push_back(word);
+  }
+  return leaves;
+}
+
+void TaskLowering::close(OpBuilder &b, Location loc,
+                         ArrayRef<Value> channels) {
+  for (Value channel : channels)
+    call(b, loc, "stream_rt_close", {}, channel);
+}
+
+void TaskLowering::buildDrain(OpBuilder &b, Location loc, Value channel) {
+  auto whileOp = b.create<scf::WhileOp>(loc, TypeRange(), ValueRange());
+  OpBuilder::InsertionGuard guard(b);
+  b.createBlock(&whileOp.getBefore());
+  Value more = call(b, loc, "stream_rt_next", b.getI1Type(), channel);
+  b.create<scf::ConditionOp>(loc, more, ValueRange());
+  b.createBlock(&whileOp.getAfter());
+  b.create<scf::YieldOp>(loc);
+}
+
+/// Builds a loop that receives an element of each input per iteration until
+/// one of them ends. `bodyFn` is called with the integers of the elements and
+/// the iteration arguments and returns the next iteration arguments. The
+/// remaining elements of the other inputs are drained afterwards, such that
+/// their producers do not block forever. Returns the final iteration
+/// arguments.
+SmallVector<Value> TaskLowering::buildElementLoop(
+    OpBuilder &b, Location loc, ArrayRef<Value> inputs,
+    ArrayRef<Type> elementTypes, ValueRange inits,
+    function_ref<SmallVector<Value>(ValueRange, ValueRange)> bodyFn) {
+  Type i1Type = b.getI1Type();
+  SmallVector<Type> types(inits.getTypes());
+  // The loop additionally returns which inputs have not ended yet.
+  SmallVector<Type> resultTypes(types);
+  resultTypes.append(inputs.size(), i1Type);
+  auto whileOp = b.create<scf::WhileOp>(loc, resultTypes, inits);
+
+  {
+    OpBuilder::InsertionGuard guard(b);
+    Block *before = b.createBlock(&whileOp.getBefore(), {}, types,
+                                  SmallVector<Location>(types.size(), loc));
+    SmallVector<Value> condArgs(before->getArguments().begin(),
+                                before->getArguments().end());
+    Value cond;
+    for (Value input : inputs) {
+      Value more = call(b, loc, "stream_rt_next", i1Type, input);
+      condArgs.push_back(more);
+      cond = cond ? b.create<arith::AndIOp>(loc, cond, more) : more;
+    }
+    b.create<scf::ConditionOp>(loc, cond, condArgs);
+
+    Block *after =
+        b.createBlock(&whileOp.getAfter(), {}, resultTypes,
+                      SmallVector<Location>(resultTypes.size(), loc));
+    SmallVector<Value> leaves;
+    for (auto it : llvm::zip(inputs, elementTypes))
+      llvm::append_range(
+          leaves, read(b, loc, std::get<0>(it), std::get<1>(it)));
+    SmallVector<Value> next =
+        bodyFn(leaves, after->getArguments().take_front(types.size()));
+    b.create<scf::YieldOp>(loc, next);
+  }
+
+  // Inputs that ended are destroyed and must not be drained.
+  if (inputs.size() > 1) {
+    for (auto it : llvm::enumerate(inputs)) {
+      Value more = whileOp.getResult(types.size() + it.index());
+      auto ifOp = b.create<scf::IfOp>(loc, TypeRange(), more,
+                                      /*withElseRegion=*/false);
+      OpBuilder::InsertionGuard guard(b);
+      b.setInsertionPointToStart(ifOp.thenBlock());
+      buildDrain(b, loc, it.value());
+    }
+  }
+  return llvm::to_vector(whileOp.getResults().take_front(types.size()));
+}
+
+void TaskLowering::buildTask(
+    OpBuilder &b, func::FuncOp parent, Location loc, ArrayRef<Value> inputs,
+    ArrayRef<SmallVector<Value>> outputs,
+    function_ref<void(OpBuilder &, ArrayRef<Value>,
+                      ArrayRef<SmallVector<Value>>)>
+        bodyFn) {
+  auto taskType = b.getFunctionType(ptrType, {});
+  auto task = func::FuncOp::create(
+      loc, (parent.getName() + "_task" + Twine(numTasks++)).str(), taskType);
+  task.setPrivate();
+  symbolTable.insert(task, Block::iterator(parent));
+
+  // The task receives its channels in the order they are added below.
+  OpBuilder taskBuilder(task.getContext());
+  Block *entry = task.addEntryBlock();
+  taskBuilder.setInsertionPointToEnd(entry);
+  Value taskArg = entry->getArgument(0);
+  unsigned idx = 0;
+  auto getChannel = [&]() {
+    return call(taskBuilder, loc, "stream_rt_task_channel", ptrType,
+                {taskArg, buildI64(taskBuilder, loc, idx++)});
+  };
+  SmallVector<Value> taskInputs;
+  for (size_t i = 0, e = inputs.size(); i < e; ++i)
+    taskInputs.push_back(getChannel());
+  SmallVector<SmallVector<Value>> taskOutputs;
+  for (ArrayRef<Value> channels : outputs) {
+    taskOutputs.emplace_back();
+    for (size_t i = 0, e = channels.size(); i < e; ++i)
+      taskOutputs.back().push_back(getChannel());
+  }
+  bodyFn(taskBuilder, taskInputs, taskOutputs);
+  for (ArrayRef<Value> channels : taskOutputs)
+    close(taskBuilder, loc, channels);
+  taskBuilder.create<func::ReturnOp>(loc);
+
+  Value fn = b.create<func::ConstantOp>(
+      loc, taskType, FlatSymbolRefAttr::get(task.getNameAttr()));
+  Value handle = call(b, loc, "stream_rt_task_create", ptrType, fn);
+  for (Value channel : inputs)
+    call(b, loc, "stream_rt_task_add_channel", {}, {handle, channel});
+  for (ArrayRef<Value> channels : outputs)
+    for (Value channel : channels)
+      call(b, loc, "stream_rt_task_add_channel", {}, {handle, channel});
+  call(b, loc, "stream_rt_task_start", {}, handle);
+}
+
+/// Builds the integers of the initial value of a reduction.
+static void buildInitLeaves(OpBuilder &b, Location loc, Attribute attr,
+                            Type type, SmallVectorImpl<Value> &leaves) {
+  if (auto tupleType = type.dyn_cast<TupleType>()) {
+    for (auto it : llvm::zip(attr.cast<ArrayAttr>(), tupleType.getTypes()))
+      buildInitLeaves(b, loc, std::get<0>(it), std::get<1>(it), leaves);
+    return;
+  }
+  APInt value = attr.cast<IntegerAttr>().getValue().sextOrTrunc(
+      type.getIntOrFloatBitWidth());
+  leaves.push_back(
+      b.create<arith::ConstantOp>(loc, b.getIntegerAttr(type, value)));
+}
+
+void TaskLowering::buildOpTask(Operation &op, OpBuilder &b,
+                               ArrayRef<Value> inputs,
+                               ArrayRef<SmallVector<Value>> outputs) {
+  Location loc = op.getLoc();
+  Type i64Type = b.getI64Type();
+  RegionFlattener flattener(op.getContext(), loc);
+  auto evaluate = [&](ValueRange args) {
+    return flattener.build(op.getRegion(0), args, b);
+  };
+  auto loop = [&](ValueRange inits,
+                  function_ref<SmallVector<Value>(ValueRange, ValueRange)>
+                      bodyFn) {
+    SmallVector<Type> elementTypes;
+    for (Value operand : op.getOperands())
+      elementTypes.push_back(getElementType(operand));
+    return buildElementLoop(b, loc, inputs, elementTypes, inits, bodyFn);
+  };
+
+  TypeSwitch<Operation *>(&op)
+      .Case<CreateOp>([&](CreateOp createOp) {
+        auto values = createOp.values();
+        int64_t numElements = values.getNumElements();
+        if (numElements == 0)
+          return;
+        // The elements are stored in a constant global, such that the code
+        // does not grow with the number of elements.
+        Type elementType = createOp.getElementType();
+        auto memrefType = MemRefType::get({numElements}, elementType);
+        auto initValue = DenseIntElementsAttr::get(
+            RankedTensorType::get({numElements}, elementType),
+            llvm::to_vector(values.getValues<APInt>()));
+        OpBuilder globalBuilder(op.getContext());
+        auto global = globalBuilder.create<memref::GlobalOp>(
+            loc, "stream_values", globalBuilder.getStringAttr("private"),
+            memrefType, initValue, /*constant=*/true,
+            /*alignment=*/IntegerAttr());
+        StringAttr name = symbolTable.insert(global, module.getBody()->begin());
+
+        Value memref = b.create<memref::GetGlobalOp>(loc, memrefType, name);
+        auto forOp = b.create<scf::ForOp>(
+            loc, b.create<arith::ConstantIndexOp>(loc, 0),
+            b.create<arith::ConstantIndexOp>(loc, numElements),
+            b.create<arith::ConstantIndexOp>(loc, 1));
+        OpBuilder::InsertionGuard guard(b);
+        b.setInsertionPointToStart(forOp.getBody());
+        Value element = b.create<memref::LoadOp>(loc, memref,
+                                                 forOp.getInductionVar());
+        push(b, loc, outputs[0], element);
+      })
+      .Case<IotaOp>([&](IotaOp iotaOp) {
+        auto forOp = b.create<scf::ForOp>(
+            loc, b.create<arith::ConstantIndexOp>(loc, 0),
+            b.create<arith::ConstantIndexOp>(loc, iotaOp.count()),
+            b.create<arith::ConstantIndexOp>(loc, 1));
+        Value start = buildI64(b, loc, iotaOp.start());
+        Value step = buildI64(b, loc, iotaOp.step());
+        OpBuilder::InsertionGuard guard(b);
+        b.setInsertionPointToStart(forOp.getBody());
+        // Only the low bits of a word are defined, so the element is not
+        // truncated to its width.
+        Value idx = b.create<arith::IndexCastOp>(loc, i64Type,
+                                                 forOp.getInductionVar());
+        Value offset = b.create<arith::MulIOp>(loc, idx, step);
+        push(b, loc, outputs[0],
+             b.create<arith::AddIOp>(loc, start, offset).getResult());
+      })
+      .Case<MapOp, CombineOp>([&](auto) {
+        loop({}, [&](ValueRange leaves, ValueRange) {
+          push(b, loc, outputs[0], evaluate(leaves));
+          return SmallVector<Value>();
+        });
+      })
+      .Case<FilterOp>([&](auto) {
+        loop({}, [&](ValueRange leaves, ValueRange) {
+          Value cond = evaluate(leaves).front();
+          auto ifOp = b.create<scf::IfOp>(loc, TypeRange(), cond,
+                                          /*withElseRegion=*/false);
+          OpBuilder::InsertionGuard guard(b);
+          b.setInsertionPointToStart(ifOp.thenBlock());
+          push(b, loc, outputs[0], leaves);
+          return SmallVector<Value>();
+        });
+      })
+      .Case<SplitOp>([&](SplitOp splitOp) {
+        loop({}, [&](ValueRange leaves, ValueRange) {
+          SmallVector<Value> results = evaluate(leaves);
+          ArrayRef<Value> remaining = results;
+          for (auto it : llvm::zip(splitOp.results(), outputs)) {
+            size_t n = getLeafTypes(getElementType(std::get<0>(it))).size();
+            push(b, loc, std::get<1>(it), remaining.take_front(n));
+            remaining = remaining.drop_front(n);
+          }
+          return SmallVector<Value>();
+        });
+      })
+      .Case<ReduceOp>([&](ReduceOp reduceOp) {
+        SmallVector<Value> inits;
+        buildInitLeaves(b, loc, reduceOp.initValue(),
+                        getElementType(reduceOp.result()), inits);
+        SmallVector<Value> acc =
+            loop(inits, [&](ValueRange leaves, ValueRange iterArgs) {
+              SmallVector<Value> args(iterArgs.begin(), iterArgs.end());
+              args.append(leaves.begin(), leaves.end());
+              return evaluate(args);
+            });
+        push(b, loc, outputs[0], acc);
+      })
+      .Case<TakeOp>([&](TakeOp takeOp) {
+        Value count = buildI64(b, loc, takeOp.count());
+        Value one = buildI64(b, loc, 1);
+        // The remaining elements are still received, such that the producer
+        // can finish.
+        loop(buildI64(b, loc, 0), [&](ValueRange leaves, ValueRange iterArgs) {
+          Value taken = iterArgs.front();
+          Value emit = b.create<arith::CmpIOp>(loc, arith::CmpIPredicate::ult,
+                                               taken, count);
+          auto ifOp = b.create<scf::IfOp>(loc, TypeRange(), emit,
+                                          /*withElseRegion=*/false);
+          {
+            OpBuilder::InsertionGuard guard(b);
+            b.setInsertionPointToStart(ifOp.thenBlock());
+            push(b, loc, outputs[0], leaves);
+          }
+          return SmallVector<Value>{b.create<arith::AddIOp>(loc, taken, one)};
+        });
+      })
+      .Case<TakeWhileOp>([&](auto) {
+        Type i1Type = b.getI1Type();
+        Value trueVal =
+            b.create<arith::ConstantOp>(loc, b.getBoolAttr(true));
+        loop(trueVal, [&](ValueRange leaves, ValueRange iterArgs) {
+          // The region is not evaluated anymore once it yielded false.
+          auto ifOp = b.create<scf::IfOp>(loc, i1Type, iterArgs.front(),
+                                          /*withElseRegion=*/true);
+          OpBuilder::InsertionGuard guard(b);
+          b.setInsertionPointToStart(ifOp.thenBlock());
+          Value cond = evaluate(leaves).front();
+          auto pushOp = b.create<scf::IfOp>(loc, TypeRange(), cond,
+                                            /*withElseRegion=*/false);
+          {
+            OpBuilder::InsertionGuard pushGuard(b);
+            b.setInsertionPointToStart(pushOp.thenBlock());
+            push(b, loc, outputs[0], leaves);
+          }
+          b.create<scf::YieldOp>(loc, cond);
+          b.setInsertionPointToStart(ifOp.elseBlock());
+          Value falseVal =
+              b.create<arith::ConstantOp>(loc, b.getBoolAttr(false));
+          b.create<scf::YieldOp>(loc, falseVal);
+          return SmallVector<Value>{ifOp.getResult(0)};
+        });
+      })
+      .Case<stream::BufferOp>([&](auto) {
+        // The channels buffer the elements already.
+        loop({}, [&](ValueRange leaves, ValueRange) {
+          push(b, loc, outputs[0], leaves);
+          return SmallVector<Value>();
+        });
+      })
+      .Case<SinkOp>([&](auto) { buildDrain(b, loc, inputs[0]); });
+}
+
+LogicalResult TaskLowering::lowerFunction(func::FuncOp funcOp) {
+  if (!funcOp.getBody().hasOneBlock())
+    return funcOp.emitError("expect the function to have a single block");
+  FunctionType funcType = funcOp.getFunctionType();
+  auto isStream = [](Type type) { return type.isa<StreamType>(); };
+  if (!llvm::all_of(funcType.getInputs(), isStream) ||
+      !llvm::all_of(funcType.getResults(), isStream))
+    return funcOp.emitError("expect all arguments and results to be streams");
+
+  Block &body = funcOp.getBody().front();
+  for (BlockArgument arg : body.getArguments())
+    if (failed(verifyElementType(funcOp, getElementType(arg))))
+      return failure();
+  SmallVector<Operation *> streamOps;
+  for (Operation &op : body.without_terminator()) {
+    if (failed(verifySupported(op)))
+      return failure();
+    streamOps.push_back(&op);
+  }
+
+  // The function creates the channels and starts the tasks, in front of the
+  // original return.
+  auto returnOp = cast<func::ReturnOp>(body.getTerminator());
+  OpBuilder b(returnOp);
+
+  // Each use of a stream gets its own channel, as the queues only support a
+  // single consumer.
+  DenseMap<OpOperand *, Value> useChannels;
+  auto createChannels = [&](Value stream) {
+    SmallVector<Value> channels;
+    for (OpOperand &use : stream.getUses()) {
+      Value channel =
+          createChannel(b, stream.getLoc(), getElementType(stream));
+      useChannels[&use] = channel;
+      channels.push_back(channel);
+    }
+    return channels;
+  };
+
+  // An argument is the channel of its only use. Otherwise, a task forwards
+  // its elements to a channel per use, or drains it if it is unused.
+  for (BlockArgument arg : body.getArguments()) {
+    if (arg.hasOneUse()) {
+      useChannels[&*arg.getUses().begin()] = arg;
+      continue;
+    }
+    SmallVector<SmallVector<Value>> outputs = {createChannels(arg)};
+    Type elementType = getElementType(arg);
+    buildTask(b, funcOp, arg.getLoc(), arg, outputs,
+              [&](OpBuilder &tb, ArrayRef<Value> inputs,
+                  ArrayRef<SmallVector<Value>> channels) {
+                buildElementLoop(tb, arg.getLoc(), inputs, elementType, {},
+                                 [&](ValueRange leaves, ValueRange) {
+                                   push(tb, arg.getLoc(), channels[0], leaves);
+                                   return SmallVector<Value>();
+                                 });
+              });
+  }
+
+  for (Operation *op : streamOps) {
+    SmallVector<Value> inputs;
+    for (OpOperand &operand : op->getOpOperands())
+      inputs.push_back(useChannels.lookup(&operand));
+    SmallVector<SmallVector<Value>> outputs;
+    for (Value result : op->getResults())
+      outputs.push_back(createChannels(result));
+    buildTask(b, funcOp, op->getLoc(), inputs, outputs,
+              [&](OpBuilder &tb, ArrayRef<Value> taskInputs,
+                  ArrayRef<SmallVector<Value>> taskOutputs) {
+                buildOpTask(*op, tb, taskInputs, taskOutputs);
+              });
+  }
+
+  // The caller consumes the returned streams.
+  SmallVector<Value> results;
+  for (OpOperand &operand : returnOp->getOpOperands())
+    results.push_back(useChannels.lookup(&operand));
+  b.create<func::ReturnOp>(returnOp.getLoc(), results);
+  returnOp.erase();
+  for (Operation *op : llvm::reverse(streamOps))
+    op->erase();
+
+  for (BlockArgument arg : body.getArguments())
+    arg.setType(ptrType);
+  funcOp.setType(b.getFunctionType(
+      SmallVector<Type>(funcType.getNumInputs(), ptrType),
+      SmallVector<Type>(funcType.getNumResults(), ptrType)));
+  return success();
+}
+
+/// Returns true if the function processes streams.
+static bool usesStreams(func::FuncOp funcOp) {
+  auto isStream = [](Type type) { return type.isa<StreamType>(); };
+  FunctionType funcType = funcOp.getFunctionType();
+  if (llvm::any_of(funcType.getInputs(), isStream) ||
+      llvm::any_of(funcType.getResults(), isStream))
+    return true;
+  return llvm::any_of(funcOp.getBody().getOps(), [](Operation &op) {
+    return isa_and_nonnull<StreamDialect>(op.getDialect());
+  });
+}
+
+namespace {
+class StreamToAsyncPass : public StreamToAsyncBase<StreamToAsyncPass> {
+public:
+  void runOnOperation() override {
+    ModuleOp module = getOperation();
+    TaskLowering lowering(module, std::max<int64_t>(batchSize, 1),
+                          std::max<int64_t>(queueDepth, 1));
+
+    // The lowering inserts the tasks into the module, so the functions are
+    // collected first.
+    SmallVector<func::FuncOp> funcOps;
+    for (auto funcOp : module.getOps<func::FuncOp>())
+      if (!funcOp.isDeclaration() && usesStreams(funcOp))
+        funcOps.push_back(funcOp);
+
+    for (func::FuncOp funcOp : funcOps)
+      if (failed(lowering.lowerFunction(funcOp))) {
+        signalPassFailure();
+        return;
+      }
+  }
+};
+} // namespace
+
+std::unique_ptr<Pass> circt_stream::createStreamToAsyncPass() {
+  return std::make_unique<StreamToAsyncPass>();
+}
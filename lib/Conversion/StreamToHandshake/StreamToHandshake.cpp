@@ -25,10 +25,16 @@
 #include "mlir/Dialect/ControlFlow/IR/ControlFlowOps.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/Func/Transforms/FuncConversions.h"
+#include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/SymbolTable.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Transforms/DialectConversion.h"
-#include "llvm/ADT/SmallSet.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/ADT/TypeSwitch.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/FormatVariadic.h"
 
 using namespace circt;
@@ -50,40 +56,62 @@ static std::string getBareOpName(Operation *op) {
 /// Helper class that provides functionality for creating unique symbol names.
 /// One instance is shared among all patterns.
 /// The uniquer remembers all symbols and new ones by checking that they do not
-/// exist yet.
+/// exist yet. The suffix of each base name continues where the previous
+/// lookup stopped, so naming N operations of the same kind takes linear time.
 class SymbolUniquer {
 public:
-  SymbolUniquer(Operation *top) : context(top->getContext()) {
-    addDefinitions(top);
-  }
+  SymbolUniquer(Operation *top) { addDefinitions(top); }
 
   void addDefinitions(mlir::Operation *top) {
     for (auto &region : top->getRegions())
       for (auto &block : region.getBlocks())
         for (auto symOp : block.getOps<mlir::SymbolOpInterface>())
-          addSymbol(symOp.getName().str());
+          addSymbol(symOp.getName());
   }
 
   std::string getUniqueSymName(Operation *op) {
     std::string opName = getBareOpName(op);
-    std::string name = opName;
+    if (addSymbol(opName))
+      return opName;
 
-    unsigned cnt = 1;
-    while (usedNames.contains(name)) {
-      name = llvm::formatv("{0}_{1}", opName, cnt++);
-    }
-    addSymbol(name);
+    unsigned &cnt = nextSuffix[opName];
+    std::string name;
+    do {
+      name = llvm::formatv("{0}_{1}", opName, ++cnt);
+    } while (!addSymbol(name));
 
     return name;
   }
 
-  void addSymbol(std::string name) { usedNames.insert(name); }
+  /// Returns false if the symbol was already used.
+  bool addSymbol(StringRef name) { return usedNames.insert(name).second; }
 
 private:
-  MLIRContext *context;
-  llvm::SmallSet<std::string, 8> usedNames;
+  llvm::StringSet<> usedNames;
+  llvm::StringMap<unsigned> nextSuffix;
 };
 
+/// Returns the type of the data that is transferred by one transaction of a
+/// stream. Multi-lane streams transfer a tuple of all elements together with a
+/// tuple of flags that indicate which lanes hold valid elements.
+static Type getPayloadType(StreamType type) {
+  Type elementType = type.getElementType();
+  unsigned lanes = type.getLanes();
+  if (lanes == 1)
+    return elementType;
+
+  MLIRContext *ctx = type.getContext();
+  SmallVector<Type> elementTypes(lanes, elementType);
+  SmallVector<Type> validTypes(lanes, IntegerType::get(ctx, 1));
+  return TupleType::get(ctx, {TupleType::get(ctx, elementTypes),
+                              TupleType::get(ctx, validTypes)});
+}
+
+static unsigned getLanes(Value stream) {
+  assert(stream.getType().isa<StreamType>());
+  return stream.getType().cast<StreamType>().getLanes();
+}
+
 class StreamTypeConverter : public TypeConverter {
 public:
   StreamTypeConverter() {
@@ -91,7 +119,7 @@ public:
     addConversion([](StreamType type, SmallVectorImpl<Type> &res) {
       MLIRContext *ctx = type.getContext();
       res.push_back(TupleType::get(
-          ctx, {type.getElementType(), IntegerType::get(ctx, 1)}));
+          ctx, {getPayloadType(type), IntegerType::get(ctx, 1)}));
       res.push_back(NoneType::get(ctx));
       return success();
     });
@@ -192,8 +220,14 @@ static void resolveNewOperands(Operation *oldOperation,
                                ValueRange remappedOperands,
                                SmallVectorImpl<Value> &newOperands) {
   for (auto [oldOp, remappedOp] :
-       llvm::zip(oldOperation->getOperands(), remappedOperands))
+       llvm::zip(oldOperation->getOperands(), remappedOperands)) {
+    // Memrefs are passed on unchanged
+    if (!oldOp.getType().isa<StreamType>()) {
+      newOperands.push_back(remappedOp);
+      continue;
+    }
     resolveStreamOperand(remappedOp, newOperands);
+  }
 
   // Resolve the init ctrl signal
   if (remappedOperands.size() == 0) {
@@ -268,6 +302,114 @@ static InstanceOp replaceWithInstance(Operation *op, FuncOp func,
   return instance;
 }
 
+static Value buildConstant(Location loc, Type type, int64_t value, Value ctrl,
+                           ConversionPatternRewriter &rewriter) {
+  return rewriter.create<handshake::ConstantOp>(
+      loc, rewriter.getIntegerAttr(type, value), ctrl);
+}
+
+/// Splits the payload of a multi-lane stream into the elements and the valid
+/// flags of each lane.
+static void unpackLanes(Value payload, Location loc,
+                        ConversionPatternRewriter &rewriter,
+                        SmallVectorImpl<Value> &elements,
+                        SmallVectorImpl<Value> &valid) {
+  auto unpack = rewriter.create<handshake::UnpackOp>(loc, payload);
+  auto elementsUnpack =
+      rewriter.create<handshake::UnpackOp>(loc, unpack.getResult(0));
+  auto validUnpack =
+      rewriter.create<handshake::UnpackOp>(loc, unpack.getResult(1));
+  llvm::append_range(elements, elementsUnpack.getResults());
+  llvm::append_range(valid, validUnpack.getResults());
+}
+
+/// Inverse of unpackLanes.
+static Value packLanes(ValueRange elements, ValueRange valid, Location loc,
+                       ConversionPatternRewriter &rewriter) {
+  auto elementsPack = rewriter.create<handshake::PackOp>(loc, elements);
+  auto validPack = rewriter.create<handshake::PackOp>(loc, valid);
+  return rewriter.create<handshake::PackOp>(
+      loc, ValueRange({elementsPack, validPack}));
+}
+
+/// Clones the operations of an already lowered region at the current
+/// insertion point. The block arguments are replaced with the provided values.
+/// Returns the values that the cloned operations yield.
+static SmallVector<Value> cloneLambda(Block *lambda, ValueRange args,
+                                      ConversionPatternRewriter &rewriter) {
+  BlockAndValueMapping mapping;
+  mapping.map(lambda->getArguments(), args);
+
+  SmallVector<Operation *> clones;
+  for (Operation &op : lambda->without_terminator())
+    clones.push_back(rewriter.clone(op, mapping));
+
+  // Values that are used before their definition, e.g., in loops, can only be
+  // remapped once all operations were cloned.
+  for (Operation *clone : clones)
+    for (OpOperand &operand : clone->getOpOperands())
+      if (Value mapped = mapping.lookupOrNull(operand.get()))
+        rewriter.updateRootInPlace(clone, [&]() { operand.set(mapped); });
+
+  return llvm::to_vector(
+      llvm::map_range(lambda->getTerminator()->getOperands(),
+                      [&](Value v) { return mapping.lookupOrDefault(v); }));
+}
+
+/// Applies the lowered region of a filter on each lane and moves the remaining
+/// elements to the lowest lanes, while preserving their order. Returns the new
+/// payload, a flag that indicates if any lane remains and the ctrl signal.
+static std::tuple<Value, Value, Value>
+buildLaneFilter(Block *lambda, Value payload, Value streamCtrl, Location loc,
+                ConversionPatternRewriter &rewriter) {
+  SmallVector<Value> elements, valid;
+  unpackLanes(payload, loc, rewriter, elements, valid);
+  unsigned lanes = elements.size();
+
+  SmallVector<Value> keep, laneCtrls;
+  for (auto [element, isValid] : llvm::zip(elements, valid)) {
+    SmallVector<Value> laneRes =
+        cloneLambda(lambda, {element, streamCtrl}, rewriter);
+    keep.push_back(rewriter.create<arith::AndIOp>(loc, laneRes[0], isValid));
+    laneCtrls.push_back(laneRes[1]);
+  }
+  Value ctrl = rewriter.create<JoinOp>(loc, laneCtrls);
+
+  // A kept element moves to the lane that corresponds to the number of kept
+  // elements in front of it.
+  Type posType = rewriter.getIntegerType(llvm::Log2_32_Ceil(lanes + 1));
+  SmallVector<Value> positions;
+  Value pos = buildConstant(loc, posType, 0, ctrl, rewriter);
+  for (Value k : keep) {
+    positions.push_back(pos);
+    Value inc = rewriter.create<arith::ExtUIOp>(loc, posType, k);
+    pos = rewriter.create<arith::AddIOp>(loc, pos, inc);
+  }
+  Value count = pos;
+
+  SmallVector<Value> outElements, outValid;
+  for (unsigned j = 0; j < lanes; ++j) {
+    Value lane = buildConstant(loc, posType, j, ctrl, rewriter);
+    // Only the elements of lane j and above can end up in lane j.
+    Value res = elements[j];
+    for (unsigned i = j + 1; i < lanes; ++i) {
+      auto atLane = rewriter.create<arith::CmpIOp>(
+          loc, arith::CmpIPredicate::eq, positions[i], lane);
+      auto sel = rewriter.create<arith::AndIOp>(loc, keep[i], atLane);
+      res = rewriter.create<arith::SelectOp>(loc, sel, elements[i], res);
+    }
+    outElements.push_back(res);
+    outValid.push_back(rewriter.create<arith::CmpIOp>(
+        loc, arith::CmpIPredicate::ugt, count, lane));
+  }
+
+  Value zero = buildConstant(loc, posType, 0, ctrl, rewriter);
+  Value any = rewriter.create<arith::CmpIOp>(loc, arith::CmpIPredicate::ne,
+                                             count, zero);
+
+  return {packLanes(outElements, outValid, loc, rewriter), any, ctrl};
+}
+
 // Usual flow:
 // 1. Apply lowerRegion from StdToHandshake
 // 2. Collect operands
@@ -276,16 +418,456 @@ static InstanceOp replaceWithInstance(Operation *op, FuncOp func,
 // 5. Change parts of the lowered Region to fit the operations needs.
 // 6. Create function and replace operation with InstanceOp
 
+/// Options that are shared among all patterns and influence the lowering of
+/// stream operations.
+struct StreamLoweringOptions {
+  /// Number of accumulators to use for associative reductions.
+  unsigned numAccumulators = 1;
+  /// Minimal number of elements for which stream.create reads its elements
+  /// from a lookup table. Zero disables the lookup table lowering.
+  unsigned createRomThreshold = 0;
+  /// Reset the state of operations on EOS, such that they can process
+  /// multiple streams.
+  bool restartable = false;
+  /// Number of requests a stream.load can have in flight.
+  unsigned loadRequests = 4;
+  /// Number of transactions a cancelled source emits before it waits for the
+  /// cancel flag of its first one.
+  unsigned cancelSlack = 8;
+  /// Flag the last element of a stream as EOS instead of sending a separate
+  /// EOS transaction. Such streams cannot be empty.
+  bool eosOnLast = false;
+};
+
+/// Emits an error if EOS is flagged on the last element. Operations that drop
+/// or regroup elements would have to move the flag to another element, which
+/// requires to look ahead in the stream.
+static LogicalResult verifySeparateEos(Operation *op,
+                                       const StreamLoweringOptions &options) {
+  if (!options.eosOnLast)
+    return success();
+  return op->emitError("cannot be lowered with EOS on the last element");
+}
+
+/// Splits the lowered body of an operation into `latency` pipeline stages.
+/// Each operation is assigned the level of the longest path that leads to it
+/// from the arguments. The stage boundaries are spread evenly over the levels
+/// and a sequential buffer is placed on each edge that crosses a boundary.
+/// As every path from an argument to the terminator crosses all boundaries,
+/// the payload, EOS, and ctrl paths stay balanced. The init ctrl, i.e., the
+/// last argument, is not pipelined.
+static LogicalResult pipelineBody(Operation *op, Block *body, uint64_t latency,
+                                  ConversionPatternRewriter &rewriter) {
+  if (latency == 0)
+    return success();
+
+  Value initCtrl = body->getArguments().back();
+  DenseMap<Value, uint64_t> levels;
+  for (Value arg : body->getArguments())
+    levels[arg] = 0;
+
+  SmallVector<std::pair<Operation *, uint64_t>> ops;
+  uint64_t depth = 0;
+  for (Operation &inner : *body) {
+    uint64_t level = 0;
+    for (Value operand : inner.getOperands()) {
+      auto it = levels.find(operand);
+      // Values used before their definition form a loop, which cannot be
+      // cut without changing the behavior.
+      if (it == levels.end())
+        return op->emitError("cannot pipeline a region with loops");
+      level = std::max(level, it->second);
+    }
+    if (inner.hasTrait<OpTrait::IsTerminator>())
+      continue;
+    ops.emplace_back(&inner, level + 1);
+    for (Value result : inner.getResults())
+      levels[result] = level + 1;
+    depth = std::max(depth, level + 1);
+  }
+
+  // Boundary k is placed in front of the first operation with a level of at
+  // least `boundaries[k]`. The terminator is on the level after the deepest
+  // operation.
+  uint64_t termLevel = depth + 1;
+  ops.emplace_back(body->getTerminator(), termLevel);
+  SmallVector<uint64_t> boundaries;
+  for (uint64_t k = 1; k <= latency; ++k)
+    boundaries.push_back(llvm::divideCeil(k * termLevel, latency + 1));
+
+  // Buffers are placed next to the definition of a value, such that all uses
+  // that cross the same boundaries share them.
+  DenseMap<std::pair<Value, uint64_t>, Value> buffers;
+  for (auto &entry : ops) {
+    Operation *user = entry.first;
+    uint64_t userLevel = entry.second;
+    for (OpOperand &operand : user->getOpOperands()) {
+      Value value = operand.get();
+      if (value == initCtrl)
+        continue;
+      uint64_t defLevel = levels[value];
+      uint64_t stages = llvm::count_if(boundaries, [&](uint64_t boundary) {
+        return defLevel < boundary && boundary <= userLevel;
+      });
+      if (stages == 0)
+        continue;
+
+      Value &buffer = buffers[{value, stages}];
+      if (!buffer) {
+        rewriter.setInsertionPointAfterValue(value);
+        buffer = rewriter.create<handshake::BufferOp>(
+            op->getLoc(), value.getType(), stages, value, BufferTypeEnum::seq);
+      }
+      rewriter.updateRootInPlace(user, [&] { operand.set(buffer); });
+    }
+  }
+  return success();
+}
+
+/// Tracks the cancel signals of streams whose consumers end them early.
+///
+/// A take or take_while emits a cancel flag for each transaction it receives,
+/// which is set once it does not forward any further element. map, filter,
+/// and split pass the flags of their consumers on to their producer, one for
+/// each transaction of their input, such that iota, create, and load turn
+/// their next transaction into EOS instead of producing the rest of the
+/// stream. Operations are lowered before their consumers, so each producer
+/// receives a placeholder that is replaced once the consumer is lowered.
+class CancelSignals {
+public:
+  explicit CancelSignals(bool eosOnLast) : eosOnLast(eosOnLast) {}
+
+  /// Returns true if the consumers of the stream can end it early. Buffers,
+  /// pipeline stages, and output FIFOs between the producer and the consumer
+  /// are not supported, as the producer waits for the flag of the previous
+  /// transaction.
+  bool canCancel(Value stream) const {
+    if (!stream.hasOneUse())
+      return false;
+    auto noStages = [](Optional<uint64_t> latency) {
+      return latency.getValueOr(0) == 0;
+    };
+    return TypeSwitch<Operation *, bool>(*stream.getUsers().begin())
+        .Case<TakeOp, TakeWhileOp>([](auto) { return true; })
+        .Case<MapOp>([&](MapOp op) {
+          return noStages(op.latency()) && op.replicas().getValueOr(1) <= 1 &&
+                 canCancel(op.result());
+        })
+        .Case<FilterOp>([&](FilterOp op) {
+          // With EOS on the last element, the held element breaks the
+          // correspondence of input and output transactions
+          return !eosOnLast && noStages(op.latency()) &&
+                 canCancel(op.result());
+        })
+        .Case<SplitOp>([&](SplitOp op) {
+          return !op.bufferDepth() &&
+                 llvm::all_of(op.results(),
+                              [&](Value result) { return canCancel(result); });
+        })
+        .Default([](Operation *) { return false; });
+  }
+
+  /// Returns true if the producer of the stream expects cancel flags.
+  bool isCancelled(Value stream) const { return placeholders.count(stream); }
+
+  /// Returns a placeholder for the cancel flags of the consumer of the stream.
+  Value getPlaceholder(Value stream, ConversionPatternRewriter &rewriter) {
+    OpBuilder::InsertionGuard guard(rewriter);
+    rewriter.setInsertionPoint(stream.getDefiningOp());
+    auto placeholder =
+        rewriter.create<NeverOp>(stream.getLoc(), rewriter.getI1Type());
+    placeholders[stream] = placeholder;
+    return placeholder;
+  }
+
+  /// Replaces the placeholder of the stream with the flags of its consumer.
+  void connect(Value stream, Value flags,
+               ConversionPatternRewriter &rewriter) {
+    auto it = placeholders.find(stream);
+    rewriter.replaceOp(it->second, flags);
+    placeholders.erase(it);
+  }
+
+private:
+  bool eosOnLast;
+  DenseMap<Value, NeverOp> placeholders;
+};
+
+/// Inserts an argument for the cancel flags of a consumer in front of the
+/// last argument of a lowered operation, i.e., its ctrl input.
+static Value addCancelArgument(Block *body, Location loc, OpBuilder &builder) {
+  return body->insertArgument(body->getNumArguments() - 1,
+                              builder.getI1Type(), loc);
+}
+
+/// Returns the cancel flags of a lowered operation in front of the last
+/// result, i.e., its init ctrl.
+static void addCancelResult(handshake::ReturnOp term, Value flags) {
+  term->insertOperands(term->getNumOperands() - 1, flags);
+}
+
+/// Builds the cancel flag of a consumer that does not forward any further
+/// element once `done` is set. EOS is never cancelled, such that the flag of
+/// the last transaction does not cancel the next stream.
+static Value buildCancelOutput(Value done, Value eos, Value ctrl, Location loc,
+                               ConversionPatternRewriter &rewriter) {
+  Value trueVal = buildConstant(loc, rewriter.getI1Type(), 1, ctrl, rewriter);
+  auto notEos = rewriter.create<arith::XOrIOp>(loc, eos, trueVal);
+  return rewriter.create<arith::AndIOp>(loc, done, notEos);
+}
+
 template <typename Op>
 struct StreamOpLowering : public OpConversionPattern<Op> {
   StreamOpLowering(TypeConverter &typeConverter, MLIRContext *ctx,
-                   SymbolUniquer &symbolUniquer)
+                   SymbolUniquer &symbolUniquer,
+                   const StreamLoweringOptions &options,
+                   CancelSignals &cancelSignals)
       : OpConversionPattern<Op>(typeConverter, ctx),
-        symbolUniquer(symbolUniquer) {}
+        symbolUniquer(symbolUniquer), options(options),
+        cancelSignals(cancelSignals) {}
+
+  /// Passes a placeholder for the cancel flags of each result in front of the
+  /// last operand of the instance, i.e., its ctrl input.
+  void addCancelOperands(ValueRange results, SmallVectorImpl<Value> &operands,
+                         ConversionPatternRewriter &rewriter) const {
+    for (Value result : results)
+      operands.insert(std::prev(operands.end()),
+                      cancelSignals.getPlaceholder(result, rewriter));
+  }
+
+  /// Forwards the cancel flags that the instance returns in front of its init
+  /// ctrl to the producer of the input.
+  void connectCancelResult(Value input, InstanceOp instance,
+                           ConversionPatternRewriter &rewriter) const {
+    cancelSignals.connect(
+        input, instance.getResult(instance.getNumResults() - 2), rewriter);
+  }
 
   SymbolUniquer &symbolUniquer;
+  StreamLoweringOptions options;
+  CancelSignals &cancelSignals;
 };
 
+/// Builds a sequential buffer of depth 1 that initially holds the provided
+/// value. Handshake buffers can only be initialized with integers, so tuples
+/// are split into a separate buffer per field.
+static Value buildInitializedBuffer(Location loc, Type type, Value input,
+                                    Attribute initValue,
+                                    ConversionPatternRewriter &rewriter) {
+  if (auto tupleType = type.dyn_cast<TupleType>()) {
+    auto unpack = rewriter.create<handshake::UnpackOp>(loc, input);
+    SmallVector<Value> fields;
+    for (auto [field, fieldInit] :
+         llvm::zip(unpack.getResults(), initValue.cast<ArrayAttr>()))
+      fields.push_back(buildInitializedBuffer(loc, field.getType(), field,
+                                              fieldInit, rewriter));
+    return rewriter.create<handshake::PackOp>(loc, fields);
+  }
+
+  auto buffer =
+      rewriter.create<handshake::BufferOp>(loc, type, 1, input,
+                                           BufferTypeEnum::seq);
+  // The values are reinterpreted with the width of the buffer, so zero
+  // extension ensures that they fit into the I64ArrayAttr.
+  int64_t value = initValue.cast<IntegerAttr>().getValue().getZExtValue();
+  buffer->setAttr("initValues", rewriter.getI64ArrayAttr({value}));
+  return buffer;
+}
+
+/// Returns an attribute that holds zero for each integer of the type.
+static Attribute getZeroAttr(Type type, OpBuilder &builder) {
+  if (auto tupleType = type.dyn_cast<TupleType>()) {
+    SmallVector<Attribute> fields;
+    for (Type fieldType : tupleType.getTypes())
+      fields.push_back(getZeroAttr(fieldType, builder));
+    return builder.getArrayAttr(fields);
+  }
+  return builder.getIntegerAttr(type, 0);
+}
+
+/// Returns true if all integers the type consists of are at most 64 bits
+/// wide, as handshake buffers are initialized with 64-bit values.
+static bool isInitializable(Type type) {
+  if (auto tupleType = type.dyn_cast<TupleType>())
+    return llvm::all_of(tupleType.getTypes(), isInitializable);
+  return type.isa<IntegerType>() && type.getIntOrFloatBitWidth() <= 64;
+}
+
+/// Builds a constant with the provided value that is triggered by ctrl.
+/// Tuples are assembled from a constant for each of their fields.
+static Value buildAttrConstant(Location loc, Type type, Attribute value,
+                               Value ctrl,
+                               ConversionPatternRewriter &rewriter) {
+  if (auto tupleType = type.dyn_cast<TupleType>()) {
+    SmallVector<Value> fields;
+    for (auto [fieldType, fieldValue] :
+         llvm::zip(tupleType.getTypes(), value.cast<ArrayAttr>()))
+      fields.push_back(
+          buildAttrConstant(loc, fieldType, fieldValue, ctrl, rewriter));
+    return rewriter.create<handshake::PackOp>(loc, fields);
+  }
+  return rewriter.create<handshake::ConstantOp>(loc, value, ctrl);
+}
+
+/// Delays the kept transactions of a filter with EOS on the last element by
+/// one, such that the flag can be moved to the last kept element once the last
+/// input transaction arrives. A held transaction is emitted when the next one
+/// is kept or the stream ends. A kept last transaction is held as well, and
+/// its ctrl token loops back for an extra iteration that emits it, like the
+/// EOS iterations of a reduce_by_key. If no element is kept, the stream ends
+/// with a transaction that only carries the flag, like a separate EOS one.
+/// Returns the output tuple and its ctrl signal.
+static std::pair<Value, Value>
+buildLastElementHold(Value payload, Value keep, Value eos, Value ctrl,
+                     Location loc, ConversionPatternRewriter &rewriter) {
+  Type i1Type = rewriter.getI1Type();
+  Type payloadType = payload.getType();
+  Attribute zero = getZeroAttr(payloadType, rewriter);
+
+  // Selects the extra iteration instead of a new input transaction
+  auto tmpSelect = rewriter.create<NeverOp>(loc, i1Type);
+  Value select = buildInitializedBuffer(
+      loc, i1Type, tmpSelect, rewriter.getIntegerAttr(i1Type, 0), rewriter);
+  auto tmpExtraCtrl = rewriter.create<NeverOp>(loc, rewriter.getNoneType());
+  Value extraKeep = buildConstant(loc, i1Type, 0, tmpExtraCtrl, rewriter);
+  Value extraEos = buildConstant(loc, i1Type, 1, tmpExtraCtrl, rewriter);
+  Value extraPayload =
+      buildAttrConstant(loc, payloadType, zero, tmpExtraCtrl, rewriter);
+
+  Value iterCtrl =
+      rewriter.create<MuxOp>(loc, select, ValueRange({ctrl, tmpExtraCtrl}));
+  Value iterKeep =
+      rewriter.create<MuxOp>(loc, select, ValueRange({keep, extraKeep}));
+  Value iterEos =
+      rewriter.create<MuxOp>(loc, select, ValueRange({eos, extraEos}));
+  Value iterPayload = rewriter.create<MuxOp>(
+      loc, select, ValueRange({payload, extraPayload}));
+
+  auto tmpHeld = rewriter.create<NeverOp>(loc, i1Type);
+  Value held = buildInitializedBuffer(
+      loc, i1Type, tmpHeld, rewriter.getIntegerAttr(i1Type, 0), rewriter);
+  auto tmpHeldPayload = rewriter.create<NeverOp>(loc, payloadType);
+  Value heldPayload = buildInitializedBuffer(loc, payloadType, tmpHeldPayload,
+                                             zero, rewriter);
+
+  Value trueVal = buildConstant(loc, i1Type, 1, iterCtrl, rewriter);
+  auto notKeep = rewriter.create<arith::XOrIOp>(loc, iterKeep, trueVal);
+  auto notEos = rewriter.create<arith::XOrIOp>(loc, iterEos, trueVal);
+  auto keepOrEos = rewriter.create<arith::OrIOp>(loc, iterKeep, iterEos);
+  auto last = rewriter.create<arith::AndIOp>(loc, iterEos, notKeep);
+  Value emit = rewriter.create<arith::OrIOp>(
+      loc, rewriter.create<arith::AndIOp>(loc, held, keepOrEos), last);
+  auto extra = rewriter.create<arith::AndIOp>(loc, iterEos, iterKeep);
+
+  // The stream ends without a held transaction, so restarts begin empty
+  auto stillHeld = rewriter.create<arith::AndIOp>(loc, held, notEos);
+  rewriter.replaceOp(tmpHeld, {rewriter.create<arith::OrIOp>(
+                                  loc, iterKeep, stillHeld)});
+  rewriter.replaceOp(tmpHeldPayload,
+                     {rewriter.create<arith::SelectOp>(
+                         loc, iterKeep, iterPayload, heldPayload)});
+  rewriter.replaceOp(tmpSelect, {extra.getResult()});
+  auto extraBr =
+      rewriter.create<handshake::ConditionalBranchOp>(loc, extra, iterCtrl);
+  rewriter.replaceOp(tmpExtraCtrl,
+                     {rewriter.create<handshake::BufferOp>(
+                         loc, rewriter.getNoneType(), 1,
+                         extraBr.trueResult(), BufferTypeEnum::seq)});
+
+  // Without a held element, the payload of the last transaction is a bubble
+  Value bubble =
+      buildAttrConstant(loc, payloadType, zero, iterCtrl, rewriter);
+  Value payloadOut =
+      rewriter.create<arith::SelectOp>(loc, held, heldPayload, bubble);
+  auto tupleOut =
+      rewriter.create<handshake::PackOp>(loc, ValueRange({payloadOut, last}));
+  auto dataBr =
+      rewriter.create<handshake::ConditionalBranchOp>(loc, emit, tupleOut);
+  auto ctrlBr =
+      rewriter.create<handshake::ConditionalBranchOp>(loc, emit, iterCtrl);
+  return {dataBr.trueResult(), ctrlBr.trueResult()};
+}
+
+/// Builds a function that distributes the transactions of a stream in a
+/// round-robin fashion to `numReplicas` instances of `replica` and reassembles
+/// the results in the original order. Each transaction is tagged with its
+/// replica, and a FIFO of the tags selects the replica that provides the next
+/// result. As every transaction, including EOS, produces exactly one result,
+/// the tags of both sides stay aligned.
+static FuncOp buildReplicatedFuncOp(Location loc, FuncOp replica,
+                                    StringRef name, uint64_t numReplicas,
+                                    ConversionPatternRewriter &rewriter) {
+  Region r;
+  TypeRange argTypes = replica.getArgumentTypes();
+  SmallVector<Location> argLocs(argTypes.size(), loc);
+  Block *entryBlock = rewriter.createBlock(&r, r.begin(), argTypes, argLocs);
+  Value tupleIn = entryBlock->getArgument(0);
+  Value streamCtrl = entryBlock->getArgument(1);
+  Value initCtrl = entryBlock->getArgument(2);
+
+  Type tagType = rewriter.getI64Type();
+  auto tmpTag = rewriter.create<NeverOp>(loc, tagType);
+  Value tag = buildInitializedBuffer(
+      loc, tagType, tmpTag, rewriter.getI64IntegerAttr(0), rewriter);
+  Value one = buildConstant(loc, tagType, 1, streamCtrl, rewriter);
+  Value incremented = rewriter.create<arith::AddIOp>(loc, tag, one);
+  Value numVal = buildConstant(loc, tagType, numReplicas, streamCtrl, rewriter);
+  Value wrap = rewriter.create<arith::CmpIOp>(loc, arith::CmpIPredicate::eq,
+                                              incremented, numVal);
+  Value zero = buildConstant(loc, tagType, 0, streamCtrl, rewriter);
+  Value next = rewriter.create<arith::SelectOp>(loc, wrap, zero, incremented);
+  rewriter.replaceOp(tmpTag, {next});
+
+  // Each stage either passes the transaction to its replica or to the next
+  // stage. The tag is steered along, such that a stage only receives a tag
+  // for the transactions that reach it.
+  SmallVector<Value> results, resultCtrls, initCtrls;
+  Value stageTuple = tupleIn, stageCtrl = streamCtrl, stageTag = tag;
+  for (uint64_t i = 0; i < numReplicas; ++i) {
+    Value replicaTuple = stageTuple, replicaCtrl = stageCtrl;
+    if (i + 1 < numReplicas) {
+      Value idx = buildConstant(loc, tagType, i, stageCtrl, rewriter);
+      Value selected = rewriter.create<arith::CmpIOp>(
+          loc, arith::CmpIPredicate::eq, stageTag, idx);
+      auto tupleBr = rewriter.create<handshake::ConditionalBranchOp>(
+          loc, selected, stageTuple);
+      auto ctrlBr = rewriter.create<handshake::ConditionalBranchOp>(
+          loc, selected, stageCtrl);
+      auto tagBr = rewriter.create<handshake::ConditionalBranchOp>(
+          loc, selected, stageTag);
+      replicaTuple = tupleBr.trueResult();
+      replicaCtrl = ctrlBr.trueResult();
+      stageTuple = tupleBr.falseResult();
+      stageCtrl = ctrlBr.falseResult();
+      stageTag = tagBr.falseResult();
+    }
+
+    auto instance = rewriter.create<InstanceOp>(
+        loc, replica, ValueRange({replicaTuple, replicaCtrl, initCtrl}));
+    // The FIFOs allow a replica to run ahead while the results of another
+    // one are collected.
+    results.push_back(rewriter.create<handshake::BufferOp>(
+        loc, instance.getResult(0).getType(), 2, instance.getResult(0),
+        BufferTypeEnum::fifo));
+    resultCtrls.push_back(rewriter.create<handshake::BufferOp>(
+        loc, instance.getResult(1).getType(), 2, instance.getResult(1),
+        BufferTypeEnum::fifo));
+    initCtrls.push_back(instance.getResult(2));
+  }
+
+  // Holds the tags of the transactions in flight in their original order.
+  Value tags = rewriter.create<handshake::BufferOp>(
+      loc, tagType, 2 * numReplicas, tag, BufferTypeEnum::fifo);
+  Value tupleOut = rewriter.create<MuxOp>(loc, tags, results);
+  Value ctrlOut = rewriter.create<MuxOp>(loc, tags, resultCtrls);
+  Value initCtrlOut = rewriter.create<JoinOp>(loc, initCtrls);
+  auto newTerm = rewriter.create<handshake::ReturnOp>(
+      loc, ValueRange({tupleOut, ctrlOut, initCtrlOut}));
+
+  rewriter.setInsertionPointAfter(replica);
+  return createFuncOp(r, name, argTypes, newTerm.getOperandTypes(), rewriter);
+}
+
 // Builds a handshake::FuncOp and that represents the mapping funtion. This
 // function is then instantiated and connected to its inputs and outputs.
 struct MapOpLowering : public StreamOpLowering<MapOp> {
@@ -318,30 +900,71 @@ struct MapOpLowering : public StreamOpLowering<MapOp> {
     Value eos = unpack.getResult(1);
 
     Block *lambda = &op.getRegion().front();
-    rewriter.mergeBlocks(lambda, entryBlock, ValueRange({data, streamCtrl}));
+    handshake::ReturnOp newTerm;
+    if (getLanes(op.input()) == 1) {
+      rewriter.mergeBlocks(lambda, entryBlock, ValueRange({data, streamCtrl}));
+
+      Operation *oldTerm = entryBlock->getTerminator();
+
+      rewriter.setInsertionPoint(oldTerm);
+      auto tupleOut = rewriter.create<handshake::PackOp>(
+          oldTerm->getLoc(), ValueRange({oldTerm->getOperand(0), eos}));
+
+      SmallVector<Value> newTermOperands = {tupleOut, oldTerm->getOperand(1),
+                                            initCtrl};
+      newTerm = rewriter.replaceOpWithNewOp<handshake::ReturnOp>(
+          oldTerm, newTermOperands);
+    } else {
+      // Replicate the mapping function for each lane
+      SmallVector<Value> elements, valid;
+      unpackLanes(data, loc, rewriter, elements, valid);
+
+      SmallVector<Value> results, laneCtrls;
+      for (Value element : elements) {
+        SmallVector<Value> laneRes =
+            cloneLambda(lambda, {element, streamCtrl}, rewriter);
+        results.push_back(laneRes[0]);
+        laneCtrls.push_back(laneRes[1]);
+      }
 
-    Operation *oldTerm = entryBlock->getTerminator();
+      auto ctrlOut = rewriter.create<JoinOp>(loc, laneCtrls);
+      auto tupleOut = rewriter.create<handshake::PackOp>(
+          loc, ValueRange({packLanes(results, valid, loc, rewriter), eos}));
 
-    rewriter.setInsertionPoint(oldTerm);
-    auto tupleOut = rewriter.create<handshake::PackOp>(
-        oldTerm->getLoc(), ValueRange({oldTerm->getOperand(0), eos}));
+      newTerm = rewriter.create<handshake::ReturnOp>(
+          loc, ValueRange({tupleOut, ctrlOut, initCtrl}));
+    }
 
-    SmallVector<Value> newTermOperands = {tupleOut, oldTerm->getOperand(1),
-                                          initCtrl};
-    auto newTerm = rewriter.replaceOpWithNewOp<handshake::ReturnOp>(
-        oldTerm, newTermOperands);
+    if (op.latency() &&
+        failed(pipelineBody(op, entryBlock, *op.latency(), rewriter)))
+      return failure();
+
+    // Elements are mapped one to one, so the flags of the consumer are passed
+    // on unchanged
+    bool cancellable = cancelSignals.isCancelled(op.input());
+    if (cancellable)
+      addCancelResult(newTerm, addCancelArgument(entryBlock, loc, rewriter));
 
     TypeRange resTypes = newTerm->getOperandTypes();
 
     SmallVector<Value> operands;
     resolveNewOperands(op, adaptor.getOperands(), operands);
+    if (cancellable)
+      addCancelOperands(op.result(), operands, rewriter);
 
     rewriter.setInsertionPointToStart(getTopLevelBlock(op));
     FuncOp newFuncOp =
         createFuncOp(r, symbolUniquer.getUniqueSymName(op),
                      entryBlock->getArgumentTypes(), resTypes, rewriter);
+    if (op.replicas() && *op.replicas() > 1)
+      newFuncOp = buildReplicatedFuncOp(loc, newFuncOp,
+                                        symbolUniquer.getUniqueSymName(op),
+                                        *op.replicas(), rewriter);
 
-    replaceWithInstance(op, newFuncOp, operands, rewriter);
+    InstanceOp instance =
+        replaceWithInstance(op, newFuncOp, operands, rewriter);
+    if (cancellable)
+      connectCancelResult(op.input(), instance, rewriter);
 
     return success();
   }
@@ -353,6 +976,17 @@ struct FilterOpLowering : public StreamOpLowering<FilterOp> {
   LogicalResult
   matchAndRewrite(FilterOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
+    if (options.eosOnLast) {
+      // The held transaction forms a loop, which cannot be pipelined
+      if (op.latency().getValueOr(0) > 0)
+        return op.emitError(
+            "cannot pipeline a filter with EOS on the last element");
+      if (!isInitializable(
+              getPayloadType(op.input().getType().cast<StreamType>())))
+        return op.emitError("cannot hold elements with integers wider than "
+                            "64 bits");
+    }
+
     Location loc = op.getLoc();
     TypeConverter *typeConverter = getTypeConverter();
 
@@ -376,46 +1010,296 @@ struct FilterOpLowering : public StreamOpLowering<FilterOp> {
     Value eos = unpack.getResult(1);
 
     Block *lambda = &op.getRegion().front();
-    rewriter.mergeBlocks(lambda, entryBlock, ValueRange({data, streamCtrl}));
-
-    Operation *oldTerm = entryBlock->getTerminator();
-
-    assert(oldTerm->getNumOperands() == 2 &&
-           "expected handshake::ReturnOp to have two operands");
-    rewriter.setInsertionPointToEnd(entryBlock);
-
-    Value cond = oldTerm->getOperand(0);
-    Value ctrl = oldTerm->getOperand(1);
-
-    auto tupleOut =
-        rewriter.create<handshake::PackOp>(loc, ValueRange({data, eos}));
-
-    auto condOrEos = rewriter.create<arith::OrIOp>(loc, cond, eos);
-
-    auto dataBr = rewriter.create<handshake::ConditionalBranchOp>(
-        rewriter.getUnknownLoc(), condOrEos, tupleOut);
+    Operation *oldTerm = nullptr;
+    Value payload, cond, ctrl;
+    if (getLanes(op.input()) == 1) {
+      rewriter.mergeBlocks(lambda, entryBlock, ValueRange({data, streamCtrl}));
+
+      oldTerm = entryBlock->getTerminator();
+
+      assert(oldTerm->getNumOperands() == 2 &&
+             "expected handshake::ReturnOp to have two operands");
+      rewriter.setInsertionPointToEnd(entryBlock);
+
+      payload = data;
+      cond = oldTerm->getOperand(0);
+      ctrl = oldTerm->getOperand(1);
+    } else {
+      // Only drop a transaction when none of its lanes remain
+      std::tie(payload, cond, ctrl) =
+          buildLaneFilter(lambda, data, streamCtrl, loc, rewriter);
+    }
 
-    // Makes sure we only emit Ctrl when data is produced
-    auto ctrlBr = rewriter.create<handshake::ConditionalBranchOp>(
-        rewriter.getUnknownLoc(), condOrEos, ctrl);
+    bool cancellable = cancelSignals.isCancelled(op.input());
+    Value tupleOut, ctrlOut, cancelOut;
+    if (options.eosOnLast) {
+      std::tie(tupleOut, ctrlOut) =
+          buildLastElementHold(payload, cond, eos, ctrl, loc, rewriter);
+    } else {
+      auto tuple =
+          rewriter.create<handshake::PackOp>(loc, ValueRange({payload, eos}));
+
+      auto condOrEos = rewriter.create<arith::OrIOp>(loc, cond, eos);
+
+      auto dataBr = rewriter.create<handshake::ConditionalBranchOp>(
+          rewriter.getUnknownLoc(), condOrEos, tuple);
+
+      // Makes sure we only emit Ctrl when data is produced
+      auto ctrlBr = rewriter.create<handshake::ConditionalBranchOp>(
+          rewriter.getUnknownLoc(), condOrEos, ctrl);
+      tupleOut = dataBr.trueResult();
+      ctrlOut = ctrlBr.trueResult();
+
+      // Dropped elements do not cancel the stream, such that their flags do
+      // not wait for the consumer
+      if (cancellable) {
+        Value cancelIn = addCancelArgument(entryBlock, loc, rewriter);
+        Value notCancelled = buildConstant(loc, rewriter.getI1Type(), 0,
+                                           ctrlBr.falseResult(), rewriter);
+        cancelOut = rewriter.create<MuxOp>(
+            loc, condOrEos, ValueRange({notCancelled, cancelIn}));
+      }
+    }
 
-    SmallVector<Value> newTermOperands = {dataBr.trueResult(),
-                                          ctrlBr.trueResult(), initCtrl};
-    auto newTerm = rewriter.replaceOpWithNewOp<handshake::ReturnOp>(
-        oldTerm, newTermOperands);
+    SmallVector<Value> newTermOperands = {tupleOut, ctrlOut, initCtrl};
+    if (cancelOut)
+      newTermOperands.insert(std::prev(newTermOperands.end()), cancelOut);
+    handshake::ReturnOp newTerm;
+    if (oldTerm)
+      newTerm = rewriter.replaceOpWithNewOp<handshake::ReturnOp>(
+          oldTerm, newTermOperands);
+    else
+      newTerm = rewriter.create<handshake::ReturnOp>(loc, newTermOperands);
+
+    if (op.latency() &&
+        failed(pipelineBody(op, entryBlock, *op.latency(), rewriter)))
+      return failure();
 
     SmallVector<Value> operands;
     resolveNewOperands(op, adaptor.getOperands(), operands);
+    if (cancelOut)
+      addCancelOperands(op.result(), operands, rewriter);
 
     rewriter.setInsertionPointToStart(getTopLevelBlock(op));
     FuncOp newFuncOp = createFuncOp(r, symbolUniquer.getUniqueSymName(op),
                                     entryBlock->getArgumentTypes(),
                                     newTerm.getOperandTypes(), rewriter);
-    replaceWithInstance(op, newFuncOp, operands, rewriter);
+    InstanceOp instance =
+        replaceWithInstance(op, newFuncOp, operands, rewriter);
+    if (cancelOut)
+      connectCancelResult(op.input(), instance, rewriter);
     return success();
   }
 };
 
+/// Emits the result of a reduction, followed by an EOS = true one cycle after
+/// the emission of the result. Returns the output tuple and its ctrl signal.
+/// Restartable reductions emit such a pair of transactions for each stream.
+/// With `eosOnLast`, the result itself is flagged as EOS instead.
+static std::pair<Value, Value>
+buildReduceOutput(Value result, Value eos, Value ctrl, Location loc,
+                  ConversionPatternRewriter &rewriter,
+                  bool restartable = false, bool eosOnLast = false) {
+  if (eosOnLast)
+    return {rewriter.create<handshake::PackOp>(loc, ValueRange({result, eos})),
+            ctrl};
+
+  // Connect outputs and ensure correct delay between value and EOS=true
+  // emission A sequental buffer ensures a cycle delay of 1
+  auto eosFalse = rewriter.create<handshake::ConstantOp>(
+      rewriter.getUnknownLoc(),
+      rewriter.getIntegerAttr(rewriter.getI1Type(), 0), ctrl);
+  auto tupleOutVal =
+      rewriter.create<handshake::PackOp>(loc, ValueRange({result, eosFalse}));
+
+  auto tupleOutEOS =
+      rewriter.create<handshake::PackOp>(loc, ValueRange({result, eos}));
+
+  Value select;
+  if (restartable) {
+    // Toggles between the tupleOut and the one with the EOS signal
+    auto tmpSelect = rewriter.create<NeverOp>(loc, rewriter.getI1Type());
+    auto selectBuf = rewriter.create<handshake::BufferOp>(
+        loc, rewriter.getI1Type(), 1, tmpSelect, BufferTypeEnum::seq);
+    selectBuf->setAttr("initValues", rewriter.getI64ArrayAttr({0}));
+    auto source = rewriter.create<SourceOp>(loc, rewriter.getNoneType());
+    auto trueVal = rewriter.create<handshake::ConstantOp>(
+        loc, rewriter.getIntegerAttr(rewriter.getI1Type(), 1), source);
+    auto toggle = rewriter.create<arith::XOrIOp>(loc, selectBuf, trueVal);
+    rewriter.replaceOp(tmpSelect, {toggle.getResult()});
+    select = selectBuf;
+  } else {
+    // Not really needed, but the BufferOp builder requires an input
+    auto bubble = rewriter.create<ConstantOp>(
+        loc, rewriter.getIntegerAttr(rewriter.getI1Type(), 0), ctrl);
+    auto selectBuf = rewriter.create<handshake::BufferOp>(
+        rewriter.getUnknownLoc(), rewriter.getI32Type(), 2, bubble,
+        BufferTypeEnum::seq);
+    // First select the tupleOut, afterwards the one with the EOS signal
+    selectBuf->setAttr("initValues", rewriter.getI64ArrayAttr({1, 0}));
+    select = selectBuf;
+  }
+
+  auto tupleOut = rewriter.create<MuxOp>(
+      loc, select, ValueRange({tupleOutVal, tupleOutEOS}));
+  auto ctrlOut = rewriter.create<MuxOp>(loc, select, ValueRange({ctrl, ctrl}));
+
+  return {tupleOut, ctrlOut};
+}
+
+/// Returns the input of an accumulator that is reset to its initial value
+/// once the accumulator was consumed by EOS. Restartable operations use this
+/// to prepare the accumulator for the next stream.
+static Value buildAccumulatorReset(Location loc, Type type, Value next,
+                                   Attribute initValue, Value eosCtrl,
+                                   ConversionPatternRewriter &rewriter) {
+  Value init = buildAttrConstant(loc, type, initValue, eosCtrl, rewriter);
+  return rewriter.create<handshake::MergeOp>(loc, ValueRange({next, init}));
+}
+
+/// Returns the operation that combines the accumulator with the element if
+/// the lowered region of a reduction applies a single associative and
+/// commutative operation on its arguments. Returns nullptr otherwise.
+static Operation *getAssociativeCombiner(Block *lambda) {
+  Value acc = lambda->getArgument(0);
+  Value val = lambda->getArgument(1);
+  if (acc.getType() != val.getType())
+    return nullptr;
+
+  Operation *combiner = lambda->getTerminator()->getOperand(0).getDefiningOp();
+  if (!combiner ||
+      !isa<arith::AddIOp, arith::MulIOp, arith::AndIOp, arith::OrIOp,
+           arith::XOrIOp, arith::MaxSIOp, arith::MinSIOp, arith::MaxUIOp,
+           arith::MinUIOp>(combiner))
+    return nullptr;
+
+  // The lowered region forwards its arguments through merges
+  auto getArg = [](Value v) -> Value {
+    if (auto merge = v.getDefiningOp<handshake::MergeOp>())
+      if (merge->getNumOperands() == 1)
+        return merge->getOperand(0);
+    return v;
+  };
+
+  Value lhs = getArg(combiner->getOperand(0));
+  Value rhs = getArg(combiner->getOperand(1));
+  if ((lhs == acc && rhs == val) || (lhs == val && rhs == acc))
+    return combiner;
+  return nullptr;
+}
+
+/// Returns the neutral element of an associative combiner.
+static APInt getIdentityValue(Operation *combiner, unsigned width) {
+  return TypeSwitch<Operation *, APInt>(combiner)
+      .Case<arith::MulIOp>([&](auto) { return APInt(width, 1); })
+      .Case<arith::AndIOp, arith::MinUIOp>(
+          [&](auto) { return APInt::getAllOnes(width); })
+      .Case<arith::MaxSIOp>(
+          [&](auto) { return APInt::getSignedMinValue(width); })
+      .Case<arith::MinSIOp>(
+          [&](auto) { return APInt::getSignedMaxValue(width); })
+      .Default([&](auto) { return APInt::getZero(width); });
+}
+
+/// Combines the values pairwise with the lowered region of an associative
+/// reduction until only a single value remains.
+static Value buildLambdaTree(Block *lambda, ArrayRef<Value> values, Value ctrl,
+                             ConversionPatternRewriter &rewriter) {
+  assert(values.size() > 0);
+  SmallVector<Value> level(values.begin(), values.end());
+  while (level.size() > 1) {
+    SmallVector<Value> nextLevel;
+    for (unsigned i = 0, e = level.size(); i + 1 < e; i += 2)
+      nextLevel.push_back(
+          cloneLambda(lambda, {level[i], level[i + 1], ctrl}, rewriter)[0]);
+    if (level.size() % 2 == 1)
+      nextLevel.push_back(level.back());
+    level = std::move(nextLevel);
+  }
+  return level.front();
+}
+
+/// Builds a reduction that distributes the elements in a round-robin fashion
+/// over multiple accumulators. As consecutive elements do not depend on each
+/// other, the latency of the region no longer limits the throughput. Once EOS
+/// arrives, the partial results are merged with a tree.
+///
+/// This is only valid for associative and commutative regions.
+static std::pair<Value, Value>
+buildParallelReduce(Block *lambda, Operation *combiner, unsigned numAccs,
+                    Type accType, Attribute initValue, Value data, Value eos,
+                    Value streamCtrl, bool restartable, Location loc,
+                    ConversionPatternRewriter &rewriter) {
+  Type cntType = rewriter.getI64Type();
+
+  // Index of the accumulator the next element is sent to
+  auto tmpCnt = rewriter.create<NeverOp>(loc, cntType);
+  auto cnt = rewriter.create<handshake::BufferOp>(loc, cntType, 1, tmpCnt,
+                                       BufferTypeEnum::seq);
+  cnt->setAttr("initValues", rewriter.getI64ArrayAttr({0}));
+
+  Value zero = buildConstant(loc, cntType, 0, streamCtrl, rewriter);
+  Value one = buildConstant(loc, cntType, 1, streamCtrl, rewriter);
+  Value last = buildConstant(loc, cntType, numAccs - 1, streamCtrl, rewriter);
+  auto incCnt = rewriter.create<arith::AddIOp>(loc, cnt, one);
+  auto wrap =
+      rewriter.create<arith::CmpIOp>(loc, arith::CmpIPredicate::eq, cnt, last);
+  auto reset = rewriter.create<arith::OrIOp>(loc, wrap, eos);
+  auto newCnt = rewriter.create<arith::SelectOp>(loc, reset, zero, incCnt);
+  rewriter.replaceOp(tmpCnt, {newCnt.getResult()});
+
+  Value trueVal =
+      buildConstant(loc, rewriter.getI1Type(), 1, streamCtrl, rewriter);
+  auto isData = rewriter.create<arith::XOrIOp>(loc, eos, trueVal);
+
+  auto eosCtrl =
+      rewriter.create<handshake::ConditionalBranchOp>(loc, eos, streamCtrl);
+
+  APInt identity = getIdentityValue(combiner, accType.getIntOrFloatBitWidth());
+  SmallVector<Value> partials;
+  for (unsigned i = 0; i < numAccs; ++i) {
+    Value idx = buildConstant(loc, cntType, i, streamCtrl, rewriter);
+    auto isSelected =
+        rewriter.create<arith::CmpIOp>(loc, arith::CmpIPredicate::eq, cnt, idx);
+    auto dataSel = rewriter.create<arith::AndIOp>(loc, isData, isSelected);
+    auto eventSel = rewriter.create<arith::OrIOp>(loc, eos, isSelected);
+
+    // Elements only visit their accumulator, while EOS visits all of them
+    auto laneData =
+        rewriter.create<handshake::ConditionalBranchOp>(loc, dataSel, data);
+    auto laneCtrl = rewriter.create<handshake::ConditionalBranchOp>(
+        loc, dataSel, streamCtrl);
+    auto laneEos =
+        rewriter.create<handshake::ConditionalBranchOp>(loc, eventSel, eos);
+
+    // Only one accumulator starts with the initial value
+    auto tmpAcc = rewriter.create<NeverOp>(loc, accType);
+    Attribute seed =
+        i == 0 ? initValue : rewriter.getIntegerAttr(accType, identity);
+    Value acc = buildInitializedBuffer(loc, accType, tmpAcc, seed, rewriter);
+    auto accBr = rewriter.create<handshake::ConditionalBranchOp>(
+        loc, laneEos.trueResult(), acc);
+
+    SmallVector<Value> res = cloneLambda(
+        lambda,
+        {accBr.falseResult(), laneData.trueResult(), laneCtrl.trueResult()},
+        rewriter);
+    Value next = res[0];
+    if (restartable)
+      next = buildAccumulatorReset(loc, accType, next, seed,
+                                   eosCtrl.trueResult(), rewriter);
+    rewriter.replaceOp(tmpAcc, {next});
+    partials.push_back(accBr.trueResult());
+  }
+
+  auto eosBr = rewriter.create<handshake::ConditionalBranchOp>(loc, eos, eos);
+  Value result =
+      buildLambdaTree(lambda, partials, eosCtrl.trueResult(), rewriter);
+
+  return buildReduceOutput(result, eosBr.trueResult(), eosCtrl.trueResult(),
+                           loc, rewriter, restartable);
+}
+
 /// Lowers a reduce operation to a ahndshake circuit
 ///
 /// Accumulates the result of the reduction in a buffer. On EOS this result is
@@ -423,6 +1307,14 @@ struct FilterOpLowering : public StreamOpLowering<FilterOp> {
 /// result.
 ///
 /// While the reduction is running, no output is produced.
+///
+/// For multi-lane inputs, all valid lanes of a transaction are folded into the
+/// accumulator at once.
+///
+/// Reductions with an associative and commutative region can use multiple
+/// accumulators, see buildParallelReduce.
+///
+/// Restartable reductions reset their accumulator to the initial value on EOS.
 struct ReduceOpLowering : public StreamOpLowering<ReduceOp> {
   using StreamOpLowering::StreamOpLowering;
 
@@ -439,10 +1331,9 @@ struct ReduceOpLowering : public StreamOpLowering<ReduceOp> {
     assert(resultTypes[0].isa<TupleType>());
     Type resultType = resultTypes[0].dyn_cast<TupleType>().getType(0);
 
-    // TODO: handshake currently only supports i64 buffers, change this as
-    // soon as support for other types is added.
-    assert(resultType == rewriter.getI64Type() &&
-           "currently, only i64 buffers are supported");
+    if (!isInitializable(resultType))
+      return op.emitError("cannot initialize accumulators with integers wider "
+                          "than 64 bits");
 
     Region r;
 
@@ -464,58 +1355,380 @@ struct ReduceOpLowering : public StreamOpLowering<ReduceOp> {
     Value eos = unpack.getResult(1);
 
     Block *lambda = &op.getRegion().front();
+    Operation *combiner = getAssociativeCombiner(lambda);
+    // The partial results of a parallel reduction are merged on a separate
+    // EOS transaction, so it requires the default encoding.
+    bool isParallel =
+        combiner && options.numAccumulators > 1 && !options.eosOnLast;
+    handshake::ReturnOp newTerm;
+    if (getLanes(op.input()) == 1 && isParallel) {
+      auto [tupleOut, ctrlOut] = buildParallelReduce(
+          lambda, combiner, options.numAccumulators, resultType,
+          adaptor.initValue(), data, eos, streamCtrl, options.restartable, loc,
+          rewriter);
+
+      newTerm = rewriter.create<handshake::ReturnOp>(
+          loc, ValueRange({tupleOut, ctrlOut, initCtrl}));
+    } else if (getLanes(op.input()) == 1 && !options.eosOnLast) {
+      Operation *oldTerm = lambda->getTerminator();
+      Value next = oldTerm->getOperand(0);
+      Value regionData = data;
+      Value regionCtrl = streamCtrl;
+      Value eosCtrl;
+      if (options.restartable) {
+        // The accumulator leaves the loop on EOS, so the EOS transaction must
+        // not enter the region. Otherwise, it would be combined with the
+        // accumulator of the next stream.
+        auto ctrlGate = rewriter.create<handshake::ConditionalBranchOp>(
+            loc, eos, streamCtrl);
+        auto dataGate =
+            rewriter.create<handshake::ConditionalBranchOp>(loc, eos, data);
+        regionData = dataGate.falseResult();
+        regionCtrl = ctrlGate.falseResult();
+        eosCtrl = ctrlGate.trueResult();
+        next = buildAccumulatorReset(loc, resultType, next,
+                                     adaptor.initValue(), eosCtrl, rewriter);
+      }
+      Value buffer = buildInitializedBuffer(loc, resultType, next,
+                                            adaptor.initValue(), rewriter);
+
+      auto dataBr = rewriter.create<handshake::ConditionalBranchOp>(
+          rewriter.getUnknownLoc(), eos, buffer);
+      auto eosBr = rewriter.create<handshake::ConditionalBranchOp>(
+          rewriter.getUnknownLoc(), eos, eos);
+      if (!options.restartable)
+        eosCtrl = rewriter
+                      .create<handshake::ConditionalBranchOp>(
+                          rewriter.getUnknownLoc(), eos, oldTerm->getOperand(1))
+                      .trueResult();
+
+      rewriter.mergeBlocks(
+          lambda, entryBlock,
+          ValueRange({dataBr.falseResult(), regionData, regionCtrl}));
+
+      rewriter.setInsertionPoint(oldTerm);
+
+      auto [tupleOut, ctrlOut] =
+          buildReduceOutput(dataBr.trueResult(), eosBr.trueResult(), eosCtrl,
+                            loc, rewriter, options.restartable);
+
+      SmallVector<Value> newTermOperands = {tupleOut, ctrlOut, initCtrl};
+
+      newTerm = rewriter.replaceOpWithNewOp<handshake::ReturnOp>(
+          oldTerm, newTermOperands);
+    } else {
+      // The accumulator's input is only known once all lanes are folded
+      auto tmpAcc = rewriter.create<NeverOp>(loc, resultType);
+      Value buffer = buildInitializedBuffer(loc, resultType, tmpAcc,
+                                            adaptor.initValue(), rewriter);
+
+      // Folds the valid lanes into the accumulator. The EOS transaction can
+      // carry valid lanes as well, and with EOS on the last element, it
+      // always carries an element.
+      Value acc = buffer;
+      Value ctrl;
+      SmallVector<Value> elements, valid;
+      if (getLanes(op.input()) == 1) {
+        SmallVector<Value> res =
+            cloneLambda(lambda, {acc, data, streamCtrl}, rewriter);
+        acc = res[0];
+        ctrl = res[1];
+      } else if (combiner) {
+        unpackLanes(data, loc, rewriter, elements, valid);
+        // Invalid lanes are replaced by the neutral element, which allows to
+        // combine the lanes with a tree before updating the accumulator.
+        APInt identity =
+            getIdentityValue(combiner, resultType.getIntOrFloatBitWidth());
+        SmallVector<Value> laneValues;
+        for (auto [element, isValid] : llvm::zip(elements, valid)) {
+          auto neutral = rewriter.create<handshake::ConstantOp>(
+              loc, rewriter.getIntegerAttr(resultType, identity), streamCtrl);
+          laneValues.push_back(
+              rewriter.create<arith::SelectOp>(loc, isValid, element, neutral));
+        }
+        Value beat = buildLambdaTree(lambda, laneValues, streamCtrl, rewriter);
+        SmallVector<Value> res =
+            cloneLambda(lambda, {acc, beat, streamCtrl}, rewriter);
+        acc = res[0];
+        ctrl = res[1];
+      } else {
+        unpackLanes(data, loc, rewriter, elements, valid);
+        SmallVector<Value> laneCtrls;
+        for (auto [element, isValid] : llvm::zip(elements, valid)) {
+          SmallVector<Value> laneRes =
+              cloneLambda(lambda, {acc, element, streamCtrl}, rewriter);
+          acc =
+              rewriter.create<arith::SelectOp>(loc, isValid, laneRes[0], acc);
+          laneCtrls.push_back(laneRes[1]);
+        }
+        ctrl = rewriter.create<JoinOp>(loc, laneCtrls);
+      }
 
-    Operation *oldTerm = lambda->getTerminator();
-    auto buffer = rewriter.create<handshake::BufferOp>(
-        rewriter.getUnknownLoc(), resultType, 1, oldTerm->getOperand(0),
-        BufferTypeEnum::seq);
-    // This does return an unsigned integer but expects signed integers
-    // TODO check if this is an MLIR bug
-    buffer->setAttr("initValues",
-                    rewriter.getI64ArrayAttr({(int64_t)adaptor.initValue()}));
+      auto dataBr = rewriter.create<handshake::ConditionalBranchOp>(
+          rewriter.getUnknownLoc(), eos, acc);
+      auto eosBr = rewriter.create<handshake::ConditionalBranchOp>(
+          rewriter.getUnknownLoc(), eos, eos);
+      auto ctrlBr = rewriter.create<handshake::ConditionalBranchOp>(
+          rewriter.getUnknownLoc(), eos, ctrl);
+      Value next = dataBr.falseResult();
+      if (options.restartable)
+        next = buildAccumulatorReset(loc, resultType, next,
+                                     adaptor.initValue(), ctrlBr.trueResult(),
+                                     rewriter);
+      rewriter.replaceOp(tmpAcc, {next});
+
+      auto [tupleOut, ctrlOut] =
+          buildReduceOutput(dataBr.trueResult(), eosBr.trueResult(),
+                            ctrlBr.trueResult(), loc, rewriter,
+                            options.restartable, options.eosOnLast);
+
+      newTerm = rewriter.create<handshake::ReturnOp>(
+          loc, ValueRange({tupleOut, ctrlOut, initCtrl}));
+    }
 
-    auto dataBr = rewriter.create<handshake::ConditionalBranchOp>(
-        rewriter.getUnknownLoc(), eos, buffer);
-    auto eosBr = rewriter.create<handshake::ConditionalBranchOp>(
-        rewriter.getUnknownLoc(), eos, eos);
-    auto ctrlBr = rewriter.create<handshake::ConditionalBranchOp>(
-        rewriter.getUnknownLoc(), eos, oldTerm->getOperand(1));
+    SmallVector<Value> operands;
+    resolveNewOperands(op, adaptor.getOperands(), operands);
 
-    rewriter.mergeBlocks(lambda, entryBlock,
-                         ValueRange({dataBr.falseResult(), data, streamCtrl}));
+    rewriter.setInsertionPointToStart(getTopLevelBlock(op));
+    FuncOp newFuncOp = createFuncOp(r, symbolUniquer.getUniqueSymName(op),
+                                    entryBlock->getArgumentTypes(),
+                                    newTerm.getOperandTypes(), rewriter);
 
-    rewriter.setInsertionPoint(oldTerm);
+    replaceWithInstance(op, newFuncOp, operands, rewriter);
+    return success();
+  }
+};
+
+/// Selects the value whose flag is set, of which there is at most one, with a
+/// balanced tree of selects. Returns the selected value and whether any flag
+/// is set. Without a set flag, the selected value is unspecified.
+static std::pair<Value, Value>
+buildOneHotSelect(ArrayRef<Value> values, ArrayRef<Value> flags, Location loc,
+                  ConversionPatternRewriter &rewriter) {
+  SmallVector<Value> level(values.begin(), values.end());
+  SmallVector<Value> levelFlags(flags.begin(), flags.end());
+  while (level.size() > 1) {
+    SmallVector<Value> next, nextFlags;
+    for (size_t i = 0; i + 1 < level.size(); i += 2) {
+      next.push_back(rewriter.create<arith::SelectOp>(loc, levelFlags[i],
+                                                      level[i], level[i + 1]));
+      nextFlags.push_back(rewriter.create<arith::OrIOp>(loc, levelFlags[i],
+                                                        levelFlags[i + 1]));
+    }
+    if (level.size() % 2 == 1) {
+      next.push_back(level.back());
+      nextFlags.push_back(levelFlags.back());
+    }
+    level = std::move(next);
+    levelFlags = std::move(nextFlags);
+  }
+  return {level.front(), levelFlags.front()};
+}
 
-    // Connect outputs and ensure correct delay between value and EOS=true
-    // emission A sequental buffer ensures a cycle delay of 1
-    auto eosFalse = rewriter.create<handshake::ConstantOp>(
-        rewriter.getUnknownLoc(),
-        rewriter.getIntegerAttr(rewriter.getI1Type(), 0), ctrlBr.trueResult());
-    auto tupleOutVal = rewriter.create<handshake::PackOp>(
-        loc, ValueRange({dataBr.trueResult(), eosFalse}));
+/// Lowers a reduce_by_key operation to a handshake circuit
+///
+/// The accumulators are held in `capacity` slots of a valid flag, a key, and
+/// an accumulator. Every transaction visits all slots and compares its key
+/// with each of them at once, like a CAM, so collisions cannot occur. An
+/// element either hits the slot of its key or claims the slot of the
+/// replacement pointer, which advances in a round-robin fashion. A single copy
+/// of the region updates the accumulator, which is selected out of the slots
+/// with a balanced tree. Like for reduce, a new element can thus be accepted
+/// once the previous one went through the region.
+///
+/// Claiming an occupied slot emits its previous contents. The EOS transaction
+/// is held in a loop, like the transactions of an unbatch, and emits the
+/// contents of one slot per iteration, followed by the EOS itself. The slots
+/// are cleared on the way, which prepares the table for the next stream.
+struct ReduceByKeyOpLowering : public StreamOpLowering<ReduceByKeyOp> {
+  using StreamOpLowering::StreamOpLowering;
 
-    auto tupleOutEOS = rewriter.create<handshake::PackOp>(
-        loc, ValueRange({dataBr.trueResult(), eosBr.trueResult()}));
+  LogicalResult
+  matchAndRewrite(ReduceByKeyOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    if (failed(verifySeparateEos(op, options)))
+      return failure();
 
-    // Not really needed, but the BufferOp builder requires an input
-    auto bubble = rewriter.create<ConstantOp>(
-        loc, rewriter.getIntegerAttr(rewriter.getI1Type(), 0),
-        ctrlBr.trueResult());
-    auto select = rewriter.create<handshake::BufferOp>(
-        rewriter.getUnknownLoc(), rewriter.getI32Type(), 2, bubble,
-        BufferTypeEnum::seq);
-    // First select the tupleOut, afterwards the one with the EOS signal
-    select->setAttr("initValues", rewriter.getI64ArrayAttr({1, 0}));
+    Location loc = op.getLoc();
+    TypeConverter *typeConverter = getTypeConverter();
 
-    auto tupleOut = rewriter.create<MuxOp>(
-        loc, select, ValueRange({tupleOutVal, tupleOutEOS}));
-    auto ctrlOut = rewriter.create<MuxOp>(
-        loc, select, ValueRange({ctrlBr.trueResult(), ctrlBr.trueResult()}));
+    auto elementType = op.result()
+                           .getType()
+                           .cast<StreamType>()
+                           .getElementType()
+                           .cast<TupleType>();
+    Type keyType = elementType.getType(0);
+    Type accType = elementType.getType(1);
+    if (!isInitializable(keyType) || !isInitializable(accType))
+      return op.emitError("cannot initialize accumulators with integers wider "
+                          "than 64 bits");
 
-    SmallVector<Value> newTermOperands = {tupleOut, ctrlOut, initCtrl};
+    Region r;
 
-    auto newTerm = rewriter.replaceOpWithNewOp<handshake::ReturnOp>(
-        oldTerm, newTermOperands);
+    SmallVector<Type> inputTypes;
+    if (failed(typeConverter->convertTypes(op->getOperandTypes(), inputTypes)))
+      return failure();
+    inputTypes.push_back(rewriter.getNoneType());
+
+    SmallVector<Location> argLocs(inputTypes.size(), loc);
+
+    Block *entryBlock =
+        rewriter.createBlock(&r, r.begin(), inputTypes, argLocs);
+    Value tupleIn = entryBlock->getArgument(0);
+    Value streamCtrl = entryBlock->getArgument(1);
+    Value initCtrl = entryBlock->getArgument(2);
+
+    uint64_t capacity = op.capacity();
+    Type i1Type = rewriter.getI1Type();
+    Type noneType = rewriter.getNoneType();
+
+    // Selects the held EOS transaction instead of a new one
+    auto tmpSelect = rewriter.create<NeverOp>(loc, i1Type);
+    Value select = buildInitializedBuffer(
+        loc, i1Type, tmpSelect, rewriter.getIntegerAttr(i1Type, 0), rewriter);
+    auto tmpHeld = rewriter.create<NeverOp>(loc, tupleIn.getType());
+    auto tmpHeldCtrl = rewriter.create<NeverOp>(loc, noneType);
+    Value current =
+        rewriter.create<MuxOp>(loc, select, ValueRange({tupleIn, tmpHeld}));
+    Value ctrl = rewriter.create<MuxOp>(
+        loc, select, ValueRange({streamCtrl, tmpHeldCtrl}));
+
+    auto unpack = rewriter.create<handshake::UnpackOp>(loc, current);
+    auto fields =
+        rewriter.create<handshake::UnpackOp>(loc, unpack.getResult(0));
+    Value key = fields.getResult(0);
+    Value value = fields.getResult(1);
+    Value eos = unpack.getResult(1);
+
+    // The slot that the EOS iteration flushes, capacity for the EOS itself.
+    // The replacement pointer uses the same type.
+    Type idxType = rewriter.getIntegerType(llvm::Log2_64_Ceil(capacity + 1));
+    auto tmpIdx = rewriter.create<NeverOp>(loc, idxType);
+    Value idx = buildInitializedBuffer(
+        loc, idxType, tmpIdx, rewriter.getIntegerAttr(idxType, 0), rewriter);
+    auto tmpPtr = rewriter.create<NeverOp>(loc, idxType);
+    Value ptr = buildInitializedBuffer(
+        loc, idxType, tmpPtr, rewriter.getIntegerAttr(idxType, 0), rewriter);
+
+    Value trueVal = buildConstant(loc, i1Type, 1, ctrl, rewriter);
+    Value end = buildConstant(loc, idxType, capacity, ctrl, rewriter);
+    auto isData = rewriter.create<arith::XOrIOp>(loc, eos, trueVal);
+    auto atEnd =
+        rewriter.create<arith::CmpIOp>(loc, arith::CmpIPredicate::eq, idx, end);
+    // The slot whose contents are emitted
+    auto target = rewriter.create<arith::SelectOp>(loc, eos, idx, ptr);
+
+    SmallVector<NeverOp> tmpValid, tmpKeys, tmpAccs;
+    SmallVector<Value> valid, keys, accs, hits, atPtr, atTarget;
+    for (uint64_t i = 0; i < capacity; ++i) {
+      tmpValid.push_back(rewriter.create<NeverOp>(loc, i1Type));
+      valid.push_back(buildInitializedBuffer(
+          loc, i1Type, tmpValid.back(), rewriter.getIntegerAttr(i1Type, 0),
+          rewriter));
+      tmpKeys.push_back(rewriter.create<NeverOp>(loc, keyType));
+      keys.push_back(buildInitializedBuffer(
+          loc, keyType, tmpKeys.back(), rewriter.getIntegerAttr(keyType, 0),
+          rewriter));
+      tmpAccs.push_back(rewriter.create<NeverOp>(loc, accType));
+      accs.push_back(buildInitializedBuffer(loc, accType, tmpAccs.back(),
+                                            adaptor.initValue(), rewriter));
+
+      auto sameKey = rewriter.create<arith::CmpIOp>(
+          loc, arith::CmpIPredicate::eq, keys[i], key);
+      hits.push_back(rewriter.create<arith::AndIOp>(loc, valid[i], sameKey));
+
+      Value slot = buildConstant(loc, idxType, i, ctrl, rewriter);
+      atPtr.push_back(rewriter.create<arith::CmpIOp>(
+          loc, arith::CmpIPredicate::eq, ptr, slot));
+      atTarget.push_back(rewriter.create<arith::CmpIOp>(
+          loc, arith::CmpIPredicate::eq, target, slot));
+    }
+
+    // At most one slot holds the key, new keys start with the initial value
+    auto [hitAcc, hit] = buildOneHotSelect(accs, hits, loc, rewriter);
+    Value init =
+        buildAttrConstant(loc, accType, adaptor.initValue(), ctrl, rewriter);
+    auto acc = rewriter.create<arith::SelectOp>(loc, hit, hitAcc, init);
+
+    Value outKey = buildOneHotSelect(keys, atTarget, loc, rewriter).first;
+    Value outAcc = buildOneHotSelect(accs, atTarget, loc, rewriter).first;
+    auto [targetValid, anyTarget] =
+        buildOneHotSelect(valid, atTarget, loc, rewriter);
+    auto outValid = rewriter.create<arith::AndIOp>(loc, targetValid, anyTarget);
+
+    SmallVector<Value> res = cloneLambda(
+        &op.getRegion().front(), {acc, value, ctrl}, rewriter);
+    Value updated = res[0];
+
+    auto notHit = rewriter.create<arith::XOrIOp>(loc, hit, trueVal);
+    auto miss = rewriter.create<arith::AndIOp>(loc, isData, notHit);
+    for (uint64_t i = 0; i < capacity; ++i) {
+      auto claim = rewriter.create<arith::AndIOp>(loc, miss, atPtr[i]);
+      // The zero key of an EOS transaction must not update the slot of key 0
+      auto dataHit = rewriter.create<arith::AndIOp>(loc, hits[i], isData);
+      auto update = rewriter.create<arith::OrIOp>(loc, dataHit, claim);
+      rewriter.replaceOp(tmpAccs[i], {rewriter.create<arith::SelectOp>(
+                                         loc, update, updated, accs[i])});
+      rewriter.replaceOp(tmpKeys[i], {rewriter.create<arith::SelectOp>(
+                                         loc, claim, key, keys[i])});
+      // The EOS iterations clear the slots they flush
+      auto flushed = rewriter.create<arith::AndIOp>(loc, eos, atTarget[i]);
+      auto kept = rewriter.create<arith::XOrIOp>(loc, flushed, trueVal);
+      auto occupied = rewriter.create<arith::OrIOp>(loc, valid[i], claim);
+      rewriter.replaceOp(tmpValid[i], {rewriter.create<arith::AndIOp>(
+                                          loc, occupied, kept)});
+    }
+
+    Value zero = buildConstant(loc, idxType, 0, ctrl, rewriter);
+    Value one = buildConstant(loc, idxType, 1, ctrl, rewriter);
+    Value last = buildConstant(loc, idxType, capacity - 1, ctrl, rewriter);
+    auto atLast = rewriter.create<arith::CmpIOp>(
+        loc, arith::CmpIPredicate::eq, ptr, last);
+    auto incPtr = rewriter.create<arith::AddIOp>(loc, ptr, one);
+    auto advanced =
+        rewriter.create<arith::SelectOp>(loc, atLast, zero, incPtr);
+    auto nextPtr = rewriter.create<arith::SelectOp>(loc, miss, advanced, ptr);
+    rewriter.replaceOp(tmpPtr, {rewriter.create<arith::SelectOp>(
+                                   loc, eos, zero, nextPtr)});
+
+    auto done = rewriter.create<arith::OrIOp>(loc, isData, atEnd);
+    auto incIdx = rewriter.create<arith::AddIOp>(loc, idx, one);
+    rewriter.replaceOp(tmpIdx, {rewriter.create<arith::SelectOp>(
+                                   loc, done, zero, incIdx)});
+
+    // The EOS transaction stays in the loop until all slots are flushed
+    auto heldBr =
+        rewriter.create<handshake::ConditionalBranchOp>(loc, done, current);
+    auto heldCtrlBr =
+        rewriter.create<handshake::ConditionalBranchOp>(loc, done, ctrl);
+    rewriter.replaceOp(tmpHeld,
+                       {rewriter.create<handshake::BufferOp>(
+                           loc, tupleIn.getType(), 1, heldBr.falseResult(),
+                           BufferTypeEnum::seq)});
+    rewriter.replaceOp(tmpHeldCtrl,
+                       {rewriter.create<handshake::BufferOp>(
+                           loc, noneType, 1, heldCtrlBr.falseResult(),
+                           BufferTypeEnum::seq)});
+    rewriter.replaceOp(tmpSelect,
+                       {rewriter.create<arith::XOrIOp>(loc, done, trueVal)});
+
+    // Elements emit the slot they evict, the EOS iterations each occupied
+    // slot and finally the EOS
+    auto evict = rewriter.create<arith::AndIOp>(loc, miss, outValid);
+    auto flush = rewriter.create<arith::OrIOp>(loc, outValid, atEnd);
+    auto flushEmit = rewriter.create<arith::AndIOp>(loc, eos, flush);
+    auto emit = rewriter.create<arith::OrIOp>(loc, evict, flushEmit);
+    auto result =
+        rewriter.create<handshake::PackOp>(loc, ValueRange({outKey, outAcc}));
+    auto tupleOut =
+        rewriter.create<handshake::PackOp>(loc, ValueRange({result, atEnd}));
+    auto dataBr =
+        rewriter.create<handshake::ConditionalBranchOp>(loc, emit, tupleOut);
+    auto ctrlBr =
+        rewriter.create<handshake::ConditionalBranchOp>(loc, emit, ctrl);
+
+    auto newTerm = rewriter.create<handshake::ReturnOp>(
+        loc, ValueRange({dataBr.trueResult(), ctrlBr.trueResult(), initCtrl}));
 
     SmallVector<Value> operands;
     resolveNewOperands(op, adaptor.getOperands(), operands);
@@ -524,7 +1737,6 @@ struct ReduceOpLowering : public StreamOpLowering<ReduceOp> {
     FuncOp newFuncOp = createFuncOp(r, symbolUniquer.getUniqueSymName(op),
                                     entryBlock->getArgumentTypes(),
                                     newTerm.getOperandTypes(), rewriter);
-
     replaceWithInstance(op, newFuncOp, operands, rewriter);
     return success();
   }
@@ -554,6 +1766,164 @@ struct UnpackOpLowering : public OpConversionPattern<stream::UnpackOp> {
   }
 };
 
+/// Builds the control loop of a stream source. The ctrl input is only used
+/// once to start the source, afterwards each emitted element triggers the next
+/// one. Returns the ctrl signal of the emitted elements.
+static Value buildSourceCtrl(Value ctrlIn, Location loc,
+                             ConversionPatternRewriter &rewriter) {
+  // Only use in ctrl once
+  // TODO ensure that subsequent ctrl inputs are ignored
+  auto falseVal = rewriter.create<handshake::ConstantOp>(
+      rewriter.getUnknownLoc(),
+      rewriter.getIntegerAttr(rewriter.getI1Type(), 0), ctrlIn);
+  auto fst = rewriter.create<handshake::BufferOp>(
+      loc, rewriter.getI1Type(), 1, falseVal, BufferTypeEnum::seq);
+  fst->setAttr("initValues", rewriter.getI64ArrayAttr({1}));
+  auto useCtrl =
+      rewriter.create<handshake::ConditionalBranchOp>(loc, fst, ctrlIn);
+
+  // Ctrl "looping" and selection
+  // We have to change the input later on
+  auto tmpCtrl = rewriter.create<NeverOp>(loc, rewriter.getNoneType());
+  auto ctrlBuf = rewriter.create<handshake::BufferOp>(
+      loc, rewriter.getNoneType(), 1, tmpCtrl, BufferTypeEnum::seq);
+  auto ctrl = rewriter.create<handshake::MergeOp>(
+      loc, ValueRange({useCtrl.trueResult(), ctrlBuf}));
+  rewriter.replaceOp(tmpCtrl, {ctrl});
+  return ctrl;
+}
+
+/// Builds the control loop of a restartable stream source. Each token of the
+/// ctrl input starts a new stream, which ends with the transaction that
+/// asserts `finished`. Afterwards, the loop waits for the next ctrl input.
+static Value buildRestartableSourceCtrl(Value ctrlIn, Value finished,
+                                        Location loc,
+                                        ConversionPatternRewriter &rewriter) {
+  // Initially, and after each EOS, the source is idle
+  auto idle = rewriter.create<handshake::BufferOp>(
+      loc, rewriter.getI1Type(), 1, finished, BufferTypeEnum::seq);
+  idle->setAttr("initValues", rewriter.getI64ArrayAttr({1}));
+
+  auto tmpCtrl = rewriter.create<NeverOp>(loc, rewriter.getNoneType());
+  auto ctrl = rewriter.create<MuxOp>(loc, idle, ValueRange({tmpCtrl, ctrlIn}));
+
+  // Only loop back while the stream has not ended
+  auto loopBr =
+      rewriter.create<handshake::ConditionalBranchOp>(loc, finished, ctrl);
+  auto ctrlBuf = rewriter.create<handshake::BufferOp>(
+      loc, rewriter.getNoneType(), 1, loopBr.falseResult(),
+      BufferTypeEnum::seq);
+  rewriter.replaceOp(tmpCtrl, {ctrlBuf.getResult()});
+  return ctrl;
+}
+
+/// Returns whether the consumers of a source cancelled its stream. They emit
+/// a flag for each transaction they receive, which arrives after the source
+/// emitted `slack` further transactions, so a buffer with `slack` initial
+/// flags decouples both sides. At the start of a stream, the buffer may hold
+/// the flags of the end of the previous one, which are thus ignored. A single
+/// flag need not be ignored, as it belongs to the EOS transaction, which is
+/// never cancelled.
+static Value buildCancelFlag(Value cancelIn, Value cnt, unsigned slack,
+                             Value ctrl, Location loc,
+                             ConversionPatternRewriter &rewriter) {
+  Type i1Type = rewriter.getI1Type();
+  auto buffer = rewriter.create<handshake::BufferOp>(
+      loc, i1Type, slack, cancelIn, BufferTypeEnum::seq);
+  buffer->setAttr("initValues",
+                  rewriter.getI64ArrayAttr(SmallVector<int64_t>(slack, 0)));
+  if (slack == 1)
+    return buffer;
+
+  Value slackVal = buildConstant(loc, cnt.getType(), slack, ctrl, rewriter);
+  auto decoupled = rewriter.create<arith::CmpIOp>(
+      loc, arith::CmpIPredicate::uge, cnt, slackVal);
+  return rewriter.create<arith::AndIOp>(loc, buffer, decoupled);
+}
+
+/// Builds a counter that is incremented for each element a source emits.
+/// Returns the counter and a flag that indicates that `numElements` elements
+/// were emitted, i.e., that the source has to emit EOS. Restartable sources
+/// reset the counter after EOS. If `cancelIn` is provided, the source also
+/// emits EOS once its consumers cancel the stream, see buildCancelFlag.
+static std::pair<Value, Value>
+buildSourceCounter(int64_t numElements, Value ctrl, Location loc,
+                   ConversionPatternRewriter &rewriter,
+                   bool restartable = false, Value cancelIn = {},
+                   unsigned slack = 1) {
+  auto tmpCnt = rewriter.create<NeverOp>(loc, rewriter.getI64Type());
+  auto cnt = rewriter.create<handshake::BufferOp>(
+      loc, rewriter.getI64Type(), 1, tmpCnt, BufferTypeEnum::seq);
+  // initialize cnt to 0 to indicate that 0 elements were emitted
+  cnt->setAttr("initValues", rewriter.getI64ArrayAttr({0}));
+
+  auto one = rewriter.create<handshake::ConstantOp>(
+      loc, rewriter.getIntegerAttr(rewriter.getI64Type(), 1), ctrl);
+
+  auto sizeConst = rewriter.create<handshake::ConstantOp>(
+      loc, rewriter.getIntegerAttr(rewriter.getI64Type(), numElements), ctrl);
+
+  Value finished = rewriter.create<arith::CmpIOp>(
+      loc, arith::CmpIPredicate::eq, cnt, sizeConst);
+  if (cancelIn)
+    finished = rewriter.create<arith::OrIOp>(
+        loc, finished,
+        buildCancelFlag(cancelIn, cnt, slack, ctrl, loc, rewriter));
+
+  Value newCnt = rewriter.create<arith::AddIOp>(loc, cnt, one);
+  if (restartable) {
+    auto zero = rewriter.create<handshake::ConstantOp>(
+        loc, rewriter.getIntegerAttr(rewriter.getI64Type(), 0), ctrl);
+    newCnt = rewriter.create<arith::SelectOp>(loc, finished, zero, newCnt);
+  }
+  // ensure looping of cnt
+  rewriter.replaceOp(tmpCnt, {newCnt});
+
+  return {cnt, finished};
+}
+
+/// Builds a lookup table that emits `values[idx]` for each index it receives.
+/// Handshake memories cannot be initialized, so a tree of branches forwards
+/// the ctrl signal to the constant of the requested entry and a mux selects
+/// its value. The logic thus grows linearly with the number of entries, but
+/// in contrast to a buffer, no entry requires a register.
+static Value buildLookupTable(ArrayRef<APInt> values, Type type, Value idx,
+                              Value ctrl, Location loc,
+                              ConversionPatternRewriter &rewriter) {
+  SmallVector<Value> entries(values.size());
+  Type idxType = idx.getType();
+
+  // Steers the ctrl signal through the node that is responsible for the
+  // entries [base, base + 2^level). Nodes only receive the index when they are
+  // on the path to the requested entry.
+  std::function<void(unsigned, size_t, Value, Value)> steer =
+      [&](unsigned level, size_t base, Value nodeIdx, Value nodeCtrl) {
+        if (level == 0) {
+          entries[base] = rewriter.create<handshake::ConstantOp>(
+              loc, rewriter.getIntegerAttr(type, values[base]), nodeCtrl);
+          return;
+        }
+        --level;
+        auto shift = rewriter.create<handshake::ConstantOp>(
+            loc, rewriter.getIntegerAttr(idxType, level), nodeCtrl);
+        auto shifted = rewriter.create<arith::ShRUIOp>(loc, nodeIdx, shift);
+        auto bit = rewriter.create<arith::TruncIOp>(loc, rewriter.getI1Type(),
+                                                    shifted);
+        auto idxBr =
+            rewriter.create<handshake::ConditionalBranchOp>(loc, bit, nodeIdx);
+        auto ctrlBr =
+            rewriter.create<handshake::ConditionalBranchOp>(loc, bit, nodeCtrl);
+
+        steer(level, base, idxBr.falseResult(), ctrlBr.falseResult());
+        size_t upper = base + (size_t(1) << level);
+        if (upper < values.size())
+          steer(level, upper, idxBr.trueResult(), ctrlBr.trueResult());
+      };
+  steer(llvm::Log2_64_Ceil(values.size()), 0, idx, ctrl);
+
+  return rewriter.create<MuxOp>(loc, idx, entries);
+}
+
 struct CreateOpLowering : public StreamOpLowering<CreateOp> {
   using StreamOpLowering::StreamOpLowering;
 
@@ -561,111 +1931,227 @@ struct CreateOpLowering : public StreamOpLowering<CreateOp> {
   LogicalResult
   matchAndRewrite(stream::CreateOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
+    if (getLanes(op.result()) != 1)
+      return op.emitError("cannot create multi-lane streams");
+
     Region r;
     Location loc = op.getLoc();
 
     Block *entryBlock = rewriter.createBlock(&r, {}, {rewriter.getNoneType()},
                                              {rewriter.getUnknownLoc()});
 
-    // TODO ensure that subsequent ctrl inputs are ignored
     Value ctrlIn = entryBlock->getArgument(0);
-    size_t bufSize = op.values().size();
+    Value cancelIn;
+    bool cancellable = cancelSignals.canCancel(op.result());
+    if (cancellable)
+      cancelIn = addCancelArgument(entryBlock, loc, rewriter);
+    size_t bufSize = op.values().getNumElements();
     Type elementType = op.getElementType();
     assert(elementType.isa<IntegerType>());
 
+    if (options.eosOnLast && bufSize == 0)
+      return op.emitError("cannot create empty streams with EOS on the last "
+                          "element");
+    // Index of the transaction that carries EOS
+    size_t eosIdx = options.eosOnLast ? bufSize - 1 : bufSize;
+
     rewriter.setInsertionPointToEnd(entryBlock);
 
-    // Only use in ctrl once
-    auto falseVal = rewriter.create<handshake::ConstantOp>(
-        rewriter.getUnknownLoc(),
-        rewriter.getIntegerAttr(rewriter.getI1Type(), 0), ctrlIn);
-    auto fst = rewriter.create<BufferOp>(loc, rewriter.getI1Type(), 1, falseVal,
-                                         BufferTypeEnum::seq);
-    fst->setAttr("initValues", rewriter.getI64ArrayAttr({1}));
-    auto useCtrl =
-        rewriter.create<handshake::ConditionalBranchOp>(loc, fst, ctrlIn);
-
-    // Ctrl "looping" and selection
-    // We have to change the input later on
-    auto tmpCtrl = rewriter.create<NeverOp>(loc, rewriter.getNoneType());
-    auto ctrlBuf = rewriter.create<BufferOp>(loc, rewriter.getNoneType(), 1,
-                                             tmpCtrl, BufferTypeEnum::seq);
-    auto ctrl = rewriter.create<MergeOp>(
-        loc, ValueRange({useCtrl.trueResult(), ctrlBuf}));
-    rewriter.replaceOp(tmpCtrl, {ctrl});
+    // A cancelled source has to stop after EOS, as its counter does not
+    // reach the end of the stream
+    NeverOp tmpFinished;
+    Value ctrl;
+    if (options.restartable || cancellable) {
+      tmpFinished = rewriter.create<NeverOp>(loc, rewriter.getI1Type());
+      ctrl = buildRestartableSourceCtrl(ctrlIn, tmpFinished, loc, rewriter);
+    } else {
+      ctrl = buildSourceCtrl(ctrlIn, loc, rewriter);
+    }
 
     // Data part
+    Value data, finished;
+    if (options.restartable || (options.createRomThreshold > 0 &&
+                                bufSize >= options.createRomThreshold)) {
+      // Large sources read their elements from a lookup table, as a buffer
+      // would require a register per element. Restartable sources have to emit
+      // their elements multiple times, which a buffer does not allow.
+      Value cnt;
+      std::tie(cnt, finished) =
+          buildSourceCounter(eosIdx, ctrl, loc, rewriter, options.restartable,
+                             cancelIn, options.cancelSlack);
+
+      // A separate EOS transaction reads the entry after the last element
+      SmallVector<APInt> values =
+          llvm::to_vector(op.values().getValues<APInt>());
+      if (!options.eosOnLast)
+        values.push_back(APInt(elementType.getIntOrFloatBitWidth(), 0));
+      data = buildLookupTable(values, elementType, cnt, ctrl, loc, rewriter);
+    } else {
+      auto bubble = rewriter.create<handshake::ConstantOp>(
+          loc, rewriter.getIntegerAttr(elementType, 0), ctrl);
+      data = bubble;
+      // An empty stream only consists of the EOS transaction, which does not
+      // need a buffer
+      if (bufSize > 0) {
+        auto dataBuf = rewriter.create<handshake::BufferOp>(
+            loc, elementType, bufSize, bubble, BufferTypeEnum::seq);
+        // The buffer works in reverse
+        SmallVector<int64_t> values;
+        for (APInt value : llvm::reverse(op.values().getValues<APInt>()))
+          values.push_back(value.getSExtValue());
+        dataBuf->setAttr("initValues", rewriter.getI64ArrayAttr(values));
+        data = dataBuf;
+      }
 
-    auto bubble = rewriter.create<handshake::ConstantOp>(
-        loc, rewriter.getIntegerAttr(elementType, 0), ctrl);
-    auto dataBuf = rewriter.create<BufferOp>(loc, elementType, bufSize, bubble,
-                                             BufferTypeEnum::seq);
-    // The buffer works in reverse
-    SmallVector<int64_t> values;
-    for (auto attr : llvm::reverse(op.values())) {
-      assert(attr.isa<IntegerAttr>());
-      values.push_back(attr.dyn_cast<IntegerAttr>().getInt());
+      std::tie(std::ignore, finished) =
+          buildSourceCounter(eosIdx, ctrl, loc, rewriter,
+                             /*restartable=*/false, cancelIn,
+                             options.cancelSlack);
     }
-    dataBuf->setAttr("initValues", rewriter.getI64ArrayAttr(values));
-    auto cnt = rewriter.create<BufferOp>(loc, rewriter.getI64Type(), 1, bubble,
-                                         BufferTypeEnum::seq);
-    // initialize cnt to 0 to indicate that 0 elements were emitted
-    cnt->setAttr("initValues", rewriter.getI64ArrayAttr({0}));
+    if (tmpFinished)
+      rewriter.replaceOp(tmpFinished, {finished});
 
-    auto one = rewriter.create<handshake::ConstantOp>(
-        loc, rewriter.getIntegerAttr(rewriter.getI64Type(), 1), ctrl);
-
-    auto sizeConst = rewriter.create<handshake::ConstantOp>(
-        loc, rewriter.getIntegerAttr(rewriter.getI64Type(), bufSize), ctrl);
-
-    auto finished = rewriter.create<arith::CmpIOp>(
-        loc, arith::CmpIPredicate::eq, cnt, sizeConst);
-
-    auto newCnt = rewriter.create<arith::AddIOp>(op.getLoc(), cnt, one);
-    // ensure looping of cnt
-    cnt.setOperand(newCnt);
-
-    auto tupleOut = rewriter.create<handshake::PackOp>(
-        loc, ValueRange({dataBuf, finished}));
+    auto tupleOut =
+        rewriter.create<handshake::PackOp>(loc, ValueRange({data, finished}));
 
     // create terminator
     auto term = rewriter.create<handshake::ReturnOp>(
         loc, ValueRange({tupleOut.result(), ctrl}));
 
-    // Collect types of function
-    SmallVector<Type> argTypes;
-    argTypes.push_back(rewriter.getNoneType());
+    SmallVector<Value> operands = {getBlockCtrlSignal(op->getBlock())};
+    if (cancellable)
+      addCancelOperands(op.result(), operands, rewriter);
 
     rewriter.setInsertionPointToStart(getTopLevelBlock(op));
     auto newFuncOp = createFuncOp(r, symbolUniquer.getUniqueSymName(op),
-                                  argTypes, term.getOperandTypes(), rewriter);
+                                  entryBlock->getArgumentTypes(),
+                                  term.getOperandTypes(), rewriter);
 
-    replaceWithInstance(op, newFuncOp, {getBlockCtrlSignal(op->getBlock())},
-                        rewriter);
+    replaceWithInstance(op, newFuncOp, operands, rewriter);
     return success();
   }
 };
 
-struct SplitOpLowering : public StreamOpLowering<SplitOp> {
+/// Lowers an iota to a counter loop. The value of the next element is
+/// computed by adding the step to the current one.
+///
+/// Restartable iotas emit a new stream for each ctrl input.
+struct IotaOpLowering : public StreamOpLowering<IotaOp> {
   using StreamOpLowering::StreamOpLowering;
 
   LogicalResult
-  matchAndRewrite(SplitOp op, OpAdaptor adaptor,
+  matchAndRewrite(stream::IotaOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
-    Location loc = op.getLoc();
-    TypeConverter *typeConverter = getTypeConverter();
+    if (getLanes(op.result()) != 1)
+      return op.emitError("cannot create multi-lane streams");
+
+    Type elementType = op.getElementType();
+    if (!isInitializable(elementType))
+      return op.emitError(
+          "cannot create streams of integers wider than 64 bits");
+    if (options.eosOnLast && adaptor.count() == 0)
+      return op.emitError("cannot create empty streams with EOS on the last "
+                          "element");
 
-    // create surrounding region
     Region r;
+    Location loc = op.getLoc();
 
-    SmallVector<Type> inputTypes;
-    if (failed(typeConverter->convertTypes(op->getOperandTypes(), inputTypes)))
-      return failure();
-    inputTypes.push_back(rewriter.getNoneType());
+    Block *entryBlock =
+        rewriter.createBlock(&r, {}, {rewriter.getNoneType()}, {loc});
+    Value ctrlIn = entryBlock->getArgument(0);
+    Value cancelIn;
+    bool cancellable = cancelSignals.canCancel(op.result());
+    if (cancellable)
+      cancelIn = addCancelArgument(entryBlock, loc, rewriter);
 
-    SmallVector<Location> argLocs(inputTypes.size(), loc);
+    rewriter.setInsertionPointToEnd(entryBlock);
 
-    Block *entryBlock =
+    // A cancelled source has to stop after EOS, as its counter does not
+    // reach the end of the stream
+    NeverOp tmpFinished;
+    Value ctrl;
+    if (options.restartable || cancellable) {
+      tmpFinished = rewriter.create<NeverOp>(loc, rewriter.getI1Type());
+      ctrl = buildRestartableSourceCtrl(ctrlIn, tmpFinished, loc, rewriter);
+    } else {
+      ctrl = buildSourceCtrl(ctrlIn, loc, rewriter);
+    }
+
+    IntegerAttr start =
+        rewriter.getIntegerAttr(elementType, (int64_t)adaptor.start());
+    auto tmpVal = rewriter.create<NeverOp>(loc, elementType);
+    Value val =
+        buildInitializedBuffer(loc, elementType, tmpVal, start, rewriter);
+    auto step = rewriter.create<handshake::ConstantOp>(
+        loc, rewriter.getIntegerAttr(elementType, (int64_t)adaptor.step()),
+        ctrl);
+    Value newVal = rewriter.create<arith::AddIOp>(loc, val, step);
+
+    int64_t eosIdx = adaptor.count() - (options.eosOnLast ? 1 : 0);
+    auto [cnt, finished] =
+        buildSourceCounter(eosIdx, ctrl, loc, rewriter, options.restartable,
+                           cancelIn, options.cancelSlack);
+
+    // Restartable iotas start over after EOS
+    if (options.restartable) {
+      auto startConst =
+          rewriter.create<handshake::ConstantOp>(loc, start, ctrl);
+      newVal =
+          rewriter.create<arith::SelectOp>(loc, finished, startConst, newVal);
+    }
+    if (tmpFinished)
+      rewriter.replaceOp(tmpFinished, {finished});
+    rewriter.replaceOp(tmpVal, {newVal});
+
+    auto tupleOut =
+        rewriter.create<handshake::PackOp>(loc, ValueRange({val, finished}));
+    auto term = rewriter.create<handshake::ReturnOp>(
+        loc, ValueRange({tupleOut.result(), ctrl}));
+
+    SmallVector<Value> operands = {getBlockCtrlSignal(op->getBlock())};
+    if (cancellable)
+      addCancelOperands(op.result(), operands, rewriter);
+
+    rewriter.setInsertionPointToStart(getTopLevelBlock(op));
+    auto newFuncOp = createFuncOp(r, symbolUniquer.getUniqueSymName(op),
+                                  entryBlock->getArgumentTypes(),
+                                  term.getOperandTypes(), rewriter);
+
+    replaceWithInstance(op, newFuncOp, operands, rewriter);
+    return success();
+  }
+};
+
+/// Places a FIFO on the tuple and the ctrl signal of each output, such that
+/// a slow consumer does not stall the other outputs until its FIFO is full.
+static void buildOutputFifos(MutableArrayRef<Value> outputs, int64_t depth,
+                             Location loc,
+                             ConversionPatternRewriter &rewriter) {
+  for (Value &output : outputs)
+    output = rewriter.create<handshake::BufferOp>(
+        loc, output.getType(), depth, output, BufferTypeEnum::fifo);
+}
+
+struct SplitOpLowering : public StreamOpLowering<SplitOp> {
+  using StreamOpLowering::StreamOpLowering;
+
+  LogicalResult
+  matchAndRewrite(SplitOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op.getLoc();
+    TypeConverter *typeConverter = getTypeConverter();
+
+    // create surrounding region
+    Region r;
+
+    SmallVector<Type> inputTypes;
+    if (failed(typeConverter->convertTypes(op->getOperandTypes(), inputTypes)))
+      return failure();
+    inputTypes.push_back(rewriter.getNoneType());
+
+    SmallVector<Location> argLocs(inputTypes.size(), loc);
+
+    Block *entryBlock =
         rewriter.createBlock(&r, r.begin(), inputTypes, argLocs);
     Value tupleIn = entryBlock->getArgument(0);
     Value streamCtrl = entryBlock->getArgument(1);
@@ -676,34 +2162,84 @@ struct SplitOpLowering : public StreamOpLowering<SplitOp> {
     Value eos = unpack.getResult(1);
 
     Block *lambda = &op.getRegion().front();
-    rewriter.mergeBlocks(lambda, entryBlock, ValueRange({data, streamCtrl}));
+    handshake::ReturnOp newTerm;
+    if (getLanes(op.input()) == 1) {
+      rewriter.mergeBlocks(lambda, entryBlock, ValueRange({data, streamCtrl}));
+
+      Operation *oldTerm = entryBlock->getTerminator();
+
+      rewriter.setInsertionPoint(oldTerm);
+      SmallVector<Value> newTermOperands;
+      for (auto oldOp : oldTerm->getOperands().drop_back()) {
+        auto pack = rewriter.create<handshake::PackOp>(
+            oldTerm->getLoc(), ValueRange({oldOp, eos}));
+        newTermOperands.push_back(pack.getResult());
+        newTermOperands.push_back(oldTerm->getOperands().back());
+      }
 
-    Operation *oldTerm = entryBlock->getTerminator();
+      if (auto depth = op.bufferDepth())
+        buildOutputFifos(newTermOperands, *depth, loc, rewriter);
+      newTermOperands.push_back(initCtrl);
+      newTerm = rewriter.replaceOpWithNewOp<handshake::ReturnOp>(
+          oldTerm, newTermOperands);
+    } else {
+      // Replicate the splitting function for each lane
+      SmallVector<Value> elements, valid;
+      unpackLanes(data, loc, rewriter, elements, valid);
+
+      SmallVector<SmallVector<Value>> results(op.getNumResults());
+      SmallVector<Value> laneCtrls;
+      for (Value element : elements) {
+        SmallVector<Value> laneRes =
+            cloneLambda(lambda, {element, streamCtrl}, rewriter);
+        for (auto it : llvm::enumerate(ArrayRef<Value>(laneRes).drop_back()))
+          results[it.index()].push_back(it.value());
+        laneCtrls.push_back(laneRes.back());
+      }
+      auto ctrl = rewriter.create<JoinOp>(loc, laneCtrls);
+
+      SmallVector<Value> newTermOperands;
+      for (auto &laneResults : results) {
+        auto pack = rewriter.create<handshake::PackOp>(
+            loc,
+            ValueRange({packLanes(laneResults, valid, loc, rewriter), eos}));
+        newTermOperands.push_back(pack.getResult());
+        newTermOperands.push_back(ctrl);
+      }
 
-    rewriter.setInsertionPoint(oldTerm);
-    SmallVector<Value> newTermOperands;
-    for (auto oldOp : oldTerm->getOperands().drop_back()) {
-      auto pack = rewriter.create<handshake::PackOp>(oldTerm->getLoc(),
-                                                     ValueRange({oldOp, eos}));
-      newTermOperands.push_back(pack.getResult());
-      newTermOperands.push_back(oldTerm->getOperands().back());
+      if (auto depth = op.bufferDepth())
+        buildOutputFifos(newTermOperands, *depth, loc, rewriter);
+      newTermOperands.push_back(initCtrl);
+      newTerm = rewriter.create<handshake::ReturnOp>(loc, newTermOperands);
     }
 
-    newTermOperands.push_back(initCtrl);
-    auto newTerm = rewriter.replaceOpWithNewOp<handshake::ReturnOp>(
-        oldTerm, newTermOperands);
+    // The input is only cancelled once all consumers cancelled their streams
+    bool cancellable = cancelSignals.isCancelled(op.input());
+    if (cancellable) {
+      rewriter.setInsertionPoint(newTerm);
+      Value cancelOut = addCancelArgument(entryBlock, loc, rewriter);
+      for (unsigned i = 1, e = op.getNumResults(); i < e; ++i)
+        cancelOut = rewriter.create<arith::AndIOp>(
+            loc, cancelOut, addCancelArgument(entryBlock, loc, rewriter));
+      addCancelResult(newTerm, cancelOut);
+    }
 
     TypeRange resTypes = newTerm->getOperandTypes();
 
     SmallVector<Value> operands;
     resolveNewOperands(op, adaptor.getOperands(), operands);
+    if (cancellable)
+      addCancelOperands(op.results(), operands, rewriter);
 
     rewriter.setInsertionPointToStart(getTopLevelBlock(op));
     FuncOp newFuncOp =
         createFuncOp(r, symbolUniquer.getUniqueSymName(op),
                      entryBlock->getArgumentTypes(), resTypes, rewriter);
 
-    replaceWithInstance(op, newFuncOp, operands, rewriter);
+    InstanceOp instance =
+        replaceWithInstance(op, newFuncOp, operands, rewriter);
+    if (cancellable)
+      connectCancelResult(op.input(), instance, rewriter);
 
     return success();
   }
@@ -721,12 +2257,38 @@ static Value buildReduceTree(ValueRange values, Location loc,
   return res;
 }
 
+/// Returns the stream whose valid lanes determine the valid lanes of the
+/// provided multi-lane stream, or nullptr if the stream is dense, i.e., all of
+/// its transactions but the last one carry an element in each lane. Maps,
+/// splits, combines, and buffers keep the valid lanes of their input. Batches
+/// and the arguments of the function provide dense streams.
+static Value getLanePattern(Value stream) {
+  Operation *def = stream.getDefiningOp();
+  if (!def || isa<BatchOp>(def))
+    return nullptr;
+  if (isa<MapOp, SplitOp, CombineOp, stream::BufferOp>(def))
+    return getLanePattern(def->getOperand(0));
+  return stream;
+}
+
 struct CombineOpLowering : public StreamOpLowering<CombineOp> {
   using StreamOpLowering::StreamOpLowering;
 
   LogicalResult
   matchAndRewrite(CombineOp op, OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
+    // The lanes of all inputs are combined pairwise, which requires them to
+    // hold the same elements of their streams. Dense streams of the same
+    // length agree, as do streams that originate from the same filter.
+    if (getLanes(op.result()) > 1) {
+      Value pattern = getLanePattern(op.inputs().front());
+      if (llvm::any_of(op.inputs().drop_front(), [&](Value input) {
+            return getLanePattern(input) != pattern;
+          }))
+        return op.emitError(
+            "cannot combine multi-lane streams whose valid lanes can differ");
+    }
+
     Location loc = op.getLoc();
     TypeConverter *typeConverter = getTypeConverter();
 
@@ -761,28 +2323,68 @@ struct CombineOpLowering : public StreamOpLowering<CombineOp> {
 
     // only execute region when ALL inputs are ready
     auto ctrlJoin = rewriter.create<JoinOp>(loc, ctrlInputs);
-    blockInputs.push_back(ctrlJoin);
     Block *lambda = &op.getRegion().front();
 
-    rewriter.mergeBlocks(lambda, entryBlock, blockInputs);
+    handshake::ReturnOp newTerm;
+    if (getLanes(op.result()) == 1) {
+      blockInputs.push_back(ctrlJoin);
+      rewriter.mergeBlocks(lambda, entryBlock, blockInputs);
 
-    Operation *oldTerm = entryBlock->getTerminator();
-    rewriter.setInsertionPoint(oldTerm);
+      Operation *oldTerm = entryBlock->getTerminator();
+      rewriter.setInsertionPoint(oldTerm);
+
+      // TODO What to do when not all streams provide an eos signal
+      Value eos = buildReduceTree<arith::OrIOp>(eosInputs, loc, rewriter);
+
+      SmallVector<Value> newTermOperands;
+      for (auto oldOp : oldTerm->getOperands().drop_back()) {
+        auto pack = rewriter.create<handshake::PackOp>(
+            oldTerm->getLoc(), ValueRange({oldOp, eos}));
+        newTermOperands.push_back(pack.getResult());
+        newTermOperands.push_back(oldTerm->getOperands().back());
+      }
+
+      newTermOperands.push_back(initCtrl);
+      newTerm = rewriter.replaceOpWithNewOp<handshake::ReturnOp>(
+          oldTerm, newTermOperands);
+    } else {
+      // Combines the elements of the same lane of all inputs. A lane is only
+      // valid when it is valid in every input.
+      SmallVector<SmallVector<Value>> inputElements, inputValid;
+      for (Value payload : blockInputs) {
+        unpackLanes(payload, loc, rewriter, inputElements.emplace_back(),
+                    inputValid.emplace_back());
+      }
+
+      SmallVector<Value> results, valid, laneCtrls;
+      for (unsigned i = 0, e = getLanes(op.result()); i < e; ++i) {
+        SmallVector<Value> laneArgs, laneValid;
+        for (auto [elements, isValid] :
+             llvm::zip(inputElements, inputValid)) {
+          laneArgs.push_back(elements[i]);
+          laneValid.push_back(isValid[i]);
+        }
+        laneArgs.push_back(ctrlJoin);
+
+        SmallVector<Value> laneRes = cloneLambda(lambda, laneArgs, rewriter);
+        results.push_back(laneRes[0]);
+        laneCtrls.push_back(laneRes[1]);
+        valid.push_back(
+            buildReduceTree<arith::AndIOp>(laneValid, loc, rewriter));
+      }
+      auto ctrl = rewriter.create<JoinOp>(loc, laneCtrls);
 
-    // TODO What to do when not all streams provide an eos signal
-    Value eos = buildReduceTree<arith::OrIOp>(eosInputs, loc, rewriter);
+      Value eos = buildReduceTree<arith::OrIOp>(eosInputs, loc, rewriter);
+      auto tupleOut = rewriter.create<handshake::PackOp>(
+          loc, ValueRange({packLanes(results, valid, loc, rewriter), eos}));
 
-    SmallVector<Value> newTermOperands;
-    for (auto oldOp : oldTerm->getOperands().drop_back()) {
-      auto pack = rewriter.create<handshake::PackOp>(oldTerm->getLoc(),
-                                                     ValueRange({oldOp, eos}));
-      newTermOperands.push_back(pack.getResult());
-      newTermOperands.push_back(oldTerm->getOperands().back());
+      newTerm = rewriter.create<handshake::ReturnOp>(
+          loc, ValueRange({tupleOut, ctrl, initCtrl}));
     }
 
-    newTermOperands.push_back(initCtrl);
-    auto newTerm = rewriter.replaceOpWithNewOp<handshake::ReturnOp>(
-        oldTerm, newTermOperands);
+    if (op.latency() &&
+        failed(pipelineBody(op, entryBlock, *op.latency(), rewriter)))
+      return failure();
 
     TypeRange resTypes = newTerm->getOperandTypes();
 
@@ -800,6 +2402,886 @@ struct CombineOpLowering : public StreamOpLowering<CombineOp> {
   }
 };
 
+// Lowers a merge to a control merge that arbitrates between the inputs. Only
+// the EOS of the last input that ends is forwarded, the others are counted and
+// dropped.
+struct MergeOpLowering : public StreamOpLowering<stream::MergeOp> {
+  using StreamOpLowering::StreamOpLowering;
+
+  LogicalResult
+  matchAndRewrite(stream::MergeOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op.getLoc();
+    TypeConverter *typeConverter = getTypeConverter();
+
+    Region r;
+
+    SmallVector<Type> inputTypes;
+    if (failed(typeConverter->convertTypes(op->getOperandTypes(), inputTypes)))
+      return failure();
+    inputTypes.push_back(rewriter.getNoneType());
+
+    SmallVector<Location> argLocs(inputTypes.size(), loc);
+
+    Block *entryBlock =
+        rewriter.createBlock(&r, r.begin(), inputTypes, argLocs);
+
+    SmallVector<Value> tupleInputs;
+    SmallVector<Value> ctrlInputs;
+    for (unsigned i = 0, e = entryBlock->getNumArguments() - 1; i < e; i += 2) {
+      tupleInputs.push_back(entryBlock->getArgument(i));
+      ctrlInputs.push_back(entryBlock->getArgument(i + 1));
+    }
+    Value initCtrl = entryBlock->getArguments().back();
+
+    // The control merge prefers the input with the lowest index. The ctrl
+    // signal is taken from the same input as the tuple.
+    auto cmerge = rewriter.create<ControlMergeOp>(loc, tupleInputs);
+    Value tupleIn = cmerge.result();
+    Value streamCtrl =
+        rewriter.create<MuxOp>(loc, cmerge.index(), ctrlInputs);
+
+    auto unpack = rewriter.create<handshake::UnpackOp>(loc, tupleIn);
+    Value eos = unpack.getResult(1);
+
+    // Records for each input whether it ended, set by the EOS of that input.
+    // The flags are cleared with the last EOS, such that the merge can process
+    // consecutive streams. An input that ends twice still counts once.
+    Type i1Type = rewriter.getI1Type();
+    Type indexType = rewriter.getIndexType();
+    SmallVector<NeverOp> tmpEnded;
+    SmallVector<Value> ended;
+    Value allEnded;
+    for (unsigned i = 0, e = tupleInputs.size(); i < e; ++i) {
+      auto tmp = rewriter.create<NeverOp>(loc, i1Type);
+      Value prev = buildInitializedBuffer(
+          loc, i1Type, tmp, rewriter.getIntegerAttr(i1Type, 0), rewriter);
+      Value idx = buildConstant(loc, indexType, i, streamCtrl, rewriter);
+      Value isInput = rewriter.create<arith::CmpIOp>(
+          loc, arith::CmpIPredicate::eq, cmerge.index(), idx);
+      Value endsNow = rewriter.create<arith::AndIOp>(loc, eos, isInput);
+      Value hasEnded = rewriter.create<arith::OrIOp>(loc, prev, endsNow);
+      allEnded = allEnded ? Value(rewriter.create<arith::AndIOp>(
+                                loc, allEnded, hasEnded))
+                          : hasEnded;
+      tmpEnded.push_back(tmp);
+      ended.push_back(hasEnded);
+    }
+    Value lastEos = rewriter.create<arith::AndIOp>(loc, eos, allEnded);
+    Value falseVal = buildConstant(loc, i1Type, 0, streamCtrl, rewriter);
+    for (auto [tmp, hasEnded] : llvm::zip(tmpEnded, ended)) {
+      Value next =
+          rewriter.create<arith::SelectOp>(loc, allEnded, falseVal, hasEnded);
+      rewriter.replaceOp(tmp, {next});
+    }
+
+    Value tupleOut, ctrlOut;
+    if (options.eosOnLast) {
+      // The last elements of the other inputs are forwarded as regular
+      // elements
+      tupleOut = rewriter.create<handshake::PackOp>(
+          loc, ValueRange({unpack.getResult(0), lastEos}));
+      ctrlOut = streamCtrl;
+    } else {
+      // Elements are always forwarded, EOS only once all inputs ended
+      Value trueVal =
+          buildConstant(loc, rewriter.getI1Type(), 1, streamCtrl, rewriter);
+      Value isElement = rewriter.create<arith::XOrIOp>(loc, eos, trueVal);
+      Value forward = rewriter.create<arith::OrIOp>(loc, isElement, lastEos);
+      auto dataBr = rewriter.create<handshake::ConditionalBranchOp>(
+          loc, forward, tupleIn);
+      auto ctrlBr = rewriter.create<handshake::ConditionalBranchOp>(
+          loc, forward, streamCtrl);
+      tupleOut = dataBr.trueResult();
+      ctrlOut = ctrlBr.trueResult();
+    }
+
+    auto newTerm = rewriter.create<handshake::ReturnOp>(
+        loc, ValueRange({tupleOut, ctrlOut, initCtrl}));
+
+    SmallVector<Value> operands;
+    resolveNewOperands(op, adaptor.getOperands(), operands);
+
+    rewriter.setInsertionPointToStart(getTopLevelBlock(op));
+    FuncOp newFuncOp = createFuncOp(r, symbolUniquer.getUniqueSymName(op),
+                                    entryBlock->getArgumentTypes(),
+                                    newTerm.getOperandTypes(), rewriter);
+    replaceWithInstance(op, newFuncOp, operands, rewriter);
+    return success();
+  }
+};
+
+// Lowers a window to a shift register that holds the previous `size - 1`
+// elements, such that each element only enters the operation once. A counter
+// determines which transactions complete a window.
+struct WindowOpLowering : public StreamOpLowering<WindowOp> {
+  using StreamOpLowering::StreamOpLowering;
+
+  LogicalResult
+  matchAndRewrite(WindowOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    if (failed(verifySeparateEos(op, options)))
+      return failure();
+
+    Location loc = op.getLoc();
+    TypeConverter *typeConverter = getTypeConverter();
+
+    Type elementType =
+        op.input().getType().cast<StreamType>().getElementType();
+    if (!isInitializable(elementType))
+      return op.emitError("cannot initialize shift registers with integers "
+                          "wider than 64 bits");
+
+    Region r;
+
+    SmallVector<Type> inputTypes;
+    if (failed(typeConverter->convertTypes(op->getOperandTypes(), inputTypes)))
+      return failure();
+    inputTypes.push_back(rewriter.getNoneType());
+
+    SmallVector<Location> argLocs(inputTypes.size(), loc);
+
+    Block *entryBlock =
+        rewriter.createBlock(&r, r.begin(), inputTypes, argLocs);
+    Value tupleIn = entryBlock->getArgument(0);
+    Value streamCtrl = entryBlock->getArgument(1);
+    Value initCtrl = entryBlock->getArgument(2);
+
+    auto unpack = rewriter.create<handshake::UnpackOp>(loc, tupleIn);
+    Value data = unpack.getResult(0);
+    Value eos = unpack.getResult(1);
+
+    // Each register emits its initial value first, so the i-th register
+    // provides the element that arrived i + 1 transactions earlier.
+    int64_t size = op.size();
+    int64_t stride = op.stride();
+    Attribute zero = getZeroAttr(elementType, rewriter);
+    SmallVector<Value> window = {data};
+    for (int64_t i = 1; i < size; ++i)
+      window.push_back(buildInitializedBuffer(loc, elementType, window.back(),
+                                              zero, rewriter));
+    std::reverse(window.begin(), window.end());
+
+    // Counts the elements of the current window. Once a window is complete,
+    // the counter is set back such that the next one completes `stride`
+    // elements later. EOS resets the counter for the next stream.
+    Type counterType = rewriter.getI64Type();
+    auto tmpCount = rewriter.create<NeverOp>(loc, counterType);
+    Value count = buildInitializedBuffer(loc, counterType, tmpCount,
+                                         rewriter.getI64IntegerAttr(0),
+                                         rewriter);
+    Value one = buildConstant(loc, counterType, 1, streamCtrl, rewriter);
+    Value incremented = rewriter.create<arith::AddIOp>(loc, count, one);
+    Value sizeVal = buildConstant(loc, counterType, size, streamCtrl, rewriter);
+    Value complete = rewriter.create<arith::CmpIOp>(
+        loc, arith::CmpIPredicate::eq, incremented, sizeVal);
+    Value restart =
+        buildConstant(loc, counterType, size - stride, streamCtrl, rewriter);
+    Value next =
+        rewriter.create<arith::SelectOp>(loc, complete, restart, incremented);
+    Value reset = buildConstant(loc, counterType, 0, streamCtrl, rewriter);
+    next = rewriter.create<arith::SelectOp>(loc, eos, reset, next);
+    rewriter.replaceOp(tmpCount, {next});
+
+    auto windowOut = rewriter.create<handshake::PackOp>(loc, window);
+    auto tupleOut =
+        rewriter.create<handshake::PackOp>(loc, ValueRange({windowOut, eos}));
+
+    auto completeOrEos = rewriter.create<arith::OrIOp>(loc, complete, eos);
+    auto dataBr = rewriter.create<handshake::ConditionalBranchOp>(
+        loc, completeOrEos, tupleOut);
+    auto ctrlBr = rewriter.create<handshake::ConditionalBranchOp>(
+        loc, completeOrEos, streamCtrl);
+
+    auto newTerm = rewriter.create<handshake::ReturnOp>(
+        loc, ValueRange({dataBr.trueResult(), ctrlBr.trueResult(), initCtrl}));
+
+    SmallVector<Value> operands;
+    resolveNewOperands(op, adaptor.getOperands(), operands);
+
+    rewriter.setInsertionPointToStart(getTopLevelBlock(op));
+    FuncOp newFuncOp = createFuncOp(r, symbolUniquer.getUniqueSymName(op),
+                                    entryBlock->getArgumentTypes(),
+                                    newTerm.getOperandTypes(), rewriter);
+    replaceWithInstance(op, newFuncOp, operands, rewriter);
+    return success();
+  }
+};
+
+// Lowers a batch to a register for each lane but the highest one. Each
+// element is written to the register of its lane, and the batch is emitted
+// together with the element of the highest lane or with EOS.
+struct BatchOpLowering : public StreamOpLowering<BatchOp> {
+  using StreamOpLowering::StreamOpLowering;
+
+  LogicalResult
+  matchAndRewrite(BatchOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    if (failed(verifySeparateEos(op, options)))
+      return failure();
+
+    Location loc = op.getLoc();
+    TypeConverter *typeConverter = getTypeConverter();
+
+    Type elementType =
+        op.input().getType().cast<StreamType>().getElementType();
+    if (!isInitializable(elementType))
+      return op.emitError("cannot initialize lane registers with integers "
+                          "wider than 64 bits");
+
+    Region r;
+
+    SmallVector<Type> inputTypes;
+    if (failed(typeConverter->convertTypes(op->getOperandTypes(), inputTypes)))
+      return failure();
+    inputTypes.push_back(rewriter.getNoneType());
+
+    SmallVector<Location> argLocs(inputTypes.size(), loc);
+
+    Block *entryBlock =
+        rewriter.createBlock(&r, r.begin(), inputTypes, argLocs);
+    Value tupleIn = entryBlock->getArgument(0);
+    Value streamCtrl = entryBlock->getArgument(1);
+    Value initCtrl = entryBlock->getArgument(2);
+
+    unsigned lanes = getLanes(op.result());
+    handshake::ReturnOp newTerm;
+    if (lanes == 1) {
+      newTerm = rewriter.create<handshake::ReturnOp>(
+          loc, ValueRange({tupleIn, streamCtrl, initCtrl}));
+    } else {
+      auto unpack = rewriter.create<handshake::UnpackOp>(loc, tupleIn);
+      Value data = unpack.getResult(0);
+      Value eos = unpack.getResult(1);
+
+      // The index of the lane the next element belongs to
+      Type idxType = rewriter.getIntegerType(llvm::Log2_32_Ceil(lanes + 1));
+      auto tmpIdx = rewriter.create<NeverOp>(loc, idxType);
+      Value idx = buildInitializedBuffer(loc, idxType, tmpIdx,
+                                         rewriter.getIntegerAttr(idxType, 0),
+                                         rewriter);
+
+      Attribute zero = getZeroAttr(elementType, rewriter);
+      SmallVector<Value> elements, valid;
+      for (unsigned j = 0; j + 1 < lanes; ++j) {
+        Value lane = buildConstant(loc, idxType, j, streamCtrl, rewriter);
+        auto atLane = rewriter.create<arith::CmpIOp>(
+            loc, arith::CmpIPredicate::eq, idx, lane);
+        auto tmpReg = rewriter.create<NeverOp>(loc, elementType);
+        Value reg = buildInitializedBuffer(loc, elementType, tmpReg, zero,
+                                           rewriter);
+        rewriter.replaceOp(
+            tmpReg, {rewriter.create<arith::SelectOp>(loc, atLane, data, reg)});
+        elements.push_back(reg);
+        // The lanes below the index hold the earlier elements of the batch
+        valid.push_back(rewriter.create<arith::CmpIOp>(
+            loc, arith::CmpIPredicate::ult, lane, idx));
+      }
+
+      // The highest lane is never stored, as its element completes the batch
+      Value trueVal = buildConstant(loc, rewriter.getI1Type(), 1, streamCtrl,
+                                    rewriter);
+      elements.push_back(data);
+      valid.push_back(rewriter.create<arith::XOrIOp>(loc, eos, trueVal));
+
+      Value lastLane =
+          buildConstant(loc, idxType, lanes - 1, streamCtrl, rewriter);
+      auto complete = rewriter.create<arith::CmpIOp>(
+          loc, arith::CmpIPredicate::eq, idx, lastLane);
+      auto completeOrEos = rewriter.create<arith::OrIOp>(loc, complete, eos);
+
+      Value one = buildConstant(loc, idxType, 1, streamCtrl, rewriter);
+      Value reset = buildConstant(loc, idxType, 0, streamCtrl, rewriter);
+      auto incremented = rewriter.create<arith::AddIOp>(loc, idx, one);
+      rewriter.replaceOp(tmpIdx, {rewriter.create<arith::SelectOp>(
+                                     loc, completeOrEos, reset, incremented)});
+
+      auto tupleOut = rewriter.create<handshake::PackOp>(
+          loc, ValueRange({packLanes(elements, valid, loc, rewriter), eos}));
+      auto dataBr = rewriter.create<handshake::ConditionalBranchOp>(
+          loc, completeOrEos, tupleOut);
+      auto ctrlBr = rewriter.create<handshake::ConditionalBranchOp>(
+          loc, completeOrEos, streamCtrl);
+
+      newTerm = rewriter.create<handshake::ReturnOp>(
+          loc,
+          ValueRange({dataBr.trueResult(), ctrlBr.trueResult(), initCtrl}));
+    }
+
+    SmallVector<Value> operands;
+    resolveNewOperands(op, adaptor.getOperands(), operands);
+
+    rewriter.setInsertionPointToStart(getTopLevelBlock(op));
+    FuncOp newFuncOp = createFuncOp(r, symbolUniquer.getUniqueSymName(op),
+                                    entryBlock->getArgumentTypes(),
+                                    newTerm.getOperandTypes(), rewriter);
+    replaceWithInstance(op, newFuncOp, operands, rewriter);
+    return success();
+  }
+};
+
+// Lowers an unbatch to a loop that holds a transaction until each of its
+// lanes was visited, one lane per iteration. As the EOS of a single-lane
+// stream cannot carry an element, a transaction with EOS is held for one
+// additional iteration that only emits EOS.
+struct UnbatchOpLowering : public StreamOpLowering<UnbatchOp> {
+  using StreamOpLowering::StreamOpLowering;
+
+  LogicalResult
+  matchAndRewrite(UnbatchOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    if (failed(verifySeparateEos(op, options)))
+      return failure();
+
+    Location loc = op.getLoc();
+    TypeConverter *typeConverter = getTypeConverter();
+
+    Region r;
+
+    SmallVector<Type> inputTypes;
+    if (failed(typeConverter->convertTypes(op->getOperandTypes(), inputTypes)))
+      return failure();
+    inputTypes.push_back(rewriter.getNoneType());
+
+    SmallVector<Location> argLocs(inputTypes.size(), loc);
+
+    Block *entryBlock =
+        rewriter.createBlock(&r, r.begin(), inputTypes, argLocs);
+    Value tupleIn = entryBlock->getArgument(0);
+    Value streamCtrl = entryBlock->getArgument(1);
+    Value initCtrl = entryBlock->getArgument(2);
+
+    unsigned lanes = getLanes(op.input());
+    handshake::ReturnOp newTerm;
+    if (lanes == 1) {
+      newTerm = rewriter.create<handshake::ReturnOp>(
+          loc, ValueRange({tupleIn, streamCtrl, initCtrl}));
+    } else {
+      Type i1Type = rewriter.getI1Type();
+      Type noneType = rewriter.getNoneType();
+
+      // Selects the held transaction instead of a new one
+      auto tmpSelect = rewriter.create<NeverOp>(loc, i1Type);
+      Value select = buildInitializedBuffer(
+          loc, i1Type, tmpSelect, rewriter.getIntegerAttr(i1Type, 0),
+          rewriter);
+      auto tmpHeld = rewriter.create<NeverOp>(loc, tupleIn.getType());
+      auto tmpHeldCtrl = rewriter.create<NeverOp>(loc, noneType);
+      Value current =
+          rewriter.create<MuxOp>(loc, select, ValueRange({tupleIn, tmpHeld}));
+      Value ctrl = rewriter.create<MuxOp>(
+          loc, select, ValueRange({streamCtrl, tmpHeldCtrl}));
+
+      auto unpack = rewriter.create<handshake::UnpackOp>(loc, current);
+      Value payload = unpack.getResult(0);
+      Value eos = unpack.getResult(1);
+      SmallVector<Value> elements, valid;
+      unpackLanes(payload, loc, rewriter, elements, valid);
+
+      // The index of the lane that is visited, lanes for the EOS iteration
+      Type idxType = rewriter.getIntegerType(llvm::Log2_32_Ceil(lanes + 1));
+      auto tmpIdx = rewriter.create<NeverOp>(loc, idxType);
+      Value idx = buildInitializedBuffer(loc, idxType, tmpIdx,
+                                         rewriter.getIntegerAttr(idxType, 0),
+                                         rewriter);
+
+      Value element = elements[0];
+      Value isValid = buildConstant(loc, i1Type, 0, ctrl, rewriter);
+      for (unsigned j = 0; j < lanes; ++j) {
+        Value lane = buildConstant(loc, idxType, j, ctrl, rewriter);
+        auto atLane = rewriter.create<arith::CmpIOp>(
+            loc, arith::CmpIPredicate::eq, idx, lane);
+        if (j > 0)
+          element = rewriter.create<arith::SelectOp>(loc, atLane, elements[j],
+                                                     element);
+        isValid =
+            rewriter.create<arith::SelectOp>(loc, atLane, valid[j], isValid);
+      }
+
+      Value trueVal = buildConstant(loc, i1Type, 1, ctrl, rewriter);
+      Value lastLane = buildConstant(loc, idxType, lanes - 1, ctrl, rewriter);
+      Value end = buildConstant(loc, idxType, lanes, ctrl, rewriter);
+      auto atLastLane = rewriter.create<arith::CmpIOp>(
+          loc, arith::CmpIPredicate::eq, idx, lastLane);
+      auto atEnd = rewriter.create<arith::CmpIOp>(
+          loc, arith::CmpIPredicate::eq, idx, end);
+      auto notEos = rewriter.create<arith::XOrIOp>(loc, eos, trueVal);
+      auto lastElement =
+          rewriter.create<arith::AndIOp>(loc, atLastLane, notEos);
+      auto done = rewriter.create<arith::OrIOp>(loc, lastElement, atEnd);
+
+      Value one = buildConstant(loc, idxType, 1, ctrl, rewriter);
+      Value reset = buildConstant(loc, idxType, 0, ctrl, rewriter);
+      auto incremented = rewriter.create<arith::AddIOp>(loc, idx, one);
+      rewriter.replaceOp(tmpIdx, {rewriter.create<arith::SelectOp>(
+                                     loc, done, reset, incremented)});
+
+      // The transaction stays in the loop until it is done
+      auto heldBr =
+          rewriter.create<handshake::ConditionalBranchOp>(loc, done, current);
+      auto heldCtrlBr =
+          rewriter.create<handshake::ConditionalBranchOp>(loc, done, ctrl);
+      rewriter.replaceOp(tmpHeld,
+                         {rewriter.create<handshake::BufferOp>(
+                             loc, tupleIn.getType(), 1, heldBr.falseResult(),
+                             BufferTypeEnum::seq)});
+      rewriter.replaceOp(tmpHeldCtrl,
+                         {rewriter.create<handshake::BufferOp>(
+                             loc, noneType, 1, heldCtrlBr.falseResult(),
+                             BufferTypeEnum::seq)});
+      rewriter.replaceOp(tmpSelect,
+                         {rewriter.create<arith::XOrIOp>(loc, done, trueVal)});
+
+      auto emit = rewriter.create<arith::OrIOp>(loc, isValid, atEnd);
+      auto tupleOut = rewriter.create<handshake::PackOp>(
+          loc, ValueRange({element, atEnd}));
+      auto dataBr =
+          rewriter.create<handshake::ConditionalBranchOp>(loc, emit, tupleOut);
+      auto ctrlBr =
+          rewriter.create<handshake::ConditionalBranchOp>(loc, emit, ctrl);
+
+      newTerm = rewriter.create<handshake::ReturnOp>(
+          loc,
+          ValueRange({dataBr.trueResult(), ctrlBr.trueResult(), initCtrl}));
+    }
+
+    SmallVector<Value> operands;
+    resolveNewOperands(op, adaptor.getOperands(), operands);
+
+    rewriter.setInsertionPointToStart(getTopLevelBlock(op));
+    FuncOp newFuncOp = createFuncOp(r, symbolUniquer.getUniqueSymName(op),
+                                    entryBlock->getArgumentTypes(),
+                                    newTerm.getOperandTypes(), rewriter);
+    replaceWithInstance(op, newFuncOp, operands, rewriter);
+    return success();
+  }
+};
+
+/// Builds the address loop of a memory access, which starts at `start` and
+/// advances by `stride` for each transaction. The address is reset to `start`
+/// when `reset` is asserted.
+static Value buildAddressCounter(int64_t start, int64_t stride, Value reset,
+                                 Value ctrl, Location loc,
+                                 ConversionPatternRewriter &rewriter) {
+  Type i64Type = rewriter.getI64Type();
+  IntegerAttr startAttr = rewriter.getI64IntegerAttr(start);
+  auto tmpAddr = rewriter.create<NeverOp>(loc, i64Type);
+  Value addr =
+      buildInitializedBuffer(loc, i64Type, tmpAddr, startAttr, rewriter);
+  Value strideVal = buildConstant(loc, i64Type, stride, ctrl, rewriter);
+  Value startVal = buildConstant(loc, i64Type, start, ctrl, rewriter);
+  Value next = rewriter.create<arith::AddIOp>(loc, addr, strideVal);
+  rewriter.replaceOp(tmpAddr, {rewriter.create<arith::SelectOp>(
+                                  loc, reset, startVal, next)});
+  return addr;
+}
+
+/// Emits an error if the memref is accessed by more than the provided
+/// operation, as each memref is lowered to a separate memory interface.
+static LogicalResult verifySingleAccess(Operation *op, Value memref) {
+  if (!memref.hasOneUse())
+    return op->emitError("expect the memref to be accessed by a single "
+                         "stream operation");
+  return success();
+}
+
+// Lowers a load to a source that issues one request to an external memory
+// per element. The requests do not wait for the responses, which are
+// buffered by a FIFO that bounds the number of requests in flight.
+struct LoadOpLowering : public StreamOpLowering<stream::LoadOp> {
+  using StreamOpLowering::StreamOpLowering;
+
+  LogicalResult
+  matchAndRewrite(stream::LoadOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    if (failed(verifySingleAccess(op, op.memref())))
+      return failure();
+
+    Region r;
+    Location loc = op.getLoc();
+    Type memrefType = op.memref().getType();
+    Type elementType = memrefType.cast<MemRefType>().getElementType();
+    Type i1Type = rewriter.getI1Type();
+    Type noneType = rewriter.getNoneType();
+
+    Block *entryBlock =
+        rewriter.createBlock(&r, {}, {memrefType, noneType}, {loc, loc});
+    Value memref = entryBlock->getArgument(0);
+    Value ctrlIn = entryBlock->getArgument(1);
+    Value cancelIn;
+    bool cancellable = cancelSignals.canCancel(op.result());
+    if (cancellable)
+      cancelIn = addCancelArgument(entryBlock, loc, rewriter);
+
+    rewriter.setInsertionPointToEnd(entryBlock);
+
+    // A load must not issue requests beyond the last element, so the source
+    // always stops after EOS and waits for the next ctrl input.
+    auto tmpFinished = rewriter.create<NeverOp>(loc, i1Type);
+    Value ctrl = buildRestartableSourceCtrl(ctrlIn, tmpFinished, loc, rewriter);
+    Value finished;
+    int64_t eosIdx = op.count() - (options.eosOnLast ? 1 : 0);
+    // The consumers cancel with a delay of the requests in flight on top of
+    // the one of the loop
+    std::tie(std::ignore, finished) =
+        buildSourceCounter(eosIdx, ctrl, loc, rewriter, /*restartable=*/true,
+                           cancelIn,
+                           options.loadRequests + options.cancelSlack);
+    rewriter.replaceOp(tmpFinished, {finished});
+    Value addr = buildAddressCounter(op.start(), op.stride(), finished, ctrl,
+                                     loc, rewriter);
+
+    // A separate EOS transaction does not issue a request
+    Value reqAddr = addr;
+    Value reqCtrl = ctrl;
+    handshake::ConditionalBranchOp ctrlBr;
+    if (!options.eosOnLast) {
+      auto addrBr =
+          rewriter.create<handshake::ConditionalBranchOp>(loc, finished, addr);
+      ctrlBr =
+          rewriter.create<handshake::ConditionalBranchOp>(loc, finished, ctrl);
+      reqAddr = addrBr.falseResult();
+      reqCtrl = ctrlBr.falseResult();
+    }
+    Value idx = rewriter.create<arith::IndexCastOp>(
+        loc, rewriter.getIndexType(), reqAddr);
+
+    auto tmpData = rewriter.create<NeverOp>(loc, elementType);
+    auto load = rewriter.create<handshake::LoadOp>(
+        loc, TypeRange({elementType, rewriter.getIndexType()}),
+        ValueRange({idx, tmpData, reqCtrl}));
+    auto memory = rewriter.create<ExternalMemoryOp>(
+        loc, memref, ValueRange({load.getResult(1)}), /*ldCount=*/1,
+        /*stCount=*/0, /*id=*/0);
+    rewriter.replaceOp(tmpData, {memory.getResult(0)});
+
+    // The EOS flags and ctrl signals wait in FIFOs of the same depth for the
+    // responses, such that they do not limit the requests in flight.
+    unsigned depth = options.loadRequests;
+    Value response = rewriter.create<handshake::BufferOp>(
+        loc, elementType, depth, load.getResult(0), BufferTypeEnum::fifo);
+    Value isEos = rewriter.create<handshake::BufferOp>(
+        loc, i1Type, depth, finished, BufferTypeEnum::fifo);
+    Value ctrlOut = rewriter.create<handshake::BufferOp>(
+        loc, noneType, depth, ctrl, BufferTypeEnum::fifo);
+    Value data = response;
+    if (!options.eosOnLast) {
+      Value eosData = buildConstant(loc, elementType, 0, ctrlBr.trueResult(),
+                                    rewriter);
+      data =
+          rewriter.create<MuxOp>(loc, isEos, ValueRange({response, eosData}));
+    }
+
+    auto tupleOut =
+        rewriter.create<handshake::PackOp>(loc, ValueRange({data, isEos}));
+    auto term = rewriter.create<handshake::ReturnOp>(
+        loc, ValueRange({tupleOut.result(), ctrlOut}));
+
+    SmallVector<Value> operands;
+    resolveNewOperands(op, adaptor.getOperands(), operands);
+    if (cancellable)
+      addCancelOperands(op.result(), operands, rewriter);
+
+    rewriter.setInsertionPointToStart(getTopLevelBlock(op));
+    auto newFuncOp = createFuncOp(r, symbolUniquer.getUniqueSymName(op),
+                                  entryBlock->getArgumentTypes(),
+                                  term.getOperandTypes(), rewriter);
+
+    replaceWithInstance(op, newFuncOp, operands, rewriter);
+    return success();
+  }
+};
+
+// Lowers a store to a sink that writes each element to an external memory.
+struct StoreOpLowering : public StreamOpLowering<stream::StoreOp> {
+  using StreamOpLowering::StreamOpLowering;
+
+  LogicalResult
+  matchAndRewrite(stream::StoreOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    if (failed(verifySingleAccess(op, op.memref())))
+      return failure();
+
+    Location loc = op.getLoc();
+    TypeConverter *typeConverter = getTypeConverter();
+
+    Region r;
+
+    SmallVector<Type> inputTypes;
+    if (failed(typeConverter->convertTypes(op->getOperandTypes(), inputTypes)))
+      return failure();
+    inputTypes.push_back(rewriter.getNoneType());
+
+    SmallVector<Location> argLocs(inputTypes.size(), loc);
+
+    Block *entryBlock =
+        rewriter.createBlock(&r, r.begin(), inputTypes, argLocs);
+    Value tupleIn = entryBlock->getArgument(0);
+    Value streamCtrl = entryBlock->getArgument(1);
+    Value memref = entryBlock->getArgument(2);
+    Value initCtrl = entryBlock->getArgument(3);
+
+    auto unpack = rewriter.create<handshake::UnpackOp>(loc, tupleIn);
+    Value data = unpack.getResult(0);
+    Value eos = unpack.getResult(1);
+
+    // EOS resets the address for the next stream
+    Value addr = buildAddressCounter(op.start(), op.stride(), eos, streamCtrl,
+                                     loc, rewriter);
+
+    // A separate EOS transaction does not carry an element to store
+    if (!options.eosOnLast) {
+      data = rewriter.create<handshake::ConditionalBranchOp>(loc, eos, data)
+                 .falseResult();
+      addr = rewriter.create<handshake::ConditionalBranchOp>(loc, eos, addr)
+                 .falseResult();
+      streamCtrl =
+          rewriter
+              .create<handshake::ConditionalBranchOp>(loc, eos, streamCtrl)
+              .falseResult();
+    }
+    Value idx =
+        rewriter.create<arith::IndexCastOp>(loc, rewriter.getIndexType(), addr);
+
+    auto store = rewriter.create<handshake::StoreOp>(
+        loc, TypeRange({data.getType(), rewriter.getIndexType()}),
+        ValueRange({idx, data, streamCtrl}));
+    rewriter.create<ExternalMemoryOp>(
+        loc, memref, ValueRange({store.getResult(0), store.getResult(1)}),
+        /*ldCount=*/0, /*stCount=*/1, /*id=*/0);
+
+    auto newTerm =
+        rewriter.create<handshake::ReturnOp>(loc, ValueRange(initCtrl));
+
+    SmallVector<Value> operands;
+    resolveNewOperands(op, adaptor.getOperands(), operands);
+
+    rewriter.setInsertionPointToStart(getTopLevelBlock(op));
+    FuncOp newFuncOp = createFuncOp(r, symbolUniquer.getUniqueSymName(op),
+                                    entryBlock->getArgumentTypes(),
+                                    newTerm.getOperandTypes(), rewriter);
+    replaceWithInstance(op, newFuncOp, operands, rewriter);
+    return success();
+  }
+};
+
+// Lowers a take to a counter of the forwarded elements. Once `count` elements
+// passed, EOS is sent and all further transactions of the stream are dropped,
+// such that the producer can complete its stream. EOS of the input resets the
+// counter for the next stream.
+struct TakeOpLowering : public StreamOpLowering<TakeOp> {
+  using StreamOpLowering::StreamOpLowering;
+
+  LogicalResult
+  matchAndRewrite(TakeOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op.getLoc();
+    TypeConverter *typeConverter = getTypeConverter();
+
+    Region r;
+
+    SmallVector<Type> inputTypes;
+    if (failed(typeConverter->convertTypes(op->getOperandTypes(), inputTypes)))
+      return failure();
+    inputTypes.push_back(rewriter.getNoneType());
+
+    SmallVector<Location> argLocs(inputTypes.size(), loc);
+
+    Block *entryBlock =
+        rewriter.createBlock(&r, r.begin(), inputTypes, argLocs);
+    Value tupleIn = entryBlock->getArgument(0);
+    Value streamCtrl = entryBlock->getArgument(1);
+    Value initCtrl = entryBlock->getArgument(2);
+
+    auto unpack = rewriter.create<handshake::UnpackOp>(loc, tupleIn);
+    Value data = unpack.getResult(0);
+    Value eos = unpack.getResult(1);
+
+    Type counterType = rewriter.getI64Type();
+    auto tmpCount = rewriter.create<NeverOp>(loc, counterType);
+    Value taken = buildInitializedBuffer(loc, counterType, tmpCount,
+                                         rewriter.getI64IntegerAttr(0),
+                                         rewriter);
+    Value one = buildConstant(loc, counterType, 1, streamCtrl, rewriter);
+    Value incremented = rewriter.create<arith::AddIOp>(loc, taken, one);
+    Value countVal =
+        buildConstant(loc, counterType, op.count(), streamCtrl, rewriter);
+
+    // With a separate EOS transaction, the transaction after the last element
+    // is turned into EOS. Otherwise, the last element carries the flag.
+    Value emit, last;
+    if (options.eosOnLast) {
+      emit = rewriter.create<arith::CmpIOp>(loc, arith::CmpIPredicate::ult,
+                                            taken, countVal);
+      last = rewriter.create<arith::CmpIOp>(loc, arith::CmpIPredicate::eq,
+                                            incremented, countVal);
+    } else {
+      emit = rewriter.create<arith::CmpIOp>(loc, arith::CmpIPredicate::ule,
+                                            taken, countVal);
+      last = rewriter.create<arith::CmpIOp>(loc, arith::CmpIPredicate::eq,
+                                            taken, countVal);
+    }
+    Value eosOut = rewriter.create<arith::OrIOp>(loc, eos, last);
+
+    // The count is reached once an element is dropped or the last one passed
+    Value cancelOut;
+    if (cancelSignals.isCancelled(op.input())) {
+      Value trueVal = buildConstant(loc, rewriter.getI1Type(), 1, streamCtrl,
+                                    rewriter);
+      Value dropped = rewriter.create<arith::XOrIOp>(loc, emit, trueVal);
+      Value reached = rewriter.create<arith::OrIOp>(loc, dropped, last);
+      cancelOut = buildCancelOutput(reached, eos, streamCtrl, loc, rewriter);
+    }
+
+    Value next =
+        rewriter.create<arith::SelectOp>(loc, emit, incremented, taken);
+    Value reset = buildConstant(loc, counterType, 0, streamCtrl, rewriter);
+    next = rewriter.create<arith::SelectOp>(loc, eos, reset, next);
+    rewriter.replaceOp(tmpCount, {next});
+
+    auto tupleOut =
+        rewriter.create<handshake::PackOp>(loc, ValueRange({data, eosOut}));
+    auto dataBr =
+        rewriter.create<handshake::ConditionalBranchOp>(loc, emit, tupleOut);
+    auto ctrlBr =
+        rewriter.create<handshake::ConditionalBranchOp>(loc, emit, streamCtrl);
+
+    auto newTerm = rewriter.create<handshake::ReturnOp>(
+        loc, ValueRange({dataBr.trueResult(), ctrlBr.trueResult(), initCtrl}));
+    if (cancelOut)
+      addCancelResult(newTerm, cancelOut);
+
+    SmallVector<Value> operands;
+    resolveNewOperands(op, adaptor.getOperands(), operands);
+
+    rewriter.setInsertionPointToStart(getTopLevelBlock(op));
+    FuncOp newFuncOp = createFuncOp(r, symbolUniquer.getUniqueSymName(op),
+                                    entryBlock->getArgumentTypes(),
+                                    newTerm.getOperandTypes(), rewriter);
+    InstanceOp instance =
+        replaceWithInstance(op, newFuncOp, operands, rewriter);
+    if (cancelOut)
+      connectCancelResult(op.input(), instance, rewriter);
+    return success();
+  }
+};
+
+// Lowers a take_while like a filter, but with a flag that records whether the
+// predicate failed already. The first failing element is turned into EOS and
+// the following transactions of the stream are dropped.
+struct TakeWhileOpLowering : public StreamOpLowering<TakeWhileOp> {
+  using StreamOpLowering::StreamOpLowering;
+
+  LogicalResult
+  matchAndRewrite(TakeWhileOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    if (failed(verifySeparateEos(op, options)))
+      return failure();
+
+    Location loc = op.getLoc();
+    TypeConverter *typeConverter = getTypeConverter();
+
+    Region r;
+
+    SmallVector<Type> inputTypes;
+    if (failed(typeConverter->convertTypes(op->getOperandTypes(), inputTypes)))
+      return failure();
+    inputTypes.push_back(rewriter.getNoneType());
+
+    SmallVector<Location> argLocs(inputTypes.size(), loc);
+
+    Block *entryBlock =
+        rewriter.createBlock(&r, r.begin(), inputTypes, argLocs);
+    Value tupleIn = entryBlock->getArgument(0);
+    Value streamCtrl = entryBlock->getArgument(1);
+    Value initCtrl = entryBlock->getArgument(2);
+
+    auto unpack = rewriter.create<handshake::UnpackOp>(loc, tupleIn);
+    Value data = unpack.getResult(0);
+    Value eos = unpack.getResult(1);
+
+    Block *lambda = &op.getRegion().front();
+    rewriter.mergeBlocks(lambda, entryBlock, ValueRange({data, streamCtrl}));
+
+    Operation *oldTerm = entryBlock->getTerminator();
+    assert(oldTerm->getNumOperands() == 2 &&
+           "expected handshake::ReturnOp to have two operands");
+    rewriter.setInsertionPoint(oldTerm);
+    Value cond = oldTerm->getOperand(0);
+    Value ctrl = oldTerm->getOperand(1);
+
+    Type flagType = rewriter.getI1Type();
+    auto tmpStopped = rewriter.create<NeverOp>(loc, flagType);
+    Value stopped = buildInitializedBuffer(loc, flagType, tmpStopped,
+                                           rewriter.getIntegerAttr(flagType, 0),
+                                           rewriter);
+    Value trueVal = buildConstant(loc, flagType, 1, streamCtrl, rewriter);
+    Value emit = rewriter.create<arith::XOrIOp>(loc, stopped, trueVal);
+    Value stop = rewriter.create<arith::XOrIOp>(loc, cond, trueVal);
+    Value eosOut = rewriter.create<arith::OrIOp>(loc, eos, stop);
+
+    Value next = rewriter.create<arith::OrIOp>(loc, stopped, stop);
+    Value cancelOut;
+    if (cancelSignals.isCancelled(op.input()))
+      cancelOut = buildCancelOutput(next, eos, streamCtrl, loc, rewriter);
+    Value reset = buildConstant(loc, flagType, 0, streamCtrl, rewriter);
+    next = rewriter.create<arith::SelectOp>(loc, eos, reset, next);
+    rewriter.replaceOp(tmpStopped, {next});
+
+    auto tupleOut =
+        rewriter.create<handshake::PackOp>(loc, ValueRange({data, eosOut}));
+    auto dataBr =
+        rewriter.create<handshake::ConditionalBranchOp>(loc, emit, tupleOut);
+    auto ctrlBr =
+        rewriter.create<handshake::ConditionalBranchOp>(loc, emit, ctrl);
+
+    auto newTerm = rewriter.replaceOpWithNewOp<handshake::ReturnOp>(
+        oldTerm,
+        ValueRange({dataBr.trueResult(), ctrlBr.trueResult(), initCtrl}));
+    if (cancelOut)
+      addCancelResult(newTerm, cancelOut);
+
+    SmallVector<Value> operands;
+    resolveNewOperands(op, adaptor.getOperands(), operands);
+
+    rewriter.setInsertionPointToStart(getTopLevelBlock(op));
+    FuncOp newFuncOp = createFuncOp(r, symbolUniquer.getUniqueSymName(op),
+                                    entryBlock->getArgumentTypes(),
+                                    newTerm.getOperandTypes(), rewriter);
+    InstanceOp instance =
+        replaceWithInstance(op, newFuncOp, operands, rewriter);
+    if (cancelOut)
+      connectCancelResult(op.input(), instance, rewriter);
+    return success();
+  }
+};
+
+// Lowers a buffer directly into the surrounding function, as it neither needs
+// a region nor state apart from the handshake buffers themselves.
+struct BufferOpLowering : public OpConversionPattern<stream::BufferOp> {
+  using OpConversionPattern<stream::BufferOp>::OpConversionPattern;
+
+  LogicalResult
+  matchAndRewrite(stream::BufferOp op, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    Location loc = op.getLoc();
+    SmallVector<Value> operands;
+    resolveStreamOperand(adaptor.input(), operands);
+
+    BufferTypeEnum kind = op.kind() == BufferKind::seq ? BufferTypeEnum::seq
+                                                       : BufferTypeEnum::fifo;
+    // Both the tuple and the ctrl signal of the stream have to be buffered
+    SmallVector<Value> buffered;
+    for (Value operand : operands)
+      buffered.push_back(rewriter.create<handshake::BufferOp>(
+          loc, operand.getType(), op.depth(), operand, kind));
+
+    rewriter.replaceOpWithNewOp<UnrealizedConversionCastOp>(
+        op, op.getType(), buffered);
+    return success();
+  }
+};
+
 struct SinkOpLowering : public StreamOpLowering<stream::SinkOp> {
   using StreamOpLowering::StreamOpLowering;
 
@@ -844,41 +3326,58 @@ struct SinkOpLowering : public StreamOpLowering<stream::SinkOp> {
 
 static void
 populateStreamToHandshakePatterns(StreamTypeConverter &typeConverter,
-                                  SymbolUniquer symbolUniquer,
+                                  SymbolUniquer &symbolUniquer,
+                                  const StreamLoweringOptions &options,
+                                  CancelSignals &cancelSignals,
                                   RewritePatternSet &patterns) {
   // clang-format off
   patterns.add<
     FuncOpLowering,
     ReturnOpLowering,
     PackOpLowering,
-    UnpackOpLowering
+    UnpackOpLowering,
+    BufferOpLowering
   >(typeConverter, patterns.getContext());
 
   patterns.add<
     MapOpLowering,
     FilterOpLowering,
     ReduceOpLowering,
+    ReduceByKeyOpLowering,
     CreateOpLowering,
+    IotaOpLowering,
     SplitOpLowering,
     CombineOpLowering,
+    MergeOpLowering,
+    WindowOpLowering,
+    BatchOpLowering,
+    UnbatchOpLowering,
+    LoadOpLowering,
+    StoreOpLowering,
+    TakeOpLowering,
+    TakeWhileOpLowering,
     SinkOpLowering
-  >(typeConverter, patterns.getContext(), symbolUniquer);
+  >(typeConverter, patterns.getContext(), symbolUniquer, options,
+    cancelSignals);
   // clang-format on
 }
 
 // ensures that the IR is in a valid state after the initial partial
-// conversion
+// conversion. The functions are independent of each other and are thus
+// processed in parallel.
 static LogicalResult materializeForksAndSinks(ModuleOp m) {
-  for (auto funcOp :
-       llvm::make_early_inc_range(m.getOps<handshake::FuncOp>())) {
-    OpBuilder builder(funcOp);
-    if (addForkOps(funcOp.getRegion(), builder).failed() ||
-        addSinkOps(funcOp.getRegion(), builder).failed() ||
-        verifyAllValuesHasOneUse(funcOp).failed())
-      return failure();
-  }
-
-  return success();
+  auto funcOps = llvm::to_vector(m.getOps<handshake::FuncOp>());
+  return failableParallelForEach(
+      m.getContext(), funcOps, [](handshake::FuncOp funcOp) {
+        if (funcOp.isDeclaration())
+          return success();
+        OpBuilder builder(funcOp);
+        if (addForkOps(funcOp.getRegion(), builder).failed() ||
+            addSinkOps(funcOp.getRegion(), builder).failed() ||
+            verifyAllValuesHasOneUse(funcOp).failed())
+          return failure();
+        return success();
+      });
 }
 
 /// Removes all forks and syncs as the insertion is not able to extend existing
@@ -898,28 +3397,200 @@ static LogicalResult dematerializeForksAndSinks(Region &r) {
 
 // TODO Do this with an op trait?
 bool isStreamOp(Operation *op) {
-  return isa<MapOp, FilterOp, ReduceOp, SplitOp, CombineOp>(op);
+  return isa<MapOp, FilterOp, ReduceOp, ReduceByKeyOp, SplitOp, CombineOp,
+             TakeWhileOp>(op);
 }
 
-/// Traverses the modules region recursively and applies the std to handshake
-/// conversion on each stream operation region.
-LogicalResult transformStdRegions(ModuleOp m) {
-  // go over all stream ops and transform their regions
-  for (auto funcOp : llvm::make_early_inc_range(m.getOps<func::FuncOp>())) {
-    if (funcOp.isDeclaration())
+/// Applies the std to handshake conversion on the region of each stream
+/// operation of the function. Only the function itself is modified, so
+/// functions can be processed in parallel.
+static LogicalResult transformStdRegions(func::FuncOp funcOp) {
+  if (funcOp.isDeclaration())
+    return success();
+  Region *funcRegion = funcOp.getCallableRegion();
+  for (Operation &op : funcRegion->getOps()) {
+    if (!isStreamOp(&op))
       continue;
-    Region *funcRegion = funcOp.getCallableRegion();
-    for (Operation &op : funcRegion->getOps()) {
-      if (!isStreamOp(&op))
+    for (auto &r : op.getRegions()) {
+      StreamLowering sl(r);
+      if (failed(lowerRegion<YieldOp>(sl, false, false)))
+        return failure();
+      if (failed(dematerializeForksAndSinks(r)))
+        return failure();
+      removeBasicBlocks(r);
+    }
+  }
+  return success();
+}
+
+/// Builds the number of valid elements that one transaction of a lowered
+/// multi-lane stream carries, i.e., the sum of its valid flags.
+static Value buildLaneCount(Value payload, Location loc, OpBuilder &builder) {
+  Type i64Type = builder.getI64Type();
+  auto unpack = builder.create<UnpackOp>(loc, payload);
+  auto validUnpack = builder.create<UnpackOp>(loc, unpack.getResult(1));
+  Value sum;
+  for (Value valid : validUnpack.getResults()) {
+    Value ext = builder.create<arith::ExtUIOp>(loc, i64Type, valid);
+    sum = sum ? builder.create<arith::AddIOp>(loc, sum, ext) : ext;
+  }
+  return sum;
+}
+
+/// Builds a counter that counts the elements of a lowered stream. The count
+/// is emitted once the EOS transaction arrives. Multi-lane transactions
+/// contribute the number of their valid lanes.
+static Value buildElementCounter(Value tuple, Value ctrl, unsigned lanes,
+                                 bool restartable, bool eosOnLast,
+                                 Location loc, OpBuilder &builder) {
+  Type i64Type = builder.getI64Type();
+  auto unpack = builder.create<UnpackOp>(loc, tuple);
+  Value eos = unpack.getResult(1);
+  auto ctrlBr = builder.create<handshake::ConditionalBranchOp>(loc, eos, ctrl);
+  Value laneCount =
+      lanes > 1 ? buildLaneCount(unpack.getResult(0), loc, builder) : Value();
+
+  auto tmpCnt = builder.create<NeverOp>(loc, i64Type);
+  auto cnt = builder.create<handshake::BufferOp>(loc, i64Type, 1, tmpCnt,
+                                                 BufferTypeEnum::seq);
+  cnt->setAttr("initValues", builder.getI64ArrayAttr({0}));
+
+  if (eosOnLast) {
+    // The last transaction carries an element as well, so it is counted
+    // before the count is emitted.
+    Value inc = laneCount ? laneCount
+                          : builder.create<handshake::ConstantOp>(
+                                loc, builder.getIntegerAttr(i64Type, 1), ctrl);
+    Value next = builder.create<arith::AddIOp>(loc, cnt, inc);
+    auto nextBr =
+        builder.create<handshake::ConditionalBranchOp>(loc, eos, next);
+    Value loop = nextBr.falseResult();
+    if (restartable) {
+      Value zero = builder.create<handshake::ConstantOp>(
+          loc, builder.getIntegerAttr(i64Type, 0), ctrlBr.trueResult());
+      loop = builder.create<handshake::MergeOp>(loc, ValueRange({loop, zero}));
+    }
+    tmpCnt.getResult().replaceAllUsesWith(loop);
+    tmpCnt->erase();
+    return nextBr.trueResult();
+  }
+
+  auto cntBr = builder.create<handshake::ConditionalBranchOp>(loc, eos, cnt);
+
+  // The EOS transaction does not carry an element.
+  Value inc =
+      laneCount
+          ? builder.create<handshake::ConditionalBranchOp>(loc, eos, laneCount)
+                .falseResult()
+          : builder.create<handshake::ConstantOp>(
+                loc, builder.getIntegerAttr(i64Type, 1), ctrlBr.falseResult());
+  Value next = builder.create<arith::AddIOp>(loc, cntBr.falseResult(), inc);
+  if (restartable) {
+    Value zero = builder.create<handshake::ConstantOp>(
+        loc, builder.getIntegerAttr(i64Type, 0), ctrlBr.trueResult());
+    next = builder.create<handshake::MergeOp>(loc, ValueRange({next, zero}));
+  }
+  tmpCnt.getResult().replaceAllUsesWith(next);
+  tmpCnt->erase();
+
+  return cntBr.trueResult();
+}
+
+static constexpr StringLiteral kPerfMonitorName = "stream_perf_monitor";
+
+/// Returns the declaration of the external module that counts the cycles of a
+/// stream, and inserts it if it does not exist yet. Handshake does not model
+/// cycles nor ready signals, so the monitor is provided in SystemVerilog, see
+/// `integration_test/Inputs/stream_perf_monitor.sv`. It passes the ctrl
+/// channel of a stream through and observes its EOS flag. Once the EOS
+/// transaction is transferred, it emits the number of cycles from the first
+/// valid transaction up to the EOS transaction, and the number of those
+/// cycles in which a transaction was valid but not ready.
+static handshake::FuncOp getOrInsertPerfMonitor(ModuleOp m,
+                                                OpBuilder &builder) {
+  if (auto monitor = m.lookupSymbol<handshake::FuncOp>(kPerfMonitorName))
+    return monitor;
+
+  OpBuilder::InsertionGuard guard(builder);
+  builder.setInsertionPointToStart(m.getBody());
+  Type i64Type = builder.getI64Type();
+  Type noneType = builder.getNoneType();
+  auto type = builder.getFunctionType({builder.getI1Type(), noneType},
+                                      {i64Type, i64Type, noneType});
+  auto monitor = builder.create<handshake::FuncOp>(
+      builder.getUnknownLoc(), kPerfMonitorName, type);
+  SymbolTable::setSymbolVisibility(monitor, SymbolTable::Visibility::Private);
+  monitor->setAttr("argNames", builder.getStrArrayAttr({"in0", "inCtrl"}));
+  monitor->setAttr("resNames",
+                   builder.getStrArrayAttr({"active", "stalled", "outCtrl"}));
+  return monitor;
+}
+
+/// Adds performance counters to each stream that is produced by an instance in
+/// a public function: the number of elements, the number of active cycles,
+/// and the number of backpressure cycles. The counts are returned as
+/// additional results in front of the ctrl result of the function.
+static LogicalResult insertPerfCounters(ModuleOp m, bool restartable,
+                                        bool eosOnLast) {
+  OpBuilder builder(m.getContext());
+  handshake::FuncOp monitor;
+  for (auto funcOp : m.getOps<handshake::FuncOp>()) {
+    if (funcOp.isDeclaration() || funcOp.isPrivate())
+      continue;
+
+    // The conversion casts still mark the streams of the lowered operations.
+    SmallVector<Value> counts;
+    for (auto castOp : llvm::make_early_inc_range(
+             funcOp.body().getOps<UnrealizedConversionCastOp>())) {
+      ValueRange inputs = castOp.getInputs();
+      if (inputs.size() != 2 || !inputs[0].getDefiningOp<InstanceOp>())
         continue;
-      for (auto &r : op.getRegions()) {
-        StreamLowering sl(r);
-        if (failed(lowerRegion<YieldOp>(sl, false, false)))
-          return failure();
-        if (failed(dematerializeForksAndSinks(r)))
-          return failure();
-        removeBasicBlocks(r);
+      if (!monitor)
+        monitor = getOrInsertPerfMonitor(m, builder);
+
+      Location loc = castOp.getLoc();
+      Value tuple = inputs[0];
+      Value ctrl = inputs[1];
+      builder.setInsertionPoint(castOp);
+      // The consumers of the stream receive the ctrl signal through the
+      // monitor, such that it observes their ready signal.
+      Value eos = builder.create<UnpackOp>(loc, tuple).getResult(1);
+      auto instance = builder.create<InstanceOp>(loc, monitor,
+                                                 ValueRange({eos, ctrl}));
+      Value monitoredCtrl = instance.getResult(2);
+      ctrl.replaceAllUsesExcept(monitoredCtrl, instance);
+
+      auto type = castOp.getResult(0).getType().cast<StreamType>();
+      counts.push_back(buildElementCounter(tuple, monitoredCtrl,
+                                           type.getLanes(), restartable,
+                                           eosOnLast, loc, builder));
+      counts.push_back(instance.getResult(0));
+      counts.push_back(instance.getResult(1));
+    }
+    if (counts.empty())
+      continue;
+
+    auto returnOp =
+        cast<handshake::ReturnOp>(funcOp.body().front().getTerminator());
+    SmallVector<Value> results(returnOp.getOperands());
+    results.insert(std::prev(results.end()), counts.begin(), counts.end());
+    returnOp->setOperands(results);
+    funcOp.setType(builder.getFunctionType(funcOp.getArgumentTypes(),
+                                           ValueRange(results).getTypes()));
+
+    if (auto resNames = funcOp->getAttrOfType<ArrayAttr>("resNames")) {
+      SmallVector<Attribute> names(resNames.begin(), resNames.end());
+      SmallVector<Attribute> countNames;
+      for (unsigned i = 0, e = counts.size() / 3; i < e; ++i) {
+        countNames.push_back(builder.getStringAttr("perf" + Twine(i)));
+        countNames.push_back(
+            builder.getStringAttr("perf" + Twine(i) + "_active"));
+        countNames.push_back(
+            builder.getStringAttr("perf" + Twine(i) + "_stalled"));
       }
+      names.insert(std::prev(names.end()), countNames.begin(),
+                   countNames.end());
+      funcOp->setAttr("resNames", builder.getArrayAttr(names));
     }
   }
   return success();
@@ -938,11 +3609,100 @@ static LogicalResult removeUnusedConversionCasts(ModuleOp m) {
   return success();
 }
 
+/// Replaces the provided instance with a copy of the callee's body.
+static void inlineInstance(InstanceOp instance, handshake::FuncOp callee) {
+  // Cloning the whole region, instead of op by op, ensures that values used
+  // before their definition, e.g., in buffer loops, are remapped as well.
+  BlockAndValueMapping mapping;
+  Region &calleeBody = callee.getBody();
+  mapping.map(calleeBody.getArguments(), instance.getOperands());
+
+  Region tmp;
+  calleeBody.cloneInto(&tmp, mapping);
+  Block *clonedBlock = &tmp.front();
+  Operation *term = clonedBlock->getTerminator();
+  assert(isa<handshake::ReturnOp>(term) &&
+         "expected outlined function to terminate with a handshake.return");
+
+  instance->getBlock()->getOperations().splice(Block::iterator(instance),
+                                               clonedBlock->getOperations());
+
+  instance->replaceAllUsesWith(term->getOperands());
+  term->erase();
+  instance->erase();
+}
+
+/// Inlines all functions that were outlined during the lowering into the
+/// handshake functions that instantiate them. Afterwards, the outlined
+/// functions are removed.
+static LogicalResult flattenInstances(ModuleOp m) {
+  SymbolTable symbolTable(m);
+  llvm::SmallSetVector<Operation *, 8> callees;
+
+  for (auto funcOp : m.getOps<handshake::FuncOp>()) {
+    if (funcOp.isDeclaration())
+      continue;
+    // Inlining can introduce new instances, thus iterate until none are left.
+    // Instances of external modules, like the performance monitor, are kept.
+    auto collectInstances = [&](SmallVectorImpl<InstanceOp> &instances) {
+      for (InstanceOp instance : funcOp.getOps<InstanceOp>()) {
+        auto callee =
+            symbolTable.lookup<handshake::FuncOp>(instance.getModule());
+        if (!callee)
+          return instance.emitError("cannot inline instance of ")
+                 << instance.getModule();
+        if (!callee.isDeclaration())
+          instances.push_back(instance);
+      }
+      return success();
+    };
+    SmallVector<InstanceOp> instances;
+    if (failed(collectInstances(instances)))
+      return failure();
+    while (!instances.empty()) {
+      for (InstanceOp instance : instances) {
+        auto callee =
+            symbolTable.lookup<handshake::FuncOp>(instance.getModule());
+        inlineInstance(instance, callee);
+        callees.insert(callee);
+      }
+      instances.clear();
+      if (failed(collectInstances(instances)))
+        return failure();
+    }
+  }
+
+  // Collect the remaining uses in a single walk, as looking up the uses of
+  // each callee separately would walk the module once per callee.
+  llvm::StringSet<> usedCallees;
+  m.walk(
+      [&](InstanceOp instance) { usedCallees.insert(instance.getModule()); });
+  for (Operation *callee : callees)
+    if (!usedCallees.contains(SymbolTable::getSymbolName(callee).getValue()))
+      callee->erase();
+
+  return success();
+}
+
+class StreamLowerRegionsPass
+    : public StreamLowerRegionsBase<StreamLowerRegionsPass> {
+public:
+  void runOnOperation() override {
+    if (failed(transformStdRegions(getOperation())))
+      signalPassFailure();
+  }
+};
+
 class StreamToHandshakePass
     : public StreamToHandshakeBase<StreamToHandshakePass> {
 public:
   void runOnOperation() override {
-    if (failed(transformStdRegions(getOperation()))) {
+    // The regions are lowered by a function-nested pipeline, such that the
+    // pass manager distributes the functions over its threads. Only the
+    // outlining below creates symbols and thus has to run on the module.
+    OpPassManager regionPM(ModuleOp::getOperationName());
+    regionPM.addNestedPass<func::FuncOp>(createStreamLowerRegionsPass());
+    if (failed(runPipeline(regionPM, getOperation()))) {
       signalPassFailure();
       return;
     }
@@ -951,9 +3711,18 @@ public:
     RewritePatternSet patterns(&getContext());
     ConversionTarget target(getContext());
     SymbolUniquer symbolUniquer(getOperation());
+    StreamLoweringOptions options;
+    options.numAccumulators = std::max(1u, reduceAccumulators.getValue());
+    options.createRomThreshold = createRomThreshold;
+    options.restartable = restartable;
+    options.loadRequests = std::max(1u, loadRequests.getValue());
+    options.cancelSlack = std::max(1u, cancelSlack.getValue());
+    options.eosOnLast = eosOnLast;
 
     // Patterns to lower stream dialect operations
-    populateStreamToHandshakePatterns(typeConverter, symbolUniquer, patterns);
+    CancelSignals cancelSignals(eosOnLast);
+    populateStreamToHandshakePatterns(typeConverter, symbolUniquer, options,
+                                      cancelSignals, patterns);
     target.addLegalOp<ModuleOp>();
     target.addLegalOp<UnrealizedConversionCastOp>();
     target.addLegalDialect<handshake::HandshakeDialect>();
@@ -967,17 +3736,32 @@ public:
       return;
     }
 
+    if (perfCounters &&
+        failed(insertPerfCounters(getOperation(), restartable, eosOnLast))) {
+      signalPassFailure();
+      return;
+    }
+
     if (failed(removeUnusedConversionCasts(getOperation()))) {
       signalPassFailure();
       return;
     }
 
+    if (flatten && failed(flattenInstances(getOperation()))) {
+      signalPassFailure();
+      return;
+    }
+
     if (failed(materializeForksAndSinks(getOperation())))
       signalPassFailure();
   }
 };
 } // namespace
 
+std::unique_ptr<Pass> circt_stream::createStreamLowerRegionsPass() {
+  return std::make_unique<StreamLowerRegionsPass>();
+}
+
 std::unique_ptr<Pass> circt_stream::createStreamToHandshakePass() {
   return std::make_unique<StreamToHandshakePass>();
 }
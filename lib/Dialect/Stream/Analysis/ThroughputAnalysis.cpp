@@ -0,0 +1,171 @@
+//===- ThroughputAnalysis.cpp - Stream throughput estimation ----*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt-stream/Dialect/Stream/Analysis/ThroughputAnalysis.h"
+
+#include "circt-stream/Dialect/Stream/StreamDialect.h"
+#include "circt-stream/Dialect/Stream/StreamOps.h"
+#include "circt-stream/Dialect/Stream/StreamTypes.h"
+#include "llvm/Support/MathExtras.h"
+
+using namespace mlir;
+using namespace circt_stream;
+using namespace circt_stream::stream;
+
+/// Returns true if the operation does not lead to any logic on its own.
+static bool isFree(Operation &op) {
+  return op.hasTrait<OpTrait::ConstantLike>() ||
+         isa<PackOp, UnpackOp, YieldOp>(op);
+}
+
+/// Returns the length of the longest path through a region that starts in
+/// one of the sources and ends in a terminator. Without sources, the paths can
+/// start anywhere.
+static int64_t getLongestPath(Region &region, ArrayRef<Value> sources) {
+  DenseMap<Value, int64_t> depth;
+  for (Value source : sources)
+    depth[source] = 0;
+
+  int64_t longest = 0;
+  for (Block &block : region) {
+    for (Operation &op : block) {
+      Optional<int64_t> start;
+      if (sources.empty())
+        start = 0;
+      for (Value operand : op.getOperands()) {
+        auto it = depth.find(operand);
+        if (it != depth.end())
+          start = std::max(start.getValueOr(0), it->second);
+      }
+      // The operation is not on a path that starts in a source
+      if (!start)
+        continue;
+
+      int64_t end = *start + (isFree(op) ? 0 : 1);
+      for (Value result : op.getResults())
+        depth[result] = end;
+
+      if (op.hasTrait<OpTrait::IsTerminator>())
+        longest = std::max(longest, end);
+    }
+  }
+  return longest;
+}
+
+static bool isStreamOp(Operation &op) {
+  auto isStream = [](Type type) { return type.isa<StreamType>(); };
+  return isa<StreamDialect>(op.getDialect()) &&
+         (llvm::any_of(op.getOperandTypes(), isStream) ||
+          llvm::any_of(op.getResultTypes(), isStream));
+}
+
+static OpTiming estimateTiming(Operation *op) {
+  OpTiming timing;
+
+  int64_t regionLatency = 0;
+  for (Region &region : op->getRegions())
+    regionLatency = std::max(regionLatency, getLongestPath(region, {}));
+
+  // An explicitly pipelined region takes one cycle per stage
+  if (auto latency = op->getAttrOfType<IntegerAttr>("latency"))
+    regionLatency = latency.getInt();
+
+  // Each lowered operation has to unpack and pack the stream's tuples
+  timing.latency = 1 + regionLatency;
+
+  // Replicated regions pass their results through a FIFO for the reassembly
+  if (auto mapOp = dyn_cast<MapOp>(op))
+    if (mapOp.replicas().getValueOr(1) > 1)
+      timing.latency += 1;
+  timing.eosLatency = timing.latency;
+
+  if (auto reduceOp = dyn_cast<ReduceOp>(op)) {
+    // The next element can only be accepted once the accumulator went through
+    // the region and its buffer.
+    Value acc = reduceOp.getRegion().front().getArgument(0);
+    timing.initiationInterval = 1 + getLongestPath(reduceOp.getRegion(), acc);
+    // The result is emitted after EOS, followed by EOS one cycle later
+    timing.eosLatency = 2;
+  }
+
+  if (auto reduceOp = dyn_cast<ReduceByKeyOp>(op)) {
+    // The accumulator of the key is selected out of the slots with a tree of
+    // selects, goes through the region, and is written back to its slot
+    // before the next element can be accepted.
+    int64_t selectDepth = 1 + llvm::Log2_64_Ceil(reduceOp.capacity());
+    Value acc = reduceOp.getRegion().front().getArgument(0);
+    timing.latency += selectDepth;
+    timing.initiationInterval =
+        2 + selectDepth + getLongestPath(reduceOp.getRegion(), acc);
+    // Each slot is emitted in its own cycle after EOS, followed by EOS
+    timing.eosLatency = reduceOp.capacity() + 1;
+  }
+
+  if (auto bufferOp = dyn_cast<BufferOp>(op)) {
+    // A pipeline delays each element by its depth, while a FIFO can be
+    // passed in a single cycle.
+    timing.latency = bufferOp.kind() == BufferKind::seq ? bufferOp.depth() : 1;
+    timing.eosLatency = timing.latency;
+  }
+
+  if (auto unbatchOp = dyn_cast<UnbatchOp>(op)) {
+    // Each lane is emitted in its own cycle
+    timing.initiationInterval =
+        unbatchOp.input().getType().cast<StreamType>().getLanes();
+  }
+
+  return timing;
+}
+
+ThroughputAnalysis::ThroughputAnalysis(Operation *funcOp) {
+  for (Region &region : funcOp->getRegions()) {
+    for (Block &block : region) {
+      for (Operation &op : block) {
+        // The returned streams determine the latency of the function
+        if (op.hasTrait<OpTrait::ReturnLike>()) {
+          for (Value operand : op.getOperands())
+            latency = std::max(latency, getArrival(operand));
+          continue;
+        }
+
+        if (!isStreamOp(op))
+          continue;
+
+        int64_t start = 0;
+        for (Value operand : op.getOperands())
+          start = std::max(start, getArrival(operand));
+
+        OpTiming timing = estimateTiming(&op);
+        for (Value result : op.getResults())
+          arrivals[result] = start + timing.latency;
+
+        if (!criticalOp || timing.initiationInterval >
+                               timings[criticalOp].initiationInterval)
+          criticalOp = &op;
+        timings[&op] = timing;
+      }
+    }
+  }
+}
+
+const OpTiming *ThroughputAnalysis::getTiming(Operation *op) const {
+  auto it = timings.find(op);
+  if (it == timings.end())
+    return nullptr;
+  return &it->second;
+}
+
+int64_t ThroughputAnalysis::getArrival(Value stream) const {
+  return arrivals.lookup(stream);
+}
+
+int64_t ThroughputAnalysis::getInitiationInterval() const {
+  if (!criticalOp)
+    return 1;
+  return getTiming(criticalOp)->initiationInterval;
+}
@@ -0,0 +1,540 @@
+//===- Interpreter.cpp - Stream dialect interpreter -------------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt-stream/Dialect/Stream/Interpreter/Interpreter.h"
+#include "Kernel.h"
+
+#include "circt-stream/Dialect/Stream/StreamDialect.h"
+#include "circt-stream/Dialect/Stream/StreamOps.h"
+#include "circt-stream/Dialect/Stream/StreamTypes.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/ControlFlow/IR/ControlFlowOps.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/TypeSwitch.h"
+
+using namespace mlir;
+using namespace circt_stream;
+using namespace circt_stream::stream;
+
+bool Element::operator==(const Element &other) const {
+  if (tuple != other.tuple)
+    return false;
+  if (tuple)
+    return fields == other.fields;
+  return value.getBitWidth() == other.value.getBitWidth() &&
+         value == other.value;
+}
+
+void Element::print(raw_ostream &os) const {
+  if (!tuple) {
+    value.print(os, /*isSigned=*/value.getBitWidth() > 1);
+    return;
+  }
+  os << "(";
+  llvm::interleaveComma(fields, os,
+                        [&](const Element &field) { field.print(os); });
+  os << ")";
+}
+
+/// Converts an attribute, e.g., the initial value of a reduction, to an
+/// element of the provided type.
+static Element getElement(Attribute attr, Type type) {
+  if (auto tupleType = type.dyn_cast<TupleType>()) {
+    std::vector<Element> fields;
+    for (auto it : llvm::zip(attr.cast<ArrayAttr>(), tupleType.getTypes()))
+      fields.push_back(getElement(std::get<0>(it), std::get<1>(it)));
+    return Element(std::move(fields));
+  }
+  return Element(attr.cast<IntegerAttr>().getValue().sextOrTrunc(
+      type.getIntOrFloatBitWidth()));
+}
+
+LogicalResult RegionEvaluator::evaluate(ArrayRef<Element> args,
+                                        SmallVectorImpl<Element> &results) {
+  values.clear();
+  Block *block = &region.front();
+  SmallVector<Element> blockArgs(args.begin(), args.end());
+  while (true) {
+    for (auto it : llvm::zip(block->getArguments(), blockArgs))
+      values[std::get<0>(it)] = std::move(std::get<1>(it));
+
+    for (Operation &op : block->without_terminator())
+      if (failed(evaluateOp(op)))
+        return failure();
+
+    Operation *terminator = block->getTerminator();
+    if (auto yieldOp = dyn_cast<YieldOp>(terminator)) {
+      for (Value result : yieldOp.results())
+        results.push_back(lookup(result));
+      return success();
+    }
+
+    OperandRange destOperands = terminator->getOperands();
+    if (auto brOp = dyn_cast<cf::BranchOp>(terminator)) {
+      block = brOp.getDest();
+    } else if (auto condBrOp = dyn_cast<cf::CondBranchOp>(terminator)) {
+      bool cond = lookupInt(condBrOp.getCondition()).getBoolValue();
+      block = cond ? condBrOp.getTrueDest() : condBrOp.getFalseDest();
+      destOperands =
+          cond ? condBrOp.getTrueOperands() : condBrOp.getFalseOperands();
+    } else {
+      return terminator->emitError("cannot interpret terminator ")
+             << terminator->getName();
+    }
+
+    blockArgs.clear();
+    for (Value operand : destOperands)
+      blockArgs.push_back(lookup(operand));
+  }
+}
+
+LogicalResult RegionEvaluator::evaluateOp(Operation &op) {
+  auto binary = [&](function_ref<APInt(const APInt &, const APInt &)> fn) {
+    values[op.getResult(0)] =
+        fn(lookupInt(op.getOperand(0)), lookupInt(op.getOperand(1)));
+    return success();
+  };
+  // Division by zero is undefined behavior in the arith dialect, so it is
+  // rejected instead of producing an arbitrary value.
+  auto division = [&](function_ref<APInt(const APInt &, const APInt &)> fn) {
+    if (lookupInt(op.getOperand(1)).isZero())
+      return op.emitError("division by zero");
+    return binary(fn);
+  };
+  unsigned resultWidth = 0;
+  if (op.getNumResults() == 1 && op.getResult(0).getType().isIntOrIndex())
+    resultWidth = op.getResult(0).getType().getIntOrFloatBitWidth();
+
+  return TypeSwitch<Operation *, LogicalResult>(&op)
+      .Case<arith::ConstantOp>([&](auto) {
+        auto value = op.getAttrOfType<IntegerAttr>("value");
+        if (!value)
+          return op.emitError("expect an integer constant");
+        values[op.getResult(0)] = value.getValue();
+        return success();
+      })
+      .Case<arith::AddIOp>([&](auto) {
+        return binary([](const APInt &a, const APInt &b) { return a + b; });
+      })
+      .Case<arith::SubIOp>([&](auto) {
+        return binary([](const APInt &a, const APInt &b) { return a - b; });
+      })
+      .Case<arith::MulIOp>([&](auto) {
+        return binary([](const APInt &a, const APInt &b) { return a * b; });
+      })
+      .Case<arith::AndIOp>([&](auto) {
+        return binary([](const APInt &a, const APInt &b) { return a & b; });
+      })
+      .Case<arith::OrIOp>([&](auto) {
+        return binary([](const APInt &a, const APInt &b) { return a | b; });
+      })
+      .Case<arith::XOrIOp>([&](auto) {
+        return binary([](const APInt &a, const APInt &b) { return a ^ b; });
+      })
+      .Case<arith::ShLIOp>([&](auto) {
+        return binary(
+            [](const APInt &a, const APInt &b) { return a.shl(b); });
+      })
+      .Case<arith::ShRSIOp>([&](auto) {
+        return binary(
+            [](const APInt &a, const APInt &b) { return a.ashr(b); });
+      })
+      .Case<arith::ShRUIOp>([&](auto) {
+        return binary(
+            [](const APInt &a, const APInt &b) { return a.lshr(b); });
+      })
+      .Case<arith::MaxSIOp>([&](auto) {
+        return binary([](const APInt &a, const APInt &b) {
+          return a.sge(b) ? a : b;
+        });
+      })
+      .Case<arith::MaxUIOp>([&](auto) {
+        return binary([](const APInt &a, const APInt &b) {
+          return a.uge(b) ? a : b;
+        });
+      })
+      .Case<arith::MinSIOp>([&](auto) {
+        return binary([](const APInt &a, const APInt &b) {
+          return a.sle(b) ? a : b;
+        });
+      })
+      .Case<arith::MinUIOp>([&](auto) {
+        return binary([](const APInt &a, const APInt &b) {
+          return a.ule(b) ? a : b;
+        });
+      })
+      .Case<arith::DivSIOp>([&](auto) {
+        return division(
+            [](const APInt &a, const APInt &b) { return a.sdiv(b); });
+      })
+      .Case<arith::DivUIOp>([&](auto) {
+        return division(
+            [](const APInt &a, const APInt &b) { return a.udiv(b); });
+      })
+      .Case<arith::RemSIOp>([&](auto) {
+        return division(
+            [](const APInt &a, const APInt &b) { return a.srem(b); });
+      })
+      .Case<arith::RemUIOp>([&](auto) {
+        return division(
+            [](const APInt &a, const APInt &b) { return a.urem(b); });
+      })
+      .Case<arith::CmpIOp>([&](auto) {
+        auto predicate =
+            op.getAttrOfType<arith::CmpIPredicateAttr>("predicate").getValue();
+        bool result =
+            arith::applyCmpPredicate(predicate, lookupInt(op.getOperand(0)),
+                                     lookupInt(op.getOperand(1)));
+        values[op.getResult(0)] = APInt(1, result);
+        return success();
+      })
+      .Case<arith::SelectOp>([&](auto) {
+        bool cond = lookupInt(op.getOperand(0)).getBoolValue();
+        // Copy the value first, as the insertion can invalidate references
+        // into the map.
+        Element result = lookup(op.getOperand(cond ? 1 : 2));
+        values[op.getResult(0)] = std::move(result);
+        return success();
+      })
+      .Case<arith::ExtSIOp>([&](auto) {
+        values[op.getResult(0)] =
+            lookupInt(op.getOperand(0)).sext(resultWidth);
+        return success();
+      })
+      .Case<arith::ExtUIOp>([&](auto) {
+        values[op.getResult(0)] =
+            lookupInt(op.getOperand(0)).zext(resultWidth);
+        return success();
+      })
+      .Case<arith::TruncIOp>([&](auto) {
+        values[op.getResult(0)] =
+            lookupInt(op.getOperand(0)).trunc(resultWidth);
+        return success();
+      })
+      .Case<PackOp>([&](PackOp packOp) {
+        std::vector<Element> fields;
+        for (Value input : packOp.inputs())
+          fields.push_back(lookup(input));
+        values[packOp.result()] = Element(std::move(fields));
+        return success();
+      })
+      .Case<UnpackOp>([&](UnpackOp unpackOp) {
+        std::vector<Element> fields =
+            lookup(unpackOp.input()).getFields().vec();
+        for (auto it : llvm::zip(unpackOp.results(), fields))
+          values[std::get<0>(it)] = std::move(std::get<1>(it));
+        return success();
+      })
+      .Default([&](Operation *unknownOp) {
+        return unknownOp->emitError("cannot interpret operation ")
+               << unknownOp->getName();
+      });
+}
+
+OpKernel::OpKernel(Operation &op) : op(op) {
+  if (op.getNumRegions() == 1)
+    evaluator = std::make_unique<RegionEvaluator>(op.getRegion(0));
+  if (auto reduceOp = dyn_cast<ReduceOp>(op)) {
+    Type accType =
+        reduceOp.result().getType().cast<StreamType>().getElementType();
+    acc = getElement(reduceOp.initValue(), accType);
+  }
+  if (auto reduceOp = dyn_cast<ReduceByKeyOp>(op)) {
+    Type accType = reduceOp.result()
+                       .getType()
+                       .cast<StreamType>()
+                       .getElementType()
+                       .cast<TupleType>()
+                       .getType(1);
+    acc = getElement(reduceOp.initValue(), accType);
+    slots.resize(reduceOp.capacity());
+  }
+}
+
+LogicalResult OpKernel::verifySupported(Operation &op) {
+  if (isa<CreateOp, IotaOp, MapOp, FilterOp, ReduceOp, ReduceByKeyOp, SplitOp,
+          CombineOp, MergeOp, WindowOp, BatchOp, UnbatchOp, BufferOp, TakeOp,
+          TakeWhileOp, SinkOp>(op))
+    return success();
+  return op.emitError("cannot interpret operation ") << op.getName();
+}
+
+LogicalResult OpKernel::process(MutableArrayRef<StreamContents> inputs,
+                                MutableArrayRef<StreamContents> outputs) {
+  return TypeSwitch<Operation *, LogicalResult>(&op)
+      .Case<CreateOp, IotaOp>([&](auto) { return success(); })
+      .Case<MapOp>([&](auto) {
+        outputs[0].reserve(outputs[0].size() + inputs[0].size());
+        for (const Element &element : inputs[0]) {
+          yielded.clear();
+          if (failed(evaluator->evaluate(element, yielded)))
+            return failure();
+          outputs[0].push_back(std::move(yielded.front()));
+        }
+        inputs[0].clear();
+        return success();
+      })
+      .Case<FilterOp>([&](auto) {
+        for (Element &element : inputs[0]) {
+          yielded.clear();
+          if (failed(evaluator->evaluate(element, yielded)))
+            return failure();
+          if (yielded.front().getValue().getBoolValue())
+            outputs[0].push_back(std::move(element));
+        }
+        inputs[0].clear();
+        return success();
+      })
+      .Case<TakeOp>([&](TakeOp takeOp) {
+        for (Element &element : inputs[0]) {
+          if (taken == takeOp.count())
+            break;
+          outputs[0].push_back(std::move(element));
+          ++taken;
+        }
+        inputs[0].clear();
+        return success();
+      })
+      .Case<TakeWhileOp>([&](auto) {
+        for (Element &element : inputs[0]) {
+          if (stopped)
+            break;
+          yielded.clear();
+          if (failed(evaluator->evaluate(element, yielded)))
+            return failure();
+          stopped = !yielded.front().getValue().getBoolValue();
+          if (!stopped)
+            outputs[0].push_back(std::move(element));
+        }
+        inputs[0].clear();
+        return success();
+      })
+      .Case<ReduceOp>([&](auto) {
+        for (const Element &element : inputs[0]) {
+          yielded.clear();
+          if (failed(evaluator->evaluate({acc, element}, yielded)))
+            return failure();
+          acc = std::move(yielded.front());
+        }
+        inputs[0].clear();
+        return success();
+      })
+      .Case<ReduceByKeyOp>([&](auto) {
+        for (const Element &element : inputs[0]) {
+          ArrayRef<Element> fields = element.getFields();
+          auto it = llvm::find_if(slots, [&](const Slot &slot) {
+            return slot.valid && slot.key == fields[0];
+          });
+          Slot *slot = it != slots.end() ? &*it : nullptr;
+          if (!slot) {
+            // Like in the lowering, a new key claims the slots in a
+            // round-robin fashion and evicts their previous contents.
+            slot = &slots[replacement];
+            replacement = (replacement + 1) % slots.size();
+            if (slot->valid)
+              outputs[0].push_back(std::vector<Element>{slot->key, slot->acc});
+            *slot = {true, fields[0], acc};
+          }
+          yielded.clear();
+          if (failed(evaluator->evaluate({slot->acc, fields[1]}, yielded)))
+            return failure();
+          slot->acc = std::move(yielded.front());
+        }
+        inputs[0].clear();
+        return success();
+      })
+      .Case<SplitOp>([&](auto) {
+        for (const Element &element : inputs[0]) {
+          yielded.clear();
+          if (failed(evaluator->evaluate(element, yielded)))
+            return failure();
+          for (auto it : llvm::zip(outputs, yielded))
+            std::get<0>(it).push_back(std::move(std::get<1>(it)));
+        }
+        inputs[0].clear();
+        return success();
+      })
+      .Case<CombineOp>([&](auto) {
+        // Only the elements that are available on all inputs can be
+        // combined.
+        size_t size = inputs.front().size();
+        for (const StreamContents &input : inputs)
+          size = std::min(size, input.size());
+
+        SmallVector<Element> args;
+        for (size_t i = 0; i < size; ++i) {
+          args.clear();
+          for (StreamContents &input : inputs)
+            args.push_back(std::move(input[i]));
+          yielded.clear();
+          if (failed(evaluator->evaluate(args, yielded)))
+            return failure();
+          outputs[0].push_back(std::move(yielded.front()));
+        }
+        for (StreamContents &input : inputs)
+          input.erase(input.begin(), input.begin() + size);
+        return success();
+      })
+      .Case<MergeOp>([&](auto) {
+        // The elements are forwarded in the order in which they are passed
+        for (StreamContents &input : inputs) {
+          outputs[0].insert(outputs[0].end(),
+                            std::make_move_iterator(input.begin()),
+                            std::make_move_iterator(input.end()));
+          input.clear();
+        }
+        return success();
+      })
+      .Case<WindowOp>([&](WindowOp windowOp) {
+        size_t size = windowOp.size();
+        for (Element &element : inputs[0]) {
+          history.push_back(std::move(element));
+          if (history.size() > size)
+            history.pop_front();
+          // Like in the lowering, the counter is set back once a window is
+          // complete, such that the next one completes `stride` elements
+          // later.
+          if (++windowCount != (int64_t)size)
+            continue;
+          outputs[0].push_back(
+              std::vector<Element>(history.begin(), history.end()));
+          windowCount = (int64_t)size - (int64_t)windowOp.stride();
+        }
+        inputs[0].clear();
+        return success();
+      })
+      .Case<BatchOp, UnbatchOp, BufferOp>([&](auto) {
+        // Lanes and timing are not modelled, so the elements remain unchanged
+        outputs[0].insert(outputs[0].end(),
+                          std::make_move_iterator(inputs[0].begin()),
+                          std::make_move_iterator(inputs[0].end()));
+        inputs[0].clear();
+        return success();
+      })
+      .Case<SinkOp>([&](auto) {
+        inputs[0].clear();
+        return success();
+      })
+      .Default([&](auto) { return verifySupported(op); });
+}
+
+LogicalResult OpKernel::finish(MutableArrayRef<StreamContents> inputs,
+                               MutableArrayRef<StreamContents> outputs) {
+  return TypeSwitch<Operation *, LogicalResult>(&op)
+      .Case<CreateOp>([&](CreateOp createOp) {
+        unsigned width = createOp.getElementType().getIntOrFloatBitWidth();
+        for (APInt value : createOp.values().getValues<APInt>())
+          outputs[0].push_back(value.sextOrTrunc(width));
+        return success();
+      })
+      .Case<IotaOp>([&](IotaOp iotaOp) {
+        unsigned width = iotaOp.getElementType().getIntOrFloatBitWidth();
+        APInt value(width, (int64_t)iotaOp.start(), /*isSigned=*/true);
+        APInt step(width, (int64_t)iotaOp.step(), /*isSigned=*/true);
+        outputs[0].reserve(iotaOp.count());
+        for (uint64_t i = 0, e = iotaOp.count(); i < e; ++i) {
+          outputs[0].push_back(value);
+          value += step;
+        }
+        return success();
+      })
+      .Case<ReduceOp>([&](auto) {
+        outputs[0].push_back(std::move(acc));
+        return success();
+      })
+      .Case<ReduceByKeyOp>([&](auto) {
+        for (Slot &slot : slots)
+          if (slot.valid)
+            outputs[0].push_back(
+                std::vector<Element>{std::move(slot.key), std::move(slot.acc)});
+        return success();
+      })
+      .Case<CombineOp>([&](CombineOp combineOp) {
+        if (llvm::any_of(inputs, [](const StreamContents &input) {
+              return !input.empty();
+            }))
+          return combineOp.emitError(
+              "expect the combined streams to have the same number of "
+              "elements");
+        return success();
+      })
+      .Default([&](auto) { return success(); });
+}
+
+namespace {
+/// Executes the stream operations of a function one after another, each on
+/// its whole input.
+class FunctionInterpreter {
+public:
+  LogicalResult run(func::FuncOp funcOp, ArrayRef<StreamContents> inputs,
+                    SmallVectorImpl<StreamContents> &results);
+
+private:
+  /// Returns the contents of the stream. The last user of a stream takes
+  /// it over instead of copying it.
+  StreamContents take(Value stream) {
+    if (stream.hasOneUse())
+      return std::move(streams[stream]);
+    return streams[stream];
+  }
+
+  DenseMap<Value, StreamContents> streams;
+};
+} // namespace
+
+LogicalResult
+FunctionInterpreter::run(func::FuncOp funcOp, ArrayRef<StreamContents> inputs,
+                         SmallVectorImpl<StreamContents> &results) {
+  Block &body = funcOp.getBody().front();
+  for (auto it : llvm::zip(body.getArguments(), inputs))
+    streams[std::get<0>(it)] = std::get<1>(it);
+
+  for (Operation &op : body) {
+    if (auto returnOp = dyn_cast<func::ReturnOp>(op)) {
+      for (Value operand : returnOp.getOperands())
+        results.push_back(streams[operand]);
+      return success();
+    }
+    if (failed(OpKernel::verifySupported(op)))
+      return failure();
+
+    SmallVector<StreamContents> opInputs;
+    for (Value operand : op.getOperands())
+      opInputs.push_back(take(operand));
+    SmallVector<StreamContents> opOutputs(op.getNumResults());
+
+    OpKernel kernel(op);
+    if (failed(kernel.process(opInputs, opOutputs)) ||
+        failed(kernel.finish(opInputs, opOutputs)))
+      return failure();
+
+    for (auto it : llvm::zip(op.getResults(), opOutputs))
+      streams[std::get<0>(it)] = std::move(std::get<1>(it));
+  }
+  return success();
+}
+
+LogicalResult stream::interpretFunction(
+    func::FuncOp funcOp, ArrayRef<StreamContents> inputs,
+    SmallVectorImpl<StreamContents> &results,
+    const InterpreterOptions &options) {
+  if (funcOp.isDeclaration())
+    return funcOp.emitError("cannot interpret a function declaration");
+  if (!funcOp.getBody().hasOneBlock())
+    return funcOp.emitError("expect the function to have a single block");
+
+  Block &body = funcOp.getBody().front();
+  if (body.getNumArguments() != inputs.size())
+    return funcOp.emitError("expect ")
+           << body.getNumArguments() << " input streams, got "
+           << inputs.size();
+
+  if (options.parallel)
+    return interpretFunctionInParallel(funcOp, inputs, results, options);
+  return FunctionInterpreter().run(funcOp, inputs, results);
+}
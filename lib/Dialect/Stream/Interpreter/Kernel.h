@@ -0,0 +1,110 @@
+//===- Kernel.h - Stream operation kernels ----------------------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// The kernels implement the semantics of the individual stream operations and
+// are shared by the sequential and the parallel interpreter.
+//
+//===----------------------------------------------------------------------===//
+
+// NOLINTNEXTLINE(llvm-header-guard)
+#ifndef DIALECT_STREAM_INTERPRETER_KERNEL_H
+#define DIALECT_STREAM_INTERPRETER_KERNEL_H
+
+#include "circt-stream/Dialect/Stream/Interpreter/Interpreter.h"
+#include "mlir/IR/Operation.h"
+#include "mlir/IR/Region.h"
+#include "llvm/ADT/DenseMap.h"
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace circt_stream {
+namespace stream {
+
+/// Evaluates the region of a stream operation for one set of arguments.
+class RegionEvaluator {
+public:
+  explicit RegionEvaluator(mlir::Region &region) : region(region) {}
+
+  /// Executes the region and appends the yielded values to `results`.
+  mlir::LogicalResult evaluate(llvm::ArrayRef<Element> args,
+                               llvm::SmallVectorImpl<Element> &results);
+
+private:
+  mlir::LogicalResult evaluateOp(mlir::Operation &op);
+
+  const Element &lookup(mlir::Value value) {
+    auto it = values.find(value);
+    assert(it != values.end() && "value was not evaluated yet");
+    return it->second;
+  }
+  const llvm::APInt &lookupInt(mlir::Value value) {
+    return lookup(value).getValue();
+  }
+
+  mlir::Region &region;
+  // The map is reused for all invocations to avoid reallocations.
+  llvm::DenseMap<mlir::Value, Element> values;
+};
+
+/// Processes the elements of a single stream operation. The elements can be
+/// passed in several batches, as the kernel keeps its state between calls.
+class OpKernel {
+public:
+  explicit OpKernel(mlir::Operation &op);
+
+  /// Emits an error if the operation cannot be interpreted.
+  static mlir::LogicalResult verifySupported(mlir::Operation &op);
+
+  /// Consumes the elements of `inputs`, one stream per operand, and appends
+  /// the produced elements to `outputs`, one stream per result. Elements that
+  /// cannot be processed yet, e.g., as the other inputs of a combine did not
+  /// arrive yet, remain in `inputs`.
+  mlir::LogicalResult process(llvm::MutableArrayRef<StreamContents> inputs,
+                              llvm::MutableArrayRef<StreamContents> outputs);
+
+  /// Processes the end of the input streams. Sources produce their elements
+  /// and reductions their result.
+  mlir::LogicalResult finish(llvm::MutableArrayRef<StreamContents> inputs,
+                             llvm::MutableArrayRef<StreamContents> outputs);
+
+private:
+  mlir::Operation &op;
+  std::unique_ptr<RegionEvaluator> evaluator;
+  // The accumulator of a reduction.
+  Element acc;
+  // The last elements and the number of elements of the current window.
+  std::deque<Element> history;
+  int64_t windowCount = 0;
+  // The number of elements a take forwarded and whether the predicate of a
+  // take_while failed already. Later elements are dropped.
+  uint64_t taken = 0;
+  bool stopped = false;
+  // The slots of a reduce_by_key and the slot the next new key claims. The
+  // initial value of the accumulators is kept in `acc`.
+  struct Slot {
+    bool valid = false;
+    Element key;
+    Element acc;
+  };
+  std::vector<Slot> slots;
+  size_t replacement = 0;
+  llvm::SmallVector<Element> yielded;
+};
+
+/// Executes each operation of the function in its own thread.
+mlir::LogicalResult
+interpretFunctionInParallel(mlir::func::FuncOp funcOp,
+                            llvm::ArrayRef<StreamContents> inputs,
+                            llvm::SmallVectorImpl<StreamContents> &results,
+                            const InterpreterOptions &options);
+
+} // namespace stream
+} // namespace circt_stream
+
+#endif // DIALECT_STREAM_INTERPRETER_KERNEL_H
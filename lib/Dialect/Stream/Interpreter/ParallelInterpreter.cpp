@@ -0,0 +1,283 @@
+//===- ParallelInterpreter.cpp - Multi-threaded interpreter -----*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Executes each stream operation of a function in its own thread. The threads
+// are connected by bounded single-producer single-consumer queues that
+// transfer the elements in batches, such that the synchronization cost is
+// amortized over many elements.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Kernel.h"
+#include "circt-stream/Dialect/Stream/Interpreter/SPSCQueue.h"
+#include "circt-stream/Dialect/Stream/StreamOps.h"
+#include "llvm/ADT/STLExtras.h"
+#include <iterator>
+#include <limits>
+#include <thread>
+
+using namespace mlir;
+using namespace circt_stream;
+using namespace circt_stream::stream;
+
+namespace {
+/// A set of consecutive elements that is transferred at once.
+struct Batch {
+  StreamContents elements;
+  /// Marks the end of the stream.
+  bool last = false;
+};
+
+/// Connects the producer of a stream with one of its users.
+class Channel {
+public:
+  enum class PopResult { Data, Empty, Closed };
+
+  Channel(size_t depth, size_t batchSize, const std::atomic<bool> &aborted)
+      : queue(depth), batchSize(batchSize), aborted(aborted) {}
+
+  /// Sends the elements in batches of at most `batchSize` elements. Blocks
+  /// while the queue is full and returns false if the execution is aborted in
+  /// the meantime.
+  bool push(StreamContents elements) {
+    if (elements.size() <= batchSize) {
+      Batch batch{std::move(elements)};
+      return batch.elements.empty() || pushBatch(batch);
+    }
+    for (size_t i = 0, e = elements.size(); i < e; i += batchSize) {
+      auto begin = std::make_move_iterator(elements.begin() + i);
+      auto end = std::make_move_iterator(elements.begin() +
+                                         std::min(i + batchSize, e));
+      Batch batch{StreamContents(begin, end)};
+      if (!pushBatch(batch))
+        return false;
+    }
+    return true;
+  }
+
+  /// Signals the end of the stream to the user.
+  bool close() {
+    Batch batch;
+    batch.last = true;
+    return pushBatch(batch);
+  }
+
+  /// Receives the next batch without blocking. Must only be called by the
+  /// user of the stream.
+  PopResult tryPop(StreamContents &elements) {
+    if (closed)
+      return PopResult::Closed;
+    Batch batch;
+    if (!queue.tryPop(batch))
+      return PopResult::Empty;
+    if (batch.last) {
+      closed = true;
+      return PopResult::Closed;
+    }
+    elements = std::move(batch.elements);
+    return PopResult::Data;
+  }
+
+private:
+  bool pushBatch(Batch &batch) {
+    while (!queue.tryPush(batch)) {
+      if (aborted.load(std::memory_order_relaxed))
+        return false;
+      std::this_thread::yield();
+    }
+    return true;
+  }
+
+  SPSCQueue<Batch> queue;
+  size_t batchSize;
+  const std::atomic<bool> &aborted;
+  // Only accessed by the user.
+  bool closed = false;
+};
+} // namespace
+
+/// Receives batches from all open channels without blocking and appends them
+/// to the buffers. Polling all channels ensures that a full queue never waits
+/// for another one to be emptied. A channel whose buffer already holds
+/// `limit` elements is skipped while another open channel has none, such
+/// that an input that runs ahead of the others, e.g., of a `combine`, is
+/// throttled by its bounded queue instead of being buffered without bound.
+/// Returns false if no channel made progress.
+static bool receive(ArrayRef<Channel *> channels,
+                    MutableArrayRef<StreamContents> buffers,
+                    MutableArrayRef<bool> closed, size_t &numClosed,
+                    size_t limit) {
+  bool starved = false;
+  for (size_t i = 0, e = channels.size(); i < e; ++i)
+    starved |= !closed[i] && buffers[i].empty();
+
+  bool progress = false;
+  for (size_t i = 0, e = channels.size(); i < e; ++i) {
+    if (closed[i] || (starved && buffers[i].size() >= limit))
+      continue;
+    StreamContents batch;
+    switch (channels[i]->tryPop(batch)) {
+    case Channel::PopResult::Data:
+      if (buffers[i].empty())
+        buffers[i] = std::move(batch);
+      else
+        buffers[i].insert(buffers[i].end(),
+                          std::make_move_iterator(batch.begin()),
+                          std::make_move_iterator(batch.end()));
+      progress = true;
+      break;
+    case Channel::PopResult::Closed:
+      closed[i] = true;
+      ++numClosed;
+      progress = true;
+      break;
+    case Channel::PopResult::Empty:
+      break;
+    }
+  }
+  return progress;
+}
+
+/// Sends the produced elements to all users of the corresponding result.
+static bool send(MutableArrayRef<StreamContents> buffers,
+                 ArrayRef<SmallVector<Channel *>> users) {
+  for (auto it : llvm::zip(buffers, users)) {
+    StreamContents &elements = std::get<0>(it);
+    ArrayRef<Channel *> channels = std::get<1>(it);
+    if (elements.empty())
+      continue;
+    for (size_t i = 0, e = channels.size(); i < e; ++i) {
+      // The last user takes over the elements instead of copying them.
+      bool sent = i + 1 == e ? channels[i]->push(std::move(elements))
+                             : channels[i]->push(elements);
+      if (!sent)
+        return false;
+    }
+    elements.clear();
+  }
+  return true;
+}
+
+/// Processes the elements of the operation until all inputs are closed.
+static void runOperation(Operation &op, ArrayRef<Channel *> inputs,
+                         ArrayRef<SmallVector<Channel *>> users,
+                         size_t batchSize, std::atomic<bool> &aborted) {
+  OpKernel kernel(op);
+  SmallVector<StreamContents> inBuffers(inputs.size());
+  SmallVector<StreamContents> outBuffers(users.size());
+  SmallVector<bool> closed(inputs.size(), false);
+  size_t numClosed = 0;
+
+  bool ok = true;
+  while (ok && numClosed < inputs.size()) {
+    if (!receive(inputs, inBuffers, closed, numClosed, batchSize)) {
+      if (aborted.load(std::memory_order_relaxed)) {
+        ok = false;
+        break;
+      }
+      std::this_thread::yield();
+      continue;
+    }
+    ok = succeeded(kernel.process(inBuffers, outBuffers)) &&
+         send(outBuffers, users);
+  }
+  ok = ok && succeeded(kernel.finish(inBuffers, outBuffers)) &&
+       send(outBuffers, users);
+
+  if (!ok)
+    aborted = true;
+  for (ArrayRef<Channel *> channels : users)
+    for (Channel *channel : channels)
+      channel->close();
+}
+
+LogicalResult stream::interpretFunctionInParallel(
+    func::FuncOp funcOp, ArrayRef<StreamContents> inputs,
+    SmallVectorImpl<StreamContents> &results,
+    const InterpreterOptions &options) {
+  Block &body = funcOp.getBody().front();
+  for (Operation &op : body.without_terminator())
+    if (failed(OpKernel::verifySupported(op)))
+      return failure();
+
+  // Each use of a stream gets its own channel, as the queues only support a
+  // single consumer.
+  std::atomic<bool> aborted{false};
+  size_t batchSize = std::max<size_t>(options.batchSize, 1);
+  std::vector<std::unique_ptr<Channel>> channels;
+  DenseMap<OpOperand *, Channel *> useChannels;
+  DenseMap<Value, SmallVector<Channel *>> userChannels;
+  auto connect = [&](Value stream) {
+    SmallVector<Channel *> &streamUsers = userChannels[stream];
+    for (OpOperand &use : stream.getUses()) {
+      channels.push_back(std::make_unique<Channel>(
+          std::max<size_t>(options.queueDepth, 1), batchSize, aborted));
+      useChannels[&use] = channels.back().get();
+      streamUsers.push_back(channels.back().get());
+    }
+  };
+  for (Value arg : body.getArguments())
+    connect(arg);
+  for (Operation &op : body.without_terminator())
+    for (Value result : op.getResults())
+      connect(result);
+
+  std::vector<std::thread> threads;
+  for (auto it : llvm::enumerate(body.getArguments())) {
+    ArrayRef<Channel *> streamUsers = userChannels[it.value()];
+    const StreamContents &input = inputs[it.index()];
+    threads.emplace_back([streamUsers, &input] {
+      for (Channel *channel : streamUsers)
+        if (!channel->push(input))
+          break;
+      for (Channel *channel : streamUsers)
+        channel->close();
+    });
+  }
+
+  for (Operation &op : body.without_terminator()) {
+    SmallVector<Channel *> opInputs;
+    for (OpOperand &operand : op.getOpOperands())
+      opInputs.push_back(useChannels[&operand]);
+    SmallVector<SmallVector<Channel *>> opUsers;
+    for (Value result : op.getResults())
+      opUsers.push_back(userChannels[result]);
+    threads.emplace_back([&op, &aborted, batchSize,
+                          opInputs = std::move(opInputs),
+                          opUsers = std::move(opUsers)] {
+      runOperation(op, opInputs, opUsers, batchSize, aborted);
+    });
+  }
+
+  // The results are received by this thread.
+  SmallVector<Channel *> resultChannels;
+  for (OpOperand &operand : body.getTerminator()->getOpOperands())
+    resultChannels.push_back(useChannels[&operand]);
+  size_t numResults = resultChannels.size();
+  size_t numClosed = 0;
+  SmallVector<StreamContents> resultBuffers(numResults);
+  SmallVector<bool> closed(numResults, false);
+  while (numClosed < numResults) {
+    // The results are collected completely, so they are never throttled.
+    if (receive(resultChannels, resultBuffers, closed, numClosed,
+                std::numeric_limits<size_t>::max()))
+      continue;
+    if (aborted.load(std::memory_order_relaxed))
+      break;
+    std::this_thread::yield();
+  }
+
+  for (std::thread &thread : threads)
+    thread.join();
+
+  if (aborted)
+    return failure();
+  for (StreamContents &result : resultBuffers)
+    results.push_back(std::move(result));
+  return success();
+}
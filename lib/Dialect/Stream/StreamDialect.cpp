@@ -10,7 +10,9 @@
 
 #include "circt-stream/Dialect/Stream/StreamOps.h"
 #include "circt-stream/Dialect/Stream/StreamTypes.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
 #include "mlir/IR/DialectImplementation.h"
+#include "mlir/Interfaces/FoldInterfaces.h"
 #include "llvm/ADT/TypeSwitch.h"
 
 using namespace mlir;
@@ -23,6 +25,19 @@ using namespace circt_stream::stream;
 // Stream dialect.
 //===----------------------------------------------------------------------===//
 
+namespace {
+/// Keeps the constants that the folder materializes or hoists inside the
+/// regions of stream operations, as the regions are lowered in isolation.
+struct StreamFoldInterface : public DialectFoldInterface {
+  using DialectFoldInterface::DialectFoldInterface;
+
+  bool shouldMaterializeInto(Region *region) const final {
+    return isa<MapOp, FilterOp, ReduceOp, ReduceByKeyOp, SplitOp, CombineOp,
+               TakeWhileOp>(region->getParentOp());
+  }
+};
+} // namespace
+
 void StreamDialect::initialize() {
   addOperations<
 #define GET_OP_LIST
@@ -32,7 +47,44 @@ void StreamDialect::initialize() {
 #define GET_TYPEDEF_LIST
 #include "circt-stream/Dialect/Stream/StreamOpsTypes.cpp.inc"
       >();
+  addInterfaces<StreamFoldInterface>();
 }
 
 #define GET_TYPEDEF_CLASSES
 #include "circt-stream/Dialect/Stream/StreamOpsTypes.cpp.inc"
+
+//===----------------------------------------------------------------------===//
+// Stream type.
+//===----------------------------------------------------------------------===//
+
+Type StreamType::parse(AsmParser &parser) {
+  llvm::SMLoc loc = parser.getCurrentLocation();
+  Type elementType;
+  unsigned lanes = 1;
+
+  if (parser.parseLess() || parser.parseType(elementType))
+    return Type();
+
+  if (succeeded(parser.parseOptionalComma()) && parser.parseInteger(lanes))
+    return Type();
+
+  if (parser.parseGreater())
+    return Type();
+
+  return parser.getChecked<StreamType>(loc, parser.getContext(), elementType,
+                                       lanes);
+}
+
+void StreamType::print(AsmPrinter &p) const {
+  p << "<" << getElementType();
+  if (getLanes() != 1)
+    p << ", " << getLanes();
+  p << ">";
+}
+
+LogicalResult StreamType::verify(function_ref<InFlightDiagnostic()> emitError,
+                                 Type elementType, unsigned lanes) {
+  if (lanes == 0)
+    return emitError() << "expect a stream to have at least one lane";
+  return success();
+}
@@ -12,14 +12,19 @@
 
 #include "circt-stream/Dialect/Stream/StreamDialect.h"
 #include "circt-stream/Dialect/Stream/StreamTypes.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/IR/BlockAndValueMapping.h"
 #include "mlir/IR/Builders.h"
 #include "mlir/IR/OpImplementation.h"
 #include "mlir/Support/LogicalResult.h"
+#include "llvm/ADT/TypeSwitch.h"
 
 using namespace mlir;
 using namespace circt_stream;
 using namespace circt_stream::stream;
 
+#include "circt-stream/Dialect/Stream/StreamOpsEnums.cpp.inc"
+
 #define GET_OP_CLASSES
 #include "circt-stream/Dialect/Stream/StreamOps.cpp.inc"
 
@@ -68,6 +73,28 @@ static Type getElementType(Type streamType) {
   return streamType.cast<StreamType>().getElementType();
 }
 
+static unsigned getLanes(Type streamType) {
+  assert(streamType.isa<StreamType>() &&
+         "can only extract the lanes of a StreamType");
+  return streamType.cast<StreamType>().getLanes();
+}
+
+/// Verifies that all streams an operation consumes and produces have the same
+/// number of lanes.
+static LogicalResult verifySameLanes(Operation *op) {
+  SmallVector<Type> streamTypes(op->getOperandTypes());
+  llvm::append_range(streamTypes, op->getResultTypes());
+  if (streamTypes.empty())
+    return success();
+
+  unsigned lanes = getLanes(streamTypes.front());
+  if (!llvm::all_of(streamTypes,
+                    [&](Type type) { return getLanes(type) == lanes; }))
+    return op->emitError("expect all streams to have the same number of lanes");
+
+  return success();
+}
+
 /// Verifies that a region has indeed the expected inputs and that all
 /// terminators return operands matching the provided return types.
 static LogicalResult verifyRegion(Operation *op, Region &r,
@@ -95,10 +122,118 @@ static LogicalResult verifyRegion(Operation *op, Region &r) {
   return verifyRegion(op, r, inputTypes, returnTypes);
 }
 
+/// Clones the operations of a single-block region to the current insertion
+/// point of the rewriter, with its arguments replaced by `args`. Returns the
+/// values the clone yields.
+static SmallVector<Value> cloneRegionBody(Region &region, ValueRange args,
+                                          PatternRewriter &rewriter) {
+  Block &block = region.front();
+  BlockAndValueMapping mapping;
+  mapping.map(block.getArguments(), args);
+  for (Operation &op : block.without_terminator())
+    rewriter.clone(op, mapping);
+
+  auto yieldOp = cast<YieldOp>(block.getTerminator());
+  return llvm::to_vector(llvm::map_range(yieldOp.results(), [&](Value v) {
+    return mapping.lookupOrDefault(v);
+  }));
+}
+
+/// Returns true if the region can be executed on elements it would not see
+/// otherwise, i.e., it has no side effects and cannot trap.
+static bool isSpeculatable(Region &region) {
+  return llvm::all_of(region.getOps(), [](Operation &op) {
+    if (isa<arith::DivSIOp, arith::DivUIOp, arith::RemSIOp, arith::RemUIOp,
+            arith::CeilDivSIOp, arith::CeilDivUIOp, arith::FloorDivSIOp>(op))
+      return false;
+    return MemoryEffectOpInterface::hasNoEffect(&op);
+  });
+}
+
+/// Verifies the optional number of pipeline stages of a region.
+static LogicalResult verifyLatency(Operation *op, Optional<uint64_t> latency) {
+  if (latency && (int64_t)*latency < 0)
+    return op->emitError("expect a non-negative latency");
+  return success();
+}
+
+/// Returns the latency of an operation that is fused from two operations, such
+/// that the fused datapath has as many pipeline stages as both together.
+static IntegerAttr addLatencies(Builder &builder, Optional<uint64_t> first,
+                                Optional<uint64_t> second) {
+  if (!first && !second)
+    return {};
+  return builder.getI64IntegerAttr(first.getValueOr(0) +
+                                   second.getValueOr(0));
+}
+
+LogicalResult MapOp::verify() {
+  if (failed(verifyLatency(getOperation(), latency())))
+    return failure();
+  if (Optional<uint64_t> numReplicas = replicas()) {
+    if ((int64_t)*numReplicas < 1)
+      return emitError("expect at least one replica");
+    if (getLanes(input().getType()) != 1)
+      return emitError("expect a single-lane stream for replicas");
+  }
+  return verifySameLanes(getOperation());
+}
+
 LogicalResult MapOp::verifyRegions() {
   return verifyRegion(getOperation(), region());
 }
 
+/// Removes maps that yield their element unchanged, unless they are pipelined,
+/// and fuses a map into the map that produces its input. In the following
+/// snippet, both maps are replaced by a single map that yields `g(f(%val))`.
+/// The fused map has the pipeline stages of both. Maps are only fused if they
+/// have the same number of replicas.
+///
+/// ```
+///   %0 = stream.map(%in) { ^0(%val): ... stream.yield f(%val) }
+///   %1 = stream.map(%0) { ^0(%val): ... stream.yield g(%val) }
+/// ```
+LogicalResult MapOp::canonicalize(MapOp op, PatternRewriter &rewriter) {
+  if (!op.region().hasOneBlock())
+    return failure();
+
+  Block &body = op.region().front();
+  auto yieldOp = cast<YieldOp>(body.getTerminator());
+  if (yieldOp.results()[0] == body.getArgument(0) &&
+      op.input().getType() == op.res().getType() && !op.latency()) {
+    rewriter.replaceOp(op, op.input());
+    return success();
+  }
+
+  auto producer = op.input().getDefiningOp<MapOp>();
+  if (!producer || !op.input().hasOneUse() ||
+      !producer.region().hasOneBlock() ||
+      producer.replicas() != op.replicas())
+    return failure();
+
+  Location loc = op.getLoc();
+  auto fused = rewriter.create<MapOp>(
+      loc, op.res().getType(), producer.input(),
+      addLatencies(rewriter, producer.latency(), op.latency()),
+      op.replicasAttr());
+  Block *block = rewriter.createBlock(
+      &fused.region(), {}, {getElementType(producer.input().getType())}, {loc});
+  SmallVector<Value> values =
+      cloneRegionBody(producer.region(), block->getArguments(), rewriter);
+  values = cloneRegionBody(op.region(), values, rewriter);
+  rewriter.create<YieldOp>(loc, values);
+
+  rewriter.replaceOp(op, fused.res());
+  rewriter.eraseOp(producer);
+  return success();
+}
+
+LogicalResult FilterOp::verify() {
+  if (failed(verifyLatency(getOperation(), latency())))
+    return failure();
+  return verifySameLanes(getOperation());
+}
+
 LogicalResult FilterOp::verifyRegions() {
   SmallVector<Type> inputTypes = llvm::to_vector(
       llvm::map_range((*this)->getOperandTypes(), getElementType));
@@ -108,11 +243,166 @@ LogicalResult FilterOp::verifyRegions() {
   return verifyRegion(getOperation(), region(), inputTypes, boolType);
 }
 
+/// Fuses a filter into the filter that produces its input. The fused filter
+/// only keeps the elements that satisfy both predicates. As the second
+/// predicate is also evaluated for elements the first one drops, it must not
+/// have side effects or trap.
+LogicalResult FilterOp::canonicalize(FilterOp op, PatternRewriter &rewriter) {
+  auto producer = op.input().getDefiningOp<FilterOp>();
+  if (!producer || !op.input().hasOneUse() ||
+      !producer.region().hasOneBlock() || !op.region().hasOneBlock() ||
+      !isSpeculatable(op.region()))
+    return failure();
+
+  Location loc = op.getLoc();
+  auto fused = rewriter.create<FilterOp>(
+      loc, op.res().getType(), producer.input(),
+      addLatencies(rewriter, producer.latency(), op.latency()));
+  Block *block = rewriter.createBlock(
+      &fused.region(), {}, {getElementType(producer.input().getType())}, {loc});
+  Value first =
+      cloneRegionBody(producer.region(), block->getArguments(), rewriter)[0];
+  Value second =
+      cloneRegionBody(op.region(), block->getArguments(), rewriter)[0];
+  Value cond = rewriter.create<arith::AndIOp>(loc, first, second);
+  rewriter.create<YieldOp>(loc, cond);
+
+  rewriter.replaceOp(op, fused.res());
+  rewriter.eraseOp(producer);
+  return success();
+}
+
+/// Verifies that the initial value of an accumulator matches its type.
+/// Integers are initialized with an integer attribute of the same type, tuples
+/// with an array that initializes each of the fields.
+static LogicalResult verifyInitValue(Operation *op, Attribute initValue,
+                                     Type accType) {
+  if (auto tupleType = accType.dyn_cast<TupleType>()) {
+    auto fields = initValue.dyn_cast<ArrayAttr>();
+    if (!fields || fields.size() != tupleType.size())
+      return op->emitError("expect the initial value to be an array of ")
+             << tupleType.size() << " elements";
+
+    for (auto [field, fieldType] : llvm::zip(fields, tupleType.getTypes()))
+      if (failed(verifyInitValue(op, field, fieldType)))
+        return failure();
+    return success();
+  }
+
+  if (!accType.isa<IntegerType>())
+    return op->emitError("expect the accumulator to be an integer or a tuple, "
+                         "got ")
+           << accType;
+
+  auto intAttr = initValue.dyn_cast<IntegerAttr>();
+  if (!intAttr || intAttr.getType() != accType)
+    return op->emitError("expect the initial value to be an integer of type ")
+           << accType;
+
+  return success();
+}
+
+LogicalResult ReduceOp::verify() {
+  if (getLanes(result().getType()) != 1)
+    return emitError("expect the result stream to have a single lane");
+  return verifyInitValue(getOperation(), initValue(),
+                         getElementType(result().getType()));
+}
+
 LogicalResult ReduceOp::verifyRegions() {
   Type inputType = getElementType(input().getType());
   Type accType = getElementType(result().getType());
 
-  return verifyRegion(getOperation(), region(), TypeRange({inputType, accType}),
+  return verifyRegion(getOperation(), region(), TypeRange({accType, inputType}),
+                      accType);
+}
+
+/// Returns true if the region of a reduction applies a single associative and
+/// commutative operation on its arguments. The lowering of such reductions
+/// interleaves several accumulators, which requires the accumulator and the
+/// element to have the same type.
+static bool isAssociativeReduction(Region &region) {
+  Block &block = region.front();
+  Value acc = block.getArgument(0);
+  Value val = block.getArgument(1);
+  if (acc.getType() != val.getType())
+    return false;
+
+  Operation *combiner = block.getTerminator()->getOperand(0).getDefiningOp();
+  if (!combiner ||
+      !isa<arith::AddIOp, arith::MulIOp, arith::AndIOp, arith::OrIOp,
+           arith::XOrIOp, arith::MaxSIOp, arith::MinSIOp, arith::MaxUIOp,
+           arith::MinUIOp>(combiner))
+    return false;
+
+  Value lhs = combiner->getOperand(0);
+  Value rhs = combiner->getOperand(1);
+  return (lhs == acc && rhs == val) || (lhs == val && rhs == acc);
+}
+
+/// Fuses a map that produces the input of a reduction into the region of the
+/// reduction.
+LogicalResult ReduceOp::canonicalize(ReduceOp op, PatternRewriter &rewriter) {
+  // The reduction has no pipeline stages or replicas that could absorb a
+  // pipelined or replicated map.
+  auto producer = op.input().getDefiningOp<MapOp>();
+  if (!producer || !op.input().hasOneUse() ||
+      !producer.region().hasOneBlock() || !op.region().hasOneBlock() ||
+      producer.latency() || producer.replicas())
+    return failure();
+
+  // The fused region would no longer be associative, which prevents the
+  // parallel lowering of the reduction.
+  if (isAssociativeReduction(op.region()))
+    return failure();
+
+  Location loc = op.getLoc();
+  Type accType = getElementType(op.result().getType());
+  Type inputType = getElementType(producer.input().getType());
+  auto fused = rewriter.create<ReduceOp>(loc, op.result().getType(),
+                                         producer.input(), op.initValue());
+  Block *block = rewriter.createBlock(&fused.region(), {},
+                                      {accType, inputType}, {loc, loc});
+  Value mapped =
+      cloneRegionBody(producer.region(), block->getArgument(1), rewriter)[0];
+  SmallVector<Value> values = cloneRegionBody(
+      op.region(), {block->getArgument(0), mapped}, rewriter);
+  rewriter.create<YieldOp>(loc, values);
+
+  rewriter.replaceOp(op, fused.result());
+  rewriter.eraseOp(producer);
+  return success();
+}
+
+LogicalResult ReduceByKeyOp::verify() {
+  if (capacity() == 0)
+    return emitError("expect a capacity of at least one");
+  if (getLanes(input().getType()) != 1 || getLanes(result().getType()) != 1)
+    return emitError("expect single-lane streams");
+
+  auto inputType = getElementType(input().getType()).dyn_cast<TupleType>();
+  if (!inputType || inputType.size() != 2)
+    return emitError("expect the input elements to be tuples of a key and a "
+                     "value");
+  Type keyType = inputType.getType(0);
+  if (!keyType.isa<IntegerType>())
+    return emitError("expect the key to be an integer, got ") << keyType;
+
+  auto resultType = getElementType(result().getType()).dyn_cast<TupleType>();
+  if (!resultType || resultType.size() != 2 ||
+      resultType.getType(0) != keyType)
+    return emitError("expect the result elements to be tuples of the key "
+                     "and the accumulator");
+  return verifyInitValue(getOperation(), initValue(), resultType.getType(1));
+}
+
+LogicalResult ReduceByKeyOp::verifyRegions() {
+  Type valueType =
+      getElementType(input().getType()).cast<TupleType>().getType(1);
+  Type accType =
+      getElementType(result().getType()).cast<TupleType>().getType(1);
+
+  return verifyRegion(getOperation(), region(), TypeRange({accType, valueType}),
                       accType);
 }
 
@@ -195,16 +485,11 @@ LogicalResult PackOp::canonicalize(PackOp op, PatternRewriter &rewriter) {
   if (op.inputs().size() == 0)
     return failure();
 
-  Operation *singleDefiningOp = op.inputs()[0].getDefiningOp();
-
-  if (!llvm::all_of(op.inputs(), [singleDefiningOp](Value input) {
-        return input.getDefiningOp() == singleDefiningOp;
-      }))
-    return failure();
-
-  UnpackOp unpackDefiningOp = dyn_cast_or_null<UnpackOp>(singleDefiningOp);
+  UnpackOp unpackDefiningOp = op.inputs()[0].getDefiningOp<UnpackOp>();
 
-  if (!unpackDefiningOp)
+  // The fields have to be packed in the order they were unpacked.
+  if (!unpackDefiningOp ||
+      !llvm::equal(op.inputs(), unpackDefiningOp.results()))
     return failure();
 
   rewriter.replaceOp(op, unpackDefiningOp.input());
@@ -226,23 +511,21 @@ ParseResult CreateOp::parse(OpAsmParser &parser, OperationState &result) {
     return parser.emitError(parser.getNameLoc(),
                             "can only create streams of integers");
 
-  SmallVector<Attribute> elements;
-  if (parser.parseLSquare())
-    return failure();
-
-  if (parser.parseCommaSeparatedList([&]() {
+  // The list can be empty, e.g., for the result of a folded filter.
+  SmallVector<APInt> elements;
+  if (parser.parseCommaSeparatedList(OpAsmParser::Delimiter::Square, [&]() {
         APInt element(elementType.getIntOrFloatBitWidth(), 0);
         if (parser.parseInteger(element))
           return failure();
-        elements.push_back(IntegerAttr::get(elementType, element));
+        elements.push_back(element);
         return success();
       }))
     return failure();
 
-  if (parser.parseRSquare())
-    return failure();
-
-  result.addAttribute("values", ArrayAttr::get(parser.getContext(), elements));
+  auto valuesType = RankedTensorType::get(
+      {static_cast<int64_t>(elements.size())}, elementType);
+  result.addAttribute("values",
+                      DenseIntElementsAttr::get(valuesType, elements));
   return success();
 }
 
@@ -251,13 +534,8 @@ void CreateOp::print(OpAsmPrinter &p) {
   p << " ";
   p << result().getType();
   p << " [";
-  llvm::interleaveComma(values(), p, [&](Attribute attr) {
-    assert(attr.isa<IntegerAttr>() && "can only handle integer attributes");
-
-    auto intAttr = attr.dyn_cast<IntegerAttr>();
-
-    p << intAttr.getValue();
-  });
+  llvm::interleaveComma(values().getValues<APInt>(), p,
+                        [&](const APInt &value) { p << value; });
   p << "]";
 }
 
@@ -267,27 +545,355 @@ LogicalResult CreateOp::verify() {
 
   Type elementType = type.getElementType();
 
-  for (auto it : llvm::enumerate(values())) {
-    unsigned i = it.index();
-    auto attr = it.value();
-    auto intAttr = attr.dyn_cast<IntegerAttr>();
-    if (!intAttr)
-      return emitError("element #") << i << " is not an integer attribute";
-
-    if (intAttr.getType() != elementType)
-      return emitError("element #")
-             << i << "'s type does not match the type of the stream: expected "
-             << elementType << " got " << intAttr.getType();
-  }
+  if (values().getType().getRank() != 1)
+    return emitError("expect the values to be one-dimensional");
+
+  Type valueType = values().getType().getElementType();
+  if (valueType != elementType)
+    return emitError("the type of the values does not match the type of the "
+                     "stream: expected ")
+           << elementType << " got " << valueType;
 
-  // TODO ensure that all array elements have the same type
   return success();
 }
 
+LogicalResult IotaOp::verify() {
+  if (!getElementType().isa<IntegerType>())
+    return emitError("can only create streams of integers");
+
+  if ((int64_t)count() < 0)
+    return emitError("expect a non-negative number of elements");
+
+  return success();
+}
+
+LogicalResult SplitOp::verify() {
+  Optional<uint64_t> depth = bufferDepth();
+  if (depth && (int64_t)*depth < 1)
+    return emitError("expect a buffer depth of at least one");
+  return verifySameLanes(getOperation());
+}
+
 LogicalResult SplitOp::verifyRegions() {
   return verifyRegion(getOperation(), region());
 }
 
+/// Removes the results of a split that are only consumed by sinks. A split
+/// with a single remaining result becomes a map.
+LogicalResult SplitOp::canonicalize(SplitOp op, PatternRewriter &rewriter) {
+  if (!op.region().hasOneBlock())
+    return failure();
+
+  SmallVector<unsigned> liveResults;
+  for (auto it : llvm::enumerate(op.results())) {
+    if (!llvm::all_of(it.value().getUsers(),
+                      [](Operation *user) { return isa<SinkOp>(user); }))
+      liveResults.push_back(it.index());
+  }
+  if (liveResults.size() == op.getNumResults())
+    return failure();
+
+  for (Value result : op.results())
+    for (Operation *user : llvm::make_early_inc_range(result.getUsers()))
+      if (isa<SinkOp>(user))
+        rewriter.eraseOp(user);
+
+  if (liveResults.empty()) {
+    rewriter.replaceOpWithNewOp<SinkOp>(op, op.input());
+    return success();
+  }
+
+  Location loc = op.getLoc();
+  SmallVector<Type> resultTypes;
+  for (unsigned idx : liveResults)
+    resultTypes.push_back(op.getResult(idx).getType());
+
+  Operation *newOp;
+  if (resultTypes.size() == 1)
+    newOp = rewriter.create<MapOp>(loc, resultTypes[0], op.input(),
+                                   /*latency=*/nullptr, /*replicas=*/nullptr);
+  else
+    newOp = rewriter.create<SplitOp>(loc, resultTypes, op.input(),
+                                     op.bufferDepthAttr());
+
+  Block *block = rewriter.createBlock(
+      &newOp->getRegion(0), {}, {getElementType(op.input().getType())}, {loc});
+  SmallVector<Value> values =
+      cloneRegionBody(op.region(), block->getArguments(), rewriter);
+  SmallVector<Value> liveValues;
+  for (unsigned idx : liveResults)
+    liveValues.push_back(values[idx]);
+  rewriter.create<YieldOp>(loc, liveValues);
+
+  // The removed results do not have any users left.
+  SmallVector<Value> replacements(op.getNumResults());
+  for (auto it : llvm::enumerate(liveResults))
+    replacements[it.value()] = newOp->getResult(it.index());
+  rewriter.replaceOp(op, replacements);
+  return success();
+}
+
+LogicalResult CombineOp::verify() {
+  if (failed(verifyLatency(getOperation(), latency())))
+    return failure();
+  return verifySameLanes(getOperation());
+}
+
 LogicalResult CombineOp::verifyRegions() {
   return verifyRegion(getOperation(), region());
 }
+
+/// Fuses a combine that consumes all results of a split into a single map. If
+/// the combine only re-packs the fields the split unpacked, the map yields its
+/// element unchanged and is removed as well.
+LogicalResult CombineOp::canonicalize(CombineOp op,
+                                      PatternRewriter &rewriter) {
+  auto producer = op.inputs()[0].getDefiningOp<SplitOp>();
+  if (!producer || producer.getNumResults() != op.inputs().size() ||
+      !producer.region().hasOneBlock() || !op.region().hasOneBlock())
+    return failure();
+
+  // Each result of the split has to be consumed exactly once by the combine.
+  SmallVector<unsigned> resultIndices;
+  for (Value input : op.inputs()) {
+    auto result = input.dyn_cast<OpResult>();
+    if (!result || result.getOwner() != producer || !input.hasOneUse())
+      return failure();
+    resultIndices.push_back(result.getResultNumber());
+  }
+
+  Location loc = op.getLoc();
+  auto fused =
+      rewriter.create<MapOp>(loc, op.result().getType(), producer.input(),
+                             op.latencyAttr(), /*replicas=*/nullptr);
+  Block *block = rewriter.createBlock(
+      &fused.region(), {}, {getElementType(producer.input().getType())}, {loc});
+  SmallVector<Value> values =
+      cloneRegionBody(producer.region(), block->getArguments(), rewriter);
+  SmallVector<Value> args;
+  for (unsigned idx : resultIndices)
+    args.push_back(values[idx]);
+  values = cloneRegionBody(op.region(), args, rewriter);
+  rewriter.create<YieldOp>(loc, values);
+
+  rewriter.replaceOp(op, fused.res());
+  rewriter.eraseOp(producer);
+  return success();
+}
+
+OpFoldResult MergeOp::fold(ArrayRef<Attribute> operands) {
+  if (inputs().size() == 1)
+    return inputs()[0];
+  return {};
+}
+
+LogicalResult WindowOp::verify() {
+  if ((int64_t)size() < 1)
+    return emitError("expect a window size of at least one");
+  if ((int64_t)stride() < 1)
+    return emitError("expect a stride of at least one");
+
+  if (getLanes(input().getType()) != 1 || getLanes(result().getType()) != 1)
+    return emitError("expect single-lane streams");
+
+  Type elementType = getElementType(input().getType());
+  auto windowType = getElementType(result().getType()).dyn_cast<TupleType>();
+  if (!windowType || windowType.size() != size() ||
+      !llvm::all_of(windowType.getTypes(),
+                    [&](Type type) { return type == elementType; }))
+    return emitError("expect the result elements to be tuples of ")
+           << size() << " elements of type " << elementType;
+
+  return success();
+}
+
+/// Verifies that the operation converts between a single-lane stream and a
+/// multi-lane stream of the same element type.
+static LogicalResult verifyBatching(Operation *op, StringRef singleLaneName,
+                                    Type singleLaneType, Type multiLaneType) {
+  if (getLanes(singleLaneType) != 1)
+    return op->emitError("expect the ")
+           << singleLaneName << " to have a single lane, got "
+           << getLanes(singleLaneType);
+  if (getElementType(singleLaneType) != getElementType(multiLaneType))
+    return op->emitError("expect both streams to have the same element type");
+  return success();
+}
+
+LogicalResult BatchOp::verify() {
+  return verifyBatching(getOperation(), "input", input().getType(),
+                        result().getType());
+}
+
+OpFoldResult BatchOp::fold(ArrayRef<Attribute> operands) {
+  if (input().getType() == result().getType())
+    return input();
+  return {};
+}
+
+LogicalResult UnbatchOp::verify() {
+  return verifyBatching(getOperation(), "result", result().getType(),
+                        input().getType());
+}
+
+OpFoldResult UnbatchOp::fold(ArrayRef<Attribute> operands) {
+  if (input().getType() == result().getType())
+    return input();
+  // Unbatching restores the elements that were batched
+  if (auto batchOp = input().getDefiningOp<BatchOp>())
+    if (batchOp.input().getType() == result().getType())
+      return batchOp.input();
+  return {};
+}
+
+/// Verifies that a stream can be transferred from or to the memref and that
+/// the accessed indices are within its bounds, as far as they are known.
+static LogicalResult verifyMemoryAccess(Operation *op, Type streamType,
+                                        Value memref, int64_t start,
+                                        int64_t stride,
+                                        Optional<int64_t> count) {
+  auto memrefType = memref.getType().cast<MemRefType>();
+  if (memrefType.getRank() != 1)
+    return op->emitError("expect a one-dimensional memref");
+  if (getElementType(streamType) != memrefType.getElementType())
+    return op->emitError("expect the stream and the memref to have the same "
+                         "element type");
+  if (getLanes(streamType) != 1)
+    return op->emitError("expect a single-lane stream");
+
+  if (start < 0)
+    return op->emitError("expect a non-negative start index");
+  if (count && *count < 0)
+    return op->emitError("expect a non-negative number of elements");
+
+  if (!count || *count == 0 || memrefType.isDynamicDim(0))
+    return success();
+  int64_t last = start + (*count - 1) * stride;
+  int64_t size = memrefType.getDimSize(0);
+  if (start >= size || last < 0 || last >= size)
+    return op->emitError("expect the accessed indices to be within the "
+                         "bounds of the memref");
+  return success();
+}
+
+LogicalResult LoadOp::verify() {
+  return verifyMemoryAccess(getOperation(), result().getType(), memref(),
+                            start(), stride(), (int64_t)count());
+}
+
+LogicalResult StoreOp::verify() {
+  return verifyMemoryAccess(getOperation(), input().getType(), memref(),
+                            start(), stride(), llvm::None);
+}
+
+LogicalResult BufferOp::verify() {
+  if ((int64_t)depth() < 1)
+    return emitError("expect a depth of at least one");
+  return success();
+}
+
+LogicalResult TakeOp::verify() {
+  if ((int64_t)count() < 1)
+    return emitError("expect a count of at least one");
+  if (getLanes(input().getType()) != 1)
+    return emitError("expect a single-lane stream");
+  return success();
+}
+
+/// Moves a take towards the source of its stream, such that the dropped
+/// elements are not produced in the first place. Consecutive takes are merged,
+/// sources are shortened, and maps and splits take from their input instead.
+LogicalResult TakeOp::canonicalize(TakeOp op, PatternRewriter &rewriter) {
+  Operation *producer = op.input().getDefiningOp();
+  if (!producer)
+    return failure();
+  uint64_t count = op.count();
+
+  // A split only emits the first elements if all its results are shortened to
+  // the same count.
+  if (auto splitOp = dyn_cast<SplitOp>(producer)) {
+    SmallVector<TakeOp> takes;
+    for (Value result : splitOp.results()) {
+      TakeOp take;
+      if (result.hasOneUse())
+        take = dyn_cast<TakeOp>(*result.user_begin());
+      if (!take || take.count() != count)
+        return failure();
+      takes.push_back(take);
+    }
+    rewriter.setInsertionPoint(splitOp);
+    Value input = rewriter.create<TakeOp>(
+        op.getLoc(), splitOp.input().getType(), splitOp.input(), count);
+    rewriter.updateRootInPlace(splitOp,
+                               [&] { splitOp.inputMutable().assign(input); });
+    for (TakeOp take : takes)
+      rewriter.replaceOp(take, take.input());
+    return success();
+  }
+
+  if (!op.input().hasOneUse())
+    return failure();
+
+  return TypeSwitch<Operation *, LogicalResult>(producer)
+      .Case([&](TakeOp takeOp) {
+        rewriter.updateRootInPlace(takeOp, [&] {
+          takeOp.countAttr(
+              rewriter.getI64IntegerAttr(std::min(count, takeOp.count())));
+        });
+        rewriter.replaceOp(op, takeOp.result());
+        return success();
+      })
+      .Case([&](IotaOp iotaOp) {
+        if (iotaOp.count() > count)
+          rewriter.updateRootInPlace(iotaOp, [&] {
+            iotaOp.countAttr(rewriter.getI64IntegerAttr(count));
+          });
+        rewriter.replaceOp(op, iotaOp.result());
+        return success();
+      })
+      .Case([&](LoadOp loadOp) {
+        if (loadOp.count() > count)
+          rewriter.updateRootInPlace(loadOp, [&] {
+            loadOp.countAttr(rewriter.getI64IntegerAttr(count));
+          });
+        rewriter.replaceOp(op, loadOp.result());
+        return success();
+      })
+      .Case([&](CreateOp createOp) {
+        auto values = llvm::to_vector(createOp.values().getValues<APInt>());
+        if (values.size() > count) {
+          values.resize(count);
+          auto type = RankedTensorType::get({(int64_t)count},
+                                            createOp.getElementType());
+          rewriter.updateRootInPlace(createOp, [&] {
+            createOp.valuesAttr(DenseIntElementsAttr::get(type, values));
+          });
+        }
+        rewriter.replaceOp(op, createOp.result());
+        return success();
+      })
+      .Case([&](MapOp mapOp) {
+        rewriter.setInsertionPoint(mapOp);
+        Value input = rewriter.create<TakeOp>(
+            op.getLoc(), mapOp.input().getType(), mapOp.input(), count);
+        rewriter.updateRootInPlace(mapOp,
+                                   [&] { mapOp.inputMutable().assign(input); });
+        rewriter.replaceOp(op, mapOp.res());
+        return success();
+      })
+      .Default([](Operation *) { return failure(); });
+}
+
+LogicalResult TakeWhileOp::verify() {
+  if (input().getType() != res().getType())
+    return emitError("expect the result to have the type of the input");
+  if (getLanes(input().getType()) != 1)
+    return emitError("expect a single-lane stream");
+  return success();
+}
+
+LogicalResult TakeWhileOp::verifyRegions() {
+  Type inputType = getElementType(input().getType());
+  Type boolType = IntegerType::get(this->getContext(), 1);
+  return verifyRegion(getOperation(), region(), inputType, boolType);
+}
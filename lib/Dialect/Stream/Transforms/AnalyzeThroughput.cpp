@@ -0,0 +1,64 @@
+//===- AnalyzeThroughput.cpp - Report stream timing estimates ---*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a pass that reports the estimates of the throughput
+// analysis as remarks and optionally attaches them to the operations.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetails.h"
+#include "circt-stream/Dialect/Stream/Analysis/ThroughputAnalysis.h"
+#include "circt-stream/Dialect/Stream/StreamPasses.h"
+#include "mlir/IR/Builders.h"
+
+using namespace mlir;
+using namespace circt_stream;
+using namespace circt_stream::stream;
+
+namespace {
+struct StreamAnalyzeThroughputPass
+    : public StreamAnalyzeThroughputBase<StreamAnalyzeThroughputPass> {
+  void runOnOperation() override {
+    auto &analysis = getAnalysis<ThroughputAnalysis>();
+    markAllAnalysesPreserved();
+
+    Operation *criticalOp = analysis.getCriticalOp();
+    if (!criticalOp)
+      return;
+
+    if (annotate) {
+      OpBuilder builder(&getContext());
+      getOperation().walk([&](Operation *op) {
+        const OpTiming *timing = analysis.getTiming(op);
+        if (!timing)
+          return;
+        NamedAttribute estimates[] = {
+            builder.getNamedAttr(
+                "ii", builder.getI64IntegerAttr(timing->initiationInterval)),
+            builder.getNamedAttr("latency",
+                                 builder.getI64IntegerAttr(timing->latency)),
+            builder.getNamedAttr(
+                "eosLatency", builder.getI64IntegerAttr(timing->eosLatency))};
+        op->setAttr("throughput", builder.getDictionaryAttr(estimates));
+      });
+    }
+
+    criticalOp->emitRemark("critical operation with an initiation interval "
+                           "of ")
+        << analysis.getInitiationInterval() << " cycles";
+    getOperation().emitRemark("estimated initiation interval of ")
+        << analysis.getInitiationInterval() << " cycles and latency of "
+        << analysis.getLatency() << " cycles";
+  }
+};
+} // namespace
+
+std::unique_ptr<Pass>
+circt_stream::stream::createStreamAnalyzeThroughputPass() {
+  return std::make_unique<StreamAnalyzeThroughputPass>();
+}
@@ -0,0 +1,92 @@
+//===- BufferSizing.cpp - Slack matching of stream paths --------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a pass that sizes the FIFOs on reconvergent stream
+// paths, such that the operands of an operation arrive at the same time.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetails.h"
+#include "circt-stream/Dialect/Stream/Analysis/ThroughputAnalysis.h"
+#include "circt-stream/Dialect/Stream/StreamPasses.h"
+#include "mlir/IR/Builders.h"
+
+using namespace mlir;
+using namespace circt_stream;
+using namespace circt_stream::stream;
+
+/// Strips the buffers in front of a stream and returns the number of elements
+/// they can hold in total, including the output FIFOs of a decoupled split.
+static int64_t getBufferedSource(Value &stream) {
+  int64_t depth = 0;
+  while (auto bufferOp = stream.getDefiningOp<BufferOp>()) {
+    depth += bufferOp.depth();
+    stream = bufferOp.input();
+  }
+  if (auto splitOp = stream.getDefiningOp<SplitOp>())
+    depth += splitOp.bufferDepth().getValueOr(0);
+  return depth;
+}
+
+namespace {
+struct StreamBufferSizingPass
+    : public StreamBufferSizingBase<StreamBufferSizingPass> {
+  void runOnOperation() override {
+    auto &analysis = getAnalysis<ThroughputAnalysis>();
+
+    OpBuilder builder(&getContext());
+    for (Block &block : getOperation().getBody()) {
+      for (Operation &op : block) {
+        if (op.getNumOperands() < 2 || !analysis.getTiming(&op))
+          continue;
+        // The inputs of a merge do not wait for each other
+        if (isa<MergeOp>(op))
+          continue;
+
+        // Existing buffers already provide some of the slack, so the arrival
+        // is determined by the stream in front of them.
+        SmallVector<int64_t> arrivals;
+        SmallVector<int64_t> buffered;
+        for (Value operand : op.getOperands()) {
+          buffered.push_back(getBufferedSource(operand));
+          arrivals.push_back(analysis.getArrival(operand));
+        }
+        int64_t start = *std::max_element(arrivals.begin(), arrivals.end());
+
+        // Delays all operands to the slowest one
+        for (OpOperand &operand : op.getOpOperands()) {
+          unsigned idx = operand.getOperandNumber();
+          int64_t depth = start - arrivals[idx] - buffered[idx];
+          if (depth <= 0)
+            continue;
+
+          // Enlarge a FIFO that only feeds this operation instead of adding
+          // another one.
+          auto bufferOp = operand.get().getDefiningOp<BufferOp>();
+          if (bufferOp && bufferOp.kind() == BufferKind::fifo &&
+              bufferOp->hasOneUse()) {
+            bufferOp.depthAttr(
+                builder.getI64IntegerAttr(bufferOp.depth() + depth));
+            continue;
+          }
+
+          builder.setInsertionPoint(&op);
+          auto newBuffer = builder.create<BufferOp>(
+              op.getLoc(), operand.get().getType(), operand.get(), depth,
+              BufferKind::fifo);
+          operand.set(newBuffer);
+        }
+      }
+    }
+  }
+};
+} // namespace
+
+std::unique_ptr<Pass> circt_stream::stream::createStreamBufferSizingPass() {
+  return std::make_unique<StreamBufferSizingPass>();
+}
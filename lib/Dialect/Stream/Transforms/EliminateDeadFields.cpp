@@ -0,0 +1,213 @@
+//===- EliminateDeadFields.cpp - Drop unused tuple fields -------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a pass that removes the fields of tuple streams that no
+// consumer unpacks, as well as the unused results of splits.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetails.h"
+#include "circt-stream/Dialect/Stream/StreamPasses.h"
+#include "circt-stream/Dialect/Stream/StreamTypes.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include "mlir/Transforms/GreedyPatternRewriteDriver.h"
+#include "llvm/ADT/BitVector.h"
+
+using namespace mlir;
+using namespace circt_stream;
+using namespace circt_stream::stream;
+
+/// Returns true if the operation forwards the elements of its input unchanged
+/// to its result.
+static bool isForwarding(Operation *op) {
+  return isa<FilterOp, TakeWhileOp, BufferOp, TakeOp>(op);
+}
+
+/// Removes the operations of the block whose results are unused.
+static void eraseDeadOps(Block &block) {
+  for (Operation &op : llvm::make_early_inc_range(llvm::reverse(block)))
+    if (isOpTriviallyDead(&op))
+      op.erase();
+}
+
+/// Marks the fields of a tuple block argument that are unpacked and used.
+/// Fails if the argument is used as a whole.
+static LogicalResult collectArgFields(BlockArgument arg, BitVector &used) {
+  for (Operation *user : arg.getUsers()) {
+    auto unpackOp = dyn_cast<UnpackOp>(user);
+    if (!unpackOp)
+      return failure();
+    for (OpResult field : unpackOp.getResults())
+      if (!field.use_empty())
+        used.set(field.getResultNumber());
+  }
+  return success();
+}
+
+/// Marks the fields of the elements of `stream` that its consumers use. Fails
+/// if a consumer needs the whole elements, e.g., when the stream is returned.
+static LogicalResult collectUsedFields(Value stream, BitVector &used) {
+  for (OpOperand &use : stream.getUses()) {
+    Operation *user = use.getOwner();
+    if (isa<SinkOp>(user))
+      continue;
+
+    // The consumers of a forwarded stream use the same fields
+    if (isForwarding(user)) {
+      if (user->getNumRegions() == 1 &&
+          (!user->getRegion(0).hasOneBlock() ||
+           failed(collectArgFields(user->getRegion(0).getArgument(0), used))))
+        return failure();
+      if (failed(collectUsedFields(user->getResult(0), used)))
+        return failure();
+      continue;
+    }
+
+    if (!isa<MapOp, SplitOp, CombineOp>(user) ||
+        !user->getRegion(0).hasOneBlock())
+      return failure();
+    BlockArgument arg = user->getRegion(0).getArgument(use.getOperandNumber());
+    if (failed(collectArgFields(arg, used)))
+      return failure();
+  }
+  return success();
+}
+
+/// Changes the type of a tuple block argument and replaces its unpack
+/// operations with ones that only produce the kept fields.
+static void narrowArg(BlockArgument arg, TupleType type,
+                      ArrayRef<unsigned> kept, OpBuilder &builder) {
+  arg.setType(type);
+  for (Operation *user : llvm::make_early_inc_range(arg.getUsers())) {
+    auto unpackOp = cast<UnpackOp>(user);
+    builder.setInsertionPoint(unpackOp);
+    auto narrowed =
+        builder.create<UnpackOp>(unpackOp.getLoc(), type.getTypes(), arg);
+    for (auto it : llvm::enumerate(kept))
+      unpackOp.getResult(it.value())
+          .replaceAllUsesWith(narrowed.getResult(it.index()));
+    unpackOp.erase();
+  }
+}
+
+/// Changes the element type of the stream and adapts the regions of its
+/// consumers, including the consumers of forwarded streams.
+static void narrowUses(Value stream, TupleType type, ArrayRef<unsigned> kept,
+                       OpBuilder &builder) {
+  auto streamType = stream.getType().cast<StreamType>();
+  stream.setType(StreamType::get(type, streamType.getLanes()));
+
+  for (OpOperand &use : stream.getUses()) {
+    Operation *user = use.getOwner();
+    if (isa<SinkOp>(user))
+      continue;
+    if (isForwarding(user)) {
+      if (user->getNumRegions() == 1)
+        narrowArg(user->getRegion(0).getArgument(0), type, kept, builder);
+      narrowUses(user->getResult(0), type, kept, builder);
+      continue;
+    }
+    narrowArg(user->getRegion(0).getArgument(use.getOperandNumber()), type,
+              kept, builder);
+  }
+}
+
+/// Makes the producer of the stream only yield the kept fields. The values
+/// that computed the dropped fields are removed.
+static void narrowProducer(OpResult stream, TupleType type,
+                           ArrayRef<unsigned> kept, OpBuilder &builder) {
+  Block &block = stream.getOwner()->getRegion(0).front();
+  Operation *yield = block.getTerminator();
+  OpOperand &yielded = yield->getOpOperand(stream.getResultNumber());
+  Location loc = yield->getLoc();
+  builder.setInsertionPoint(yield);
+
+  SmallVector<Value> fields;
+  if (auto packOp = yielded.get().getDefiningOp<PackOp>()) {
+    llvm::append_range(fields, packOp.inputs());
+  } else {
+    auto tupleType = yielded.get().getType().cast<TupleType>();
+    auto unpackOp =
+        builder.create<UnpackOp>(loc, tupleType.getTypes(), yielded.get());
+    llvm::append_range(fields, unpackOp.getResults());
+  }
+
+  SmallVector<Value> keptFields;
+  for (unsigned field : kept)
+    keptFields.push_back(fields[field]);
+  yielded.set(builder.create<PackOp>(loc, type, keptFields));
+  eraseDeadOps(block);
+}
+
+namespace {
+struct StreamEliminateDeadFieldsPass
+    : public StreamEliminateDeadFieldsBase<StreamEliminateDeadFieldsPass> {
+  void runOnOperation() override {
+    func::FuncOp funcOp = getOperation();
+    if (funcOp.isDeclaration())
+      return;
+    Block &body = funcOp.getBody().front();
+
+    // The canonicalization of a split removes the results that are only
+    // consumed by sinks.
+    RewritePatternSet patterns(&getContext());
+    SplitOp::getCanonicalizationPatterns(patterns, &getContext());
+    FrozenRewritePatternSet frozenPatterns(std::move(patterns));
+    for (SplitOp splitOp : llvm::to_vector(body.getOps<SplitOp>()))
+      (void)applyOpPatternsAndFold(splitOp, frozenPatterns);
+
+    for (Operation &op : body)
+      for (Region &region : op.getRegions())
+        if (region.hasOneBlock())
+          eraseDeadOps(region.front());
+
+    // Consumers are visited before their producers, such that the fields that
+    // a region no longer needs are dropped from its inputs as well.
+    OpBuilder builder(&getContext());
+    for (Operation &op : llvm::reverse(body)) {
+      if (!isa<MapOp, SplitOp, CombineOp>(op) ||
+          !op.getRegion(0).hasOneBlock())
+        continue;
+
+      for (OpResult result : op.getResults()) {
+        auto tupleType = result.getType()
+                             .cast<StreamType>()
+                             .getElementType()
+                             .dyn_cast<TupleType>();
+        if (!tupleType || tupleType.size() < 2)
+          continue;
+
+        BitVector used(tupleType.size());
+        if (failed(collectUsedFields(result, used)))
+          continue;
+        // Without any used field, the elements themselves are still needed.
+        if (used.none())
+          used.set(0);
+        if (used.all())
+          continue;
+
+        SmallVector<unsigned> kept;
+        SmallVector<Type> keptTypes;
+        for (unsigned field : used.set_bits()) {
+          kept.push_back(field);
+          keptTypes.push_back(tupleType.getType(field));
+        }
+        auto narrowType = TupleType::get(&getContext(), keptTypes);
+        narrowUses(result, narrowType, kept, builder);
+        narrowProducer(result, narrowType, kept, builder);
+      }
+    }
+  }
+};
+} // namespace
+
+std::unique_ptr<mlir::Pass>
+circt_stream::stream::createStreamEliminateDeadFieldsPass() {
+  return std::make_unique<StreamEliminateDeadFieldsPass>();
+}
@@ -0,0 +1,248 @@
+//===- FoldConstants.cpp - Evaluate constant stream pipelines ---*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a pass that evaluates the stream operations whose
+// inputs are known at compile time with the interpreter and replaces them with
+// `stream.create` operations of the results.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetails.h"
+#include "circt-stream/Dialect/Stream/Interpreter/Interpreter.h"
+#include "circt-stream/Dialect/Stream/StreamPasses.h"
+#include "circt-stream/Dialect/Stream/StreamTypes.h"
+#include "mlir/IR/BlockAndValueMapping.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "llvm/ADT/SetVector.h"
+
+using namespace mlir;
+using namespace circt_stream;
+using namespace circt_stream::stream;
+
+/// Returns true if the regions of the operation only consist of operations
+/// that the interpreter can evaluate without observable side effects.
+static bool hasFoldableRegions(Operation *op) {
+  for (Region &region : op->getRegions()) {
+    if (!region.hasOneBlock())
+      return false;
+    for (Operation &nested : region.front()) {
+      if (nested.getNumRegions() != 0)
+        return false;
+      if (!isa<arith::ArithmeticDialect>(nested.getDialect()) &&
+          !isa<PackOp, UnpackOp, YieldOp>(nested))
+        return false;
+    }
+  }
+  return true;
+}
+
+/// Returns true if the operation computes its results only from the elements
+/// of its inputs. A merge is excluded, as the order of its elements depends on
+/// the timing of the circuit.
+static bool isFoldable(Operation *op) {
+  return isa<MapOp, FilterOp, ReduceOp, ReduceByKeyOp, SplitOp, CombineOp,
+             WindowOp, BatchOp, UnbatchOp, BufferOp, TakeOp, TakeWhileOp,
+             SinkOp>(op) &&
+         hasFoldableRegions(op);
+}
+
+/// Returns true if a `stream.create` can produce the stream.
+static bool isMaterializable(Value stream) {
+  auto type = stream.getType().cast<StreamType>();
+  return type.getLanes() == 1 && type.getElementType().isa<IntegerType>();
+}
+
+namespace {
+struct StreamFoldConstantsPass
+    : public StreamFoldConstantsBase<StreamFoldConstantsPass> {
+  void runOnOperation() override;
+
+private:
+  /// Collects the operations that only depend on sources, in program order.
+  void collectConstantOps(Block &block);
+
+  /// Removes operations whose results cannot be replaced by a
+  /// `stream.create`, but are needed by the rest of the function. Their
+  /// operands are materialized instead.
+  void pruneConstantOps();
+
+  /// Evaluates the collected operations and stores the contents of each
+  /// resulting stream.
+  LogicalResult evaluate();
+
+  bool isConstant(Value stream) {
+    Operation *def = stream.getDefiningOp();
+    return def && constantOps.contains(def);
+  }
+
+  /// Returns true if the stream is needed by an operation that is not
+  /// folded.
+  bool isLeaving(Value stream) {
+    return llvm::any_of(stream.getUsers(), [&](Operation *user) {
+      return !constantOps.contains(user);
+    });
+  }
+
+  /// Returns true if a `stream.create` of the stream is cheaper than its
+  /// producers. An iota only needs a counter, so a stream that stems from one
+  /// is only replaced if it has fewer elements, e.g., the result of a reduce.
+  bool isSmaller(Value stream) {
+    auto it = iotaCounts.find(stream.getDefiningOp());
+    return it == iotaCounts.end() || contents[stream].size() < it->second;
+  }
+
+  llvm::SetVector<Operation *> constantOps;
+  DenseMap<Value, StreamContents> contents;
+  /// The smallest count of the iotas that each operation depends on.
+  DenseMap<Operation *, uint64_t> iotaCounts;
+};
+} // namespace
+
+void StreamFoldConstantsPass::collectConstantOps(Block &block) {
+  for (Operation &op : block) {
+    if (auto iotaOp = dyn_cast<IotaOp>(op)) {
+      // Long sequences are not worth being turned into a table
+      if (iotaOp.count() <= maxElements) {
+        constantOps.insert(&op);
+        iotaCounts[&op] = iotaOp.count();
+      }
+      continue;
+    }
+    if (auto createOp = dyn_cast<CreateOp>(op)) {
+      if ((uint64_t)createOp.values().getNumElements() <= maxElements)
+        constantOps.insert(&op);
+      continue;
+    }
+    bool constantOperands = llvm::all_of(
+        op.getOperands(), [&](Value operand) { return isConstant(operand); });
+    if (!isFoldable(&op) || !constantOperands)
+      continue;
+    constantOps.insert(&op);
+    for (Value operand : op.getOperands()) {
+      auto it = iotaCounts.find(operand.getDefiningOp());
+      if (it == iotaCounts.end())
+        continue;
+      // Inserting may invalidate the iterator
+      uint64_t count = it->second;
+      auto [entry, inserted] = iotaCounts.try_emplace(&op, count);
+      if (!inserted)
+        entry->second = std::min(entry->second, count);
+    }
+  }
+}
+
+void StreamFoldConstantsPass::pruneConstantOps() {
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (Operation *op : constantOps) {
+      if (isa<CreateOp, IotaOp>(op))
+        continue;
+      bool keep = llvm::all_of(op->getResults(), [&](Value result) {
+        return !isLeaving(result) ||
+               (isMaterializable(result) &&
+                contents[result].size() <= maxElements && isSmaller(result));
+      });
+      if (!keep) {
+        constantOps.remove(op);
+        changed = true;
+        break;
+      }
+    }
+  }
+}
+
+LogicalResult StreamFoldConstantsPass::evaluate() {
+  // The operations are copied into a function that returns all of their
+  // streams, such that the interpreter can run them as usual.
+  Location loc = getOperation().getLoc();
+  OwningOpRef<ModuleOp> module = ModuleOp::create(loc);
+  OpBuilder builder = OpBuilder::atBlockEnd(module->getBody());
+
+  SmallVector<Value> streams;
+  for (Operation *op : constantOps)
+    llvm::append_range(streams, op->getResults());
+  SmallVector<Type> types;
+  for (Value stream : streams)
+    types.push_back(stream.getType());
+
+  auto funcOp = builder.create<func::FuncOp>(
+      loc, "fold", builder.getFunctionType({}, types));
+  builder.setInsertionPointToStart(funcOp.addEntryBlock());
+  BlockAndValueMapping mapping;
+  for (Operation *op : constantOps)
+    builder.clone(*op, mapping);
+  SmallVector<Value> returned;
+  for (Value stream : streams)
+    returned.push_back(mapping.lookup(stream));
+  builder.create<func::ReturnOp>(loc, returned);
+
+  // Failures, e.g., a division by zero, leave the function unchanged.
+  ScopedDiagnosticHandler handler(&getContext(),
+                                  [](Diagnostic &) { return success(); });
+  SmallVector<StreamContents> results;
+  if (failed(interpretFunction(funcOp, {}, results)))
+    return failure();
+
+  for (auto [stream, result] : llvm::zip(streams, results))
+    contents[stream] = std::move(result);
+  return success();
+}
+
+void StreamFoldConstantsPass::runOnOperation() {
+  func::FuncOp funcOp = getOperation();
+  if (funcOp.isDeclaration())
+    return;
+
+  collectConstantOps(funcOp.getBody().front());
+  if (llvm::all_of(constantOps,
+                   [](Operation *op) { return isa<CreateOp, IotaOp>(op); }))
+    return;
+  if (failed(evaluate()))
+    return;
+  pruneConstantOps();
+
+  OpBuilder builder(&getContext());
+  for (Operation *op : constantOps) {
+    if (isa<CreateOp, IotaOp>(op))
+      continue;
+    for (Value result : op->getResults()) {
+      if (!isLeaving(result))
+        continue;
+      auto elementType = result.getType()
+                             .cast<StreamType>()
+                             .getElementType()
+                             .cast<IntegerType>();
+      SmallVector<APInt> values;
+      for (const Element &element : contents[result])
+        values.push_back(element.getValue());
+      auto valuesType = RankedTensorType::get(
+          {static_cast<int64_t>(values.size())}, elementType);
+
+      builder.setInsertionPoint(op);
+      auto createOp = builder.create<CreateOp>(
+          op->getLoc(), result.getType(),
+          DenseIntElementsAttr::get(valuesType, values));
+      result.replaceAllUsesWith(createOp.result());
+    }
+  }
+
+  // The users of a stream follow its producer, so the operations can be
+  // erased in reverse order once their results are unused.
+  for (Operation *op : llvm::reverse(constantOps))
+    if (op->use_empty())
+      op->erase();
+}
+
+std::unique_ptr<mlir::Pass>
+circt_stream::stream::createStreamFoldConstantsPass() {
+  return std::make_unique<StreamFoldConstantsPass>();
+}
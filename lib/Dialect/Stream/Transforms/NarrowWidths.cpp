@@ -0,0 +1,566 @@
+//===- NarrowWidths.cpp - Narrow the element types of streams ---*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a pass that computes the value ranges of the elements
+// of each stream and narrows the integer element types to the smallest width
+// that can hold all of them.
+//
+//===----------------------------------------------------------------------===//
+
+#include "PassDetails.h"
+#include "circt-stream/Dialect/Stream/StreamPasses.h"
+#include "mlir/IR/Builders.h"
+#include "llvm/ADT/TypeSwitch.h"
+
+using namespace mlir;
+using namespace circt_stream;
+using namespace circt_stream::stream;
+
+/// The bounds of all ranges are stored with this width. It is large enough to
+/// hold the results of the supported operations on 64-bit integers without
+/// overflowing, e.g., the product of two such integers.
+static constexpr unsigned rangeWidth = 130;
+
+/// The number of times the region of a reduction is evaluated to find the
+/// range of its accumulator, before it is assumed to be unbounded.
+static constexpr unsigned maxReduceIterations = 16;
+
+namespace {
+/// A signed interval of integer values.
+struct Range {
+  APInt min;
+  APInt max;
+
+  Range(APInt min, APInt max) : min(std::move(min)), max(std::move(max)) {}
+
+  /// Returns the range of a single value of any width.
+  static Range get(const APInt &value) {
+    APInt wide = value.sext(rangeWidth);
+    return Range(wide, wide);
+  }
+
+  /// Returns the range holding all values of the provided width.
+  static Range getFull(unsigned width) {
+    return Range(APInt::getSignedMinValue(width).sext(rangeWidth),
+                 APInt::getSignedMaxValue(width).sext(rangeWidth));
+  }
+
+  bool isNonNegative() const { return !min.isNegative(); }
+
+  bool isConstant() const { return min == max; }
+
+  /// Returns true if all values of the range can be represented by a signed
+  /// integer of the provided width.
+  bool fits(unsigned width) const {
+    return min.getMinSignedBits() <= width && max.getMinSignedBits() <= width;
+  }
+
+  bool operator==(const Range &other) const {
+    return min == other.min && max == other.max;
+  }
+  bool operator!=(const Range &other) const { return !(*this == other); }
+};
+
+/// The ranges of the integer leaves of a value, i.e., of the value itself or
+/// of the fields of a tuple, in the order they appear in the type.
+using Ranges = SmallVector<Range, 1>;
+
+/// Computes the ranges of the elements of all streams of a function. The
+/// ranges start at the sources and are propagated through the regions of the
+/// operations. Values that are not understood are assumed to cover their
+/// whole type.
+class RangeAnalysis {
+public:
+  explicit RangeAnalysis(func::FuncOp funcOp);
+
+  /// Returns the ranges of a value, or of the elements of a stream.
+  const Ranges &lookup(Value value);
+
+private:
+  void visitStreamOp(Operation &op);
+  void visitReduce(ReduceOp op);
+  LogicalResult evaluateRegion(Region &region, ArrayRef<Ranges> args,
+                               SmallVectorImpl<Ranges> &results);
+  void evaluateOp(Operation &op);
+  Optional<Range> evaluateIntOp(Operation &op);
+
+  void setFull(Value value) { ranges[value] = getFullRanges(value); }
+  static Ranges getFullRanges(Value value);
+
+  DenseMap<Value, Ranges> ranges;
+};
+} // namespace
+
+/// Returns the type of the values that are described by the ranges of a
+/// value, i.e., the element type for streams.
+static Type getRangeType(Value value) {
+  Type type = value.getType();
+  if (auto streamType = type.dyn_cast<StreamType>())
+    return streamType.getElementType();
+  return type;
+}
+
+static void getLeafTypes(Type type, SmallVectorImpl<Type> &leaves) {
+  if (auto tupleType = type.dyn_cast<TupleType>()) {
+    for (Type field : tupleType.getTypes())
+      getLeafTypes(field, leaves);
+    return;
+  }
+  leaves.push_back(type);
+}
+
+/// Returns the width of integers whose ranges are tracked. Other types are
+/// never known to lie in a smaller range.
+static unsigned getTrackedWidth(Type type) {
+  auto intType = type.dyn_cast<IntegerType>();
+  if (!intType || intType.getWidth() > 64)
+    return rangeWidth;
+  return intType.getWidth();
+}
+
+static Range unite(const Range &lhs, const Range &rhs) {
+  return Range(lhs.min.slt(rhs.min) ? lhs.min : rhs.min,
+               lhs.max.sgt(rhs.max) ? lhs.max : rhs.max);
+}
+
+static Ranges unite(ArrayRef<Range> lhs, ArrayRef<Range> rhs) {
+  Ranges result;
+  for (auto [l, r] : llvm::zip(lhs, rhs))
+    result.push_back(unite(l, r));
+  return result;
+}
+
+/// Flattens the initial value of an accumulator into the ranges of its
+/// leaves.
+static void getInitRanges(Attribute initValue, Ranges &result) {
+  if (auto fields = initValue.dyn_cast<ArrayAttr>()) {
+    for (Attribute field : fields)
+      getInitRanges(field, result);
+    return;
+  }
+  auto intAttr = initValue.cast<IntegerAttr>();
+  if (getTrackedWidth(intAttr.getType()) == rangeWidth)
+    result.push_back(Range::getFull(rangeWidth));
+  else
+    result.push_back(Range::get(intAttr.getValue()));
+}
+
+Ranges RangeAnalysis::getFullRanges(Value value) {
+  SmallVector<Type> leaves;
+  getLeafTypes(getRangeType(value), leaves);
+  Ranges result;
+  for (Type leaf : leaves)
+    result.push_back(Range::getFull(getTrackedWidth(leaf)));
+  return result;
+}
+
+RangeAnalysis::RangeAnalysis(func::FuncOp funcOp) {
+  // The stream graph is acyclic, so all operands are visited before their
+  // users.
+  for (Block &block : funcOp.getBody())
+    for (Operation &op : block)
+      visitStreamOp(op);
+}
+
+const Ranges &RangeAnalysis::lookup(Value value) {
+  auto it = ranges.find(value);
+  if (it != ranges.end())
+    return it->second;
+  // Arguments and results of unknown operations can hold any value.
+  return ranges[value] = getFullRanges(value);
+}
+
+void RangeAnalysis::visitStreamOp(Operation &op) {
+  TypeSwitch<Operation *>(&op)
+      .Case<CreateOp>([&](CreateOp createOp) {
+        auto values = createOp.values().getValues<APInt>();
+        if (values.empty() ||
+            getTrackedWidth(createOp.getElementType()) == rangeWidth) {
+          setFull(createOp.result());
+          return;
+        }
+        Range range = Range::get(*values.begin());
+        for (const APInt &value : values)
+          range = unite(range, Range::get(value));
+        ranges[createOp.result()] = {range};
+      })
+      .Case<IotaOp>([&](IotaOp iotaOp) {
+        unsigned width = getTrackedWidth(iotaOp.getElementType());
+        APInt start(rangeWidth, iotaOp.start(), /*isSigned=*/true);
+        APInt step(rangeWidth, iotaOp.step(), /*isSigned=*/true);
+        APInt count(rangeWidth, std::max<int64_t>(1, iotaOp.count()));
+        APInt last = start + step * (count - 1);
+        Range range = unite(Range(start, start), Range(last, last));
+        if (!range.fits(width))
+          range = Range::getFull(width);
+        ranges[iotaOp.result()] = {range};
+      })
+      .Case<MapOp, SplitOp, CombineOp>([&](auto regionOp) {
+        SmallVector<Ranges> args;
+        for (Value operand : regionOp->getOperands())
+          args.push_back(lookup(operand));
+        SmallVector<Ranges> results;
+        if (failed(evaluateRegion(regionOp.region(), args, results))) {
+          for (Value result : regionOp->getResults())
+            setFull(result);
+          return;
+        }
+        for (auto [result, range] : llvm::zip(regionOp->getResults(), results))
+          ranges[result] = range;
+      })
+      .Case<ReduceOp>([&](ReduceOp reduceOp) { visitReduce(reduceOp); })
+      .Case<FilterOp, TakeOp, TakeWhileOp, BufferOp>([&](Operation *passOp) {
+        // The elements are forwarded unchanged.
+        Ranges input = lookup(passOp->getOperand(0));
+        ranges[passOp->getResult(0)] = input;
+      })
+      .Case<MergeOp>([&](MergeOp mergeOp) {
+        Ranges result = lookup(mergeOp.inputs().front());
+        for (Value input : mergeOp.inputs().drop_front())
+          result = unite(result, lookup(input));
+        ranges[mergeOp.result()] = result;
+      })
+      .Default([&](Operation *) {
+        for (Value result : op.getResults())
+          setFull(result);
+      });
+}
+
+/// Evaluates the region of the reduction until the range of the accumulator
+/// no longer grows. Accumulators that keep growing, e.g., sums, are assumed to
+/// cover their whole type.
+void RangeAnalysis::visitReduce(ReduceOp op) {
+  Ranges acc;
+  getInitRanges(op.initValue(), acc);
+  Ranges input = lookup(op.input());
+
+  for (unsigned i = 0; i < maxReduceIterations; ++i) {
+    SmallVector<Ranges> results;
+    if (failed(evaluateRegion(op.region(), {acc, input}, results)))
+      break;
+    Ranges next = unite(acc, results.front());
+    if (next == acc) {
+      ranges[op.result()] = acc;
+      return;
+    }
+    acc = next;
+  }
+  setFull(op.result());
+}
+
+/// Evaluates the region for the provided argument ranges and stores the ranges
+/// of the yielded values in `results`. Only regions with a single block are
+/// supported.
+LogicalResult RangeAnalysis::evaluateRegion(Region &region,
+                                            ArrayRef<Ranges> args,
+                                            SmallVectorImpl<Ranges> &results) {
+  if (!region.hasOneBlock())
+    return failure();
+
+  Block &block = region.front();
+  for (auto [arg, range] : llvm::zip(block.getArguments(), args))
+    ranges[arg] = range;
+
+  for (Operation &op : block.without_terminator())
+    evaluateOp(op);
+
+  for (Value yielded : block.getTerminator()->getOperands())
+    results.push_back(lookup(yielded));
+  return success();
+}
+
+void RangeAnalysis::evaluateOp(Operation &op) {
+  if (auto unpackOp = dyn_cast<UnpackOp>(op)) {
+    Ranges input = lookup(unpackOp.input());
+    unsigned offset = 0;
+    for (Value result : unpackOp.results()) {
+      SmallVector<Type> leaves;
+      getLeafTypes(result.getType(), leaves);
+      ranges[result] =
+          Ranges(ArrayRef<Range>(input).slice(offset, leaves.size()));
+      offset += leaves.size();
+    }
+    return;
+  }
+
+  if (auto packOp = dyn_cast<PackOp>(op)) {
+    Ranges result;
+    for (Value input : packOp.inputs()) {
+      Ranges field = lookup(input);
+      result.append(field.begin(), field.end());
+    }
+    ranges[packOp.result()] = result;
+    return;
+  }
+
+  Optional<Range> range;
+  if (op.getNumResults() == 1)
+    range = evaluateIntOp(op);
+
+  if (!range) {
+    for (Value result : op.getResults())
+      setFull(result);
+    return;
+  }
+
+  // Results that do not fit into their type wrap around.
+  unsigned width = getTrackedWidth(op.getResult(0).getType());
+  if (!range->fits(width))
+    range = Range::getFull(width);
+  ranges[op.getResult(0)] = {*range};
+}
+
+/// Computes the range of the result of an integer operation. Returns None for
+/// operations that are not understood.
+Optional<Range> RangeAnalysis::evaluateIntOp(Operation &op) {
+  // Ranges are only tracked for integers of up to 64 bits, so the bounds of
+  // tracked operands cannot overflow.
+  for (Type type : op.getOperandTypes())
+    if (getTrackedWidth(type) == rangeWidth)
+      return llvm::None;
+  if (getTrackedWidth(op.getResult(0).getType()) == rangeWidth)
+    return llvm::None;
+
+  if (auto constOp = dyn_cast<arith::ConstantOp>(op)) {
+    auto intAttr = constOp.getValue().dyn_cast<IntegerAttr>();
+    if (!intAttr)
+      return llvm::None;
+    return Range::get(intAttr.getValue());
+  }
+
+  SmallVector<Range> args;
+  for (Value operand : op.getOperands())
+    args.push_back(lookup(operand).front());
+
+  auto minOf = [](const APInt &a, const APInt &b) { return a.slt(b) ? a : b; };
+  auto maxOf = [](const APInt &a, const APInt &b) { return a.sgt(b) ? a : b; };
+
+  return TypeSwitch<Operation *, Optional<Range>>(&op)
+      .Case<arith::AddIOp>([&](auto) {
+        return Range(args[0].min + args[1].min, args[0].max + args[1].max);
+      })
+      .Case<arith::SubIOp>([&](auto) {
+        return Range(args[0].min - args[1].max, args[0].max - args[1].min);
+      })
+      .Case<arith::MulIOp>([&](auto) {
+        APInt products[] = {args[0].min * args[1].min,
+                            args[0].min * args[1].max,
+                            args[0].max * args[1].min,
+                            args[0].max * args[1].max};
+        Range range(products[0], products[0]);
+        for (const APInt &product : products)
+          range = unite(range, Range(product, product));
+        return range;
+      })
+      .Case<arith::AndIOp>([&](auto) -> Optional<Range> {
+        // The result is bounded by each non-negative operand.
+        APInt zero(rangeWidth, 0);
+        if (args[0].isNonNegative() && args[1].isNonNegative())
+          return Range(zero, minOf(args[0].max, args[1].max));
+        if (args[0].isNonNegative())
+          return Range(zero, args[0].max);
+        if (args[1].isNonNegative())
+          return Range(zero, args[1].max);
+        return llvm::None;
+      })
+      .Case<arith::OrIOp, arith::XOrIOp>([&](auto) -> Optional<Range> {
+        if (!args[0].isNonNegative() || !args[1].isNonNegative())
+          return llvm::None;
+        unsigned bits = std::max(args[0].max.getActiveBits(),
+                                 args[1].max.getActiveBits());
+        return Range(APInt(rangeWidth, 0),
+                     APInt::getLowBitsSet(rangeWidth, bits));
+      })
+      .Case<arith::MaxSIOp>([&](auto) {
+        return Range(maxOf(args[0].min, args[1].min),
+                     maxOf(args[0].max, args[1].max));
+      })
+      .Case<arith::MinSIOp>([&](auto) {
+        return Range(minOf(args[0].min, args[1].min),
+                     minOf(args[0].max, args[1].max));
+      })
+      .Case<arith::MaxUIOp, arith::MinUIOp>([&](auto) -> Optional<Range> {
+        // Only coincides with the signed comparison for non-negative values.
+        if (!args[0].isNonNegative() || !args[1].isNonNegative())
+          return llvm::None;
+        if (isa<arith::MaxUIOp>(op))
+          return Range(maxOf(args[0].min, args[1].min),
+                       maxOf(args[0].max, args[1].max));
+        return Range(minOf(args[0].min, args[1].min),
+                     minOf(args[0].max, args[1].max));
+      })
+      .Case<arith::RemUIOp>([&](auto) -> Optional<Range> {
+        if (!args[0].isNonNegative() || !args[1].isNonNegative() ||
+            args[1].min.isZero())
+          return llvm::None;
+        return Range(APInt(rangeWidth, 0),
+                     minOf(args[0].max, args[1].max - 1));
+      })
+      .Case<arith::ShLIOp, arith::ShRSIOp, arith::ShRUIOp>(
+          [&](auto) -> Optional<Range> {
+            unsigned width = getTrackedWidth(op.getResult(0).getType());
+            if (!args[1].isConstant() || !args[1].isNonNegative() ||
+                args[1].min.uge(width))
+              return llvm::None;
+            unsigned amount = args[1].min.getZExtValue();
+            if (isa<arith::ShLIOp>(op))
+              return Range(args[0].min.shl(amount), args[0].max.shl(amount));
+            if (isa<arith::ShRUIOp>(op) && !args[0].isNonNegative())
+              return llvm::None;
+            return Range(args[0].min.ashr(amount), args[0].max.ashr(amount));
+          })
+      .Case<arith::SelectOp>([&](auto) { return unite(args[1], args[2]); })
+      .Case<arith::ExtSIOp>([&](auto) { return args[0]; })
+      .Case<arith::ExtUIOp>([&](auto) -> Optional<Range> {
+        if (args[0].isNonNegative())
+          return args[0];
+        unsigned width = getTrackedWidth(op.getOperand(0).getType());
+        return Range(APInt(rangeWidth, 0),
+                     APInt::getLowBitsSet(rangeWidth, width));
+      })
+      .Case<arith::TruncIOp>([&](auto) { return args[0]; })
+      .Default([](Operation *) { return llvm::None; });
+}
+
+/// Collects the streams that carry the elements of `root` unchanged, i.e.,
+/// the results of buffers, filters, and takes. Fails if any of them is used by
+/// an operation that cannot extend the narrowed elements to the original type.
+static LogicalResult collectNarrowedStreams(Value root,
+                                            SmallVectorImpl<Value> &streams) {
+  streams.push_back(root);
+  for (unsigned i = 0; i < streams.size(); ++i) {
+    for (Operation *user : streams[i].getUsers()) {
+      if (isa<BufferOp, FilterOp, TakeOp, TakeWhileOp>(user)) {
+        streams.push_back(user->getResult(0));
+        continue;
+      }
+      if (!isa<MapOp, ReduceOp, SplitOp, CombineOp, SinkOp>(user))
+        return failure();
+    }
+  }
+  return success();
+}
+
+/// Changes the type of the block argument to the narrowed type and extends it
+/// to the original type for its users.
+static void extendArgument(BlockArgument arg, IntegerType narrowType,
+                           bool isUnsigned, OpBuilder &builder) {
+  Type wideType = arg.getType();
+  arg.setType(narrowType);
+  builder.setInsertionPointToStart(arg.getOwner());
+  Operation *ext;
+  if (isUnsigned)
+    ext = builder.create<arith::ExtUIOp>(arg.getLoc(), wideType, arg);
+  else
+    ext = builder.create<arith::ExtSIOp>(arg.getLoc(), wideType, arg);
+  arg.replaceAllUsesExcept(ext->getResult(0), ext);
+}
+
+/// Makes the producer of `root` emit elements of the narrowed type.
+static void narrowProducer(OpResult root, IntegerType narrowType,
+                           bool isUnsigned, OpBuilder &builder) {
+  Operation *op = root.getOwner();
+  if (auto createOp = dyn_cast<CreateOp>(op)) {
+    SmallVector<APInt> values;
+    for (const APInt &value : createOp.values().getValues<APInt>())
+      values.push_back(value.trunc(narrowType.getWidth()));
+    auto valuesType = RankedTensorType::get(
+        {static_cast<int64_t>(values.size())}, narrowType);
+    createOp.valuesAttr(DenseIntElementsAttr::get(valuesType, values));
+    return;
+  }
+
+  // An iota computes its elements with the type of the stream.
+  if (isa<IotaOp>(op))
+    return;
+
+  Block &block = op->getRegion(0).front();
+  Operation *yield = block.getTerminator();
+  OpOperand &yielded = yield->getOpOperand(root.getResultNumber());
+  builder.setInsertionPoint(yield);
+  yielded.set(builder.create<arith::TruncIOp>(yield->getLoc(), narrowType,
+                                              yielded.get()));
+
+  // The accumulator of a reduction has the type of its result.
+  if (auto reduceOp = dyn_cast<ReduceOp>(op)) {
+    APInt init = reduceOp.initValue().cast<IntegerAttr>().getValue();
+    reduceOp.initValueAttr(builder.getIntegerAttr(
+        narrowType, init.trunc(narrowType.getWidth())));
+    extendArgument(block.getArgument(0), narrowType, isUnsigned, builder);
+  }
+}
+
+/// Narrows the type of the stream and of the streams that forward its
+/// elements. The consumers extend the elements to the original type, such
+/// that their regions are unchanged.
+static void narrowStreams(ArrayRef<Value> streams, IntegerType narrowType,
+                          bool isUnsigned, OpBuilder &builder) {
+  narrowProducer(streams.front().cast<OpResult>(), narrowType, isUnsigned,
+                 builder);
+
+  for (Value stream : streams) {
+    auto streamType = stream.getType().cast<StreamType>();
+    stream.setType(StreamType::get(narrowType, streamType.getLanes()));
+
+    for (OpOperand &use : stream.getUses()) {
+      Operation *user = use.getOwner();
+      if (isa<BufferOp, TakeOp, SinkOp>(user))
+        continue;
+      // The accumulator precedes the elements in the region of a reduction.
+      unsigned argIdx = use.getOperandNumber();
+      if (isa<ReduceOp>(user))
+        argIdx = 1;
+      extendArgument(user->getRegion(0).getArgument(argIdx), narrowType,
+                     isUnsigned, builder);
+    }
+  }
+}
+
+namespace {
+struct StreamNarrowWidthsPass
+    : public StreamNarrowWidthsBase<StreamNarrowWidthsPass> {
+  void runOnOperation() override {
+    RangeAnalysis analysis(getOperation());
+    OpBuilder builder(&getContext());
+
+    SmallVector<Value> roots;
+    for (Block &block : getOperation().getBody())
+      for (Operation &op : block)
+        if (isa<CreateOp, IotaOp, MapOp, SplitOp, CombineOp, ReduceOp>(op))
+          llvm::append_range(roots, op.getResults());
+
+    for (Value root : roots) {
+      auto elementType = root.getType().cast<StreamType>().getElementType();
+      auto intType = elementType.dyn_cast<IntegerType>();
+      if (!intType || intType.getWidth() > 64)
+        continue;
+
+      // Non-negative values do not need a sign bit.
+      const Range &range = analysis.lookup(root).front();
+      bool isUnsigned = range.isNonNegative();
+      unsigned width = isUnsigned ? range.max.getActiveBits()
+                                  : std::max(range.min.getMinSignedBits(),
+                                             range.max.getMinSignedBits());
+      width = std::max(width, 1u);
+      if (width >= intType.getWidth())
+        continue;
+
+      SmallVector<Value> streams;
+      if (failed(collectNarrowedStreams(root, streams)))
+        continue;
+
+      narrowStreams(streams, builder.getIntegerType(width), isUnsigned,
+                    builder);
+    }
+  }
+};
+} // namespace
+
+std::unique_ptr<Pass> circt_stream::stream::createStreamNarrowWidthsPass() {
+  return std::make_unique<StreamNarrowWidthsPass>();
+}
@@ -0,0 +1,28 @@
+//===- PassDetails.h - Stream pass class details ----------------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+// NOLINTNEXTLINE(llvm-header-guard)
+#ifndef DIALECT_STREAM_TRANSFORMS_PASSDETAILS_H
+#define DIALECT_STREAM_TRANSFORMS_PASSDETAILS_H
+
+#include "circt-stream/Dialect/Stream/StreamDialect.h"
+#include "circt-stream/Dialect/Stream/StreamOps.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Pass/Pass.h"
+
+namespace circt_stream {
+namespace stream {
+
+#define GEN_PASS_CLASSES
+#include "circt-stream/Dialect/Stream/StreamPasses.h.inc"
+
+} // namespace stream
+} // namespace circt_stream
+
+#endif // DIALECT_STREAM_TRANSFORMS_PASSDETAILS_H
@@ -0,0 +1,153 @@
+//===- StreamRuntime.cpp - Runtime of the CPU lowering ----------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Implements the channels and tasks that the code produced by
+// `--convert-stream-to-async` is built from.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt-stream/Runtime/StreamRuntime.h"
+#include "circt-stream/Dialect/Stream/Interpreter/SPSCQueue.h"
+#include <algorithm>
+#include <cassert>
+#include <thread>
+#include <vector>
+
+using namespace circt_stream::stream;
+
+namespace {
+/// A set of consecutive elements that is transferred at once.
+struct Batch {
+  std::vector<int64_t> words;
+  /// Marks the end of the stream.
+  bool last = false;
+};
+
+/// The producer only touches the pending batch and the consumer only the
+/// current one, so the queue is the only state that is shared.
+class Channel {
+public:
+  Channel(size_t words, size_t depth, size_t batchSize)
+      : queue(depth), words(words), batchWords(words * batchSize) {
+    pending.reserve(batchWords);
+  }
+
+  void push(int64_t word) {
+    pending.push_back(word);
+    if (pending.size() == batchWords)
+      flush();
+  }
+
+  void close() {
+    flush();
+    Batch batch;
+    batch.last = true;
+    send(batch);
+  }
+
+  bool next() {
+    pos += words;
+    while (pos >= current.size()) {
+      Batch batch;
+      while (!queue.tryPop(batch))
+        std::this_thread::yield();
+      if (batch.last)
+        return false;
+      current = std::move(batch.words);
+      pos = 0;
+    }
+    return true;
+  }
+
+  int64_t value(size_t idx) const {
+    assert(idx < words && "word index out of range");
+    return current[pos + idx];
+  }
+
+private:
+  void flush() {
+    if (pending.empty())
+      return;
+    Batch batch{std::move(pending)};
+    send(batch);
+    pending.clear();
+    pending.reserve(batchWords);
+  }
+
+  void send(Batch &batch) {
+    while (!queue.tryPush(batch))
+      std::this_thread::yield();
+  }
+
+  SPSCQueue<Batch> queue;
+  size_t words;
+  size_t batchWords;
+  // Only accessed by the producer.
+  std::vector<int64_t> pending;
+  // Only accessed by the consumer. The first call of `next` moves `pos` past
+  // the empty batch.
+  std::vector<int64_t> current;
+  size_t pos = 0;
+};
+
+struct Task {
+  void (*fn)(void *);
+  std::vector<void *> channels;
+};
+} // namespace
+
+extern "C" void *stream_rt_channel_create(int64_t words, int64_t depth,
+                                          int64_t batchSize) {
+  assert(words > 0 && "expected elements of at least one word");
+  return new Channel(words, std::max<int64_t>(depth, 1),
+                     std::max<int64_t>(batchSize, 1));
+}
+
+extern "C" void stream_rt_push(void *channel, int64_t word) {
+  static_cast<Channel *>(channel)->push(word);
+}
+
+extern "C" void stream_rt_close(void *channel) {
+  static_cast<Channel *>(channel)->close();
+}
+
+extern "C" bool stream_rt_next(void *channel) {
+  auto *ch = static_cast<Channel *>(channel);
+  if (ch->next())
+    return true;
+  // The producer does not touch the channel after closing it, so the consumer
+  // owns it once the end was received.
+  delete ch;
+  return false;
+}
+
+extern "C" int64_t stream_rt_value(void *channel, int64_t idx) {
+  return static_cast<Channel *>(channel)->value(idx);
+}
+
+extern "C" void *stream_rt_task_create(void (*fn)(void *)) {
+  return new Task{fn, {}};
+}
+
+extern "C" void stream_rt_task_add_channel(void *task, void *channel) {
+  static_cast<Task *>(task)->channels.push_back(channel);
+}
+
+extern "C" void *stream_rt_task_channel(void *task, int64_t idx) {
+  return static_cast<Task *>(task)->channels[idx];
+}
+
+extern "C" void stream_rt_task_start(void *task) {
+  // Tasks block on their channels, so each of them needs its own thread
+  // instead of a slot in a fixed-size thread pool.
+  std::thread([task] {
+    auto *t = static_cast<Task *>(task);
+    t->fn(t);
+    delete t;
+  }).detach();
+}
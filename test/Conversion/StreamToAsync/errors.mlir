@@ -0,0 +1,23 @@
+// RUN: stream-opt %s --convert-stream-to-async --split-input-file --verify-diagnostics
+
+func.func @wide() -> !stream.stream<i128> {
+  // expected-error @+1 {{expect stream elements to consist of integers of at most 64 bits, got 'i128'}}
+  %out = stream.iota start 0 step 1 count 4 : !stream.stream<i128>
+  return %out : !stream.stream<i128>
+}
+
+// -----
+
+// expected-error @+1 {{expect all arguments and results to be streams}}
+func.func @load(%mem: memref<16xi32>) -> !stream.stream<i32> {
+  %out = stream.load %mem[start 0 stride 1 count 16] : memref<16xi32> -> !stream.stream<i32>
+  return %out : !stream.stream<i32>
+}
+
+// -----
+
+func.func @window(%in: !stream.stream<i32>) -> !stream.stream<tuple<i32, i32>> {
+  // expected-error @+1 {{cannot lower operation 'stream.window' to tasks}}
+  %out = stream.window(%in) size 2 stride 1 : (!stream.stream<i32>) -> !stream.stream<tuple<i32, i32>>
+  return %out : !stream.stream<tuple<i32, i32>>
+}
@@ -0,0 +1,138 @@
+// RUN: stream-opt %s --convert-stream-to-async="batch-size=16 queue-depth=2" --split-input-file | FileCheck %s
+
+func.func @map(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %res = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val: i32):
+    %0 = arith.constant 1 : i32
+    %r = arith.addi %0, %val : i32
+    stream.yield %r : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+// CHECK-DAG: func.func private @stream_rt_task_start(!llvm.ptr<i8>)
+// CHECK-DAG: func.func private @stream_rt_task_add_channel(!llvm.ptr<i8>, !llvm.ptr<i8>)
+// CHECK-DAG: func.func private @stream_rt_task_create((!llvm.ptr<i8>) -> ()) -> !llvm.ptr<i8>
+// CHECK-DAG: func.func private @stream_rt_channel_create(i64, i64, i64) -> !llvm.ptr<i8>
+// CHECK-DAG: func.func private @stream_rt_close(!llvm.ptr<i8>)
+// CHECK-DAG: func.func private @stream_rt_push(!llvm.ptr<i8>, i64)
+// CHECK-DAG: func.func private @stream_rt_value(!llvm.ptr<i8>, i64) -> i64
+// CHECK-DAG: func.func private @stream_rt_next(!llvm.ptr<i8>) -> i1
+// CHECK-DAG: func.func private @stream_rt_task_channel(!llvm.ptr<i8>, i64) -> !llvm.ptr<i8>
+
+// CHECK-LABEL: func.func private @map_task0(
+// CHECK-SAME:      %[[TASK:.*]]: !llvm.ptr<i8>) {
+// CHECK:         %[[IN:.*]] = call @stream_rt_task_channel(%[[TASK]], %{{.*}})
+// CHECK:         %[[OUT:.*]] = call @stream_rt_task_channel(%[[TASK]], %{{.*}})
+// CHECK:         scf.while : () -> () {
+// CHECK:           %[[MORE:.*]] = func.call @stream_rt_next(%[[IN]])
+// CHECK:           scf.condition(%[[MORE]])
+// CHECK:         } do {
+// CHECK:           %[[WORD:.*]] = func.call @stream_rt_value(%[[IN]], %{{.*}})
+// CHECK:           %[[VAL:.*]] = arith.trunci %[[WORD]] : i64 to i32
+// CHECK:           %[[RES:.*]] = scf.execute_region -> i32 {
+// CHECK:             cf.br ^[[BB:.*]](%[[VAL]] : i32)
+// CHECK:           ^[[BB]](%[[ARG:.*]]: i32):
+// CHECK:             %[[SUM:.*]] = arith.addi %{{.*}}, %[[ARG]] : i32
+// CHECK:             scf.yield %[[SUM]] : i32
+// CHECK:           }
+// CHECK:           %[[EXT:.*]] = arith.extui %[[RES]] : i32 to i64
+// CHECK:           func.call @stream_rt_push(%[[OUT]], %[[EXT]])
+// CHECK:         }
+// CHECK:         call @stream_rt_close(%[[OUT]])
+// CHECK:         return
+
+// CHECK-LABEL: func.func @map(
+// CHECK-SAME:      %[[IN:.*]]: !llvm.ptr<i8>) -> !llvm.ptr<i8> {
+// CHECK:         %[[WORDS:.*]] = arith.constant 1 : i64
+// CHECK:         %[[DEPTH:.*]] = arith.constant 2 : i64
+// CHECK:         %[[BATCH:.*]] = arith.constant 16 : i64
+// CHECK:         %[[OUT:.*]] = call @stream_rt_channel_create(%[[WORDS]], %[[DEPTH]], %[[BATCH]])
+// CHECK:         %[[FN:.*]] = constant @map_task0 : (!llvm.ptr<i8>) -> ()
+// CHECK:         %[[HANDLE:.*]] = call @stream_rt_task_create(%[[FN]])
+// CHECK:         call @stream_rt_task_add_channel(%[[HANDLE]], %[[IN]])
+// CHECK:         call @stream_rt_task_add_channel(%[[HANDLE]], %[[OUT]])
+// CHECK:         call @stream_rt_task_start(%[[HANDLE]])
+// CHECK:         return %[[OUT]] : !llvm.ptr<i8>
+
+// -----
+
+func.func @fork(%in: !stream.stream<tuple<i32, i1>>) -> (!stream.stream<tuple<i32, i1>>, !stream.stream<tuple<i32, i1>>) {
+  return %in, %in : !stream.stream<tuple<i32, i1>>, !stream.stream<tuple<i32, i1>>
+}
+
+// CHECK-LABEL: func.func private @fork_task0(
+// CHECK:         scf.while
+// CHECK:           func.call @stream_rt_value(%{{.*}}, %[[C0:.*]]) : (!llvm.ptr<i8>, i64) -> i64
+// CHECK:           func.call @stream_rt_value(%{{.*}}, %[[C1:.*]]) : (!llvm.ptr<i8>, i64) -> i64
+// CHECK-COUNT-4:   func.call @stream_rt_push
+// CHECK:         call @stream_rt_close
+// CHECK:         call @stream_rt_close
+
+// CHECK-LABEL: func.func @fork(
+// CHECK:         %[[WORDS:.*]] = arith.constant 2 : i64
+// CHECK:         %[[OUT0:.*]] = call @stream_rt_channel_create(%[[WORDS]],
+// CHECK:         %[[OUT1:.*]] = call @stream_rt_channel_create(
+// CHECK:         return %[[OUT0]], %[[OUT1]]
+
+// -----
+
+func.func @reduce() -> !stream.stream<i64> {
+  %in = stream.iota start 0 step 2 count 8 : !stream.stream<i64>
+  %res = stream.reduce(%in) {initValue = 0 : i64}: (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%acc: i64, %val: i64):
+    %r = arith.addi %acc, %val : i64
+    stream.yield %r : i64
+  }
+  return %res : !stream.stream<i64>
+}
+
+// CHECK-LABEL: func.func private @reduce_task0(
+// CHECK:         scf.for %[[IV:.*]] = %{{.*}} to %{{.*}} step %{{.*}} {
+// CHECK:           %[[IDX:.*]] = arith.index_cast %[[IV]] : index to i64
+// CHECK:           %[[OFF:.*]] = arith.muli %[[IDX]], %{{.*}} : i64
+// CHECK:           %[[VAL:.*]] = arith.addi %{{.*}}, %[[OFF]] : i64
+// CHECK:           func.call @stream_rt_push(%{{.*}}, %[[VAL]])
+
+// CHECK-LABEL: func.func private @reduce_task1(
+// CHECK:         %[[INIT:.*]] = arith.constant 0 : i64
+// CHECK:         %[[ACC:.*]] = scf.while (%{{.*}} = %[[INIT]]) : (i64) -> (i64, i1) {
+// CHECK:         call @stream_rt_push(%{{.*}}, %[[ACC]]#0)
+
+// -----
+
+func.func @create() -> !stream.stream<i32> {
+  %out = stream.create !stream.stream<i32> [1, 2, 3]
+  return %out : !stream.stream<i32>
+}
+
+// CHECK: memref.global "private" constant @stream_values : memref<3xi32> = dense<[1, 2, 3]>
+// CHECK-LABEL: func.func private @create_task0(
+// CHECK:         %[[MEM:.*]] = memref.get_global @stream_values : memref<3xi32>
+// CHECK:         scf.for %[[IV:.*]] =
+// CHECK:           %[[VAL:.*]] = memref.load %[[MEM]][%[[IV]]] : memref<3xi32>
+// CHECK:           %[[EXT:.*]] = arith.extui %[[VAL]] : i32 to i64
+// CHECK:           func.call @stream_rt_push(%{{.*}}, %[[EXT]])
+
+// -----
+
+func.func @combine(%in0: !stream.stream<i32>, %in1: !stream.stream<i32>) -> !stream.stream<tuple<i32, i32>> {
+  %res = stream.combine(%in0, %in1) : (!stream.stream<i32>, !stream.stream<i32>) -> !stream.stream<tuple<i32, i32>> {
+  ^0(%a: i32, %b: i32):
+    %t = stream.pack %a, %b : tuple<i32, i32>
+    stream.yield %t : tuple<i32, i32>
+  }
+  return %res : !stream.stream<tuple<i32, i32>>
+}
+
+// CHECK-LABEL: func.func private @combine_task0(
+// CHECK:         %{{.*}}:2 = scf.while : () -> (i1, i1) {
+// CHECK:           %[[MORE0:.*]] = func.call @stream_rt_next(
+// CHECK:           %[[MORE1:.*]] = func.call @stream_rt_next(
+// CHECK:           %[[BOTH:.*]] = arith.andi %[[MORE0]], %[[MORE1]] : i1
+// CHECK:           scf.condition(%[[BOTH]]) %[[MORE0]], %[[MORE1]] : i1, i1
+// CHECK:           %{{.*}}:2 = scf.execute_region -> (i32, i32) {
+// CHECK:           ^{{.*}}(%[[A:.*]]: i32, %[[B:.*]]: i32):
+// CHECK:             scf.yield %[[A]], %[[B]] : i32, i32
+// CHECK:         scf.if %{{.*}}#0 {
+// CHECK:         scf.if %{{.*}}#1 {
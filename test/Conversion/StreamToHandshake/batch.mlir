@@ -0,0 +1,47 @@
+// RUN: stream-opt %s --convert-stream-to-handshake --split-input-file | FileCheck %s
+
+func.func @batch(%in: !stream.stream<i32>) -> !stream.stream<i32, 2> {
+  %res = stream.batch(%in) : (!stream.stream<i32>) -> !stream.stream<i32, 2>
+  return %res : !stream.stream<i32, 2>
+}
+
+// CHECK:       handshake.func private @[[LABEL:.*]](%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<tuple<tuple<i32, i32>, tuple<i1, i1>>, i1>, none, none)
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i2
+// CHECK:         arith.cmpi eq
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i32
+// CHECK:         arith.select
+// CHECK:         arith.cmpi ult
+// CHECK:         arith.xori
+// CHECK:         arith.cmpi eq
+// CHECK:         arith.ori
+// CHECK:         arith.addi
+// CHECK:         arith.select
+// CHECK:         pack %{{.*}}, %{{.*}} : tuple<i32, i32>
+// CHECK:         pack %{{.*}}, %{{.*}} : tuple<i1, i1>
+// CHECK:         cond_br
+// CHECK:         cond_br
+// CHECK:       handshake.func @batch(%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<tuple<tuple<i32, i32>, tuple<i1, i1>>, i1>, none, none)
+// CHECK:         instance @[[LABEL]]
+
+// -----
+
+func.func @unbatch(%in: !stream.stream<i32, 2>) -> !stream.stream<i32> {
+  %res = stream.unbatch(%in) : (!stream.stream<i32, 2>) -> !stream.stream<i32>
+  return %res : !stream.stream<i32>
+}
+
+// CHECK:       handshake.func private @[[LABEL:.*]](%{{.*}}: tuple<tuple<tuple<i32, i32>, tuple<i1, i1>>, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, none)
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i1
+// CHECK:         mux %{{.*}} [%{{.*}}, %{{.*}}] : i1, tuple<tuple<tuple<i32, i32>, tuple<i1, i1>>, i1>
+// CHECK:         mux %{{.*}} [%{{.*}}, %{{.*}}] : i1, none
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i2
+// CHECK-COUNT-2: arith.cmpi eq
+// CHECK:         arith.andi
+// CHECK:         arith.ori
+// CHECK:         cond_br
+// CHECK:         cond_br
+// CHECK:         buffer [1] seq %{{.*}} : tuple<tuple<tuple<i32, i32>, tuple<i1, i1>>, i1>
+// CHECK:         buffer [1] seq %{{.*}} : none
+// CHECK:         pack %{{.*}}, %{{.*}} : tuple<i32, i1>
+// CHECK:       handshake.func @unbatch(%{{.*}}: tuple<tuple<tuple<i32, i32>, tuple<i1, i1>>, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, none)
+// CHECK:         instance @[[LABEL]]
@@ -0,0 +1,14 @@
+// RUN: stream-opt %s --convert-stream-to-handshake | FileCheck %s
+
+func.func @buffer(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %0 = stream.buffer [2] seq %in : !stream.stream<i32>
+  %res = stream.buffer [4] fifo %0 : !stream.stream<i32>
+  return %res : !stream.stream<i32>
+}
+
+// CHECK:       handshake.func @buffer(%[[IN:.*]]: tuple<i32, i1>, %[[CTRL:.*]]: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, none)
+// CHECK-DAG:     %[[SEQ_IN:.*]] = buffer [2] seq %[[IN]] : tuple<i32, i1>
+// CHECK-DAG:     %[[SEQ_CTRL:.*]] = buffer [2] seq %[[CTRL]] : none
+// CHECK-DAG:     %[[FIFO_IN:.*]] = buffer [4] fifo %[[SEQ_IN]] : tuple<i32, i1>
+// CHECK-DAG:     %[[FIFO_CTRL:.*]] = buffer [4] fifo %[[SEQ_CTRL]] : none
+// CHECK:         return %[[FIFO_IN]], %[[FIFO_CTRL]], %{{.*}} : tuple<i32, i1>, none, none
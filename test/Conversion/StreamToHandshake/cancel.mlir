@@ -0,0 +1,158 @@
+// RUN: stream-opt %s --convert-stream-to-handshake --split-input-file | FileCheck %s
+// RUN: stream-opt %s --convert-stream-to-handshake=cancel-slack=2 --split-input-file | FileCheck %s --check-prefix=SLACK
+
+func.func @cancel() -> !stream.stream<i32> {
+  %in = stream.iota start 0 step 1 count 1000 : !stream.stream<i32>
+  %mapped = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %0 = arith.constant 3 : i32
+    %r = arith.muli %0, %val : i32
+    stream.yield %r : i32
+  }
+  %filtered = stream.filter(%mapped) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val: i32):
+    %c0_i32 = arith.constant 0 : i32
+    %0 = arith.cmpi sgt, %val, %c0_i32 : i32
+    stream.yield %0 : i1
+  }
+  %res = stream.take %filtered count 4 : !stream.stream<i32>
+  return %res : !stream.stream<i32>
+}
+
+// CHECK:       handshake.func private @[[TAKE:stream_take.*]](%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, i1, none)
+// CHECK:         arith.cmpi ule
+// CHECK:         arith.cmpi eq
+// CHECK:         arith.ori
+// CHECK:         arith.xori
+// CHECK:         arith.ori
+// CHECK:         arith.xori
+// CHECK:         arith.andi
+// CHECK:         return %{{.*}}, %{{.*}}, %{{.*}}, %{{.*}} : tuple<i32, i1>, none, i1, none
+// CHECK:       handshake.func private @[[FILTER:stream_filter.*]](%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: i1, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, i1, none)
+// CHECK:         cond_br %{{.*}}, %{{.*}} : none
+// CHECK:         constant %{{.*}} {value = false} : i1
+// CHECK:         mux %{{.*}} [%{{.*}}, %{{.*}}] : i1, i1
+// CHECK:       handshake.func private @[[MAP:stream_map.*]](%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: i1, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, i1, none)
+// CHECK:       handshake.func private @[[IOTA:stream_iota.*]](%{{.*}}: i1, %{{.*}}: none, ...) -> (tuple<i32, i1>, none)
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [1]} : i1
+// CHECK:         mux %{{.*}} [%{{.*}}, %{{.*}}] : i1, none
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i64
+// CHECK:         constant %{{.*}} {value = 1000 : i64} : i64
+// CHECK:         arith.cmpi eq
+// CHECK:         buffer [8] seq %{{.*}} {initValues = [0, 0, 0, 0, 0, 0, 0, 0]} : i1
+// CHECK:         constant %{{.*}} {value = 8 : i64} : i64
+// CHECK:         arith.cmpi uge
+// CHECK:         arith.andi
+// CHECK:         arith.ori
+// CHECK:       handshake.func @cancel(
+// CHECK:         instance @[[IOTA]](%{{.*}}, %{{.*}}) : (i1, none) -> (tuple<i32, i1>, none)
+// CHECK:         instance @[[MAP]](%{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}) : (tuple<i32, i1>, none, i1, none) -> (tuple<i32, i1>, none, i1, none)
+// CHECK:         instance @[[FILTER]](%{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}) : (tuple<i32, i1>, none, i1, none) -> (tuple<i32, i1>, none, i1, none)
+// CHECK:         instance @[[TAKE]](%{{.*}}, %{{.*}}, %{{.*}}) : (tuple<i32, i1>, none, none) -> (tuple<i32, i1>, none, i1, none)
+// CHECK-NOT:     never
+
+// SLACK:       handshake.func private @stream_iota(%{{.*}}: i1, %{{.*}}: none, ...) -> (tuple<i32, i1>, none)
+// SLACK:         buffer [2] seq %{{.*}} {initValues = [0, 0]} : i1
+// SLACK:         constant %{{.*}} {value = 2 : i64} : i64
+// SLACK:         arith.cmpi uge
+// SLACK:         arith.andi
+// SLACK:         arith.ori
+
+// -----
+
+func.func @load(%mem: memref<16xi32>) -> !stream.stream<i32> {
+  %in = stream.load %mem[start 0 stride 1 count 16] : memref<16xi32> -> !stream.stream<i32>
+  %res = stream.take_while(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val: i32):
+    %c10 = arith.constant 10 : i32
+    %cond = arith.cmpi slt, %val, %c10 : i32
+    stream.yield %cond : i1
+  }
+  return %res : !stream.stream<i32>
+}
+
+// CHECK:       handshake.func private @[[TAKE:stream_take_while.*]](%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, i1, none)
+// CHECK:       handshake.func private @[[LOAD:stream_load.*]](%{{.*}}: memref<16xi32>, %{{.*}}: i1, %{{.*}}: none, ...) -> (tuple<i32, i1>, none)
+// CHECK:         constant %{{.*}} {value = 16 : i64} : i64
+// CHECK:         arith.cmpi eq
+// CHECK:         buffer [12] seq %{{.*}} {initValues = [0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0]} : i1
+// CHECK:         constant %{{.*}} {value = 12 : i64} : i64
+// CHECK:         arith.cmpi uge
+// CHECK:         arith.andi
+// CHECK:         arith.ori
+// CHECK:       handshake.func @load(
+// CHECK:         instance @[[LOAD]](%{{.*}}, %{{.*}}, %{{.*}}) : (memref<16xi32>, i1, none) -> (tuple<i32, i1>, none)
+// CHECK:         instance @[[TAKE]](%{{.*}}, %{{.*}}, %{{.*}}) : (tuple<i32, i1>, none, none) -> (tuple<i32, i1>, none, i1, none)
+
+// -----
+
+func.func @create() -> !stream.stream<i32> {
+  %in = stream.create !stream.stream<i32> [1,2,3,4,5,6,7,8,9,10]
+  %res = stream.take %in count 2 : !stream.stream<i32>
+  return %res : !stream.stream<i32>
+}
+
+// CHECK:       handshake.func private @[[CREATE:stream_create.*]](%{{.*}}: i1, %{{.*}}: none, ...) -> (tuple<i32, i1>, none)
+// CHECK:         buffer [10] seq %{{.*}} {initValues = [10, 9, 8, 7, 6, 5, 4, 3, 2, 1]} : i32
+// CHECK:         constant %{{.*}} {value = 10 : i64} : i64
+// CHECK:         arith.cmpi eq
+// CHECK:         buffer [8] seq %{{.*}} {initValues = [0, 0, 0, 0, 0, 0, 0, 0]} : i1
+// CHECK:         constant %{{.*}} {value = 8 : i64} : i64
+// CHECK:         arith.cmpi uge
+// CHECK:         arith.andi
+// CHECK:         arith.ori
+// CHECK:       handshake.func @create(
+// CHECK:         instance @[[CREATE]](%{{.*}}, %{{.*}}) : (i1, none) -> (tuple<i32, i1>, none)
+
+// SLACK:       handshake.func private @stream_create{{.*}}(%{{.*}}: i1, %{{.*}}: none, ...) -> (tuple<i32, i1>, none)
+// SLACK:         buffer [2] seq %{{.*}} {initValues = [0, 0]} : i1
+// SLACK:         arith.cmpi uge
+
+// -----
+
+func.func @split(%in: !stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  %res0, %res1 = stream.split(%in) : (!stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  ^0(%val: tuple<i32, i32>):
+    %0, %1 = stream.unpack %val : tuple<i32, i32>
+    stream.yield %0, %1 : i32, i32
+  }
+  %out0 = stream.take %res0 count 2 : !stream.stream<i32>
+  %out1 = stream.take %res1 count 3 : !stream.stream<i32>
+  return %out0, %out1 : !stream.stream<i32>, !stream.stream<i32>
+}
+
+// The argument of the function cannot be cancelled, so the split does not
+// forward the flags of the takes.
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, none)
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, none)
+// CHECK:       handshake.func private @stream_split(%{{.*}}: tuple<tuple<i32, i32>, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, tuple<i32, i1>, none, none)
+
+// -----
+
+func.func @split_iota() -> (!stream.stream<i32>, !stream.stream<i32>) {
+  %in = stream.iota start 0 step 1 count 100 : !stream.stream<i32>
+  %res0, %res1 = stream.split(%in) : (!stream.stream<i32>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  ^0(%val: i32):
+    stream.yield %val, %val : i32, i32
+  }
+  %out0 = stream.take %res0 count 2 : !stream.stream<i32>
+  %out1 = stream.take %res1 count 3 : !stream.stream<i32>
+  return %out0, %out1 : !stream.stream<i32>, !stream.stream<i32>
+}
+
+// CHECK:       handshake.func private @stream_split(%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: i1, %{{.*}}: i1, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, tuple<i32, i1>, none, i1, none)
+// CHECK:         arith.andi
+// CHECK:       handshake.func private @stream_iota(%{{.*}}: i1, %{{.*}}: none, ...) -> (tuple<i32, i1>, none)
+
+// -----
+
+func.func @multiple_uses() -> (!stream.stream<i32>, !stream.stream<i32>) {
+  %in = stream.iota start 0 step 1 count 100 : !stream.stream<i32>
+  %out0 = stream.take %in count 2 : !stream.stream<i32>
+  %out1 = stream.take %in count 3 : !stream.stream<i32>
+  return %out0, %out1 : !stream.stream<i32>, !stream.stream<i32>
+}
+
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, none)
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, none)
+// CHECK:       handshake.func private @stream_iota(%{{.*}}: none, ...) -> (tuple<i32, i1>, none)
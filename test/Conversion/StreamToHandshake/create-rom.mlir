@@ -0,0 +1,19 @@
+// RUN: stream-opt %s --convert-stream-to-handshake="create-rom-threshold=3" | FileCheck %s
+
+func.func @create() -> !stream.stream<i32> {
+  %out = stream.create !stream.stream<i32> [4,5,6]
+  return %out : !stream.stream<i32>
+}
+
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: none, ...) -> (tuple<i32, i1>, none)
+// CHECK-NOT:     buffer [3]
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i64
+// CHECK:         arith.cmpi eq
+// CHECK:         arith.shrui
+// CHECK:         arith.trunci %{{.*}} : i64 to i1
+// CHECK:         constant %{{.*}} {value = 4 : i32} : i32
+// CHECK:         constant %{{.*}} {value = 5 : i32} : i32
+// CHECK:         constant %{{.*}} {value = 6 : i32} : i32
+// CHECK:         constant %{{.*}} {value = 0 : i32} : i32
+// CHECK:         mux %{{.*}} [%{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}] : i64, i32
+// CHECK:         pack %{{.*}}, %{{.*}} : tuple<i32, i1>
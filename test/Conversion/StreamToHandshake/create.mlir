@@ -1,4 +1,4 @@
-// RUN: stream-opt %s --convert-stream-to-handshake | FileCheck %s
+// RUN: stream-opt %s --convert-stream-to-handshake --split-input-file | FileCheck %s
 
 func.func @create() -> !stream.stream<i32> {
   %out = stream.create !stream.stream<i32> [1,2,3]
@@ -24,3 +24,18 @@ func.func @create() -> !stream.stream<i32> {
 // CHECK-NEXT:    %{{.*}} = pack %{{.*}}, %{{.*}} : tuple<i32, i1>
 // CHECK-NEXT:    return %{{.*}}, %{{.*}}#1 : tuple<i32, i1>, none
 // CHECK-NEXT:  }
+
+// -----
+
+// An empty stream only emits the EOS transaction, without a data buffer.
+
+func.func @create_empty() -> !stream.stream<i32> {
+  %out = stream.create !stream.stream<i32> []
+  return %out : !stream.stream<i32>
+}
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: none, ...) -> (tuple<i32, i1>, none)
+// CHECK:         %[[DATA:.*]] = constant %{{.*}} {value = 0 : i32} : i32
+// CHECK-NOT:     buffer [{{.*}}] seq %{{.*}} : i32
+// CHECK:         constant %{{.*}} {value = 0 : i64} : i64
+// CHECK:         %[[EOS:.*]] = arith.cmpi eq
+// CHECK:         pack %[[DATA]], %[[EOS]] : tuple<i32, i1>
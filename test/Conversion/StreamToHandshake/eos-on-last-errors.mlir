@@ -0,0 +1,45 @@
+// RUN: stream-opt %s --convert-stream-to-handshake="eos-on-last" --split-input-file --verify-diagnostics
+
+func.func @empty() -> !stream.stream<i32> {
+  // expected-error @+1 {{cannot create empty streams with EOS on the last element}}
+  %out = stream.iota start 0 step 1 count 0 : !stream.stream<i32>
+  return %out : !stream.stream<i32>
+}
+
+// -----
+
+func.func @filter(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  // expected-error @+1 {{cannot pipeline a filter with EOS on the last element}}
+  %res = stream.filter(%in) {latency = 1 : i64} : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val: i32):
+    %c0 = arith.constant 0 : i32
+    %cond = arith.cmpi sgt, %val, %c0 : i32
+    stream.yield %cond : i1
+  }
+  return %res : !stream.stream<i32>
+}
+
+// -----
+
+func.func @take_while(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  // expected-error @+1 {{cannot be lowered with EOS on the last element}}
+  %res = stream.take_while(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val: i32):
+    %c0 = arith.constant 0 : i32
+    %cond = arith.cmpi sgt, %val, %c0 : i32
+    stream.yield %cond : i1
+  }
+  return %res : !stream.stream<i32>
+}
+
+// -----
+
+func.func @reduce_by_key(%in: !stream.stream<tuple<i8, i32>>) -> !stream.stream<tuple<i8, i32>> {
+  // expected-error @+1 {{cannot be lowered with EOS on the last element}}
+  %res = stream.reduce_by_key(%in) {initValue = 0 : i32, capacity = 4 : i64}: (!stream.stream<tuple<i8, i32>>) -> !stream.stream<tuple<i8, i32>> {
+  ^0(%acc: i32, %val: i32):
+    %r = arith.addi %acc, %val : i32
+    stream.yield %r : i32
+  }
+  return %res : !stream.stream<tuple<i8, i32>>
+}
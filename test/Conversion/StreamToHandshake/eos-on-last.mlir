@@ -0,0 +1,118 @@
+// RUN: stream-opt %s --convert-stream-to-handshake="eos-on-last" --split-input-file | FileCheck %s
+
+func.func @create() -> !stream.stream<i32> {
+  %out = stream.create !stream.stream<i32> [1,2,3]
+  return %out : !stream.stream<i32>
+}
+
+// The last element is emitted together with EOS.
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: none, ...) -> (tuple<i32, i1>, none)
+// CHECK:         buffer [3] seq %{{.*}} {initValues = [3, 2, 1]} : i32
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i64
+// CHECK:         constant %{{.*}} {value = 2 : i64} : i64
+// CHECK:         arith.cmpi eq
+
+// -----
+
+func.func @iota() -> !stream.stream<i32> {
+  %out = stream.iota start 0 step 1 count 4 : !stream.stream<i32>
+  return %out : !stream.stream<i32>
+}
+
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: none, ...) -> (tuple<i32, i1>, none)
+// CHECK:         constant %{{.*}} {value = 3 : i64} : i64
+// CHECK:         arith.cmpi eq
+
+// -----
+
+func.func @reduce(%in: !stream.stream<i64>) -> !stream.stream<i64> {
+  %res = stream.reduce(%in) {initValue = 0 : i64}: (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%acc: i64, %val: i64):
+    %r = arith.addi %acc, %val : i64
+    stream.yield %r : i64
+  }
+  return %res : !stream.stream<i64>
+}
+
+// The last element is folded into the accumulator, and the result is emitted
+// in a single transaction.
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: tuple<i64, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i64, i1>, none, none)
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i64
+// CHECK:         arith.addi %{{.*}}, %{{.*}} : i64
+// CHECK:         cond_br %{{.*}}, %{{.*}} : i64
+// CHECK:         pack %{{.*}}, %{{.*}} : tuple<i64, i1>
+// CHECK-NOT:     mux
+// CHECK:         return
+
+// -----
+
+func.func @filter(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %res = stream.filter(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val: i32):
+    %c0 = arith.constant 0 : i32
+    %cond = arith.cmpi sgt, %val, %c0 : i32
+    stream.yield %cond : i1
+  }
+  return %res : !stream.stream<i32>
+}
+
+// Kept elements are held for one transaction. A kept last element takes an
+// extra iteration of its ctrl token, which emits it with EOS.
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, none)
+// CHECK-DAG:     buffer [1] seq %{{.*}} {initValues = [0]} : i1
+// CHECK-DAG:     buffer [1] seq %{{.*}} {initValues = [0]} : i32
+// CHECK-DAG:     buffer [1] seq %{{.*}} : none
+// CHECK-DAG:     mux %{{.*}} [%{{.*}}, %{{.*}}] : i1, none
+// CHECK-DAG:     mux %{{.*}} [%{{.*}}, %{{.*}}] : i1, i32
+// CHECK-DAG:     pack %{{.*}}, %{{.*}} : tuple<i32, i1>
+// CHECK:         return
+
+// -----
+
+func.func @filter_none(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %res = stream.filter(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val: i32):
+    %false = arith.constant false
+    stream.yield %false : i1
+  }
+  return %res : !stream.stream<i32>
+}
+
+// Without a held element, the last input transaction is emitted with EOS and
+// a bubble as payload, so a stream of which no element is kept still ends.
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, none)
+// CHECK:         %[[LAST:.*]] = arith.andi
+// CHECK:         %[[HELD_EMIT:.*]] = arith.andi
+// CHECK:         %[[EMIT:.*]] = arith.ori %[[HELD_EMIT]], %[[LAST]] : i1
+// CHECK:         %[[BUBBLE:.*]] = constant %{{.*}} {value = 0 : i32} : i32
+// CHECK:         %[[PAYLOAD:.*]] = arith.select %{{.*}}, %{{.*}}, %[[BUBBLE]] : i32
+// CHECK:         %[[TUPLE:.*]] = pack %[[PAYLOAD]], %[[LAST]] : tuple<i32, i1>
+// CHECK:         cond_br %[[EMIT]], %[[TUPLE]] : tuple<i32, i1>
+// CHECK:         return
+
+// -----
+
+func.func @merge(%in0: !stream.stream<i32>, %in1: !stream.stream<i32>) -> !stream.stream<i32> {
+  %res = stream.merge %in0, %in1 : !stream.stream<i32>
+  return %res : !stream.stream<i32>
+}
+
+// All elements are forwarded, but only the last one of the last input keeps
+// the EOS flag.
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, none)
+// CHECK:         control_merge
+// CHECK:         arith.andi
+// CHECK-NOT:     cond_br %{{.*}}, %{{.*}} : tuple<i32, i1>
+// CHECK:         pack %{{.*}}, %{{.*}} : tuple<i32, i1>
+
+// -----
+
+func.func @store(%in: !stream.stream<i32>, %mem: memref<16xi32>) {
+  stream.store %in, %mem[start 0 stride 1] : !stream.stream<i32>, memref<16xi32>
+  return
+}
+
+// Each transaction stores an element.
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: memref<16xi32>, %{{.*}}: none, ...) -> none
+// CHECK-NOT:     cond_br
+// CHECK:         store [%{{.*}}] %{{.*}}, %{{.*}} : index, i32
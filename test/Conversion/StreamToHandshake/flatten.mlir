@@ -0,0 +1,30 @@
+// RUN: stream-opt %s --convert-stream-to-handshake=flatten=true | FileCheck %s
+
+module {
+  func.func @map(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+    %tmp = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+    ^0(%val : i32):
+      %0 = arith.constant 1 : i32
+      %r = arith.addi %0, %val : i32
+      stream.yield %r : i32
+    }
+    %res = stream.map(%tmp) : (!stream.stream<i32>) -> !stream.stream<i32> {
+    ^0(%val : i32):
+      %0 = arith.constant 10 : i32
+      %r = arith.muli %0, %val : i32
+      stream.yield %r : i32
+    }
+    return %res : !stream.stream<i32>
+  }
+
+  // CHECK-NOT:  handshake.func private
+  // CHECK-LABEL: handshake.func @map(%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, none)
+  // CHECK-NOT:    instance
+  // CHECK:        arith.addi
+  // CHECK-NOT:    instance
+  // CHECK:        arith.muli
+  // CHECK-NOT:    instance
+  // CHECK:        return %{{.*}}, %{{.*}}, %{{.*}} : tuple<i32, i1>, none, none
+  // CHECK-NEXT: }
+  // CHECK-NOT:  handshake.func
+}
@@ -0,0 +1,18 @@
+// RUN: stream-opt %s --convert-stream-to-handshake | FileCheck %s
+
+func.func @iota() -> !stream.stream<i16> {
+  %out = stream.iota start 3 step 2 count 8 : !stream.stream<i16>
+  return %out : !stream.stream<i16>
+}
+
+// CHECK:       handshake.func private @[[LABEL:.*]](%{{.*}}: none, ...) -> (tuple<i16, i1>, none)
+// CHECK:         merge %{{.*}}, %{{.*}} : none
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [3]} : i16
+// CHECK:         constant %{{.*}} {value = 2 : i16} : i16
+// CHECK:         arith.addi %{{.*}}, %{{.*}} : i16
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i64
+// CHECK:         constant %{{.*}} {value = 8 : i64} : i64
+// CHECK:         arith.cmpi eq
+// CHECK:         pack %{{.*}}, %{{.*}} : tuple<i16, i1>
+// CHECK:       handshake.func @iota(%{{.*}}: none, ...) -> (tuple<i16, i1>, none)
+// CHECK:         instance @[[LABEL]]
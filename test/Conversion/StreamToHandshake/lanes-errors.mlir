@@ -0,0 +1,21 @@
+// RUN: stream-opt %s --convert-stream-to-handshake --split-input-file --verify-diagnostics
+
+func.func @combine_filtered(%in: !stream.stream<i32, 2>) -> !stream.stream<i32, 2> {
+  %a, %b = stream.split(%in) : (!stream.stream<i32, 2>) -> (!stream.stream<i32, 2>, !stream.stream<i32, 2>) {
+  ^0(%val: i32):
+    stream.yield %val, %val : i32, i32
+  }
+  %f = stream.filter(%a) : (!stream.stream<i32, 2>) -> !stream.stream<i32, 2> {
+  ^0(%val: i32):
+    %c0 = arith.constant 0 : i32
+    %cond = arith.cmpi sgt, %val, %c0 : i32
+    stream.yield %cond : i1
+  }
+  // expected-error @+1 {{cannot combine multi-lane streams whose valid lanes can differ}}
+  %res = stream.combine(%f, %b) : (!stream.stream<i32, 2>, !stream.stream<i32, 2>) -> (!stream.stream<i32, 2>) {
+  ^0(%val0: i32, %val1: i32):
+    %0 = arith.addi %val0, %val1 : i32
+    stream.yield %0 : i32
+  }
+  return %res : !stream.stream<i32, 2>
+}
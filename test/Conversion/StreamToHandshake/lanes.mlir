@@ -0,0 +1,124 @@
+// RUN: stream-opt %s --convert-stream-to-handshake --split-input-file | FileCheck %s
+
+func.func @map(%in: !stream.stream<i32, 2>) -> !stream.stream<i32, 2> {
+  %res = stream.map(%in) : (!stream.stream<i32, 2>) -> !stream.stream<i32, 2> {
+  ^0(%val : i32):
+    %0 = arith.constant 1 : i32
+    %r = arith.addi %0, %val : i32
+    stream.yield %r : i32
+  }
+  return %res : !stream.stream<i32, 2>
+}
+
+// CHECK:       handshake.func private @[[LABEL:.*]](%{{.*}}: tuple<tuple<tuple<i32, i32>, tuple<i1, i1>>, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<tuple<tuple<i32, i32>, tuple<i1, i1>>, i1>, none, none)
+// CHECK:         arith.addi
+// CHECK:         arith.addi
+// CHECK:         join
+// CHECK:         pack %{{.*}}, %{{.*}} : tuple<i32, i32>
+// CHECK:         pack %{{.*}}, %{{.*}} : tuple<i1, i1>
+// CHECK:         return
+// CHECK:       handshake.func @map(%{{.*}}: tuple<tuple<tuple<i32, i32>, tuple<i1, i1>>, i1>, %{{.*}}: none, %{{.*}}: none, ...)
+// CHECK:         instance @[[LABEL]]
+
+// -----
+
+func.func @filter(%in: !stream.stream<i32, 2>) -> !stream.stream<i32, 2> {
+  %out = stream.filter(%in) : (!stream.stream<i32, 2>) -> !stream.stream<i32, 2> {
+  ^bb0(%val: i32):
+    %c0_i32 = arith.constant 0 : i32
+    %0 = arith.cmpi sgt, %val, %c0_i32 : i32
+    stream.yield %0 : i1
+  }
+  return %out : !stream.stream<i32, 2>
+}
+
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: tuple<tuple<tuple<i32, i32>, tuple<i1, i1>>, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<tuple<tuple<i32, i32>, tuple<i1, i1>>, i1>, none, none)
+// CHECK-COUNT-2: arith.cmpi sgt
+// CHECK:         arith.select
+// CHECK:         arith.cmpi ugt
+// CHECK:         arith.cmpi ne
+// CHECK:         cond_br
+
+// -----
+
+func.func @reduce(%in: !stream.stream<i64, 2>) -> !stream.stream<i64> {
+  %res = stream.reduce(%in) {initValue = 0 : i64}: (!stream.stream<i64, 2>) -> !stream.stream<i64> {
+  ^0(%acc: i64, %val: i64):
+    %r = arith.addi %acc, %val : i64
+    stream.yield %r : i64
+  }
+  return %res : !stream.stream<i64>
+}
+
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: tuple<tuple<tuple<i64, i64>, tuple<i1, i1>>, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i64, i1>, none, none)
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i64
+// CHECK:         arith.select
+// CHECK:         arith.select
+// CHECK:         arith.addi
+// CHECK:         arith.addi
+// CHECK:         buffer [2] seq %{{.*}} {initValues = [1, 0]} : i32
+
+// -----
+
+func.func @reduce_sub(%in: !stream.stream<i64, 2>) -> !stream.stream<i64> {
+  %res = stream.reduce(%in) {initValue = 0 : i64}: (!stream.stream<i64, 2>) -> !stream.stream<i64> {
+  ^0(%acc: i64, %val: i64):
+    %r = arith.subi %acc, %val : i64
+    stream.yield %r : i64
+  }
+  return %res : !stream.stream<i64>
+}
+
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: tuple<tuple<tuple<i64, i64>, tuple<i1, i1>>, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i64, i1>, none, none)
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i64
+// CHECK:         arith.subi
+// CHECK:         arith.select
+// CHECK:         arith.subi
+// CHECK:         arith.select
+// CHECK:         join
+// CHECK:         buffer [2] seq %{{.*}} {initValues = [1, 0]} : i32
+
+// -----
+
+func.func @combine(%in0: !stream.stream<i32, 2>, %in1: !stream.stream<i32, 2>) -> (!stream.stream<i32, 2>) {
+  %res = stream.combine(%in0, %in1) : (!stream.stream<i32, 2>, !stream.stream<i32, 2>) -> (!stream.stream<i32, 2>) {
+  ^0(%val0: i32, %val1: i32):
+    %0 = arith.addi %val0, %val1 : i32
+    stream.yield %0 : i32
+  }
+  return %res : !stream.stream<i32, 2>
+}
+
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: tuple<tuple<tuple<i32, i32>, tuple<i1, i1>>, i1>, %{{.*}}: none, %{{.*}}: tuple<tuple<tuple<i32, i32>, tuple<i1, i1>>, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<tuple<tuple<i32, i32>, tuple<i1, i1>>, i1>, none, none)
+// CHECK-COUNT-2: arith.addi
+// CHECK:         arith.andi
+// CHECK:         arith.andi
+// CHECK:         arith.ori
+
+// -----
+
+// Both inputs originate from the same filter, so their valid lanes agree.
+
+func.func @combine_same_filter(%in: !stream.stream<i32, 2>) -> (!stream.stream<i32, 2>) {
+  %f = stream.filter(%in) : (!stream.stream<i32, 2>) -> !stream.stream<i32, 2> {
+  ^0(%val: i32):
+    %c0 = arith.constant 0 : i32
+    %cond = arith.cmpi sgt, %val, %c0 : i32
+    stream.yield %cond : i1
+  }
+  %a, %b = stream.split(%f) : (!stream.stream<i32, 2>) -> (!stream.stream<i32, 2>, !stream.stream<i32, 2>) {
+  ^0(%val: i32):
+    stream.yield %val, %val : i32, i32
+  }
+  %res = stream.combine(%a, %b) : (!stream.stream<i32, 2>, !stream.stream<i32, 2>) -> (!stream.stream<i32, 2>) {
+  ^0(%val0: i32, %val1: i32):
+    %0 = arith.muli %val0, %val1 : i32
+    stream.yield %0 : i32
+  }
+  return %res : !stream.stream<i32, 2>
+}
+
+// CHECK-LABEL: handshake.func @combine_same_filter
+// CHECK:         instance @{{.*}}
+// CHECK:         instance @{{.*}}
+// CHECK:         instance @{{.*}}
@@ -0,0 +1,50 @@
+// RUN: stream-opt %s --pass-pipeline='func.func(stream-lower-regions)' | FileCheck %s
+
+// The regions of all functions are lowered independently, while the stream
+// operations themselves are kept.
+
+func.func @first(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %res = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %c0 = arith.constant 0 : i32
+    %cond = arith.cmpi eq, %c0, %val : i32
+    cf.cond_br %cond, ^1, ^2(%val: i32)
+  ^1:
+    %0 = arith.constant 1 : i32
+    %r = arith.addi %0, %val : i32
+    cf.br ^2(%r: i32)
+  ^2(%out: i32):
+    stream.yield %out : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+func.func @second(%in: !stream.stream<i32>) -> !stream.stream<i1> {
+  %res = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<i1> {
+  ^0(%val : i32):
+    %c0 = arith.constant 0 : i32
+    %cond = arith.cmpi eq, %c0, %val : i32
+    cf.cond_br %cond, ^1, ^2(%val: i32)
+  ^1:
+    cf.br ^2(%c0: i32)
+  ^2(%out: i32):
+    %r = arith.cmpi sgt, %out, %c0 : i32
+    stream.yield %r : i1
+  }
+  return %res : !stream.stream<i1>
+}
+
+// CHECK-LABEL: func.func @first(
+// CHECK:         stream.map
+// CHECK-NOT:     cf.
+// CHECK:           handshake.cond_br
+// CHECK:           arith.addi
+// CHECK:           stream.yield
+// CHECK:         return
+// CHECK-LABEL: func.func @second(
+// CHECK:         stream.map
+// CHECK-NOT:     cf.
+// CHECK:           handshake.cond_br
+// CHECK:           arith.cmpi sgt
+// CHECK:           stream.yield
+// CHECK:         return
@@ -0,0 +1,41 @@
+// RUN: stream-opt %s --convert-stream-to-handshake --split-input-file | FileCheck %s
+// RUN: stream-opt %s --convert-stream-to-handshake=load-requests=16 --split-input-file | FileCheck %s --check-prefix=REQUESTS
+
+func.func @load(%mem: memref<16xi32>) -> !stream.stream<i32> {
+  %out = stream.load %mem[start 2 stride 3 count 4] : memref<16xi32> -> !stream.stream<i32>
+  return %out : !stream.stream<i32>
+}
+
+// CHECK:       handshake.func private @[[LABEL:.*]](%{{.*}}: memref<16xi32>, %{{.*}}: none, ...) -> (tuple<i32, i1>, none)
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i64
+// CHECK:         constant %{{.*}} {value = 4 : i64} : i64
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [2]} : i64
+// CHECK:         constant %{{.*}} {value = 3 : i64} : i64
+// CHECK:         arith.index_cast %{{.*}} : i64 to index
+// CHECK:         load [%{{.*}}] %{{.*}}, %{{.*}} : index, i32
+// CHECK:         extmemory[ld = 1, st = 0] (%{{.*}} : memref<16xi32>)
+// CHECK:         buffer [4] fifo %{{.*}} : i32
+// CHECK:         buffer [4] fifo %{{.*}} : i1
+// CHECK:         buffer [4] fifo %{{.*}} : none
+// CHECK:         mux %{{.*}} [%{{.*}}, %{{.*}}] : i1, i32
+// CHECK:       handshake.func @load(%{{.*}}: memref<16xi32>, %{{.*}}: none, ...) -> (tuple<i32, i1>, none)
+// CHECK:         instance @[[LABEL]](%{{.*}}, %{{.*}}) : (memref<16xi32>, none) -> (tuple<i32, i1>, none)
+
+// REQUESTS:      buffer [16] fifo %{{.*}} : i32
+// REQUESTS:      buffer [16] fifo %{{.*}} : i1
+// REQUESTS:      buffer [16] fifo %{{.*}} : none
+
+// -----
+
+func.func @store(%in: !stream.stream<i32>, %mem: memref<16xi32>) {
+  stream.store %in, %mem[start 1 stride 1] : !stream.stream<i32>, memref<16xi32>
+  return
+}
+
+// CHECK:       handshake.func private @[[LABEL:.*]](%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: memref<16xi32>, %{{.*}}: none, ...) -> none
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [1]} : i64
+// CHECK:         arith.index_cast %{{.*}} : i64 to index
+// CHECK:         store [%{{.*}}] %{{.*}}, %{{.*}} : index, i32
+// CHECK:         extmemory[ld = 0, st = 1] (%{{.*}} : memref<16xi32>)
+// CHECK:       handshake.func @store(%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: memref<16xi32>, %{{.*}}: none, ...) -> none
+// CHECK:         instance @[[LABEL]](%{{.*}}, %{{.*}}, %{{.*}}, %{{.*}}) : (tuple<i32, i1>, none, memref<16xi32>, none) -> none
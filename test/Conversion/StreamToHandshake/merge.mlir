@@ -0,0 +1,39 @@
+// RUN: stream-opt %s --convert-stream-to-handshake | FileCheck %s
+
+func.func @merge(%in0: !stream.stream<i32>, %in1: !stream.stream<i32>, %in2: !stream.stream<i32>) -> !stream.stream<i32> {
+  %res = stream.merge %in0, %in1, %in2 : !stream.stream<i32>
+  return %res : !stream.stream<i32>
+}
+
+// CHECK:       handshake.func private @[[LABEL:.*]](%[[IN0:.*]]: tuple<i32, i1>, %[[CTRL0:.*]]: none, %[[IN1:.*]]: tuple<i32, i1>, %[[CTRL1:.*]]: none, %[[IN2:.*]]: tuple<i32, i1>, %[[CTRL2:.*]]: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, none)
+// CHECK:         %[[TUPLE:.*]], %[[INDEX:.*]] = control_merge %[[IN0]], %[[IN1]], %[[IN2]] : tuple<i32, i1>
+// CHECK:         mux %{{.*}} [%[[CTRL0]], %[[CTRL1]], %[[CTRL2]]] : index, none
+// CHECK:         %{{.*}}:2 = unpack %{{.*}} : tuple<i32, i1>
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i1
+// CHECK:         constant %{{.*}} {value = 0 : index} : index
+// CHECK:         arith.cmpi eq, %[[INDEX]], %{{.*}} : index
+// CHECK:         arith.andi
+// CHECK:         arith.ori
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i1
+// CHECK:         constant %{{.*}} {value = 1 : index} : index
+// CHECK:         arith.cmpi eq, %[[INDEX]], %{{.*}} : index
+// CHECK:         arith.andi
+// CHECK:         arith.ori
+// CHECK:         arith.andi
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i1
+// CHECK:         constant %{{.*}} {value = 2 : index} : index
+// CHECK:         arith.cmpi eq, %[[INDEX]], %{{.*}} : index
+// CHECK:         arith.andi
+// CHECK:         arith.ori
+// CHECK:         arith.andi
+// CHECK:         arith.andi
+// CHECK:         constant %{{.*}} {value = false} : i1
+// CHECK:         arith.select
+// CHECK:         arith.select
+// CHECK:         arith.select
+// CHECK:         arith.xori
+// CHECK:         arith.ori
+// CHECK:         cond_br
+// CHECK:         cond_br
+// CHECK:       handshake.func @merge(
+// CHECK:         instance @[[LABEL]]
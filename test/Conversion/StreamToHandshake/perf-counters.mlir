@@ -0,0 +1,60 @@
+// RUN: stream-opt %s --convert-stream-to-handshake="perf-counters" --split-input-file | FileCheck %s
+
+func.func @map(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %res = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %0 = arith.constant 1 : i32
+    %r = arith.addi %0, %val : i32
+    stream.yield %r : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+// CHECK:       handshake.func private @stream_perf_monitor(i1, none{{.*}}) -> (i64, i64, none)
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, none)
+// CHECK-NOT:     initValues
+// CHECK:       handshake.func @map(%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, i64, i64, i64, none) attributes {{{.*}}resNames = [{{.*}}"perf0", "perf0_active", "perf0_stalled", {{.*}}]}
+// CHECK:         %[[RES:.*]]:2 = instance @{{.*}}
+// CHECK:         %[[DATA:.*]], %[[EOS:.*]] = unpack %[[RES]]#0
+// CHECK:         %[[MON:.*]]:3 = instance @stream_perf_monitor(%[[EOS]], %[[RES]]#1) : (i1, none) -> (i64, i64, none)
+// CHECK:         unpack %[[RES]]#0
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i64
+// CHECK:         constant %{{.*}} {value = 1 : i64} : i64
+// CHECK:         arith.addi
+// CHECK:         return %[[RES]]#0, %[[MON]]#2, %{{.*}}, %[[MON]]#0, %[[MON]]#1, %{{.*}} : tuple<i32, i1>, none, i64, i64, i64, none
+
+// -----
+
+func.func @split(%in: !stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  %res0, %res1 = stream.split(%in) : (!stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  ^0(%val: tuple<i32, i32>):
+    %0, %1 = stream.unpack %val : tuple<i32, i32>
+    stream.yield %0, %1 : i32, i32
+  }
+  return %res0, %res1 : !stream.stream<i32>, !stream.stream<i32>
+}
+
+// CHECK:       handshake.func @split(%{{.*}}: tuple<tuple<i32, i32>, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, tuple<i32, i1>, none, i64, i64, i64, i64, i64, i64, none)
+// CHECK-COUNT-2: instance @stream_perf_monitor
+
+// -----
+
+func.func @lanes(%in: !stream.stream<i32, 2>) -> !stream.stream<i32, 2> {
+  %res = stream.map(%in) : (!stream.stream<i32, 2>) -> !stream.stream<i32, 2> {
+  ^0(%val : i32):
+    stream.yield %val : i32
+  }
+  return %res : !stream.stream<i32, 2>
+}
+
+// Each transaction contributes the number of its valid lanes.
+// CHECK:       handshake.func @lanes
+// CHECK:         instance @stream_perf_monitor
+// CHECK:         %[[PAYLOAD:.*]], %[[EOS:.*]] = unpack
+// CHECK:         %[[LANES:.*]]:2 = unpack %[[PAYLOAD]]
+// CHECK:         %[[VALID:.*]]:2 = unpack %[[LANES]]#1 : tuple<i1, i1>
+// CHECK:         %[[EXT0:.*]] = arith.extui %[[VALID]]#0 : i1 to i64
+// CHECK:         %[[EXT1:.*]] = arith.extui %[[VALID]]#1 : i1 to i64
+// CHECK:         %[[SUM:.*]] = arith.addi %[[EXT0]], %[[EXT1]] : i64
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i64
+// CHECK:         cond_br %{{.*}}, %[[SUM]] : i64
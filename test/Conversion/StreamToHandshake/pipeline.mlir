@@ -0,0 +1,52 @@
+// RUN: stream-opt %s --convert-stream-to-handshake --split-input-file | FileCheck %s
+
+// The EOS and the ctrl signal cross both stages, like the payload that is
+// cut in front of and behind the addition.
+
+// CHECK-LABEL: handshake.func private @stream_map(
+// CHECK-DAG:     %[[EOS:.*]] = buffer [2] seq %{{.*}} : i1
+// CHECK-DAG:     %[[CTRL:.*]] = buffer [2] seq %{{.*}} : none
+// CHECK-DAG:     buffer [1] seq %{{.*}} : i32
+// CHECK-DAG:     %[[TUPLE:.*]] = pack %{{.*}}, %[[EOS]] : tuple<i32, i1>
+// CHECK:         return %[[TUPLE]], %[[CTRL]], %{{.*}} : tuple<i32, i1>, none, none
+func.func @map(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %res = stream.map(%in) {latency = 2 : i64} : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %0 = arith.constant 1 : i32
+    %r = arith.addi %0, %val : i32
+    stream.yield %r : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+// -----
+
+// CHECK-LABEL: handshake.func private @stream_filter(
+// CHECK:         buffer [{{[0-9]+}}] seq
+// CHECK:         cond_br
+// CHECK:         cond_br
+func.func @filter(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %res = stream.filter(%in) {latency = 3 : i64} : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %c0 = arith.constant 0 : i32
+    %0 = arith.cmpi sgt, %val, %c0 : i32
+    stream.yield %0 : i1
+  }
+  return %res : !stream.stream<i32>
+}
+
+// -----
+
+// Without a latency, no buffers are placed.
+
+// CHECK-LABEL: handshake.func private @stream_combine(
+// CHECK-NOT:     buffer
+// CHECK:         return
+func.func @combine(%in0: !stream.stream<i32>, %in1: !stream.stream<i32>) -> !stream.stream<i32> {
+  %res = stream.combine(%in0, %in1) {latency = 0 : i64} : (!stream.stream<i32>, !stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val0: i32, %val1: i32):
+    %0 = arith.addi %val0, %val1 : i32
+    stream.yield %0 : i32
+  }
+  return %res : !stream.stream<i32>
+}
@@ -0,0 +1,44 @@
+// RUN: stream-opt %s --convert-stream-to-handshake | FileCheck %s
+
+func.func @reduce_by_key(%in: !stream.stream<tuple<i8, i32>>) -> !stream.stream<tuple<i8, i32>> {
+  %res = stream.reduce_by_key(%in) {initValue = 0 : i32, capacity = 2 : i64}: (!stream.stream<tuple<i8, i32>>) -> !stream.stream<tuple<i8, i32>> {
+  ^0(%acc: i32, %val: i32):
+    %r = arith.addi %acc, %val : i32
+    stream.yield %r : i32
+  }
+  return %res : !stream.stream<tuple<i8, i32>>
+}
+
+// The EOS transaction is held in a loop that flushes one slot per iteration.
+// CHECK:       handshake.func private @[[LABEL:.*]](%{{.*}}: tuple<tuple<i8, i32>, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<tuple<i8, i32>, i1>, none, none)
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i1
+// CHECK:         mux %{{.*}} [%{{.*}}, %{{.*}}] : i1, tuple<tuple<i8, i32>, i1>
+// CHECK:         mux %{{.*}} [%{{.*}}, %{{.*}}] : i1, none
+// CHECK:         unpack %{{.*}} : tuple<tuple<i8, i32>, i1>
+// CHECK:         unpack %{{.*}} : tuple<i8, i32>
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i2
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i2
+// CHECK:         constant %{{.*}} {value = -2 : i2} : i2
+
+// Each slot holds a valid flag, a key, and an accumulator.
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i1
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i8
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i32
+// CHECK:         arith.cmpi eq, %{{.*}}, %{{.*}} : i8
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i1
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i8
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i32
+// CHECK:         arith.cmpi eq, %{{.*}}, %{{.*}} : i8
+
+// A single copy of the region updates the selected accumulator.
+// CHECK:         arith.select %{{.*}}, %{{.*}}, %{{.*}} : i32
+// CHECK:         constant %{{.*}} {value = 0 : i32} : i32
+// CHECK:         arith.select %{{.*}}, %{{.*}}, %{{.*}} : i32
+// CHECK:         arith.addi %{{.*}}, %{{.*}} : i32
+// CHECK-NOT:     arith.addi %{{.*}}, %{{.*}} : i32
+// CHECK:         pack %{{.*}}, %{{.*}} : tuple<i8, i32>
+// CHECK:         pack %{{.*}}, %{{.*}} : tuple<tuple<i8, i32>, i1>
+// CHECK:         cond_br %{{.*}}, %{{.*}} : tuple<tuple<i8, i32>, i1>
+// CHECK:         cond_br %{{.*}}, %{{.*}} : none
+// CHECK:       handshake.func @reduce_by_key(%{{.*}}: tuple<tuple<i8, i32>, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<tuple<i8, i32>, i1>, none, none)
+// CHECK:         instance @[[LABEL]]
@@ -0,0 +1,38 @@
+// RUN: stream-opt %s --convert-stream-to-handshake="reduce-accumulators=2" --split-input-file | FileCheck %s
+
+func.func @reduce_mul(%in: !stream.stream<i64>) -> !stream.stream<i64> {
+  %res = stream.reduce(%in) {initValue = 3 : i64}: (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%acc: i64, %val: i64):
+    %r = arith.muli %val, %acc : i64
+    stream.yield %r : i64
+  }
+  return %res : !stream.stream<i64>
+}
+
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: tuple<i64, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i64, i1>, none, none)
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i64
+// CHECK:         arith.select
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [3]} : i64
+// CHECK:         arith.muli
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [1]} : i64
+// CHECK:         arith.muli
+// CHECK:         arith.muli
+// CHECK:         buffer [2] seq %{{.*}} {initValues = [1, 0]} : i32
+
+// -----
+
+func.func @reduce_sub(%in: !stream.stream<i64>) -> !stream.stream<i64> {
+  %res = stream.reduce(%in) {initValue = 0 : i64}: (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%acc: i64, %val: i64):
+    %r = arith.subi %acc, %val : i64
+    stream.yield %r : i64
+  }
+  return %res : !stream.stream<i64>
+}
+
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: tuple<i64, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i64, i1>, none, none)
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i64
+// CHECK-NOT:     buffer [1]
+// CHECK:         arith.subi
+// CHECK-NOT:     arith.subi
+// CHECK:         buffer [2] seq %{{.*}} {initValues = [1, 0]} : i32
@@ -0,0 +1,39 @@
+// RUN: stream-opt %s --convert-stream-to-handshake --split-input-file | FileCheck %s
+
+func.func @reduce_i8(%in: !stream.stream<i8>) -> !stream.stream<i8> {
+  %res = stream.reduce(%in) {initValue = -1 : i8}: (!stream.stream<i8>) -> !stream.stream<i8> {
+  ^0(%acc: i8, %val: i8):
+    %r = arith.andi %acc, %val : i8
+    stream.yield %r : i8
+  }
+  return %res : !stream.stream<i8>
+}
+
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: tuple<i8, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i8, i1>, none, none)
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [255]} : i8
+// CHECK:         arith.andi %{{.*}}, %{{.*}} : i8
+// CHECK:         pack %{{.*}}, %{{.*}} : tuple<i8, i1>
+
+// -----
+
+func.func @reduce_tuple(%in: !stream.stream<i8>) -> !stream.stream<tuple<i16, i8>> {
+  %res = stream.reduce(%in) {initValue = [0 : i16, 1 : i8]}: (!stream.stream<i8>) -> !stream.stream<tuple<i16, i8>> {
+  ^0(%acc: tuple<i16, i8>, %val: i8):
+    %sum, %cnt = stream.unpack %acc : tuple<i16, i8>
+    %ext = arith.extsi %val : i8 to i16
+    %newSum = arith.addi %sum, %ext : i16
+    %one = arith.constant 1 : i8
+    %newCnt = arith.addi %cnt, %one : i8
+    %r = stream.pack %newSum, %newCnt : tuple<i16, i8>
+    stream.yield %r : tuple<i16, i8>
+  }
+  return %res : !stream.stream<tuple<i16, i8>>
+}
+
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: tuple<i8, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<tuple<i16, i8>, i1>, none, none)
+// CHECK:         unpack %{{.*}} : tuple<i16, i8>
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i16
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [1]} : i8
+// CHECK:         pack %{{.*}}, %{{.*}} : tuple<i16, i8>
+// CHECK:         arith.addi %{{.*}}, %{{.*}} : i16
+// CHECK:         arith.addi %{{.*}}, %{{.*}} : i8
@@ -0,0 +1,37 @@
+// RUN: stream-opt %s --convert-stream-to-handshake | FileCheck %s
+
+// The region is outlined once and instantiated for each replica. The tags are
+// steered along the stages and a FIFO of them selects the results.
+
+// CHECK-LABEL: handshake.func private @stream_map(
+// CHECK:         arith.addi
+// CHECK-LABEL: handshake.func private @stream_map_1(
+// CHECK-SAME:      %{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, none)
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i64
+// CHECK:         constant %{{.*}} {value = 3 : i64} : i64
+// CHECK:         arith.select
+// CHECK:         constant %{{.*}} {value = 0 : i64} : i64
+// CHECK:         cond_br
+// CHECK:         instance @stream_map(
+// CHECK:         buffer [2] fifo %{{.*}} : tuple<i32, i1>
+// CHECK:         buffer [2] fifo %{{.*}} : none
+// CHECK:         constant %{{.*}} {value = 1 : i64} : i64
+// CHECK:         cond_br
+// CHECK:         instance @stream_map(
+// CHECK:         instance @stream_map(
+// CHECK:         buffer [6] fifo %{{.*}} : i64
+// CHECK:         mux %{{.*}} [%{{.*}}, %{{.*}}, %{{.*}}] : i64, tuple<i32, i1>
+// CHECK:         mux %{{.*}} [%{{.*}}, %{{.*}}, %{{.*}}] : i64, none
+// CHECK:         join
+// CHECK-LABEL: handshake.func @replicated(
+// CHECK:         instance @stream_map_1(
+// CHECK-NOT:     instance
+func.func @replicated(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %res = stream.map(%in) {replicas = 3 : i64} : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %0 = arith.constant 1 : i32
+    %r = arith.addi %0, %val : i32
+    stream.yield %r : i32
+  }
+  return %res : !stream.stream<i32>
+}
@@ -0,0 +1,41 @@
+// RUN: stream-opt %s --convert-stream-to-handshake="restartable" --split-input-file | FileCheck %s
+
+func.func @create() -> !stream.stream<i32> {
+  %out = stream.create !stream.stream<i32> [1,2]
+  return %out : !stream.stream<i32>
+}
+
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: none, ...) -> (tuple<i32, i1>, none)
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [1]} : i1
+// CHECK:         mux %{{.*}} [%{{.*}}, %{{.*}}] : i1, none
+// CHECK:         cond_br %{{.*}}, %{{.*}} : none
+// CHECK:         buffer [1] seq %{{.*}} : none
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i64
+// CHECK:         arith.cmpi eq
+// CHECK:         arith.addi
+// CHECK:         constant %{{.*}} {value = 0 : i64} : i64
+// CHECK:         arith.select
+// CHECK-NOT:     buffer [2]
+// CHECK:         mux %{{.*}} [%{{.*}}, %{{.*}}, %{{.*}}] : i64, i32
+
+// -----
+
+func.func @reduce(%in: !stream.stream<i64>) -> !stream.stream<i64> {
+  %res = stream.reduce(%in) {initValue = 7 : i64}: (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%acc: i64, %val: i64):
+    %r = arith.addi %acc, %val : i64
+    stream.yield %r : i64
+  }
+  return %res : !stream.stream<i64>
+}
+
+// CHECK:       handshake.func private @{{.*}}(%{{.*}}: tuple<i64, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i64, i1>, none, none)
+// CHECK:         cond_br %{{.*}}, %{{.*}} : none
+// CHECK:         cond_br %{{.*}}, %{{.*}} : i64
+// CHECK:         constant %{{.*}} {value = 7 : i64} : i64
+// CHECK:         merge %{{.*}}, %{{.*}} : i64
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [7]} : i64
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i1
+// CHECK:         source
+// CHECK:         arith.xori
+// CHECK:         mux %{{.*}} [%{{.*}}, %{{.*}}] : i1, tuple<i64, i1>
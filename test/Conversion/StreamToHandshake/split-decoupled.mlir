@@ -0,0 +1,19 @@
+// RUN: stream-opt %s --convert-stream-to-handshake | FileCheck %s
+
+func.func @split(%in: !stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  %res0, %res1 = stream.split(%in) {bufferDepth = 4 : i64} : (!stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  ^0(%val: tuple<i32, i32>):
+    %0, %1 = stream.unpack %val : tuple<i32, i32>
+    stream.yield %0, %1 : i32, i32
+  }
+  return %res0, %res1 : !stream.stream<i32>, !stream.stream<i32>
+}
+
+// CHECK:       handshake.func private @stream_split(%{{.*}}: tuple<tuple<i32, i32>, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, tuple<i32, i1>, none, none)
+// CHECK:         %[[PACK0:.*]] = pack %{{.*}}#0, %{{.*}}#1 : tuple<i32, i1>
+// CHECK:         %[[PACK1:.*]] = pack %{{.*}}#1, %{{.*}}#0 : tuple<i32, i1>
+// CHECK-DAG:     %[[TUPLE0:.*]] = buffer [4] fifo %[[PACK0]] : tuple<i32, i1>
+// CHECK-DAG:     %[[CTRL0:.*]] = buffer [4] fifo %{{.*}} : none
+// CHECK-DAG:     %[[TUPLE1:.*]] = buffer [4] fifo %[[PACK1]] : tuple<i32, i1>
+// CHECK-DAG:     %[[CTRL1:.*]] = buffer [4] fifo %{{.*}} : none
+// CHECK:         return %[[TUPLE0]], %[[CTRL0]], %[[TUPLE1]], %[[CTRL1]], %{{.*}} : tuple<i32, i1>, none, tuple<i32, i1>, none, none
@@ -0,0 +1,28 @@
+// RUN: stream-opt %s --convert-stream-to-handshake | FileCheck %s
+
+// Already existing symbols are skipped when naming the outlined operations.
+func.func private @stream_map_2()
+
+func.func @names(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %0 = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    stream.yield %val : i32
+  }
+  %1 = stream.map(%0) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    stream.yield %val : i32
+  }
+  %2 = stream.map(%1) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    stream.yield %val : i32
+  }
+  return %2 : !stream.stream<i32>
+}
+
+// CHECK-DAG:   handshake.func private @stream_map(
+// CHECK-DAG:   handshake.func private @stream_map_1(
+// CHECK-DAG:   handshake.func private @stream_map_3(
+// CHECK:       handshake.func @names(
+// CHECK:         instance @stream_map(
+// CHECK:         instance @stream_map_1(
+// CHECK:         instance @stream_map_3(
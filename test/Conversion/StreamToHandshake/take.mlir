@@ -0,0 +1,53 @@
+// RUN: stream-opt %s --convert-stream-to-handshake --split-input-file | FileCheck %s
+
+func.func @take(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %res = stream.take %in count 4 : !stream.stream<i32>
+  return %res : !stream.stream<i32>
+}
+
+// CHECK:       handshake.func private @[[LABEL:.*]](%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, none)
+// CHECK:         unpack %{{.*}} : tuple<i32, i1>
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i64
+// CHECK:         constant %{{.*}} {value = 1 : i64} : i64
+// CHECK:         arith.addi %{{.*}}, %{{.*}} : i64
+// CHECK:         constant %{{.*}} {value = 4 : i64} : i64
+// CHECK:         arith.cmpi ule
+// CHECK:         arith.cmpi eq
+// CHECK:         arith.ori
+// CHECK:         arith.select
+// CHECK:         constant %{{.*}} {value = 0 : i64} : i64
+// CHECK:         arith.select
+// CHECK:         pack %{{.*}}, %{{.*}} : tuple<i32, i1>
+// CHECK:         cond_br %{{.*}}, %{{.*}} : tuple<i32, i1>
+// CHECK:         cond_br %{{.*}}, %{{.*}} : none
+// CHECK:       handshake.func @take(%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, none)
+// CHECK:         instance @[[LABEL]]
+
+// -----
+
+func.func @take_while(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %res = stream.take_while(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val: i32):
+    %c10 = arith.constant 10 : i32
+    %cond = arith.cmpi slt, %val, %c10 : i32
+    stream.yield %cond : i1
+  }
+  return %res : !stream.stream<i32>
+}
+
+// CHECK:       handshake.func private @[[LABEL:.*]](%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, none)
+// CHECK:         unpack %{{.*}} : tuple<i32, i1>
+// CHECK:         arith.cmpi slt, %{{.*}}, %{{.*}} : i32
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i1
+// CHECK:         constant %{{.*}} {value = true} : i1
+// CHECK:         arith.xori
+// CHECK:         arith.xori
+// CHECK:         arith.ori
+// CHECK:         arith.ori
+// CHECK:         constant %{{.*}} {value = false} : i1
+// CHECK:         arith.select
+// CHECK:         pack %{{.*}}, %{{.*}} : tuple<i32, i1>
+// CHECK:         cond_br %{{.*}}, %{{.*}} : tuple<i32, i1>
+// CHECK:         cond_br %{{.*}}, %{{.*}} : none
+// CHECK:       handshake.func @take_while(%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<i32, i1>, none, none)
+// CHECK:         instance @[[LABEL]]
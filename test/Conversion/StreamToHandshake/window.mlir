@@ -0,0 +1,27 @@
+// RUN: stream-opt %s --convert-stream-to-handshake | FileCheck %s
+
+func.func @window(%in: !stream.stream<i32>) -> !stream.stream<tuple<i32, i32, i32>> {
+  %res = stream.window(%in) size 3 stride 2 : (!stream.stream<i32>) -> !stream.stream<tuple<i32, i32, i32>>
+  return %res : !stream.stream<tuple<i32, i32, i32>>
+}
+
+// CHECK:       handshake.func private @[[LABEL:.*]](%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<tuple<i32, i32, i32>, i1>, none, none)
+// CHECK:         %{{.*}}:2 = unpack %{{.*}} : tuple<i32, i1>
+// CHECK:         %{{.*}} = buffer [1] seq %{{.*}} {initValues = [0]} : i32
+// CHECK:         %{{.*}} = buffer [1] seq %{{.*}} {initValues = [0]} : i32
+// CHECK:         buffer [1] seq %{{.*}} {initValues = [0]} : i64
+// CHECK:         constant %{{.*}} {value = 1 : i64} : i64
+// CHECK:         arith.addi %{{.*}}, %{{.*}} : i64
+// CHECK:         constant %{{.*}} {value = 3 : i64} : i64
+// CHECK:         arith.cmpi eq
+// CHECK:         constant %{{.*}} {value = 1 : i64} : i64
+// CHECK:         arith.select
+// CHECK:         constant %{{.*}} {value = 0 : i64} : i64
+// CHECK:         arith.select
+// CHECK:         pack %{{.*}}, %{{.*}}, %{{.*}} : tuple<i32, i32, i32>
+// CHECK:         pack %{{.*}}, %{{.*}} : tuple<tuple<i32, i32, i32>, i1>
+// CHECK:         arith.ori
+// CHECK:         cond_br
+// CHECK:         cond_br
+// CHECK:       handshake.func @window(%{{.*}}: tuple<i32, i1>, %{{.*}}: none, %{{.*}}: none, ...) -> (tuple<tuple<i32, i32, i32>, i1>, none, none)
+// CHECK:         instance @[[LABEL]]
@@ -0,0 +1,80 @@
+// RUN: stream-opt %s --stream-analyze-throughput --verify-diagnostics
+// RUN: stream-opt %s --stream-analyze-throughput=annotate 2>/dev/null | FileCheck %s
+
+// expected-remark @+1 {{estimated initiation interval of 3 cycles and latency of 6 cycles}}
+func.func @reduce(%in: !stream.stream<i64>) -> !stream.stream<i64> {
+  // CHECK: stream.map(%{{.*}}) {throughput = {eosLatency = 2 : i64, ii = 1 : i64, latency = 2 : i64}}
+  %0 = stream.map(%in) : (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%val : i64):
+    %c = arith.constant 1 : i64
+    %r = arith.addi %val, %c : i64
+    stream.yield %r : i64
+  }
+  // CHECK: stream.reduce(%{{.*}}) {initValue = 1 : i64, throughput = {eosLatency = 2 : i64, ii = 3 : i64, latency = 4 : i64}}
+  // expected-remark @+1 {{critical operation with an initiation interval of 3 cycles}}
+  %res = stream.reduce(%0) {initValue = 1 : i64}: (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%acc: i64, %val: i64):
+    %c = arith.constant 3 : i64
+    %e = arith.addi %val, %c : i64
+    %m = arith.muli %acc, %e : i64
+    %r = arith.addi %m, %c : i64
+    stream.yield %r : i64
+  }
+  return %res : !stream.stream<i64>
+}
+
+// expected-remark @+1 {{estimated initiation interval of 4 cycles and latency of 1 cycles}}
+func.func @unbatch(%in: !stream.stream<i8, 4>) -> !stream.stream<i8> {
+  // CHECK: stream.unbatch(%{{.*}}) {throughput = {eosLatency = 1 : i64, ii = 4 : i64, latency = 1 : i64}}
+  // expected-remark @+1 {{critical operation with an initiation interval of 4 cycles}}
+  %res = stream.unbatch(%in) : (!stream.stream<i8, 4>) -> !stream.stream<i8>
+  return %res : !stream.stream<i8>
+}
+
+// expected-remark @+1 {{estimated initiation interval of 1 cycles and latency of 4 cycles}}
+func.func @buffer(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  // CHECK: stream.buffer [3] seq %{{.*}} {throughput = {eosLatency = 3 : i64, ii = 1 : i64, latency = 3 : i64}}
+  // expected-remark @+1 {{critical operation with an initiation interval of 1 cycles}}
+  %0 = stream.buffer [3] seq %in : !stream.stream<i32>
+  // CHECK: stream.buffer [8] fifo %{{.*}} {throughput = {eosLatency = 1 : i64, ii = 1 : i64, latency = 1 : i64}}
+  %res = stream.buffer [8] fifo %0 : !stream.stream<i32>
+  return %res : !stream.stream<i32>
+}
+
+// expected-remark @+1 {{estimated initiation interval of 1 cycles and latency of 5 cycles}}
+func.func @pipelined(%in: !stream.stream<i64>) -> !stream.stream<i64> {
+  // CHECK: stream.map(%{{.*}}) {latency = 4 : i64, throughput = {eosLatency = 5 : i64, ii = 1 : i64, latency = 5 : i64}}
+  // expected-remark @+1 {{critical operation with an initiation interval of 1 cycles}}
+  %res = stream.map(%in) {latency = 4 : i64} : (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%val : i64):
+    %c = arith.constant 1 : i64
+    %r = arith.addi %val, %c : i64
+    stream.yield %r : i64
+  }
+  return %res : !stream.stream<i64>
+}
+
+// expected-remark @+1 {{estimated initiation interval of 1 cycles and latency of 3 cycles}}
+func.func @replicated(%in: !stream.stream<i64>) -> !stream.stream<i64> {
+  // CHECK: stream.map(%{{.*}}) {replicas = 4 : i64, throughput = {eosLatency = 3 : i64, ii = 1 : i64, latency = 3 : i64}}
+  // expected-remark @+1 {{critical operation with an initiation interval of 1 cycles}}
+  %res = stream.map(%in) {replicas = 4 : i64} : (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%val : i64):
+    %c = arith.constant 1 : i64
+    %r = arith.addi %val, %c : i64
+    stream.yield %r : i64
+  }
+  return %res : !stream.stream<i64>
+}
+
+// expected-remark @+1 {{estimated initiation interval of 6 cycles and latency of 5 cycles}}
+func.func @reduce_by_key(%in: !stream.stream<tuple<i8, i64>>) -> !stream.stream<tuple<i8, i64>> {
+  // CHECK: stream.reduce_by_key(%{{.*}}) {capacity = 4 : i64, initValue = 0 : i64, throughput = {eosLatency = 5 : i64, ii = 6 : i64, latency = 5 : i64}}
+  // expected-remark @+1 {{critical operation with an initiation interval of 6 cycles}}
+  %res = stream.reduce_by_key(%in) {capacity = 4 : i64, initValue = 0 : i64}: (!stream.stream<tuple<i8, i64>>) -> !stream.stream<tuple<i8, i64>> {
+  ^0(%acc: i64, %val: i64):
+    %r = arith.addi %acc, %val : i64
+    stream.yield %r : i64
+  }
+  return %res : !stream.stream<tuple<i8, i64>>
+}
@@ -0,0 +1,127 @@
+// RUN: stream-opt %s --stream-buffer-sizing | FileCheck %s
+
+// CHECK-LABEL: func.func @reconvergent
+func.func @reconvergent(%in: !stream.stream<tuple<i32, i32>>) -> !stream.stream<i32> {
+  %left, %right = stream.split(%in) : (!stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  ^0(%val: tuple<i32, i32>):
+    %0, %1 = stream.unpack %val : tuple<i32, i32>
+    stream.yield %0, %1 : i32, i32
+  }
+
+  %mapped = stream.map(%left) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %c = arith.constant 3 : i32
+    %0 = arith.addi %val, %c : i32
+    %1 = arith.muli %0, %c : i32
+    stream.yield %1 : i32
+  }
+
+  // CHECK: %[[BUF:.*]] = stream.buffer [3] fifo %{{.*}} : !stream.stream<i32>
+  // CHECK: stream.combine(%{{.*}}, %[[BUF]])
+  %res = stream.combine(%mapped, %right) : (!stream.stream<i32>, !stream.stream<i32>) -> (!stream.stream<i32>) {
+  ^0(%val0: i32, %val1: i32):
+    %0 = arith.addi %val0, %val1 : i32
+    stream.yield %0 : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+// CHECK-LABEL: func.func @balanced
+func.func @balanced(%in: !stream.stream<tuple<i32, i32>>) -> !stream.stream<i32> {
+  %left, %right = stream.split(%in) : (!stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  ^0(%val: tuple<i32, i32>):
+    %0, %1 = stream.unpack %val : tuple<i32, i32>
+    stream.yield %0, %1 : i32, i32
+  }
+
+  // CHECK-NOT: stream.buffer
+  %res = stream.combine(%left, %right) : (!stream.stream<i32>, !stream.stream<i32>) -> (!stream.stream<i32>) {
+  ^0(%val0: i32, %val1: i32):
+    %0 = arith.addi %val0, %val1 : i32
+    stream.yield %0 : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+// CHECK-LABEL: func.func @existing_fifo
+func.func @existing_fifo(%in: !stream.stream<tuple<i32, i32>>) -> !stream.stream<i32> {
+  %left, %right = stream.split(%in) : (!stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  ^0(%val: tuple<i32, i32>):
+    %0, %1 = stream.unpack %val : tuple<i32, i32>
+    stream.yield %0, %1 : i32, i32
+  }
+
+  %mapped = stream.map(%left) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %c = arith.constant 3 : i32
+    %0 = arith.addi %val, %c : i32
+    %1 = arith.muli %0, %c : i32
+    stream.yield %1 : i32
+  }
+
+  // CHECK: %[[BUF:.*]] = stream.buffer [3] fifo %{{.*}} : !stream.stream<i32>
+  // CHECK-NOT: stream.buffer
+  // CHECK: stream.combine(%{{.*}}, %[[BUF]])
+  %buf = stream.buffer [1] fifo %right : !stream.stream<i32>
+  %res = stream.combine(%mapped, %buf) : (!stream.stream<i32>, !stream.stream<i32>) -> (!stream.stream<i32>) {
+  ^0(%val0: i32, %val1: i32):
+    %0 = arith.addi %val0, %val1 : i32
+    stream.yield %0 : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+// CHECK-LABEL: func.func @existing_pipeline
+func.func @existing_pipeline(%in: !stream.stream<tuple<i32, i32>>) -> !stream.stream<i32> {
+  %left, %right = stream.split(%in) : (!stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  ^0(%val: tuple<i32, i32>):
+    %0, %1 = stream.unpack %val : tuple<i32, i32>
+    stream.yield %0, %1 : i32, i32
+  }
+
+  %mapped = stream.map(%left) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %c = arith.constant 3 : i32
+    %0 = arith.addi %val, %c : i32
+    %1 = arith.muli %0, %c : i32
+    stream.yield %1 : i32
+  }
+
+  // CHECK: %[[SEQ:.*]] = stream.buffer [2] seq %{{.*}} : !stream.stream<i32>
+  // CHECK: %[[BUF:.*]] = stream.buffer [1] fifo %[[SEQ]] : !stream.stream<i32>
+  // CHECK: stream.combine(%{{.*}}, %[[BUF]])
+  %buf = stream.buffer [2] seq %right : !stream.stream<i32>
+  %res = stream.combine(%mapped, %buf) : (!stream.stream<i32>, !stream.stream<i32>) -> (!stream.stream<i32>) {
+  ^0(%val0: i32, %val1: i32):
+    %0 = arith.addi %val0, %val1 : i32
+    stream.yield %0 : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+// CHECK-LABEL: func.func @decoupled_split
+func.func @decoupled_split(%in: !stream.stream<tuple<i32, i32>>) -> !stream.stream<i32> {
+  %left, %right = stream.split(%in) {bufferDepth = 2 : i64} : (!stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  ^0(%val: tuple<i32, i32>):
+    %0, %1 = stream.unpack %val : tuple<i32, i32>
+    stream.yield %0, %1 : i32, i32
+  }
+
+  %mapped = stream.map(%left) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %c = arith.constant 3 : i32
+    %0 = arith.addi %val, %c : i32
+    %1 = arith.muli %0, %c : i32
+    stream.yield %1 : i32
+  }
+
+  // The FIFOs of the split already hold two of the three elements.
+  // CHECK: %[[BUF:.*]] = stream.buffer [1] fifo %{{.*}} : !stream.stream<i32>
+  // CHECK: stream.combine(%{{.*}}, %[[BUF]])
+  %res = stream.combine(%mapped, %right) : (!stream.stream<i32>, !stream.stream<i32>) -> (!stream.stream<i32>) {
+  ^0(%val0: i32, %val1: i32):
+    %0 = arith.addi %val0, %val1 : i32
+    stream.yield %0 : i32
+  }
+  return %res : !stream.stream<i32>
+}
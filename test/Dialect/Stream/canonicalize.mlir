@@ -75,3 +75,344 @@ func.func @unpack_pack_negative(%arg: i32, %other_res: tuple<i32, i64>) {
   "test.foo"(%res, %a, %b) : (tuple<i32, i32>, i32, i64) -> ()
   return
 }
+
+// CHECK-LABEL:   func.func @map_map(
+// CHECK-SAME:                       %[[IN:.*]]: !stream.stream<i32>) -> !stream.stream<i32> {
+// CHECK:           %[[RES:.*]] = stream.map(%[[IN]]) : (!stream.stream<i32>) -> !stream.stream<i32> {
+// CHECK:           ^{{.*}}(%[[VAL:.*]]: i32):
+// CHECK-DAG:         %[[C1:.*]] = arith.constant 1 : i32
+// CHECK-DAG:         %[[C2:.*]] = arith.constant 2 : i32
+// CHECK:             %[[ADD:.*]] = arith.addi %[[VAL]], %[[C1]] : i32
+// CHECK:             %[[MUL:.*]] = arith.muli %[[ADD]], %[[C2]] : i32
+// CHECK:             stream.yield %[[MUL]] : i32
+// CHECK:           }
+// CHECK-NOT:       stream.map
+// CHECK:           return %[[RES]] : !stream.stream<i32>
+func.func @map_map(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %0 = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %c1 = arith.constant 1 : i32
+    %r = arith.addi %val, %c1 : i32
+    stream.yield %r : i32
+  }
+  %1 = stream.map(%0) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %c2 = arith.constant 2 : i32
+    %r = arith.muli %val, %c2 : i32
+    stream.yield %r : i32
+  }
+  return %1 : !stream.stream<i32>
+}
+
+// CHECK-LABEL:   func.func @map_map_replicas(
+// CHECK:           stream.map(%{{.*}}) {replicas = 4 : i64}
+// CHECK:           stream.map(%{{.*}}) : (!stream.stream<i32>) -> !stream.stream<i32>
+func.func @map_map_replicas(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %0 = stream.map(%in) {replicas = 4 : i64} : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %c1 = arith.constant 1 : i32
+    %r = arith.addi %val, %c1 : i32
+    stream.yield %r : i32
+  }
+  %1 = stream.map(%0) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %c2 = arith.constant 2 : i32
+    %r = arith.muli %val, %c2 : i32
+    stream.yield %r : i32
+  }
+  return %1 : !stream.stream<i32>
+}
+
+// CHECK-LABEL:   func.func @map_identity(
+// CHECK-SAME:                            %[[IN:.*]]: !stream.stream<i32>) -> !stream.stream<i32> {
+// CHECK-NEXT:      return %[[IN]] : !stream.stream<i32>
+func.func @map_identity(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %0 = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    stream.yield %val : i32
+  }
+  return %0 : !stream.stream<i32>
+}
+
+// CHECK-LABEL:   func.func @map_multi_use(
+// CHECK-COUNT-2:   stream.map
+func.func @map_multi_use(%in: !stream.stream<i32>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  %0 = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %c1 = arith.constant 1 : i32
+    %r = arith.addi %val, %c1 : i32
+    stream.yield %r : i32
+  }
+  %1 = stream.map(%0) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %r = arith.muli %val, %val : i32
+    stream.yield %r : i32
+  }
+  return %0, %1 : !stream.stream<i32>, !stream.stream<i32>
+}
+
+// CHECK-LABEL:   func.func @filter_filter(
+// CHECK-SAME:                             %[[IN:.*]]: !stream.stream<i32>) -> !stream.stream<i32> {
+// CHECK:           %[[RES:.*]] = stream.filter(%[[IN]]) : (!stream.stream<i32>) -> !stream.stream<i32> {
+// CHECK:             %[[GT:.*]] = arith.cmpi sgt
+// CHECK:             %[[LT:.*]] = arith.cmpi slt
+// CHECK:             %[[AND:.*]] = arith.andi %[[GT]], %[[LT]] : i1
+// CHECK:             stream.yield %[[AND]] : i1
+// CHECK:           }
+// CHECK-NOT:       stream.filter
+// CHECK:           return %[[RES]] : !stream.stream<i32>
+func.func @filter_filter(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %0 = stream.filter(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %c0 = arith.constant 0 : i32
+    %r = arith.cmpi sgt, %val, %c0 : i32
+    stream.yield %r : i1
+  }
+  %1 = stream.filter(%0) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %c10 = arith.constant 10 : i32
+    %r = arith.cmpi slt, %val, %c10 : i32
+    stream.yield %r : i1
+  }
+  return %1 : !stream.stream<i32>
+}
+
+// The division must not be executed for elements the first filter drops.
+// CHECK-LABEL:   func.func @filter_filter_div(
+// CHECK-COUNT-2:   stream.filter
+func.func @filter_filter_div(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %0 = stream.filter(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %c0 = arith.constant 0 : i32
+    %r = arith.cmpi ne, %val, %c0 : i32
+    stream.yield %r : i1
+  }
+  %1 = stream.filter(%0) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %c10 = arith.constant 10 : i32
+    %c1 = arith.constant 1 : i32
+    %d = arith.divsi %c10, %val : i32
+    %r = arith.cmpi sgt, %d, %c1 : i32
+    stream.yield %r : i1
+  }
+  return %1 : !stream.stream<i32>
+}
+
+// CHECK-LABEL:   func.func @map_reduce(
+// CHECK-SAME:                          %[[IN:.*]]: !stream.stream<i64>) -> !stream.stream<i64> {
+// CHECK:           %[[RES:.*]] = stream.reduce(%[[IN]]) {initValue = 0 : i64} : (!stream.stream<i64>) -> !stream.stream<i64> {
+// CHECK:           ^{{.*}}(%[[ACC:.*]]: i64, %[[VAL:.*]]: i64):
+// CHECK:             %[[SQ:.*]] = arith.muli %[[VAL]], %[[VAL]] : i64
+// CHECK:             %[[DIFF:.*]] = arith.subi %[[ACC]], %[[SQ]] : i64
+// CHECK:             stream.yield %[[DIFF]] : i64
+// CHECK:           }
+// CHECK-NOT:       stream.map
+// CHECK:           return %[[RES]] : !stream.stream<i64>
+func.func @map_reduce(%in: !stream.stream<i64>) -> !stream.stream<i64> {
+  %0 = stream.map(%in) : (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%val : i64):
+    %r = arith.muli %val, %val : i64
+    stream.yield %r : i64
+  }
+  %1 = stream.reduce(%0) {initValue = 0 : i64}: (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%acc: i64, %val: i64):
+    %r = arith.subi %acc, %val : i64
+    stream.yield %r : i64
+  }
+  return %1 : !stream.stream<i64>
+}
+
+// An associative reduction keeps its region, such that it can still be
+// lowered with interleaved accumulators.
+// CHECK-LABEL:   func.func @map_reduce_associative(
+// CHECK-SAME:                                      %[[IN:.*]]: !stream.stream<i64>) -> !stream.stream<i64> {
+// CHECK:           %[[MAP:.*]] = stream.map(%[[IN]])
+// CHECK:           %[[RES:.*]] = stream.reduce(%[[MAP]]) {initValue = 0 : i64} : (!stream.stream<i64>) -> !stream.stream<i64> {
+// CHECK:           ^{{.*}}(%[[ACC:.*]]: i64, %[[VAL:.*]]: i64):
+// CHECK:             %[[SUM:.*]] = arith.addi %[[ACC]], %[[VAL]] : i64
+// CHECK:             stream.yield %[[SUM]] : i64
+// CHECK:           }
+// CHECK:           return %[[RES]] : !stream.stream<i64>
+func.func @map_reduce_associative(%in: !stream.stream<i64>) -> !stream.stream<i64> {
+  %0 = stream.map(%in) : (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%val : i64):
+    %r = arith.muli %val, %val : i64
+    stream.yield %r : i64
+  }
+  %1 = stream.reduce(%0) {initValue = 0 : i64}: (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%acc: i64, %val: i64):
+    %r = arith.addi %acc, %val : i64
+    stream.yield %r : i64
+  }
+  return %1 : !stream.stream<i64>
+}
+
+// CHECK-LABEL:   func.func @split_sink(
+// CHECK-SAME:                          %[[IN:.*]]: !stream.stream<tuple<i32, i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+// CHECK:           %[[RES:.*]]:2 = stream.split(%[[IN]]) : (!stream.stream<tuple<i32, i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+// CHECK:             %[[F:.*]]:3 = stream.unpack %{{.*}} : tuple<i32, i32, i32>
+// CHECK:             stream.yield %[[F]]#0, %[[F]]#2 : i32, i32
+// CHECK:           }
+// CHECK-NOT:       stream.sink
+// CHECK:           return %[[RES]]#0, %[[RES]]#1 : !stream.stream<i32>, !stream.stream<i32>
+func.func @split_sink(%in: !stream.stream<tuple<i32, i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  %0, %1, %2 = stream.split(%in) : (!stream.stream<tuple<i32, i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>, !stream.stream<i32>) {
+  ^0(%val: tuple<i32, i32, i32>):
+    %a, %b, %c = stream.unpack %val : tuple<i32, i32, i32>
+    stream.yield %a, %b, %c : i32, i32, i32
+  }
+  stream.sink %1 : !stream.stream<i32>
+  return %0, %2 : !stream.stream<i32>, !stream.stream<i32>
+}
+
+// CHECK-LABEL:   func.func @split_sink_single(
+// CHECK-SAME:                                 %[[IN:.*]]: !stream.stream<tuple<i32, i64>>) -> !stream.stream<i64> {
+// CHECK:           %[[RES:.*]] = stream.map(%[[IN]]) : (!stream.stream<tuple<i32, i64>>) -> !stream.stream<i64> {
+// CHECK:             %[[F:.*]]:2 = stream.unpack %{{.*}} : tuple<i32, i64>
+// CHECK:             stream.yield %[[F]]#1 : i64
+// CHECK:           }
+// CHECK-NOT:       stream.split
+// CHECK:           return %[[RES]] : !stream.stream<i64>
+func.func @split_sink_single(%in: !stream.stream<tuple<i32, i64>>) -> !stream.stream<i64> {
+  %0, %1 = stream.split(%in) : (!stream.stream<tuple<i32, i64>>) -> (!stream.stream<i32>, !stream.stream<i64>) {
+  ^0(%val: tuple<i32, i64>):
+    %a, %b = stream.unpack %val : tuple<i32, i64>
+    stream.yield %a, %b : i32, i64
+  }
+  stream.sink %0 : !stream.stream<i32>
+  return %1 : !stream.stream<i64>
+}
+
+// CHECK-LABEL:   func.func @split_combine_repack(
+// CHECK-SAME:                                    %[[IN:.*]]: !stream.stream<tuple<i32, i64>>) -> !stream.stream<tuple<i32, i64>> {
+// CHECK-NEXT:      return %[[IN]] : !stream.stream<tuple<i32, i64>>
+func.func @split_combine_repack(%in: !stream.stream<tuple<i32, i64>>) -> !stream.stream<tuple<i32, i64>> {
+  %0, %1 = stream.split(%in) : (!stream.stream<tuple<i32, i64>>) -> (!stream.stream<i32>, !stream.stream<i64>) {
+  ^0(%val: tuple<i32, i64>):
+    %a, %b = stream.unpack %val : tuple<i32, i64>
+    stream.yield %a, %b : i32, i64
+  }
+  %res = stream.combine(%0, %1) : (!stream.stream<i32>, !stream.stream<i64>) -> (!stream.stream<tuple<i32, i64>>) {
+  ^0(%a: i32, %b: i64):
+    %t = stream.pack %a, %b : tuple<i32, i64>
+    stream.yield %t : tuple<i32, i64>
+  }
+  return %res : !stream.stream<tuple<i32, i64>>
+}
+
+// CHECK-LABEL:   func.func @split_combine_swap(
+// CHECK-SAME:                                  %[[IN:.*]]: !stream.stream<tuple<i32, i32>>) -> !stream.stream<tuple<i32, i32>> {
+// CHECK:           %[[RES:.*]] = stream.map(%[[IN]]) : (!stream.stream<tuple<i32, i32>>) -> !stream.stream<tuple<i32, i32>> {
+// CHECK:             %[[F:.*]]:2 = stream.unpack %{{.*}} : tuple<i32, i32>
+// CHECK:             %[[T:.*]] = stream.pack %[[F]]#1, %[[F]]#0 : tuple<i32, i32>
+// CHECK:             stream.yield %[[T]] : tuple<i32, i32>
+// CHECK:           }
+// CHECK-NOT:       stream.combine
+// CHECK:           return %[[RES]] : !stream.stream<tuple<i32, i32>>
+func.func @split_combine_swap(%in: !stream.stream<tuple<i32, i32>>) -> !stream.stream<tuple<i32, i32>> {
+  %0, %1 = stream.split(%in) : (!stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  ^0(%val: tuple<i32, i32>):
+    %a, %b = stream.unpack %val : tuple<i32, i32>
+    stream.yield %a, %b : i32, i32
+  }
+  %res = stream.combine(%1, %0) : (!stream.stream<i32>, !stream.stream<i32>) -> (!stream.stream<tuple<i32, i32>>) {
+  ^0(%b: i32, %a: i32):
+    %t = stream.pack %b, %a : tuple<i32, i32>
+    stream.yield %t : tuple<i32, i32>
+  }
+  return %res : !stream.stream<tuple<i32, i32>>
+}
+
+// CHECK-LABEL:   func.func @batch_unbatch(
+// CHECK-SAME:                             %[[IN:.*]]: !stream.stream<i8>) -> (!stream.stream<i8>, !stream.stream<i8, 4>) {
+// CHECK:           %[[WIDE:.*]] = stream.batch(%[[IN]]) : (!stream.stream<i8>) -> !stream.stream<i8, 4>
+// CHECK-NOT:       stream.unbatch
+// CHECK:           return %[[IN]], %[[WIDE]] : !stream.stream<i8>, !stream.stream<i8, 4>
+func.func @batch_unbatch(%in: !stream.stream<i8>) -> (!stream.stream<i8>, !stream.stream<i8, 4>) {
+  %wide = stream.batch(%in) : (!stream.stream<i8>) -> !stream.stream<i8, 4>
+  %res = stream.unbatch(%wide) : (!stream.stream<i8, 4>) -> !stream.stream<i8>
+  %single = stream.batch(%res) : (!stream.stream<i8>) -> !stream.stream<i8>
+  return %single, %wide : !stream.stream<i8>, !stream.stream<i8, 4>
+}
+
+// CHECK-LABEL:   func.func @merge_single(
+// CHECK-SAME:                            %[[IN:.*]]: !stream.stream<i32>) -> !stream.stream<i32> {
+// CHECK-NEXT:      return %[[IN]] : !stream.stream<i32>
+func.func @merge_single(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %res = stream.merge %in : !stream.stream<i32>
+  return %res : !stream.stream<i32>
+}
+
+// CHECK-LABEL:   func.func @take_take(
+// CHECK-SAME:                         %[[IN:.*]]: !stream.stream<i32>) -> !stream.stream<i32> {
+// CHECK-NEXT:      %[[RES:.*]] = stream.take %[[IN]] count 3 : !stream.stream<i32>
+// CHECK-NEXT:      return %[[RES]] : !stream.stream<i32>
+func.func @take_take(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %0 = stream.take %in count 3 : !stream.stream<i32>
+  %res = stream.take %0 count 5 : !stream.stream<i32>
+  return %res : !stream.stream<i32>
+}
+
+// CHECK-LABEL:   func.func @take_sources() -> (!stream.stream<i32>, !stream.stream<i32>, !stream.stream<i32>) {
+// CHECK-DAG:       %[[IOTA:.*]] = stream.iota start 0 step 2 count 3 : !stream.stream<i32>
+// CHECK-DAG:       %[[CREATE:.*]] = stream.create !stream.stream<i32> [1, 2]
+// CHECK-DAG:       %[[SHORT:.*]] = stream.iota start 0 step 1 count 2 : !stream.stream<i32>
+// CHECK-NOT:       stream.take
+// CHECK:           return %[[IOTA]], %[[CREATE]], %[[SHORT]]
+func.func @take_sources() -> (!stream.stream<i32>, !stream.stream<i32>, !stream.stream<i32>) {
+  %iota = stream.iota start 0 step 2 count 100 : !stream.stream<i32>
+  %0 = stream.take %iota count 3 : !stream.stream<i32>
+  %create = stream.create !stream.stream<i32> [1, 2, 3, 4]
+  %1 = stream.take %create count 2 : !stream.stream<i32>
+  %short = stream.iota start 0 step 1 count 2 : !stream.stream<i32>
+  %2 = stream.take %short count 8 : !stream.stream<i32>
+  return %0, %1, %2 : !stream.stream<i32>, !stream.stream<i32>, !stream.stream<i32>
+}
+
+// CHECK-LABEL:   func.func @take_map(
+// CHECK-SAME:                        %[[IN:.*]]: !stream.stream<i32>) -> !stream.stream<i64> {
+// CHECK-NEXT:      %[[TAKE:.*]] = stream.take %[[IN]] count 4 : !stream.stream<i32>
+// CHECK-NEXT:      %[[RES:.*]] = stream.map(%[[TAKE]]) : (!stream.stream<i32>) -> !stream.stream<i64> {
+// CHECK:           }
+// CHECK-NEXT:      return %[[RES]] : !stream.stream<i64>
+func.func @take_map(%in: !stream.stream<i32>) -> !stream.stream<i64> {
+  %0 = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<i64> {
+  ^0(%val : i32):
+    %e = arith.extsi %val : i32 to i64
+    stream.yield %e : i64
+  }
+  %res = stream.take %0 count 4 : !stream.stream<i64>
+  return %res : !stream.stream<i64>
+}
+
+// CHECK-LABEL:   func.func @take_split(
+// CHECK-SAME:                          %[[IN:.*]]: !stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+// CHECK-NEXT:      %[[TAKE:.*]] = stream.take %[[IN]] count 2 : !stream.stream<tuple<i32, i32>>
+// CHECK-NEXT:      %[[RES:.*]]:2 = stream.split(%[[TAKE]])
+// CHECK-NOT:       stream.take
+// CHECK:           return %[[RES]]#0, %[[RES]]#1 : !stream.stream<i32>, !stream.stream<i32>
+func.func @take_split(%in: !stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  %0, %1 = stream.split(%in) : (!stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  ^0(%val: tuple<i32, i32>):
+    %a, %b = stream.unpack %val : tuple<i32, i32>
+    stream.yield %a, %b : i32, i32
+  }
+  %res0 = stream.take %0 count 2 : !stream.stream<i32>
+  %res1 = stream.take %1 count 2 : !stream.stream<i32>
+  return %res0, %res1 : !stream.stream<i32>, !stream.stream<i32>
+}
+
+// CHECK-LABEL:   func.func @take_split_different(
+// CHECK:           stream.split(%{{.*}})
+// CHECK:           stream.take %{{.*}} count 2 : !stream.stream<i32>
+// CHECK:           stream.take %{{.*}} count 3 : !stream.stream<i32>
+func.func @take_split_different(%in: !stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  %0, %1 = stream.split(%in) : (!stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  ^0(%val: tuple<i32, i32>):
+    %a, %b = stream.unpack %val : tuple<i32, i32>
+    stream.yield %a, %b : i32, i32
+  }
+  %res0 = stream.take %0 count 2 : !stream.stream<i32>
+  %res1 = stream.take %1 count 3 : !stream.stream<i32>
+  return %res0, %res1 : !stream.stream<i32>, !stream.stream<i32>
+}
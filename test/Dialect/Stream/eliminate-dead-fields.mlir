@@ -0,0 +1,157 @@
+// RUN: stream-opt %s --stream-eliminate-dead-fields --split-input-file | FileCheck %s
+
+// The multiplication that computed the unused field is removed.
+
+// CHECK-LABEL: func.func @map
+// CHECK:         %[[T:.*]] = stream.map(%{{.*}}) : (!stream.stream<i32>) -> !stream.stream<tuple<i32>> {
+// CHECK-NEXT:    ^{{.*}}(%[[VAL:.*]]: i32):
+// CHECK-NEXT:      %[[P:.*]] = stream.pack %[[VAL]] : tuple<i32>
+// CHECK-NEXT:      stream.yield %[[P]] : tuple<i32>
+// CHECK:         stream.map(%[[T]]) : (!stream.stream<tuple<i32>>) -> !stream.stream<i32> {
+// CHECK-NEXT:    ^{{.*}}(%[[ARG:.*]]: tuple<i32>):
+// CHECK-NEXT:      %[[F:.*]] = stream.unpack %[[ARG]] : tuple<i32>
+// CHECK-NEXT:      stream.yield %[[F]] : i32
+func.func @map(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %t = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<tuple<i32, i32>> {
+  ^0(%val : i32):
+    %c3 = arith.constant 3 : i32
+    %m = arith.muli %val, %c3 : i32
+    %p = stream.pack %val, %m : tuple<i32, i32>
+    stream.yield %p : tuple<i32, i32>
+  }
+  %res = stream.map(%t) : (!stream.stream<tuple<i32, i32>>) -> !stream.stream<i32> {
+  ^0(%val : tuple<i32, i32>):
+    %a, %b = stream.unpack %val : tuple<i32, i32>
+    stream.yield %a : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+// -----
+
+// The sunk result of the split is removed, which turns it into a map. The
+// fields that are dropped from its output are dropped from its input, too.
+
+// CHECK-LABEL: func.func @split
+// CHECK:         %[[T:.*]] = stream.map(%{{.*}}) : (!stream.stream<i32>) -> !stream.stream<tuple<i32>> {
+// CHECK-NOT:       arith.muli
+// CHECK:           %[[P:.*]] = stream.pack %{{.*}} : tuple<i32>
+// CHECK-NEXT:      stream.yield %[[P]] : tuple<i32>
+// CHECK:         %[[A:.*]] = stream.map(%[[T]]) : (!stream.stream<tuple<i32>>) -> !stream.stream<tuple<i32>> {
+// CHECK-NEXT:    ^{{.*}}(%[[ARG:.*]]: tuple<i32>):
+// CHECK-NEXT:      %[[F:.*]] = stream.unpack %[[ARG]] : tuple<i32>
+// CHECK-NEXT:      %[[P:.*]] = stream.pack %[[F]] : tuple<i32>
+// CHECK-NEXT:      stream.yield %[[P]] : tuple<i32>
+// CHECK:         stream.map(%[[A]]) : (!stream.stream<tuple<i32>>) -> !stream.stream<i32>
+// CHECK-NOT:     stream.sink
+func.func @split(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %t = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<tuple<i32, i32, i32>> {
+  ^0(%val : i32):
+    %c2 = arith.constant 2 : i32
+    %c3 = arith.constant 3 : i32
+    %m2 = arith.muli %val, %c2 : i32
+    %m3 = arith.muli %val, %c3 : i32
+    %p = stream.pack %val, %m2, %m3 : tuple<i32, i32, i32>
+    stream.yield %p : tuple<i32, i32, i32>
+  }
+  %a, %b = stream.split(%t) : (!stream.stream<tuple<i32, i32, i32>>) -> (!stream.stream<tuple<i32, i32>>, !stream.stream<i32>) {
+  ^0(%val : tuple<i32, i32, i32>):
+    %f0, %f1, %f2 = stream.unpack %val : tuple<i32, i32, i32>
+    %p = stream.pack %f0, %f1 : tuple<i32, i32>
+    stream.yield %p, %f2 : tuple<i32, i32>, i32
+  }
+  stream.sink %b : !stream.stream<i32>
+  %res = stream.map(%a) : (!stream.stream<tuple<i32, i32>>) -> !stream.stream<i32> {
+  ^0(%val : tuple<i32, i32>):
+    %x, %y = stream.unpack %val : tuple<i32, i32>
+    stream.yield %x : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+// -----
+
+// The fields used by the consumers of a filter are kept.
+
+// CHECK-LABEL: func.func @filter
+// CHECK:         %[[T:.*]] = stream.map(%{{.*}}) : (!stream.stream<i32>) -> !stream.stream<tuple<i32, i32>> {
+// CHECK:           %[[P:.*]] = stream.pack %{{.*}}, %{{.*}} : tuple<i32, i32>
+// CHECK-NEXT:      stream.yield %[[P]] : tuple<i32, i32>
+// CHECK:         %[[F:.*]] = stream.filter(%[[T]]) : (!stream.stream<tuple<i32, i32>>) -> !stream.stream<tuple<i32, i32>> {
+// CHECK-NEXT:    ^{{.*}}(%[[ARG:.*]]: tuple<i32, i32>):
+// CHECK-NEXT:      %{{.*}}:2 = stream.unpack %[[ARG]] : tuple<i32, i32>
+// CHECK:         %[[B:.*]] = stream.buffer [4] fifo %[[F]] : !stream.stream<tuple<i32, i32>>
+// CHECK:         stream.map(%[[B]]) : (!stream.stream<tuple<i32, i32>>) -> !stream.stream<i32> {
+func.func @filter(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %t = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<tuple<i32, i32, i32>> {
+  ^0(%val : i32):
+    %c2 = arith.constant 2 : i32
+    %c3 = arith.constant 3 : i32
+    %m2 = arith.muli %val, %c2 : i32
+    %m3 = arith.muli %val, %c3 : i32
+    %p = stream.pack %val, %m2, %m3 : tuple<i32, i32, i32>
+    stream.yield %p : tuple<i32, i32, i32>
+  }
+  %f = stream.filter(%t) : (!stream.stream<tuple<i32, i32, i32>>) -> !stream.stream<tuple<i32, i32, i32>> {
+  ^0(%val : tuple<i32, i32, i32>):
+    %f0, %f1, %f2 = stream.unpack %val : tuple<i32, i32, i32>
+    %c0 = arith.constant 0 : i32
+    %cond = arith.cmpi sgt, %f0, %c0 : i32
+    stream.yield %cond : i1
+  }
+  %b = stream.buffer [4] fifo %f : !stream.stream<tuple<i32, i32, i32>>
+  %res = stream.map(%b) : (!stream.stream<tuple<i32, i32, i32>>) -> !stream.stream<i32> {
+  ^0(%val : tuple<i32, i32, i32>):
+    %x, %y, %z = stream.unpack %val : tuple<i32, i32, i32>
+    stream.yield %z : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+// -----
+
+// Each input of a combine is narrowed on its own.
+
+// CHECK-LABEL: func.func @combine
+// CHECK:         stream.combine(%{{.*}}, %{{.*}}) : (!stream.stream<tuple<i32>>, !stream.stream<tuple<i64>>) -> (!stream.stream<i64>) {
+// CHECK-NEXT:    ^{{.*}}(%[[LHS:.*]]: tuple<i32>, %[[RHS:.*]]: tuple<i64>):
+// CHECK-NEXT:      %{{.*}} = stream.unpack %[[LHS]] : tuple<i32>
+// CHECK-NEXT:      %{{.*}} = stream.unpack %[[RHS]] : tuple<i64>
+func.func @combine(%in0: !stream.stream<i32>, %in1: !stream.stream<i64>) -> !stream.stream<i64> {
+  %l = stream.map(%in0) : (!stream.stream<i32>) -> !stream.stream<tuple<i32, i64>> {
+  ^0(%val : i32):
+    %e = arith.extsi %val : i32 to i64
+    %p = stream.pack %val, %e : tuple<i32, i64>
+    stream.yield %p : tuple<i32, i64>
+  }
+  %r = stream.map(%in1) : (!stream.stream<i64>) -> !stream.stream<tuple<i32, i64>> {
+  ^0(%val : i64):
+    %t = arith.trunci %val : i64 to i32
+    %p = stream.pack %t, %val : tuple<i32, i64>
+    stream.yield %p : tuple<i32, i64>
+  }
+  %res = stream.combine(%l, %r) : (!stream.stream<tuple<i32, i64>>, !stream.stream<tuple<i32, i64>>) -> (!stream.stream<i64>) {
+  ^0(%lhs : tuple<i32, i64>, %rhs : tuple<i32, i64>):
+    %l0, %l1 = stream.unpack %lhs : tuple<i32, i64>
+    %r0, %r1 = stream.unpack %rhs : tuple<i32, i64>
+    %e = arith.extsi %l0 : i32 to i64
+    %s = arith.addi %e, %r1 : i64
+    stream.yield %s : i64
+  }
+  return %res : !stream.stream<i64>
+}
+
+// -----
+
+// Streams that are returned keep all of their fields.
+
+// CHECK-LABEL: func.func @returned
+// CHECK:         stream.map(%{{.*}}) : (!stream.stream<i32>) -> !stream.stream<tuple<i32, i32>>
+func.func @returned(%in: !stream.stream<i32>) -> !stream.stream<tuple<i32, i32>> {
+  %t = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<tuple<i32, i32>> {
+  ^0(%val : i32):
+    %p = stream.pack %val, %val : tuple<i32, i32>
+    stream.yield %p : tuple<i32, i32>
+  }
+  return %t : !stream.stream<tuple<i32, i32>>
+}
@@ -1,8 +1,8 @@
 // RUN: stream-opt %s --split-input-file --verify-diagnostics
 
 func.func @create_wrong_type() {
-  // expected-error @+1 {{element #1's type does not match the type of the stream: expected 'i32' got 'i64'}}
-  %0 = "stream.create"() {values = [1 : i32, 2 : i64, 3 : i32, 4 : i32]} : () -> !stream.stream<i32>
+  // expected-error @+1 {{the type of the values does not match the type of the stream: expected 'i32' got 'i64'}}
+  %0 = "stream.create"() {values = dense<[1, 2, 3, 4]> : tensor<4xi64>} : () -> !stream.stream<i32>
 }
 
 // -----
@@ -136,3 +136,330 @@ func.func @combine_wrong_input_types(%in0: !stream.stream<i32>, %in1: !stream.st
     return %res : !stream.stream<tuple<i32, i32>>
   }
 
+// -----
+
+// expected-error @+1 {{expect a stream to have at least one lane}}
+func.func @zero_lanes(%in: !stream.stream<i32, 0>) {
+  return
+}
+
+// -----
+
+func.func @map_lanes_mismatch(%in: !stream.stream<i32, 4>) -> !stream.stream<i32, 2> {
+  // expected-error @+1 {{expect all streams to have the same number of lanes}}
+  %res = stream.map(%in) : (!stream.stream<i32, 4>) -> !stream.stream<i32, 2> {
+  ^0(%val : i32):
+    stream.yield %val : i32
+  }
+  return %res : !stream.stream<i32, 2>
+}
+
+// -----
+
+func.func @reduce_lanes_result(%in: !stream.stream<i64, 4>) -> !stream.stream<i64, 4> {
+  // expected-error @+1 {{expect the result stream to have a single lane}}
+  %res = stream.reduce(%in) {initValue = 0 : i64}: (!stream.stream<i64, 4>) -> !stream.stream<i64, 4> {
+  ^0(%acc: i64, %val: i64):
+    %r = arith.addi %acc, %val : i64
+    stream.yield %r : i64
+  }
+  return %res : !stream.stream<i64, 4>
+}
+
+// -----
+
+func.func @reduce_init_type(%in: !stream.stream<i8>) -> !stream.stream<i8> {
+  // expected-error @+1 {{expect the initial value to be an integer of type 'i8'}}
+  %res = stream.reduce(%in) {initValue = 0 : i64}: (!stream.stream<i8>) -> !stream.stream<i8> {
+  ^0(%acc: i8, %val: i8):
+    %r = arith.addi %acc, %val : i8
+    stream.yield %r : i8
+  }
+  return %res : !stream.stream<i8>
+}
+
+// -----
+
+func.func @reduce_init_tuple(%in: !stream.stream<i8>) -> !stream.stream<tuple<i16, i8>> {
+  // expected-error @+1 {{expect the initial value to be an array of 2 elements}}
+  %res = stream.reduce(%in) {initValue = [0 : i16]}: (!stream.stream<i8>) -> !stream.stream<tuple<i16, i8>> {
+  ^0(%acc: tuple<i16, i8>, %val: i8):
+    stream.yield %acc : tuple<i16, i8>
+  }
+  return %res : !stream.stream<tuple<i16, i8>>
+}
+
+// -----
+
+func.func @create_rank() {
+  // expected-error @+1 {{expect the values to be one-dimensional}}
+  %0 = "stream.create"() {values = dense<[[1, 2], [3, 4]]> : tensor<2x2xi32>} : () -> !stream.stream<i32>
+}
+
+// -----
+
+func.func @iota_count() {
+  // expected-error @+1 {{expect a non-negative number of elements}}
+  %0 = stream.iota start 0 step 1 count -1 : !stream.stream<i32>
+}
+
+// -----
+
+func.func @window_size(%in: !stream.stream<i32>) -> !stream.stream<tuple<>> {
+  // expected-error @+1 {{expect a window size of at least one}}
+  %res = stream.window(%in) size 0 stride 1 : (!stream.stream<i32>) -> !stream.stream<tuple<>>
+  return %res : !stream.stream<tuple<>>
+}
+
+// -----
+
+func.func @window_stride(%in: !stream.stream<i32>) -> !stream.stream<tuple<i32>> {
+  // expected-error @+1 {{expect a stride of at least one}}
+  %res = stream.window(%in) size 1 stride 0 : (!stream.stream<i32>) -> !stream.stream<tuple<i32>>
+  return %res : !stream.stream<tuple<i32>>
+}
+
+// -----
+
+func.func @window_type(%in: !stream.stream<i32>) -> !stream.stream<tuple<i32, i64>> {
+  // expected-error @+1 {{expect the result elements to be tuples of 2 elements of type 'i32'}}
+  %res = stream.window(%in) size 2 stride 1 : (!stream.stream<i32>) -> !stream.stream<tuple<i32, i64>>
+  return %res : !stream.stream<tuple<i32, i64>>
+}
+
+// -----
+
+func.func @window_lanes(%in: !stream.stream<i32, 2>) -> !stream.stream<tuple<i32, i32>, 2> {
+  // expected-error @+1 {{expect single-lane streams}}
+  %res = stream.window(%in) size 2 stride 1 : (!stream.stream<i32, 2>) -> !stream.stream<tuple<i32, i32>, 2>
+  return %res : !stream.stream<tuple<i32, i32>, 2>
+}
+
+// -----
+
+func.func @batch_lanes(%in: !stream.stream<i32, 2>) -> !stream.stream<i32, 4> {
+  // expected-error @+1 {{expect the input to have a single lane, got 2}}
+  %res = stream.batch(%in) : (!stream.stream<i32, 2>) -> !stream.stream<i32, 4>
+  return %res : !stream.stream<i32, 4>
+}
+
+// -----
+
+func.func @batch_type(%in: !stream.stream<i32>) -> !stream.stream<i64, 4> {
+  // expected-error @+1 {{expect both streams to have the same element type}}
+  %res = stream.batch(%in) : (!stream.stream<i32>) -> !stream.stream<i64, 4>
+  return %res : !stream.stream<i64, 4>
+}
+
+// -----
+
+func.func @unbatch_lanes(%in: !stream.stream<i32, 4>) -> !stream.stream<i32, 2> {
+  // expected-error @+1 {{expect the result to have a single lane, got 2}}
+  %res = stream.unbatch(%in) : (!stream.stream<i32, 4>) -> !stream.stream<i32, 2>
+  return %res : !stream.stream<i32, 2>
+}
+
+// -----
+
+func.func @load_type(%mem: memref<16xi32>) -> !stream.stream<i64> {
+  // expected-error @+1 {{expect the stream and the memref to have the same element type}}
+  %out = stream.load %mem[start 0 stride 1 count 4] : memref<16xi32> -> !stream.stream<i64>
+  return %out : !stream.stream<i64>
+}
+
+// -----
+
+func.func @load_rank(%mem: memref<4x4xi32>) -> !stream.stream<i32> {
+  // expected-error @+1 {{expect a one-dimensional memref}}
+  %out = stream.load %mem[start 0 stride 1 count 4] : memref<4x4xi32> -> !stream.stream<i32>
+  return %out : !stream.stream<i32>
+}
+
+// -----
+
+func.func @load_bounds(%mem: memref<16xi32>) -> !stream.stream<i32> {
+  // expected-error @+1 {{expect the accessed indices to be within the bounds of the memref}}
+  %out = stream.load %mem[start 1 stride 2 count 9] : memref<16xi32> -> !stream.stream<i32>
+  return %out : !stream.stream<i32>
+}
+
+// -----
+
+func.func @store_lanes(%in: !stream.stream<i32, 2>, %mem: memref<16xi32>) {
+  // expected-error @+1 {{expect a single-lane stream}}
+  stream.store %in, %mem[start 0 stride 1] : !stream.stream<i32, 2>, memref<16xi32>
+  return
+}
+
+// -----
+
+func.func @buffer_depth(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  // expected-error @+1 {{expect a depth of at least one}}
+  %res = stream.buffer [0] fifo %in : !stream.stream<i32>
+  return %res : !stream.stream<i32>
+}
+
+// -----
+
+func.func @merge_types(%in0: !stream.stream<i32>, %in1: !stream.stream<i64>) -> !stream.stream<i32> {
+  // expected-error @+1 {{requires the same type for all operands and results}}
+  %res = "stream.merge"(%in0, %in1) : (!stream.stream<i32>, !stream.stream<i64>) -> !stream.stream<i32>
+  return %res : !stream.stream<i32>
+}
+
+// -----
+
+func.func @split_buffer_depth(%in: !stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  // expected-error @+1 {{expect a buffer depth of at least one}}
+  %res0, %res1 = stream.split(%in) {bufferDepth = 0 : i64} : (!stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  ^0(%val: tuple<i32, i32>):
+    %0, %1 = stream.unpack %val : tuple<i32, i32>
+    stream.yield %0, %1 : i32, i32
+  }
+  return %res0, %res1 : !stream.stream<i32>, !stream.stream<i32>
+}
+
+// -----
+
+func.func @map_latency(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  // expected-error @+1 {{expect a non-negative latency}}
+  %res = stream.map(%in) {latency = -1 : i64} : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    stream.yield %val : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+// -----
+
+func.func @take_count(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  // expected-error @+1 {{expect a count of at least one}}
+  %res = stream.take %in count 0 : !stream.stream<i32>
+  return %res : !stream.stream<i32>
+}
+
+// -----
+
+func.func @take_lanes(%in: !stream.stream<i32, 4>) -> !stream.stream<i32, 4> {
+  // expected-error @+1 {{expect a single-lane stream}}
+  %res = stream.take %in count 2 : !stream.stream<i32, 4>
+  return %res : !stream.stream<i32, 4>
+}
+
+// -----
+
+func.func @take_while_type(%in: !stream.stream<i32>) -> !stream.stream<i64> {
+  // expected-error @+1 {{expect the result to have the type of the input}}
+  %res = stream.take_while(%in) : (!stream.stream<i32>) -> !stream.stream<i64> {
+  ^0(%val: i32):
+    %c0 = arith.constant 0 : i32
+    %cond = arith.cmpi sgt, %val, %c0 : i32
+    stream.yield %cond : i1
+  }
+  return %res : !stream.stream<i64>
+}
+
+// -----
+
+func.func @take_while_predicate(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  %res = stream.take_while(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val: i32):
+    // expected-error @+1 {{expect the operand #0 to have type 'i1', got 'i32' instead.}}
+    stream.yield %val : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+// -----
+
+func.func @map_replicas(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+  // expected-error @+1 {{expect at least one replica}}
+  %res = stream.map(%in) {replicas = 0 : i64} : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    stream.yield %val : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+// -----
+
+func.func @map_replicas_lanes(%in: !stream.stream<i32, 2>) -> !stream.stream<i32, 2> {
+  // expected-error @+1 {{expect a single-lane stream for replicas}}
+  %res = stream.map(%in) {replicas = 2 : i64} : (!stream.stream<i32, 2>) -> !stream.stream<i32, 2> {
+  ^0(%val : i32):
+    stream.yield %val : i32
+  }
+  return %res : !stream.stream<i32, 2>
+}
+
+// -----
+
+func.func @reduce_by_key_capacity(%in: !stream.stream<tuple<i8, i32>>) -> !stream.stream<tuple<i8, i32>> {
+  // expected-error @+1 {{expect a capacity of at least one}}
+  %res = stream.reduce_by_key(%in) {initValue = 0 : i32, capacity = 0 : i64}: (!stream.stream<tuple<i8, i32>>) -> !stream.stream<tuple<i8, i32>> {
+  ^0(%acc: i32, %val: i32):
+    %r = arith.addi %acc, %val : i32
+    stream.yield %r : i32
+  }
+  return %res : !stream.stream<tuple<i8, i32>>
+}
+
+// -----
+
+func.func @reduce_by_key_input(%in: !stream.stream<i32>) -> !stream.stream<tuple<i8, i32>> {
+  // expected-error @+1 {{expect the input elements to be tuples of a key and a value}}
+  %res = stream.reduce_by_key(%in) {initValue = 0 : i32, capacity = 4 : i64}: (!stream.stream<i32>) -> !stream.stream<tuple<i8, i32>> {
+  ^0(%acc: i32, %val: i32):
+    %r = arith.addi %acc, %val : i32
+    stream.yield %r : i32
+  }
+  return %res : !stream.stream<tuple<i8, i32>>
+}
+
+// -----
+
+func.func @reduce_by_key_key_type(%in: !stream.stream<tuple<tuple<i8, i8>, i32>>) -> !stream.stream<tuple<tuple<i8, i8>, i32>> {
+  // expected-error @+1 {{expect the key to be an integer, got 'tuple<i8, i8>'}}
+  %res = stream.reduce_by_key(%in) {initValue = 0 : i32, capacity = 4 : i64}: (!stream.stream<tuple<tuple<i8, i8>, i32>>) -> !stream.stream<tuple<tuple<i8, i8>, i32>> {
+  ^0(%acc: i32, %val: i32):
+    %r = arith.addi %acc, %val : i32
+    stream.yield %r : i32
+  }
+  return %res : !stream.stream<tuple<tuple<i8, i8>, i32>>
+}
+
+// -----
+
+func.func @reduce_by_key_result(%in: !stream.stream<tuple<i8, i32>>) -> !stream.stream<tuple<i16, i32>> {
+  // expected-error @+1 {{expect the result elements to be tuples of the key and the accumulator}}
+  %res = stream.reduce_by_key(%in) {initValue = 0 : i32, capacity = 4 : i64}: (!stream.stream<tuple<i8, i32>>) -> !stream.stream<tuple<i16, i32>> {
+  ^0(%acc: i32, %val: i32):
+    %r = arith.addi %acc, %val : i32
+    stream.yield %r : i32
+  }
+  return %res : !stream.stream<tuple<i16, i32>>
+}
+
+// -----
+
+func.func @reduce_by_key_lanes(%in: !stream.stream<tuple<i8, i32>, 2>) -> !stream.stream<tuple<i8, i32>> {
+  // expected-error @+1 {{expect single-lane streams}}
+  %res = stream.reduce_by_key(%in) {initValue = 0 : i32, capacity = 4 : i64}: (!stream.stream<tuple<i8, i32>, 2>) -> !stream.stream<tuple<i8, i32>> {
+  ^0(%acc: i32, %val: i32):
+    %r = arith.addi %acc, %val : i32
+    stream.yield %r : i32
+  }
+  return %res : !stream.stream<tuple<i8, i32>>
+}
+
+// -----
+
+func.func @reduce_by_key_region(%in: !stream.stream<tuple<i8, i32>>) -> !stream.stream<tuple<i8, i64>> {
+  // expected-error @+1 {{expect the block argument #1 to have type 'i32', got 'i64' instead.}}
+  %res = stream.reduce_by_key(%in) {initValue = 0 : i64, capacity = 4 : i64}: (!stream.stream<tuple<i8, i32>>) -> !stream.stream<tuple<i8, i64>> {
+  ^0(%acc: i64, %val: i64):
+    %r = arith.addi %acc, %val : i64
+    stream.yield %r : i64
+  }
+  return %res : !stream.stream<tuple<i8, i64>>
+}
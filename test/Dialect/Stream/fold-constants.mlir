@@ -0,0 +1,187 @@
+// RUN: stream-opt %s --stream-fold-constants --split-input-file | FileCheck %s
+
+// CHECK-LABEL: func.func @reductions
+// CHECK-NEXT:    %[[RES:.*]] = stream.create !stream.stream<i64> [12]
+// CHECK-NEXT:    return %[[RES]] : !stream.stream<i64>
+func.func @reductions() -> !stream.stream<i64> {
+  %in = stream.create !stream.stream<i64> [1,2,3]
+  %left, %right = stream.split(%in) : (!stream.stream<i64>) -> (!stream.stream<i64>, !stream.stream<i64>) {
+  ^0(%val : i64):
+    stream.yield %val, %val : i64, i64
+  }
+  %leftR = stream.reduce(%left) {initValue = 0 : i64}: (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%acc: i64, %val: i64):
+    %r = arith.addi %acc, %val : i64
+    stream.yield %r : i64
+  }
+  %rightR = stream.reduce(%right) {initValue = 1 : i64}: (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%acc: i64, %val: i64):
+    %r = arith.muli %acc, %val : i64
+    stream.yield %r : i64
+  }
+  %out = stream.combine(%leftR, %rightR) : (!stream.stream<i64>, !stream.stream<i64>) -> (!stream.stream<i64>) {
+  ^0(%val0: i64, %val1: i64):
+    %0 = arith.addi %val0, %val1 : i64
+    stream.yield %0 : i64
+  }
+  return %out : !stream.stream<i64>
+}
+
+// -----
+
+// Only the constant part in front of the combine is folded.
+
+// CHECK-LABEL: func.func @table
+// CHECK-NEXT:    %[[TABLE:.*]] = stream.create !stream.stream<i64> [11, 12, 13]
+// CHECK-NEXT:    stream.combine(%[[TABLE]], %{{.*}})
+func.func @table(%arg: !stream.stream<i64>) -> !stream.stream<i64> {
+  %in = stream.create !stream.stream<i64> [1,2,3]
+  %table = stream.map(%in) : (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%val : i64):
+    %c10 = arith.constant 10 : i64
+    %r = arith.addi %val, %c10 : i64
+    stream.yield %r : i64
+  }
+  %out = stream.combine(%table, %arg) : (!stream.stream<i64>, !stream.stream<i64>) -> (!stream.stream<i64>) {
+  ^0(%val0: i64, %val1: i64):
+    %0 = arith.muli %val0, %val1 : i64
+    stream.yield %0 : i64
+  }
+  return %out : !stream.stream<i64>
+}
+
+// -----
+
+// Tuples can be folded inside the subgraph, but cannot be created.
+
+// CHECK-LABEL: func.func @tuples
+// CHECK-NEXT:    %[[IN:.*]] = stream.create !stream.stream<i64> [1, 2, 3]
+// CHECK-NEXT:    %[[TUPLES:.*]] = stream.map(%[[IN]])
+// CHECK:         %[[SUMS:.*]] = stream.create !stream.stream<i64> [3, 6, 9]
+// CHECK-NEXT:    return %[[TUPLES]], %[[SUMS]]
+func.func @tuples() -> (!stream.stream<tuple<i64, i64>>, !stream.stream<i64>) {
+  %in = stream.create !stream.stream<i64> [1, 2, 3]
+  %tuples = stream.map(%in) : (!stream.stream<i64>) -> !stream.stream<tuple<i64, i64>> {
+  ^0(%val : i64):
+    %c2 = arith.constant 2 : i64
+    %0 = arith.muli %val, %c2 : i64
+    %t = stream.pack %val, %0 : tuple<i64, i64>
+    stream.yield %t : tuple<i64, i64>
+  }
+  %sums = stream.map(%tuples) : (!stream.stream<tuple<i64, i64>>) -> !stream.stream<i64> {
+  ^0(%t : tuple<i64, i64>):
+    %a, %b = stream.unpack %t : tuple<i64, i64>
+    %r = arith.addi %a, %b : i64
+    stream.yield %r : i64
+  }
+  return %tuples, %sums : !stream.stream<tuple<i64, i64>>, !stream.stream<i64>
+}
+
+// -----
+
+// CHECK-LABEL: func.func @filtered
+// CHECK-NEXT:    %[[RES:.*]] = stream.create !stream.stream<i32> []
+// CHECK-NEXT:    return %[[RES]] : !stream.stream<i32>
+func.func @filtered() -> !stream.stream<i32> {
+  %in = stream.create !stream.stream<i32> [-1, -2]
+  %res = stream.filter(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %c0 = arith.constant 0 : i32
+    %cond = arith.cmpi sgt, %val, %c0 : i32
+    stream.yield %cond : i1
+  }
+  return %res : !stream.stream<i32>
+}
+
+// -----
+
+// CHECK-LABEL: func.func @sunk
+// CHECK-NEXT:    return
+func.func @sunk() {
+  %in = stream.create !stream.stream<i32> [1, 2]
+  %res = stream.take %in count 1 : !stream.stream<i32>
+  stream.sink %res : !stream.stream<i32>
+  return
+}
+
+// -----
+
+// The order of a merge depends on the circuit.
+
+// CHECK-LABEL: func.func @merge
+// CHECK:         stream.merge
+func.func @merge() -> !stream.stream<i32> {
+  %a = stream.create !stream.stream<i32> [1, 2]
+  %b = stream.create !stream.stream<i32> [3, 4]
+  %res = stream.merge %a, %b : !stream.stream<i32>
+  return %res : !stream.stream<i32>
+}
+
+// -----
+
+// CHECK-LABEL: func.func @division_by_zero
+// CHECK:         stream.map
+// CHECK:           arith.divsi
+func.func @division_by_zero() -> !stream.stream<i32> {
+  %in = stream.create !stream.stream<i32> [1, 0]
+  %res = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %c10 = arith.constant 10 : i32
+    %r = arith.divsi %c10, %val : i32
+    stream.yield %r : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+// -----
+
+// CHECK-LABEL: func.func @long_iota
+// CHECK:         stream.iota
+// CHECK:         stream.map
+func.func @long_iota() -> !stream.stream<i32> {
+  %in = stream.iota start 0 step 1 count 2000 : !stream.stream<i32>
+  %res = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %c1 = arith.constant 1 : i32
+    %r = arith.addi %val, %c1 : i32
+    stream.yield %r : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+// -----
+
+// An iota only needs a counter, so a map of it is not turned into a table.
+
+// CHECK-LABEL: func.func @iota_map
+// CHECK-NEXT:    stream.iota
+// CHECK-NEXT:    stream.map
+func.func @iota_map() -> !stream.stream<i32> {
+  %in = stream.iota start 0 step 1 count 8 : !stream.stream<i32>
+  %res = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %r = arith.muli %val, %val : i32
+    stream.yield %r : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+// -----
+
+// CHECK-LABEL: func.func @iota_reduce
+// CHECK-NEXT:    %[[RES:.*]] = stream.create !stream.stream<i32> [140]
+// CHECK-NEXT:    return %[[RES]] : !stream.stream<i32>
+func.func @iota_reduce() -> !stream.stream<i32> {
+  %in = stream.iota start 0 step 1 count 8 : !stream.stream<i32>
+  %squares = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %r = arith.muli %val, %val : i32
+    stream.yield %r : i32
+  }
+  %res = stream.reduce(%squares) {initValue = 0 : i32}: (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%acc: i32, %val: i32):
+    %r = arith.addi %acc, %val : i32
+    stream.yield %r : i32
+  }
+  return %res : !stream.stream<i32>
+}
@@ -0,0 +1,153 @@
+// RUN: stream-opt %s --stream-narrow-widths --split-input-file | FileCheck %s
+
+// Non-negative elements are zero-extended, so the printed values of the
+// narrowed create are their signed interpretation.
+
+// CHECK-LABEL: func.func @create
+// CHECK:         %[[IN:.*]] = stream.create !stream.stream<i2> [1, -2, -1]
+// CHECK:         stream.map(%[[IN]]) : (!stream.stream<i2>) -> !stream.stream<i64> {
+// CHECK-NEXT:    ^{{.*}}(%[[VAL:.*]]: i2):
+// CHECK-NEXT:      %[[EXT:.*]] = arith.extui %[[VAL]] : i2 to i64
+// CHECK:           arith.addi %{{.*}}, %[[EXT]] : i64
+func.func @create() -> !stream.stream<i64> {
+  %in = stream.create !stream.stream<i64> [1, 2, 3]
+  %res = stream.map(%in) : (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%val : i64):
+    %0 = arith.constant 1 : i64
+    %r = arith.addi %0, %val : i64
+    stream.yield %r : i64
+  }
+  return %res : !stream.stream<i64>
+}
+
+// -----
+
+// CHECK-LABEL: func.func @tuples
+// CHECK:         %[[IN:.*]] = stream.iota start 0 step 1 count 8 : !stream.stream<i3>
+// CHECK:         %[[TUPLES:.*]] = stream.map(%[[IN]]) : (!stream.stream<i3>) -> !stream.stream<tuple<i64, i64>>
+// CHECK:         %[[SUMS:.*]] = stream.map(%[[TUPLES]]) : (!stream.stream<tuple<i64, i64>>) -> !stream.stream<i5>
+// CHECK:           %[[SUM:.*]] = arith.addi
+// CHECK:           %[[TRUNC:.*]] = arith.trunci %[[SUM]] : i64 to i5
+// CHECK:           stream.yield %[[TRUNC]] : i5
+// CHECK:         stream.map(%[[SUMS]]) : (!stream.stream<i5>) -> !stream.stream<i64>
+// CHECK-NEXT:    ^{{.*}}(%[[VAL:.*]]: i5):
+// CHECK-NEXT:      arith.extui %[[VAL]] : i5 to i64
+func.func @tuples() -> !stream.stream<i64> {
+  %in = stream.iota start 0 step 1 count 8 : !stream.stream<i64>
+  %tuples = stream.map(%in) : (!stream.stream<i64>) -> !stream.stream<tuple<i64, i64>> {
+  ^0(%val : i64):
+    %c2 = arith.constant 2 : i64
+    %0 = arith.muli %val, %c2 : i64
+    %t = stream.pack %val, %0 : tuple<i64, i64>
+    stream.yield %t : tuple<i64, i64>
+  }
+  %sums = stream.map(%tuples) : (!stream.stream<tuple<i64, i64>>) -> !stream.stream<i64> {
+  ^0(%t : tuple<i64, i64>):
+    %a, %b = stream.unpack %t : tuple<i64, i64>
+    %s = arith.addi %a, %b : i64
+    stream.yield %s : i64
+  }
+  %res = stream.map(%sums) : (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%val : i64):
+    %c1 = arith.constant 1 : i64
+    %0 = arith.subi %val, %c1 : i64
+    stream.yield %0 : i64
+  }
+  return %res : !stream.stream<i64>
+}
+
+// -----
+
+// The accumulator of a maximum is bounded by its initial value and the
+// elements.
+
+// CHECK-LABEL: func.func @reduce_max
+// CHECK:         %[[IN:.*]] = stream.iota start -4 step 1 count 8 : !stream.stream<i3>
+// CHECK:         %[[MAX:.*]] = stream.reduce(%[[IN]]) {initValue = 0 : i2} : (!stream.stream<i3>) -> !stream.stream<i2> {
+// CHECK-NEXT:    ^{{.*}}(%[[ACC:.*]]: i2, %[[VAL:.*]]: i3):
+// CHECK-DAG:       %[[ACCEXT:.*]] = arith.extui %[[ACC]] : i2 to i32
+// CHECK-DAG:       %[[VALEXT:.*]] = arith.extsi %[[VAL]] : i3 to i32
+// CHECK:           %[[RES:.*]] = arith.maxsi %[[ACCEXT]], %[[VALEXT]] : i32
+// CHECK:           %[[TRUNC:.*]] = arith.trunci %[[RES]] : i32 to i2
+// CHECK:           stream.yield %[[TRUNC]] : i2
+// CHECK:         stream.map(%[[MAX]]) : (!stream.stream<i2>) -> !stream.stream<i32>
+func.func @reduce_max() -> !stream.stream<i32> {
+  %in = stream.iota start -4 step 1 count 8 : !stream.stream<i32>
+  %max = stream.reduce(%in) {initValue = 0 : i32} : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%acc : i32, %val : i32):
+    %r = arith.maxsi %acc, %val : i32
+    stream.yield %r : i32
+  }
+  %res = stream.map(%max) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    stream.yield %val : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+// -----
+
+// A sum keeps growing, so its accumulator is not narrowed.
+
+// CHECK-LABEL: func.func @reduce_sum
+// CHECK:         stream.reduce(%{{.*}}) {initValue = 0 : i64} : (!stream.stream<i3>) -> !stream.stream<i64>
+func.func @reduce_sum() -> !stream.stream<i64> {
+  %in = stream.iota start 0 step 1 count 8 : !stream.stream<i64>
+  %sum = stream.reduce(%in) {initValue = 0 : i64} : (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%acc : i64, %val : i64):
+    %r = arith.addi %acc, %val : i64
+    stream.yield %r : i64
+  }
+  %res = stream.map(%sum) : (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%val : i64):
+    stream.yield %val : i64
+  }
+  return %res : !stream.stream<i64>
+}
+
+// -----
+
+// Filters forward the narrowed elements.
+
+// CHECK-LABEL: func.func @filter
+// CHECK:         %[[IN:.*]] = stream.create !stream.stream<i9> [5, -212, 7]
+// CHECK:         %[[FILTERED:.*]] = stream.filter(%[[IN]]) : (!stream.stream<i9>) -> !stream.stream<i9> {
+// CHECK-NEXT:    ^{{.*}}(%[[VAL:.*]]: i9):
+// CHECK-NEXT:      arith.extui %[[VAL]] : i9 to i64
+// CHECK:         stream.map(%[[FILTERED]]) : (!stream.stream<i9>) -> !stream.stream<i64>
+// CHECK-NEXT:    ^{{.*}}(%[[VAL:.*]]: i9):
+// CHECK-NEXT:      arith.extui %[[VAL]] : i9 to i64
+func.func @filter() -> !stream.stream<i64> {
+  %in = stream.create !stream.stream<i64> [5, 300, 7]
+  %filtered = stream.filter(%in) : (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%val : i64):
+    %c6 = arith.constant 6 : i64
+    %0 = arith.cmpi sgt, %val, %c6 : i64
+    stream.yield %0 : i1
+  }
+  %res = stream.map(%filtered) : (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%val : i64):
+    stream.yield %val : i64
+  }
+  return %res : !stream.stream<i64>
+}
+
+// -----
+
+// Arguments can hold any value and returned streams keep their type.
+
+// CHECK-LABEL: func.func @unknown
+// CHECK-NOT:     arith.ext
+// CHECK:         stream.create !stream.stream<i64> [1, 2]
+// CHECK-NOT:     arith.ext
+func.func @unknown(%in: !stream.stream<i64>) -> (!stream.stream<i64>, !stream.stream<i64>) {
+  %res = stream.map(%in) : (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%val : i64):
+    %c1 = arith.constant 1 : i64
+    %0 = arith.andi %val, %c1 : i64
+    %1 = arith.addi %0, %val : i64
+    stream.yield %1 : i64
+  }
+  %c = stream.create !stream.stream<i64> [1, 2]
+  return %res, %c : !stream.stream<i64>, !stream.stream<i64>
+}
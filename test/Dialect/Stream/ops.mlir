@@ -79,6 +79,16 @@ module {
   // CHECK-NEXT:   return %{{.*}} : !stream.stream<i32>
   // CHECK-NEXT: }
 
+  func.func @iota() -> !stream.stream<i32> {
+    %out = stream.iota start 0 step -2 count 4 : !stream.stream<i32>
+    return %out : !stream.stream<i32>
+  }
+
+  // CHECK: func.func @iota() -> !stream.stream<i32> {
+  // CHECK-NEXT:   %{{.*}} = stream.iota start 0 step -2 count 4 : !stream.stream<i32>
+  // CHECK-NEXT:   return %{{.*}} : !stream.stream<i32>
+  // CHECK-NEXT: }
+
   func.func @split(%in: !stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
     %res0, %res1 = stream.split(%in) : (!stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
     ^0(%val: tuple<i32, i32>):
@@ -115,6 +125,22 @@ module {
   // CHECK-NEXT:   return %{{.*}} : !stream.stream<tuple<i32, i32>>
   // CHECK-NEXT: }
 
+  func.func @lanes(%in: !stream.stream<i32, 4>) -> !stream.stream<i32, 4> {
+    %res = stream.map(%in) : (!stream.stream<i32, 4>) -> !stream.stream<i32, 4> {
+    ^0(%val : i32):
+      stream.yield %val : i32
+    }
+    return %res : !stream.stream<i32, 4>
+  }
+
+  // CHECK: func.func @lanes(%{{.*}}: !stream.stream<i32, 4>) -> !stream.stream<i32, 4> {
+  // CHECK-NEXT:   %{{.*}} = stream.map(%{{.*}}) : (!stream.stream<i32, 4>) -> !stream.stream<i32, 4> {
+  // CHECK-NEXT:   ^{{.*}}(%{{.*}}: i32):
+  // CHECK-NEXT:     stream.yield %{{.*}} : i32
+  // CHECK-NEXT:   }
+  // CHECK-NEXT:   return %{{.*}} : !stream.stream<i32, 4>
+  // CHECK-NEXT: }
+
   func.func @sink(%in: !stream.stream<i32>) {
     stream.sink %in : !stream.stream<i32>
     return
@@ -124,4 +150,124 @@ module {
   // CHECK-NEXT:   stream.sink %{{.*}} : !stream.stream<i32>
   // CHECK-NEXT:   return
   // CHECK-NEXT: }
+
+  func.func @reduce_tuple(%in: !stream.stream<i8>) -> !stream.stream<tuple<i16, i8>> {
+    %res = stream.reduce(%in) {initValue = [0 : i16, 0 : i8]}: (!stream.stream<i8>) -> !stream.stream<tuple<i16, i8>> {
+    ^0(%acc: tuple<i16, i8>, %val: i8):
+      %sum, %cnt = stream.unpack %acc : tuple<i16, i8>
+      %ext = arith.extsi %val : i8 to i16
+      %newSum = arith.addi %sum, %ext : i16
+      %one = arith.constant 1 : i8
+      %newCnt = arith.addi %cnt, %one : i8
+      %r = stream.pack %newSum, %newCnt : tuple<i16, i8>
+      stream.yield %r : tuple<i16, i8>
+    }
+    return %res : !stream.stream<tuple<i16, i8>>
+  }
+
+  // CHECK: func.func @reduce_tuple(%{{.*}}: !stream.stream<i8>) -> !stream.stream<tuple<i16, i8>> {
+  // CHECK-NEXT:  %{{.*}} = stream.reduce(%{{.*}}) {initValue = [0 : i16, 0 : i8]} : (!stream.stream<i8>) -> !stream.stream<tuple<i16, i8>> {
+  // CHECK-NEXT:  ^bb0(%{{.*}}: tuple<i16, i8>, %{{.*}}: i8):
+  // CHECK:         stream.yield %{{.*}} : tuple<i16, i8>
+  // CHECK-NEXT:  }
+  // CHECK-NEXT:  return %{{.*}} : !stream.stream<tuple<i16, i8>>
+  // CHECK-NEXT:}
+
+  func.func @window(%in: !stream.stream<i32>) -> !stream.stream<tuple<i32, i32, i32>> {
+    %res = stream.window(%in) size 3 stride 2 : (!stream.stream<i32>) -> !stream.stream<tuple<i32, i32, i32>>
+    return %res : !stream.stream<tuple<i32, i32, i32>>
+  }
+
+  // CHECK: func.func @window(%{{.*}}: !stream.stream<i32>) -> !stream.stream<tuple<i32, i32, i32>> {
+  // CHECK-NEXT:  %{{.*}} = stream.window(%{{.*}}) size 3 stride 2 : (!stream.stream<i32>) -> !stream.stream<tuple<i32, i32, i32>>
+  // CHECK-NEXT:  return %{{.*}} : !stream.stream<tuple<i32, i32, i32>>
+  // CHECK-NEXT:}
+
+  func.func @batch(%in: !stream.stream<i8>) -> !stream.stream<i8> {
+    %wide = stream.batch(%in) : (!stream.stream<i8>) -> !stream.stream<i8, 4>
+    %res = stream.unbatch(%wide) : (!stream.stream<i8, 4>) -> !stream.stream<i8>
+    return %res : !stream.stream<i8>
+  }
+
+  // CHECK: func.func @batch(%{{.*}}: !stream.stream<i8>) -> !stream.stream<i8> {
+  // CHECK-NEXT:  %{{.*}} = stream.batch(%{{.*}}) : (!stream.stream<i8>) -> !stream.stream<i8, 4>
+  // CHECK-NEXT:  %{{.*}} = stream.unbatch(%{{.*}}) : (!stream.stream<i8, 4>) -> !stream.stream<i8>
+  // CHECK-NEXT:  return %{{.*}} : !stream.stream<i8>
+  // CHECK-NEXT:}
+
+  func.func @memory(%src: memref<16xi32>, %dst: memref<?xi32>) {
+    %in = stream.load %src[start 1 stride 2 count 8] : memref<16xi32> -> !stream.stream<i32>
+    stream.store %in, %dst[start 0 stride 1] : !stream.stream<i32>, memref<?xi32>
+    return
+  }
+
+  // CHECK: func.func @memory(%{{.*}}: memref<16xi32>, %{{.*}}: memref<?xi32>) {
+  // CHECK-NEXT:  %{{.*}} = stream.load %{{.*}}[start 1 stride 2 count 8] : memref<16xi32> -> !stream.stream<i32>
+  // CHECK-NEXT:  stream.store %{{.*}}, %{{.*}}[start 0 stride 1] : !stream.stream<i32>, memref<?xi32>
+  // CHECK-NEXT:  return
+  // CHECK-NEXT:}
+
+  func.func @buffer(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+    %0 = stream.buffer [2] seq %in : !stream.stream<i32>
+    %res = stream.buffer [8] fifo %0 : !stream.stream<i32>
+    return %res : !stream.stream<i32>
+  }
+
+  // CHECK: func.func @buffer(%{{.*}}: !stream.stream<i32>) -> !stream.stream<i32> {
+  // CHECK-NEXT:  %{{.*}} = stream.buffer [2] seq %{{.*}} : !stream.stream<i32>
+  // CHECK-NEXT:  %{{.*}} = stream.buffer [8] fifo %{{.*}} : !stream.stream<i32>
+  // CHECK-NEXT:  return %{{.*}} : !stream.stream<i32>
+  // CHECK-NEXT:}
+
+  func.func @merge(%in0: !stream.stream<i32>, %in1: !stream.stream<i32>) -> !stream.stream<i32> {
+    %res = stream.merge %in0, %in1 : !stream.stream<i32>
+    return %res : !stream.stream<i32>
+  }
+
+  // CHECK: func.func @merge(%{{.*}}: !stream.stream<i32>, %{{.*}}: !stream.stream<i32>) -> !stream.stream<i32> {
+  // CHECK-NEXT:  %{{.*}} = stream.merge %{{.*}}, %{{.*}} : !stream.stream<i32>
+  // CHECK-NEXT:  return %{{.*}} : !stream.stream<i32>
+  // CHECK-NEXT:}
+
+  func.func @take(%in: !stream.stream<i32>) -> !stream.stream<i32> {
+    %0 = stream.take %in count 4 : !stream.stream<i32>
+    %res = stream.take_while(%0) : (!stream.stream<i32>) -> !stream.stream<i32> {
+    ^bb0(%val: i32):
+      %c10_i32 = arith.constant 10 : i32
+      %1 = arith.cmpi slt, %val, %c10_i32 : i32
+      stream.yield %1 : i1
+    }
+    return %res : !stream.stream<i32>
+  }
+
+  // CHECK: func.func @take(%{{.*}}: !stream.stream<i32>) -> !stream.stream<i32> {
+  // CHECK-NEXT:  %{{.*}} = stream.take %{{.*}} count 4 : !stream.stream<i32>
+  // CHECK-NEXT:  %{{.*}} = stream.take_while(%{{.*}}) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  // CHECK-NEXT:  ^{{.*}}(%{{.*}}: i32):
+  // CHECK-NEXT:    %{{.*}} = arith.constant 10 : i32
+  // CHECK-NEXT:    %{{.*}} = arith.cmpi slt, %{{.*}}, %{{.*}} : i32
+  // CHECK-NEXT:    stream.yield %{{.*}} : i1
+  // CHECK-NEXT:  }
+  // CHECK-NEXT:  return %{{.*}} : !stream.stream<i32>
+  // CHECK-NEXT:}
+
+  func.func @reduce_by_key(%in: !stream.stream<tuple<i8, i32>>) -> !stream.stream<tuple<i8, i64>> {
+    %res = stream.reduce_by_key(%in) {initValue = 0 : i64, capacity = 16 : i64}: (!stream.stream<tuple<i8, i32>>) -> !stream.stream<tuple<i8, i64>> {
+    ^0(%acc: i64, %val: i32):
+      %ext = arith.extsi %val : i32 to i64
+      %r = arith.addi %acc, %ext : i64
+      stream.yield %r : i64
+    }
+    return %res : !stream.stream<tuple<i8, i64>>
+  }
+
+  // CHECK: func.func @reduce_by_key(%{{.*}}: !stream.stream<tuple<i8, i32>>) -> !stream.stream<tuple<i8, i64>> {
+  // CHECK-NEXT:  %{{.*}} = stream.reduce_by_key(%{{.*}}) {capacity = 16 : i64, initValue = 0 : i64} : (!stream.stream<tuple<i8, i32>>) -> !stream.stream<tuple<i8, i64>> {
+  // CHECK-NEXT:  ^{{.*}}(%{{.*}}: i64, %{{.*}}: i32):
+  // CHECK-NEXT:    %{{.*}} = arith.extsi %{{.*}} : i32 to i64
+  // CHECK-NEXT:    %{{.*}} = arith.addi %{{.*}}, %{{.*}} : i64
+  // CHECK-NEXT:    stream.yield %{{.*}} : i64
+  // CHECK-NEXT:  }
+  // CHECK-NEXT:  return %{{.*}} : !stream.stream<tuple<i8, i64>>
+  // CHECK-NEXT:}
 }
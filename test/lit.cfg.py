@@ -55,6 +55,7 @@ llvm_config.with_environment('PATH', config.llvm_tools_dir, append_path=True)
 tool_dirs = [config.stream_tools_dir, config.llvm_tools_dir]
 tools = [
     'stream-opt',
+    'stream-run',
     ToolSubst('%PYTHON', config.python_executable, unresolved='ignore'),
 ]
 
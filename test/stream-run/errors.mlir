@@ -0,0 +1,30 @@
+// RUN: not stream-run %s --entry=div 2>&1 | FileCheck %s --check-prefix=DIV
+// RUN: not stream-run %s --entry=combine 2>&1 | FileCheck %s --check-prefix=COMBINE
+// RUN: not stream-run %s --entry=div --parallel 2>&1 | FileCheck %s --check-prefix=DIV
+// RUN: not stream-run %s --entry=missing 2>&1 | FileCheck %s --check-prefix=MISSING
+
+func.func @div() -> !stream.stream<i32> {
+  %in = stream.create !stream.stream<i32> [1,0]
+  %out = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %c1 = arith.constant 1 : i32
+    // DIV: error: division by zero
+    %r = arith.divsi %c1, %val : i32
+    stream.yield %r : i32
+  }
+  return %out : !stream.stream<i32>
+}
+
+func.func @combine() -> !stream.stream<i32> {
+  %in0 = stream.create !stream.stream<i32> [1,2]
+  %in1 = stream.create !stream.stream<i32> [1]
+  // COMBINE: error: expect the combined streams to have the same number of elements
+  %res = stream.combine(%in0, %in1) : (!stream.stream<i32>, !stream.stream<i32>) -> (!stream.stream<i32>) {
+  ^0(%val0: i32, %val1: i32):
+    %0 = arith.addi %val0, %val1 : i32
+    stream.yield %0 : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+// MISSING: could not find the function 'missing'
@@ -0,0 +1,44 @@
+// RUN: stream-run %s --entry=add --input=1,2,3 --input="10, 20, -30" | FileCheck %s --check-prefix=ADD
+// RUN: stream-run %s --entry=add --input=1,2,3 --input=10,20,-30 --parallel | FileCheck %s --check-prefix=ADD
+// RUN: stream-run %s --entry=add --input= --input= | FileCheck %s --check-prefix=EMPTY
+// RUN: stream-run %s --entry=swap --input="(1, 2), (3, -4)" | FileCheck %s --check-prefix=SWAP
+// RUN: not stream-run %s --entry=add --input=1,x --input=1,2 2>&1 | FileCheck %s --check-prefix=INVALID
+// RUN: not stream-run %s --entry=swap --input="(1, 2" 2>&1 | FileCheck %s --check-prefix=TUPLE
+// RUN: not stream-run %s --entry=add --input=1 2>&1 | FileCheck %s --check-prefix=COUNT
+
+// ADD:      Element=11
+// ADD-NEXT: Element=22
+// ADD-NEXT: Element=-27
+// ADD-NEXT: EOS
+// ADD-NEXT: Count=3
+
+// EMPTY:      EOS
+// EMPTY-NEXT: Count=0
+
+// INVALID: could not parse input stream 0: '1,x'
+
+// COUNT: error: expect 2 input streams, got 1
+func.func @add(%in0: !stream.stream<i32>, %in1: !stream.stream<i32>) -> !stream.stream<i32> {
+  %res = stream.combine(%in0, %in1) : (!stream.stream<i32>, !stream.stream<i32>) -> (!stream.stream<i32>) {
+  ^0(%val0: i32, %val1: i32):
+    %0 = arith.addi %val0, %val1 : i32
+    stream.yield %0 : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+// SWAP:      Element=(2, 1)
+// SWAP-NEXT: Element=(-4, 3)
+// SWAP-NEXT: EOS
+// SWAP-NEXT: Count=2
+
+// TUPLE: could not parse input stream 0: '(1, 2'
+func.func @swap(%in: !stream.stream<tuple<i32, i32>>) -> !stream.stream<tuple<i32, i32>> {
+  %res = stream.map(%in) : (!stream.stream<tuple<i32, i32>>) -> !stream.stream<tuple<i32, i32>> {
+  ^0(%val: tuple<i32, i32>):
+    %0, %1 = stream.unpack %val : tuple<i32, i32>
+    %r = stream.pack %1, %0 : tuple<i32, i32>
+    stream.yield %r : tuple<i32, i32>
+  }
+  return %res : !stream.stream<tuple<i32, i32>>
+}
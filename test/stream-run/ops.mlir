@@ -0,0 +1,322 @@
+// RUN: stream-run %s --entry=map | FileCheck %s --check-prefix=MAP
+// RUN: stream-run %s --entry=filter | FileCheck %s --check-prefix=FILTER
+// RUN: stream-run %s --entry=reduce | FileCheck %s --check-prefix=REDUCE
+// RUN: stream-run %s --entry=reduce_tuple | FileCheck %s --check-prefix=TUPLE
+// RUN: stream-run %s --entry=split | FileCheck %s --check-prefix=SPLIT
+// RUN: stream-run %s --entry=combine | FileCheck %s --check-prefix=COMBINE
+// RUN: stream-run %s --entry=branches | FileCheck %s --check-prefix=BRANCHES
+// RUN: stream-run %s --entry=iota --count-only | FileCheck %s --check-prefix=IOTA
+// RUN: stream-run %s --entry=window | FileCheck %s --check-prefix=WINDOW
+// RUN: stream-run %s --entry=window_skip | FileCheck %s --check-prefix=SKIP
+// RUN: stream-run %s --entry=batch | FileCheck %s --check-prefix=BATCH
+// RUN: stream-run %s --entry=merge | FileCheck %s --check-prefix=MERGE
+// RUN: stream-run %s --entry=take | FileCheck %s --check-prefix=TAKE
+// RUN: stream-run %s --entry=take_while | FileCheck %s --check-prefix=WHILE
+// RUN: stream-run %s --entry=reduce_by_key | FileCheck %s --check-prefix=GROUP
+// RUN: stream-run %s --entry=reduce_by_key_evict | FileCheck %s --check-prefix=EVICT
+
+// RUN: stream-run %s --entry=filter --parallel --batch-size=2 | FileCheck %s --check-prefix=FILTER
+// RUN: stream-run %s --entry=reduce_tuple --parallel | FileCheck %s --check-prefix=TUPLE
+// RUN: stream-run %s --entry=split --parallel --batch-size=1 --queue-depth=1 | FileCheck %s --check-prefix=SPLIT
+// RUN: stream-run %s --entry=combine --parallel --batch-size=1 | FileCheck %s --check-prefix=COMBINE
+// RUN: stream-run %s --entry=reconverge --parallel --batch-size=2 --queue-depth=1 | FileCheck %s --check-prefix=RECONVERGE
+// RUN: stream-run %s --entry=reconverge --parallel --batch-size=1 --queue-depth=1 | FileCheck %s --check-prefix=RECONVERGE
+// RUN: stream-run %s --entry=iota --count-only --parallel | FileCheck %s --check-prefix=IOTA
+// RUN: stream-run %s --entry=window --parallel --batch-size=2 | FileCheck %s --check-prefix=WINDOW
+// RUN: stream-run %s --entry=merge --parallel --batch-size=1 | FileCheck %s --check-prefix=MERGE
+// RUN: stream-run %s --entry=take --parallel --batch-size=2 | FileCheck %s --check-prefix=TAKE
+// RUN: stream-run %s --entry=take_while --parallel --batch-size=2 | FileCheck %s --check-prefix=WHILE
+// RUN: stream-run %s --entry=reduce_by_key_evict --parallel --batch-size=1 | FileCheck %s --check-prefix=EVICT
+
+// MAP:      Element=11
+// MAP-NEXT: Element=12
+// MAP-NEXT: Element=13
+// MAP-NEXT: EOS
+// MAP-NEXT: Count=3
+func.func @map() -> !stream.stream<i64> {
+  %in = stream.create !stream.stream<i64> [1,2,3]
+  %out = stream.map(%in) : (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%val : i64):
+    %0 = arith.constant 10 : i64
+    %r = arith.addi %0, %val : i64
+    stream.yield %r : i64
+  }
+  return %out : !stream.stream<i64>
+}
+
+// FILTER:      Element=1
+// FILTER-NEXT: Element=2
+// FILTER-NEXT: Element=4
+// FILTER-NEXT: EOS
+func.func @filter() -> !stream.stream<i64> {
+  %in = stream.create !stream.stream<i64> [0,1,2,0,4,-3]
+  %out = stream.filter(%in) : (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^bb0(%val: i64):
+    %c0_i64 = arith.constant 0 : i64
+    %0 = arith.cmpi sgt, %val, %c0_i64 : i64
+    stream.yield %0 : i1
+  }
+  return %out : !stream.stream<i64>
+}
+
+// REDUCE:      Element=6
+// REDUCE-NEXT: EOS
+// REDUCE-NEXT: Count=1
+func.func @reduce() -> !stream.stream<i64> {
+  %in = stream.create !stream.stream<i64> [1,2,3]
+  %out = stream.reduce(%in) {initValue = 0 : i64}: (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%acc: i64, %val: i64):
+    %r = arith.addi %acc, %val : i64
+    stream.yield %r : i64
+  }
+  return %out : !stream.stream<i64>
+}
+
+// TUPLE:      Element=(3, 6)
+// TUPLE-NEXT: EOS
+func.func @reduce_tuple() -> !stream.stream<tuple<i32, i32>> {
+  %in = stream.create !stream.stream<i32> [1,2,3]
+  %out = stream.reduce(%in) {initValue = [0 : i32, 1 : i32]}: (!stream.stream<i32>) -> !stream.stream<tuple<i32, i32>> {
+  ^0(%acc: tuple<i32, i32>, %val: i32):
+    %max, %prod = stream.unpack %acc : tuple<i32, i32>
+    %0 = arith.maxsi %max, %val : i32
+    %1 = arith.muli %prod, %val : i32
+    %r = stream.pack %0, %1 : tuple<i32, i32>
+    stream.yield %r : tuple<i32, i32>
+  }
+  return %out : !stream.stream<tuple<i32, i32>>
+}
+
+// SPLIT:      S0: Element=1
+// SPLIT-NEXT: S0: Element=3
+// SPLIT-NEXT: S0: EOS
+// SPLIT-NEXT: S0: Count=2
+// SPLIT-NEXT: S1: Element=2
+// SPLIT-NEXT: S1: Element=4
+// SPLIT-NEXT: S1: EOS
+// SPLIT-NEXT: S1: Count=2
+func.func @split() -> (!stream.stream<i32>, !stream.stream<i32>) {
+  %in = stream.create !stream.stream<i32> [1,2,3,4]
+  %tuples = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<tuple<i32, i32>> {
+  ^0(%val : i32):
+    %c1 = arith.constant 1 : i32
+    %next = arith.addi %val, %c1 : i32
+    %r = stream.pack %val, %next : tuple<i32, i32>
+    stream.yield %r : tuple<i32, i32>
+  }
+  %odd = stream.filter(%tuples) : (!stream.stream<tuple<i32, i32>>) -> !stream.stream<tuple<i32, i32>> {
+  ^0(%val : tuple<i32, i32>):
+    %a, %b = stream.unpack %val : tuple<i32, i32>
+    %c1 = arith.constant 1 : i32
+    %0 = arith.andi %a, %c1 : i32
+    %1 = arith.trunci %0 : i32 to i1
+    stream.yield %1 : i1
+  }
+  %res0, %res1 = stream.split(%odd) : (!stream.stream<tuple<i32, i32>>) -> (!stream.stream<i32>, !stream.stream<i32>) {
+  ^0(%val: tuple<i32, i32>):
+    %a, %b = stream.unpack %val : tuple<i32, i32>
+    stream.yield %a, %b : i32, i32
+  }
+  return %res0, %res1 : !stream.stream<i32>, !stream.stream<i32>
+}
+
+// COMBINE:      Element=11
+// COMBINE-NEXT: Element=13
+// COMBINE-NEXT: Element=15
+// COMBINE-NEXT: EOS
+func.func @combine() -> !stream.stream<i64> {
+  %in0 = stream.create !stream.stream<i64> [1,2,3]
+  %in1 = stream.create !stream.stream<i64> [10,11,12]
+  %res = stream.combine(%in0, %in1) : (!stream.stream<i64>, !stream.stream<i64>) -> (!stream.stream<i64>) {
+  ^0(%val0: i64, %val1: i64):
+    %0 = arith.addi %val0, %val1 : i64
+    stream.yield %0 : i64
+  }
+  return %res : !stream.stream<i64>
+}
+
+// BRANCHES:      Element=4
+// BRANCHES-NEXT: Element=-1
+// BRANCHES-NEXT: EOS
+func.func @branches() -> !stream.stream<i32> {
+  %in = stream.create !stream.stream<i32> [2,-1]
+  %out = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %c0 = arith.constant 0 : i32
+    %cond = arith.cmpi slt, %val, %c0 : i32
+    cf.cond_br %cond, ^1(%val : i32), ^2
+  ^1(%res : i32):
+    stream.yield %res : i32
+  ^2:
+    %sq = arith.muli %val, %val : i32
+    cf.br ^1(%sq : i32)
+  }
+  return %out : !stream.stream<i32>
+}
+
+// The same stream is consumed by both operands of the combine.
+// RECONVERGE:      Element=0
+// RECONVERGE-NEXT: Element=2
+// RECONVERGE-NEXT: Element=6
+// RECONVERGE-NEXT: Element=12
+// RECONVERGE-NEXT: EOS
+func.func @reconverge() -> !stream.stream<i32> {
+  %in = stream.iota start 0 step 1 count 4 : !stream.stream<i32>
+  %sq = stream.map(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val : i32):
+    %r = arith.muli %val, %val : i32
+    stream.yield %r : i32
+  }
+  %res = stream.combine(%sq, %in) : (!stream.stream<i32>, !stream.stream<i32>) -> (!stream.stream<i32>) {
+  ^0(%val0: i32, %val1: i32):
+    %0 = arith.addi %val0, %val1 : i32
+    stream.yield %0 : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+// IOTA-NOT:  Element
+// IOTA:      Count=1000000
+func.func @iota() -> !stream.stream<i64> {
+  %in = stream.iota start 0 step 3 count 1000000 : !stream.stream<i64>
+  %out = stream.map(%in) : (!stream.stream<i64>) -> !stream.stream<i64> {
+  ^0(%val : i64):
+    %c7 = arith.constant 7 : i64
+    %r = arith.remui %val, %c7 : i64
+    stream.yield %r : i64
+  }
+  return %out : !stream.stream<i64>
+}
+
+// WINDOW:      Element=(1, 2, 3)
+// WINDOW-NEXT: Element=(3, 4, 5)
+// WINDOW-NEXT: EOS
+// WINDOW-NEXT: Count=2
+func.func @window() -> !stream.stream<tuple<i32, i32, i32>> {
+  %in = stream.iota start 1 step 1 count 6 : !stream.stream<i32>
+  %out = stream.window(%in) size 3 stride 2 : (!stream.stream<i32>) -> !stream.stream<tuple<i32, i32, i32>>
+  return %out : !stream.stream<tuple<i32, i32, i32>>
+}
+
+// SKIP:      Element=3
+// SKIP-NEXT: Element=9
+// SKIP-NEXT: EOS
+// SKIP-NEXT: Count=2
+func.func @window_skip() -> !stream.stream<i32> {
+  %in = stream.iota start 1 step 1 count 7 : !stream.stream<i32>
+  %windows = stream.window(%in) size 2 stride 3 : (!stream.stream<i32>) -> !stream.stream<tuple<i32, i32>>
+  %out = stream.map(%windows) : (!stream.stream<tuple<i32, i32>>) -> !stream.stream<i32> {
+  ^0(%val : tuple<i32, i32>):
+    %a, %b = stream.unpack %val : tuple<i32, i32>
+    %r = arith.addi %a, %b : i32
+    stream.yield %r : i32
+  }
+  return %out : !stream.stream<i32>
+}
+
+// BATCH:      Element=2
+// BATCH-NEXT: Element=4
+// BATCH-NEXT: Element=6
+// BATCH-NEXT: Element=8
+// BATCH-NEXT: Element=10
+// BATCH-NEXT: EOS
+func.func @batch() -> !stream.stream<i32> {
+  %in = stream.iota start 1 step 1 count 5 : !stream.stream<i32>
+  %wide = stream.batch(%in) : (!stream.stream<i32>) -> !stream.stream<i32, 4>
+  %doubled = stream.map(%wide) : (!stream.stream<i32, 4>) -> !stream.stream<i32, 4> {
+  ^0(%val : i32):
+    %r = arith.addi %val, %val : i32
+    stream.yield %r : i32
+  }
+  %out = stream.unbatch(%doubled) : (!stream.stream<i32, 4>) -> !stream.stream<i32>
+  return %out : !stream.stream<i32>
+}
+
+// The order of the merged elements is not defined, so only their sum is
+// checked.
+// MERGE:      Element=55
+// MERGE-NEXT: EOS
+func.func @merge() -> !stream.stream<i32> {
+  %in0 = stream.iota start 1 step 1 count 4 : !stream.stream<i32>
+  %in1 = stream.iota start 5 step 1 count 6 : !stream.stream<i32>
+  %merged = stream.merge %in0, %in1 : !stream.stream<i32>
+  %res = stream.reduce(%merged) {initValue = 0 : i32} : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%acc: i32, %val: i32):
+    %r = arith.addi %acc, %val : i32
+    stream.yield %r : i32
+  }
+  return %res : !stream.stream<i32>
+}
+
+// TAKE:      Element=10
+// TAKE-NEXT: Element=11
+// TAKE-NEXT: Element=12
+// TAKE-NEXT: EOS
+// TAKE-NEXT: Count=3
+func.func @take() -> !stream.stream<i32> {
+  %in = stream.iota start 10 step 1 count 8 : !stream.stream<i32>
+  %res = stream.take %in count 3 : !stream.stream<i32>
+  return %res : !stream.stream<i32>
+}
+
+// Elements after the first failing one are dropped, even if they satisfy the
+// predicate.
+// WHILE:      Element=1
+// WHILE-NEXT: Element=2
+// WHILE-NEXT: EOS
+// WHILE-NEXT: Count=2
+func.func @take_while() -> !stream.stream<i32> {
+  %in = stream.create !stream.stream<i32> [1, 2, 0, 3, 4]
+  %res = stream.take_while(%in) : (!stream.stream<i32>) -> !stream.stream<i32> {
+  ^0(%val: i32):
+    %c0 = arith.constant 0 : i32
+    %cond = arith.cmpi sgt, %val, %c0 : i32
+    stream.yield %cond : i1
+  }
+  return %res : !stream.stream<i32>
+}
+
+// GROUP:      Element=(1, 3)
+// GROUP-NEXT: Element=(2, 2)
+// GROUP-NEXT: Element=(3, 1)
+// GROUP-NEXT: EOS
+// GROUP-NEXT: Count=3
+func.func @reduce_by_key() -> !stream.stream<tuple<i8, i32>> {
+  %in = stream.create !stream.stream<i8> [1, 2, 1, 3, 2, 1]
+  %pairs = stream.map(%in) : (!stream.stream<i8>) -> !stream.stream<tuple<i8, i32>> {
+  ^0(%key: i8):
+    %c1 = arith.constant 1 : i32
+    %pair = stream.pack %key, %c1 : tuple<i8, i32>
+    stream.yield %pair : tuple<i8, i32>
+  }
+  %res = stream.reduce_by_key(%pairs) {initValue = 0 : i32, capacity = 4 : i64}: (!stream.stream<tuple<i8, i32>>) -> !stream.stream<tuple<i8, i32>> {
+  ^0(%acc: i32, %val: i32):
+    %r = arith.addi %acc, %val : i32
+    stream.yield %r : i32
+  }
+  return %res : !stream.stream<tuple<i8, i32>>
+}
+
+// New keys evict the oldest slot once the table is full, so the partial
+// results of the first two keys are emitted before EOS.
+// EVICT:      Element=(1, 2)
+// EVICT-NEXT: Element=(2, 2)
+// EVICT-NEXT: Element=(3, 1)
+// EVICT-NEXT: Element=(1, 1)
+// EVICT-NEXT: EOS
+// EVICT-NEXT: Count=4
+func.func @reduce_by_key_evict() -> !stream.stream<tuple<i8, i32>> {
+  %in = stream.create !stream.stream<i8> [1, 2, 1, 3, 2, 1]
+  %pairs = stream.map(%in) : (!stream.stream<i8>) -> !stream.stream<tuple<i8, i32>> {
+  ^0(%key: i8):
+    %c1 = arith.constant 1 : i32
+    %pair = stream.pack %key, %c1 : tuple<i8, i32>
+    stream.yield %pair : tuple<i8, i32>
+  }
+  %res = stream.reduce_by_key(%pairs) {initValue = 0 : i32, capacity = 2 : i64}: (!stream.stream<tuple<i8, i32>>) -> !stream.stream<tuple<i8, i32>> {
+  ^0(%acc: i32, %val: i32):
+    %r = arith.addi %acc, %val : i32
+    stream.yield %r : i32
+  }
+  return %res : !stream.stream<tuple<i8, i32>>
+}
@@ -0,0 +1,200 @@
+//===- stream-run.cpp -------------------------------------------*- C++ -*-===//
+//
+// This file is licensed under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Executes a function built from stream operations in software and prints the
+// elements of the resulting streams in the format of the simulation drivers.
+//
+//===----------------------------------------------------------------------===//
+
+#include "circt-stream/Dialect/Stream/Interpreter/Interpreter.h"
+#include "circt-stream/Dialect/Stream/StreamDialect.h"
+#include "circt-stream/Dialect/Stream/StreamTypes.h"
+#include "mlir/Dialect/Arithmetic/IR/Arithmetic.h"
+#include "mlir/Dialect/ControlFlow/IR/ControlFlowOps.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Dialect.h"
+#include "mlir/IR/MLIRContext.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Support/FileUtilities.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/SourceMgr.h"
+
+using namespace mlir;
+using namespace circt_stream;
+
+static llvm::cl::opt<std::string> inputFilename(llvm::cl::Positional,
+                                                llvm::cl::desc("<input file>"),
+                                                llvm::cl::init("-"));
+
+static llvm::cl::opt<std::string>
+    entryName("entry", llvm::cl::desc("Name of the function to execute"),
+              llvm::cl::init("top"));
+
+static llvm::cl::opt<bool>
+    countOnly("count-only",
+              llvm::cl::desc("Only print the number of elements of each "
+                             "result stream"),
+              llvm::cl::init(false));
+
+static llvm::cl::opt<bool>
+    parallel("parallel",
+             llvm::cl::desc("Execute each stream operation in its own thread"),
+             llvm::cl::init(false));
+
+static llvm::cl::opt<unsigned> batchSize(
+    "batch-size",
+    llvm::cl::desc("Number of elements that are transferred at once "
+                   "between threads"),
+    llvm::cl::init(1024));
+
+static llvm::cl::opt<unsigned>
+    queueDepth("queue-depth",
+               llvm::cl::desc("Number of batches a queue between two threads "
+                              "can hold"),
+               llvm::cl::init(8));
+
+static llvm::cl::list<std::string>
+    inputStreams("input",
+                 llvm::cl::desc("Comma-separated elements of the next input "
+                                "stream, e.g., `1,2,3` or `(1, 2), (3, 4)` "
+                                "for tuples"),
+                 llvm::cl::ZeroOrMore);
+
+/// Parses an element of the provided type from the front of `text`. Integers
+/// are given as decimals and tuples as `(a, b, ...)`, like they are printed.
+static bool parseElement(StringRef &text, Type type, stream::Element &element) {
+  text = text.ltrim();
+  if (auto tupleType = type.dyn_cast<TupleType>()) {
+    if (!text.consume_front("("))
+      return false;
+    std::vector<stream::Element> fields(tupleType.size());
+    for (auto it : llvm::enumerate(tupleType.getTypes())) {
+      text = text.ltrim();
+      if (it.index() > 0 && !text.consume_front(","))
+        return false;
+      if (!parseElement(text, it.value(), fields[it.index()]))
+        return false;
+    }
+    text = text.ltrim();
+    if (!text.consume_front(")"))
+      return false;
+    element = stream::Element(std::move(fields));
+    return true;
+  }
+
+  unsigned width = type.getIntOrFloatBitWidth();
+  bool negative = text.consume_front("-");
+  size_t end = text.find_first_of(", \t)");
+  StringRef digits = text.take_front(end);
+  text = text.drop_front(digits.size());
+  llvm::APInt value;
+  if (digits.getAsInteger(10, value) || value.getActiveBits() > width)
+    return false;
+  value = value.zextOrTrunc(width);
+  if (negative)
+    value.negate();
+  element = stream::Element(value);
+  return true;
+}
+
+/// Parses the comma-separated elements of an input stream.
+static bool parseStream(StringRef text, Type elementType,
+                        stream::StreamContents &contents) {
+  text = text.trim();
+  while (!text.empty()) {
+    if (!contents.empty()) {
+      if (!text.consume_front(","))
+        return false;
+      text = text.ltrim();
+    }
+    stream::Element element;
+    if (!parseElement(text, elementType, element))
+      return false;
+    contents.push_back(std::move(element));
+    text = text.ltrim();
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  llvm::InitLLVM y(argc, argv);
+  llvm::cl::ParseCommandLineOptions(argc, argv, "stream dialect interpreter\n");
+
+  DialectRegistry registry;
+  registry.insert<func::FuncDialect>();
+  registry.insert<arith::ArithmeticDialect>();
+  registry.insert<cf::ControlFlowDialect>();
+  registry.insert<stream::StreamDialect>();
+  MLIRContext context(registry);
+
+  std::string errorMessage;
+  auto file = openInputFile(inputFilename, &errorMessage);
+  if (!file) {
+    llvm::errs() << errorMessage << "\n";
+    return 1;
+  }
+
+  llvm::SourceMgr sourceMgr;
+  sourceMgr.AddNewSourceBuffer(std::move(file), llvm::SMLoc());
+  SourceMgrDiagnosticHandler diagHandler(sourceMgr, &context);
+  OwningOpRef<ModuleOp> module = parseSourceFile<ModuleOp>(sourceMgr, &context);
+  if (!module)
+    return 1;
+
+  auto funcOp = module->lookupSymbol<func::FuncOp>(entryName);
+  if (!funcOp) {
+    llvm::errs() << "could not find the function '" << entryName << "'\n";
+    return 1;
+  }
+
+  stream::InterpreterOptions options;
+  options.parallel = parallel;
+  options.batchSize = batchSize;
+  options.queueDepth = queueDepth;
+
+  // Superfluous inputs stay empty, such that the interpreter reports the
+  // mismatch of the number of streams.
+  std::vector<stream::StreamContents> inputs(inputStreams.size());
+  ArrayRef<Type> argTypes = funcOp.getArgumentTypes();
+  for (unsigned i = 0, e = std::min(inputs.size(), argTypes.size()); i < e;
+       ++i) {
+    auto type = argTypes[i].dyn_cast<stream::StreamType>();
+    if (!type) {
+      llvm::errs() << "argument " << i << " of '" << entryName
+                   << "' is not a stream\n";
+      return 1;
+    }
+    if (!parseStream(inputStreams[i], type.getElementType(), inputs[i])) {
+      llvm::errs() << "could not parse input stream " << i << ": '"
+                   << inputStreams[i] << "'\n";
+      return 1;
+    }
+  }
+
+  SmallVector<stream::StreamContents> results;
+  if (failed(stream::interpretFunction(funcOp, inputs, results, options)))
+    return 1;
+
+  // Multiple streams are distinguished by a prefix, like in the drivers.
+  llvm::raw_ostream &os = llvm::outs();
+  for (auto it : llvm::enumerate(results)) {
+    std::string prefix;
+    if (results.size() > 1)
+      prefix = "S" + std::to_string(it.index()) + ": ";
+
+    if (!countOnly) {
+      for (const stream::Element &element : it.value())
+        os << prefix << "Element=" << element << "\n";
+      os << prefix << "EOS\n";
+    }
+    os << prefix << "Count=" << it.value().size() << "\n";
+  }
+  return 0;
+}